@@ -10,6 +10,7 @@
 #define AL_BACKEND_H 1
 
 #include "al_context.h"
+#include "al_path.h"
 
 #if defined(_WIN32)
 #  define IMAS_CORE_LIBRARY_API __declspec(dllexport)
@@ -19,14 +20,202 @@
 
 #ifdef __cplusplus
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <string>
 #include "data_interpolation.h"
 
+/**
+   Allocator of the data returned by Backend::readData().
+   The data returned to the caller of al_read_data is allocated by the backends with 
+   ALAllocator::allocate() and released with ALAllocator::release() when the lowlevel or a 
+   backend drops it. Defaults to malloc() and free(), applications can route these 
+   allocations to their own pools with al_set_allocator().
+*/
+class IMAS_CORE_LIBRARY_API ALAllocator
+{
+public:
+  typedef void* (*AllocFn)(size_t size, void *user);
+  typedef void (*FreeFn)(void *ptr, void *user);
+
+  /**
+     Allocates a data buffer.
+     @param[in] size number of bytes
+     @result pointer on the buffer
+     @throw ALBackendException if the allocator fails
+  */
+  static void* allocate(size_t size);
+
+  /**
+     Releases a data buffer (no-op for NULL).
+     @param[in] ptr buffer returned by allocate()
+  */
+  static void release(void *ptr);
+
+  /**
+     Allocates a copy of a null-terminated string, as strdup() does.
+     @param[in] s string to copy
+     @result pointer on the copy
+  */
+  static char* duplicate(const char *s);
+
+  /**
+     Grows or shrinks a data buffer, keeping its first min(size, newSize) bytes.
+     @param[in] ptr buffer returned by allocate()
+     @param[in] size current size of the buffer in bytes
+     @param[in] newSize new size in bytes
+     @result pointer on the buffer, which may have moved
+  */
+  static void* reallocate(void *ptr, size_t size, size_t newSize);
+
+  /**
+     Installs an allocator (malloc and free when both functions are NULL).
+     @param[in] alloc allocation function
+     @param[in] release release function
+     @param[in] user argument passed to both functions
+  */
+  static void set(AllocFn alloc, FreeFn release, void *user);
+
+  /**
+     Tells if the default allocator (malloc and free) is in use.
+  */
+  static bool isDefault();
+};
+
+/**
+   Live memory held by the components of a data entry, as reported by al_memory_usage().
+   Backends and decorators add the bytes they hold, per component and per IDS, in
+   Backend::getMemoryUsage(). Each component also keeps the process-wide count of its live
+   bytes in a Counter.
+*/
+class IMAS_CORE_LIBRARY_API ALMemoryUsage
+{
+public:
+  /**
+     Process-wide count of the live bytes of a component, declared once per component as a
+     static object and updated where its memory is allocated and released.
+  */
+  class IMAS_CORE_LIBRARY_API Counter
+  {
+  public:
+    /**
+       Registers the counter of a component.
+       @param[in] component name of the component (static string)
+    */
+    Counter(const char *component);
+
+    void add(size_t bytes) { live += (int64_t)bytes; }
+    void sub(size_t bytes) { live -= (int64_t)bytes; }
+    int64_t get() const { return live; }
+
+  private:
+    std::atomic<int64_t> live;
+  };
+
+  /**
+     Accounts memory held by a component.
+     @param[in] component name of the component
+     @param[in] ids IDS the memory belongs to ("<idsname>[/<occurrence>]"), empty if not
+     attributed to an IDS
+     @param[in] bytes number of bytes
+  */
+  void add(const std::string &component, const std::string &ids, size_t bytes);
+
+  /**
+     Returns the total number of bytes accounted.
+  */
+  size_t total() const;
+
+  /**
+     Serializes the accounted memory into a JSON object:
+     {"total": N, "components": {"<component>": {"total": N, "ids": {"<ids>": N, ...}}, ...}}
+  */
+  std::string toJSON() const;
+
+  /**
+     Serializes the process-wide counters into a JSON object, with the resident set size of the
+     process when known: {"total": N, "components": {"<component>": N, ...}, "resident": N}
+  */
+  static std::string processJSON();
+
+private:
+  std::map<std::string, std::map<std::string, size_t>> components;   /**< key = component, then IDS */
+};
+
+/**
+   Counters of the puts done in incremental mode (URI option incremental_put=yes), as reported
+   by al_get_statistics(). Fields whose content did not change since the previous put of the
+   same IDS are not written again, their bytes are counted as saved.
+*/
+struct IMAS_CORE_LIBRARY_API ALIncrementalPutCounters
+{
+  uint64_t puts = 0;                              /**< puts done in incremental mode */
+  uint64_t fullRewrites = 0;                      /**< puts written entirely (first put, shapes or fields changed) */
+  uint64_t fieldsWritten = 0;                     /**< fields written */
+  uint64_t fieldsSkipped = 0;                     /**< fields left untouched, unchanged since the previous put */
+  uint64_t bytesWritten = 0;                      /**< bytes of the fields written */
+  uint64_t bytesSaved = 0;                        /**< bytes of the fields left untouched */
+
+  ALIncrementalPutCounters& operator+=(const ALIncrementalPutCounters &other);
+
+  /**
+     Serializes the counters into a JSON object.
+  */
+  std::string toJSON() const;
+};
+
+/**
+   Counters of the deduplication of the arrays written (URI option dedup=yes), as reported by
+   al_get_statistics(). An array whose content equals an array already stored for the same IDS
+   is kept once and shared, its bytes are counted as shared.
+*/
+struct IMAS_CORE_LIBRARY_API ALDedupCounters
+{
+  uint64_t arrays = 0;                            /**< arrays written */
+  uint64_t sharedArrays = 0;                      /**< arrays stored as a reference to an equal array */
+  uint64_t bytes = 0;                             /**< bytes of the arrays written */
+  uint64_t sharedBytes = 0;                       /**< bytes of the arrays stored as a reference */
+
+  ALDedupCounters& operator+=(const ALDedupCounters &other);
+
+  /**
+     Deduplication ratio: bytes written over bytes actually stored (1 when nothing is shared).
+  */
+  double ratio() const;
+
+  /**
+     Serializes the counters into a JSON object.
+  */
+  std::string toJSON() const;
+};
+
+/**
+   Description of one field within a batched data operation.
+   For writes, data, datatype, dim and size are the arguments of Backend::writeData().
+   For reads, data, datatype, dim and size are filled by the backend the same way as
+   the corresponding arguments of Backend::readData(), and found receives its result.
+*/
+struct IMAS_CORE_LIBRARY_API DataBatchItem
+{
+  ALPath fieldname;                               /**< field name */
+  ALPath timebasename;                            /**< timebase field name */
+  void* data;                                     /**< pointer on the data */
+  int datatype;                                   /**< type of the data */
+  int dim;                                        /**< dimension of the data */
+  int* size;                                      /**< size of each dimension */
+  int found;                                      /**< 0 when there is no such data (or 1 on success) */
+
+  DataBatchItem()
+    : data(NULL), datatype(0), dim(0), size(NULL), found(0) {}
+};
+
 /**
    Abstract Backend class.
    Defines the back-end API, as pure virtual member functions. 
+   Field and timebase names are passed as interned paths (see al_path.h): backends can key 
+   their internal structures on ALPath::id() and reuse ALPath::components().
 */
 class IMAS_CORE_LIBRARY_API Backend
 {
@@ -41,6 +230,25 @@ public:
   */
   static Backend* initBackend(DataEntryContext *ctx);
 
+  /**
+     Returns the size in bytes of a data.
+     @param[in] datatype type of the data
+     @param[in] dim dimension of the data
+     @param[in] size array of the size of each dimension
+     @result number of bytes needed to store the data
+  */
+  static size_t getDataByteSize(int datatype, int dim, const int* size);
+
+  /**
+     Returns a fast 64-bit hash of a buffer, used to fingerprint the content of data.
+     Not a cryptographic hash: data with equal hashes is taken as unchanged.
+     @param[in] data pointer on the buffer
+     @param[in] bytes size of the buffer in bytes
+     @param[in] seed hash of the preceding bytes, to chain several buffers
+     @result hash of the buffer
+  */
+  static uint64_t hashData(const void* data, size_t bytes, uint64_t seed = 0);
+
   /**
      Returns version of the backend (pair <major,minor>), to be used for compatibility checks.
      Version number needs to be bumped when:
@@ -111,8 +319,8 @@ public:
      @throw BackendException
   */
   virtual void writeData(Context *ctx,
-			 std::string fieldname,
-			 std::string timebasename, 
+			 ALPath fieldname,
+			 ALPath timebasename, 
 			 void* data,
 			 int datatype,
 			 int dim,
@@ -136,13 +344,87 @@ public:
      @throw BackendException
   */
   virtual int readData(Context *ctx,
-		       std::string fieldname,
-		       std::string timebasename, 
+		       ALPath fieldname,
+		       ALPath timebasename, 
 		       void** data,
 		       int* datatype,
 		       int* dim,
 		       int* size) = 0;
 
+  /**
+     Reads data into a caller provided buffer.
+     This function reads a signal as readData() does, but stores it directly in dst when it has 
+     the expected type and fits in capacity bytes. Otherwise the data is returned in *data as 
+     readData() would do. The default implementation calls readData() and copies the result.
+     @param[in] ctx pointer on Context (either Operation or Arraystruct)
+     @param[in] fieldname field name
+     @param[in] timebasename timebase field name
+     @param[out] dst destination buffer
+     @param[in] capacity size of dst in bytes
+     @param[out] data returned pointer on the read data, when not stored in dst
+     @param[inout] datatype type of data to be read (expected type on input)
+     @param[inout] dim returned dimension of the data
+     @param[out] size array returned with elements filled at the size of each dimension 
+     @result returns 0 when there is no such data, 1 when data is stored in dst, 2 when data 
+     is returned in *data
+     @throw BackendException
+  */
+  virtual int readDataInto(Context *ctx,
+			   ALPath fieldname,
+			   ALPath timebasename,
+			   void* dst,
+			   size_t capacity,
+			   void** data,
+			   int* datatype,
+			   int* dim,
+			   int* size);
+
+  /**
+     Reads the shape of data.
+     This function returns the type and shape readData() would return, without the data 
+     itself. The default implementation calls readData() and drops the data.
+     @param[in] ctx pointer on Context (either Operation or Arraystruct)
+     @param[in] fieldname field name
+     @param[in] timebasename timebase field name
+     @param[inout] datatype type of data (expected type on input)
+     @param[inout] dim returned dimension of the data
+     @param[out] size array returned with elements filled at the size of each dimension 
+     @result returns 0 when there is no such data (or 1 on success)
+     @throw BackendException
+  */
+  virtual int readDataShape(Context *ctx,
+			    ALPath fieldname,
+			    ALPath timebasename,
+			    int* datatype,
+			    int* dim,
+			    int* size);
+
+  /**
+     Writes several data in a row.
+     This function writes all the passed fields in the same Context, as writeData() would do for
+     each of them. Backends can override it to process the whole batch in a single pass, the 
+     default implementation calls writeData() for each item.
+     @param[in] ctx pointer on Context (either Operation or Arraystruct)
+     @param[in] items fields to write
+     @throw BackendException
+  */
+  virtual void writeDataBatch(Context *ctx,
+			      std::vector<DataBatchItem> &items);
+
+  /**
+     Reads several data in a row.
+     This function reads all the passed fields from the same Context, as readData() would do for 
+     each of them. Backends can override it to resolve the whole batch in a single pass, the 
+     default implementation calls readData() for each item.
+     @param[in] ctx pointer on Context (either Operation or Arraystruct)
+     @param[in,out] items fields to read, with the returned data and found status filled 
+     for each of them (data of items already read is left for the caller to release if 
+     an exception is thrown)
+     @throw BackendException
+  */
+  virtual void readDataBatch(Context *ctx,
+			     std::vector<DataBatchItem> &items);
+
   /**
     Deletes data.
     This function deletes some data (can be a signal, a structure, the whole DATAOBJECT) in the database 
@@ -174,6 +456,36 @@ public:
   **/
   virtual void get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) = 0;
 
+  /**
+    Reports the memory held by the backend for a data entry.
+    This function adds to usage the live bytes of the backend components (buffers, caches,
+    in-memory data), per IDS when they belong to one. Decorators add their own memory and
+    forward to their target. The default implementation reports nothing.
+    @param[in] ctx pointer on pulse context
+    @param[in,out] usage accounted memory
+    @throw BackendException
+  **/
+  virtual void getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage);
+
+  /**
+    Reports the counters of the incremental puts of a data entry.
+    Decorators forward to their target. The default implementation reports nothing.
+    @param[in] ctx pointer on pulse context
+    @param[out] counters counters of the puts done in incremental mode
+    @result true if the data entry was opened with incremental_put=yes, false otherwise
+    @throw BackendException
+  **/
+  virtual bool getIncrementalPutCounters(DataEntryContext *ctx, ALIncrementalPutCounters &counters);
+
+  /**
+    Reports the counters of the deduplication of the arrays written in a data entry.
+    Decorators forward to their target. The default implementation reports nothing.
+    @param[in] ctx pointer on pulse context
+    @param[out] counters counters of the arrays written with deduplication
+    @result true if the data entry was opened with dedup=yes, false otherwise
+    @throw BackendException
+  **/
+  virtual bool getDedupCounters(DataEntryContext *ctx, ALDedupCounters &counters);
 
   /**
     Returns true if the backend performs time data interpolation (e.g time slices operations or IMAS-3885 with data resampling), false otherwise.
@@ -29,6 +29,7 @@
 #include <cstdlib>
 #include <atomic>
 #include <string>
+#include <vector>
 
 #define CTX_TYPE 100
 #define CTX_PULSE_TYPE 101
@@ -83,6 +84,15 @@ public:
   */
   virtual std::string getBackendName() const = 0;
 
+  /**
+     Tells whether a node is requested by the operation of the context (see 
+     OperationContext::getProjection()).
+     @param[in] path path of the node relative to the context, without AoS indices
+     @param[in] container true for a structure or an array of structures, which is also requested
+     when it contains a requested node
+     @result true when the node is requested (always true without projection)
+  */
+  virtual bool isProjected(const std::string &path, bool container) const;
 
   
 protected:
@@ -307,6 +317,16 @@ public:
   */
   std::string getDatapath() const;
 
+  /**
+     Returns the projection of a partial get: the path prefixes listed in datapath, separated 
+     by ';', without AoS indices (e.g. "profiles_1d/electrons;time"). Backends skip the nodes
+     outside the projection. Empty for non-partial gets and for a datapath without ';'.
+     @result path prefixes
+  */
+  const std::vector<std::string>& getProjection() const;
+
+  bool isProjected(const std::string &path, bool container) const override;
+
   /**
      Returns access type of the operation.
      @result accessmode
@@ -375,6 +395,7 @@ protected:
   double time;                          /**< operation time */
   int interpmode;                       /**< operation interpolation type */
   std::string datapath;                 /**< path to data node for partial get operations */
+  std::vector<std::string> projection;  /**< path prefixes of datapath */
 };
 
 
@@ -462,6 +483,14 @@ class IMAS_CORE_LIBRARY_API ArraystructContext : public Context
   */
   std::string getTimebasePath() const;
 
+  /**
+     Returns the path of the array of structure in the DATAOBJECT, without AoS indices.
+     @result path
+  */
+  std::string getFullPath() const;
+
+  bool isProjected(const std::string &path, bool container) const override;
+
   /**
      Returns whether the array of structure is time-dependent or not.
      @result timed
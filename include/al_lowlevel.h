@@ -26,8 +26,38 @@
 #include <set>
 #include <map>
 #include <mutex>
+#include <atomic>
 #include <complex>
+#include <memory>
 #include <string>
+#include <string_view>
+
+/**
+   Node of the bound plugins path trie.
+   Each node stands for one component of a field path ("core_profiles:0", "profiles_1d",
+   "grid", ...) and holds the plugins bound to the path ending at this node. Nodes are never
+   removed, so pointers on them stay valid while bindings come and go.
+*/
+struct LLpluginPathNode
+{
+  std::vector<std::string> plugins;                                                     /**< plugins bound to this path */
+  std::map<std::string, std::unique_ptr<LLpluginPathNode>, std::less<>> children;     /**< next path components */
+
+  const LLpluginPathNode* find(std::string_view path) const;
+  LLpluginPathNode* insert(std::string_view path);
+};
+
+/**
+   Bound plugins resolution memoized for a context.
+   Trie nodes of the context path prefix and of the IDS occurrence and any occurrence wildcards.
+*/
+struct LLpluginPrefix
+{
+  bool resolved = false;
+  const LLpluginPathNode *node = nullptr;
+  const LLpluginPathNode *occurrenceWildcard = nullptr;
+  const LLpluginPathNode *idsWildcard = nullptr;
+};
 
 /**
    Holds a plugin.
@@ -41,6 +71,11 @@ private:
   static void addDestroyPlugin(const char* name, void *destroy_plugin);
   static void addPlugin(const char* name, void *plugin);
   static void bind_plugin(const char* pluginName, const std::string &path, std::map<std::string, std::vector<std::string>>& bound_plugins);
+  static void syncBoundPath(const std::string &path);
+  static void resolvePrefix(int ctxID, LLpluginPrefix &prefix);
+
+  static std::atomic<bool> pluginsEnabled;                                            /**< IMAS_AL_ENABLE_PLUGINS latched at init */
+  static LLpluginPathNode boundPluginsTrie;                                           /**< boundPlugins compiled into a path trie */
 
 public:
 
@@ -56,9 +91,11 @@ public:
   static std::string getOperationPath;
   static std::vector<std::string> pluginsNames;
   static std::map<std::string, std::vector<std::string>> get_plugins;
+  static std::recursive_mutex frameworkMutex;                                         /**< serializes lowlevel calls while plugins are enabled */
 
   static void getFullPath(int ctxID, const char* fieldPath,  std::string &full_path, std::string &fullDataObjectName);
-  static bool pluginsFrameworkEnabled();
+  static bool pluginsFrameworkEnabled() { return pluginsEnabled; }
+  static void latchPluginsFrameworkFlag();
   static void checkIfPluginsFrameworkIsEnabled();
 
   LLplugin()
@@ -90,8 +127,10 @@ public:
   static void unbindPlugin(const char* fieldPath, const char* pluginName, std::map<std::string, std::vector<std::string>> &boundPlugins_);
   static bool getBoundPlugins(const std::string &fullPath, std::vector<std::string> &pluginsNames);
   static bool getBoundPlugins(int ctxID, const char* fieldPath, std::vector<std::string> &pluginsNames);
+  static const std::vector<std::string>* findBoundPlugins(int ctxID, const char* fieldPath);
   static bool getBoundPlugins(const char* dataobjectname, std::set<std::string> &pluginsNames);
   static bool isPluginBound(const char* path, const char* pluginName);
+  static std::string idsWildcardPath(const std::string &dataObjectName);   // path binding all the occurrences of "ids_name:occ", i.e. "ids_name:*" followed by "/*"
   static void setvalueParameterPlugin(const char* parameter_name, int datatype, int dim, int *size, void *data, const char* pluginName);
 
 };
@@ -105,6 +144,7 @@ class IMAS_CORE_LIBRARY_API LLenv
 public:
   Backend* backend;                               /**< pointer on Backend object */
   Context* context;                               /**< pointer on Context object */
+  mutable LLpluginPrefix pluginPrefix;            /**< memoized bound plugins resolution */
 
   LLenv()
   {
@@ -117,7 +157,71 @@ public:
     context = ctx;
   }
   
-  ArraystructContext* create(const char* path, const char* timebase); 
+  ArraystructContext* create(const char* path, const char* timebase) const;
+};
+
+
+/**
+   Generation-tagged handle table storing the lowlevel environments.
+   A handle encodes the index of its slot together with the generation of that
+   slot, so that identifiers of ended contexts are reported as stale instead of
+   aliasing whatever environment recycled the slot. Slots are allocated in pages
+   that never move: lookups are wait-free and may run concurrently with
+   insertions and removals, which are serialized and recycle slots in O(1)
+   through a free list.
+*/
+class IMAS_CORE_LIBRARY_API LLenvTable
+{
+public:
+  LLenvTable();
+  ~LLenvTable();
+
+  /**
+     Stores a new lowlevel environment.
+     @param[in] be pointer on backend object
+     @param[in] ctx pointer on context object
+     @result handle of the stored environment (always > 0)
+  */
+  int insert(Backend *be, Context *ctx);
+
+  /**
+     Retrieves a stored lowlevel environment.
+     @param[in] handle handle returned by insert()
+     @result reference to the stored environment, valid until the handle is removed
+     @throw ALLowlevelException if the handle is unknown or stale
+  */
+  const LLenv& lookup(int handle) const;
+
+  /**
+     Removes a lowlevel environment, making its handle stale.
+     @param[in] handle handle returned by insert()
+     @result LLenv structure (not stored anymore)
+     @throw ALLowlevelException if the handle is unknown or stale
+  */
+  LLenv remove(int handle);
+
+private:
+  static const int INDEX_BITS = 20;               /**< bits of a handle used for the slot index */
+  static const int PAGE_BITS = 10;                /**< log2 of the number of slots per page */
+  static const unsigned int PAGE_SIZE = 1u << PAGE_BITS;
+  static const unsigned int MAX_SLOTS = 1u << INDEX_BITS;
+  static const unsigned int MAX_PAGES = MAX_SLOTS / PAGE_SIZE;
+  static const unsigned int GENERATION_MASK = (1u << (31 - INDEX_BITS)) - 1;
+
+  struct Slot
+  {
+    std::atomic<int> handle;                      /**< handle of the live entry, 0 when the slot is free */
+    unsigned int generation;                      /**< generation given to the next entry stored in the slot */
+    int nextFree;                                 /**< next slot in the free list, -1 at the end */
+    LLenv env;
+  };
+
+  Slot* slot(int handle) const;
+
+  std::atomic<Slot*> pages[MAX_PAGES];            /**< slot pages, allocated on demand and never moved */
+  std::mutex mutex;                               /**< serializes insertions and removals */
+  int freeHead;                                   /**< first recycled slot, -1 if none */
+  unsigned int nextSlot;                          /**< first never used slot */
 };
 
 
@@ -146,7 +250,7 @@ public:
      @param[in] idx storage element identifier
      @result LLenv structure containing a pair of pointers on backend and context objects
   */
-  static LLenv getLLenv(int idx);
+  static const LLenv& getLLenv(int idx);
 
   /**
      Returns and removes a lowlevel environment from storage.
@@ -184,15 +288,31 @@ public:
   static void setDefaultValue(int type, int dim, void **var, int *size);
 
   /**
-     Converts data to the specified new type.
-     @tparam From type of the data
-     @param[in] data source data value
-     @param[in] size total size of the data
+     Converts data to the specified new type, into a distinct buffer or in place (dest == data).
+     Data is converted between char, integer and double types, to complex type and from complex
+     to double type (real part). Integer and double conversions use SIMD instructions when 
+     available.
+     @param[in] data source data
+     @param[in] srctype type ID of the source data
+     @param[in] size number of elements
      @param[in] desttype type ID for the converted data
-     @result converted data (returned as void*)
+     @param[out] dest buffer receiving the converted data (size elements of type desttype), may be
+     data when it is large enough for the converted data
+     @result false if the conversion is not supported (dest is then left untouched)
    */
-  template <typename From>
-    static void* convertData(From* data, size_t size, int desttype);
+  static bool convertDataInto(const void* data, int srctype, size_t size, int desttype, void* dest);
+
+  /**
+     Converts malloc'd data to the specified new type, in place. The buffer is reallocated when
+     the new type is larger than the source type.
+     @param[in] data source data, allocated with malloc
+     @param[in] srctype type ID of the source data
+     @param[in] size number of elements
+     @param[in] desttype type ID for the converted data
+     @result converted data (returned as void*, replaces data), NULL if the conversion is not
+     supported (data is then neither reallocated nor modified, and still owned by the caller)
+   */
+  static void* convertData(void* data, int srctype, size_t size, int desttype);
 
   /**
      Sets a variable to a converted value.
@@ -205,6 +325,22 @@ public:
    */
   static void setConvertedValue(void *data, int srctype, int dim, int *size, int desttype, void** var);
 
+  /**
+     Hands data returned by a backend read over to the caller.
+     Sets the default value when no data was found and converts data returned with another type.
+     @param[in] found status returned by the backend read (0 when there is no such data)
+     @param[in] data data returned by the backend, released or handed over to var
+     @param[in] srctype type ID of the returned data
+     @param[in] srcdim dimension of the returned data
+     @param[in] desttype expected type ID
+     @param[in] dim expected dimension
+     @param[in,out] size array storing size of each dimension
+     @param[in,out] var variable which will store the value, passed as void**
+     @result true if the data had to be converted to the expected type
+     @throw ALLowlevelException if the returned dimension is not the expected one
+  */
+  static bool setReadValue(int found, void *data, int srctype, int srcdim, int desttype, int dim, int *size, void **var);
+
   /**
      Starts an action on a pulse in the database using an URI.
      @param[in] uri URI
@@ -216,11 +352,7 @@ public:
   
 
 private:
-  static std::mutex mutex;                        /**< mutex for thread safe Factory accesses */
-
-  static std::vector<LLenv> llenvStore;           /**< objects (Backend, Context) storage */
-  static int curStoreElt;                         /**< position of next free slot in Store */
-  static int maxStoreElt;                         /**< size of allocated Store */
+  static LLenvTable llenvStore;                   /**< objects (Backend, Context) storage */
 };
 
 extern "C"
@@ -242,6 +374,37 @@ extern "C"
    */
   IMAS_CORE_LIBRARY_API al_status_t al_context_info(int ctx, char **info);
 
+  /**
+     Return the call statistics collected for the data entry of the passed Context identifier.
+     Statistics are collected for data entries opened while the environment variable IMAS_AL_PROFILE
+     (report file, written at al_close_pulse) is set or IMAS_AL_STATISTICS=TRUE. They are given per 
+     call (lowlevel API and Backend functions) and per IDS: number of calls, total, mean, min and max 
+     latencies, log2 latency histogram and number of bytes read and written. For data entries 
+     opened with the URI option cache=memory, a "cache" object gives the hits, misses, evictions 
+     and invalidations of the cache and its occupancy (also when call statistics are not collected).
+     Likewise, for data entries opened with incremental_put=yes, an "incremental_put" object gives
+     the number of fields and bytes written and left untouched by the puts, and for data entries
+     opened with dedup=yes a "dedup" object gives the arrays and bytes stored once and shared.
+     @param[in] ctx Context ID (either DataEntryContext, OperationContext or ArraystructContext)
+     @param[out] json statistics as a JSON string -> NEED TO BE FREEED!!
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+   */
+  IMAS_CORE_LIBRARY_API al_status_t al_get_statistics(int ctx, char **json);
+
+  /**
+     Return the memory held by the Access Layer for the data entry of the passed Context identifier.
+     The "data_entry" object gives the live bytes of each component of the data entry (in-memory 
+     data of the memory backend, HDF5 read and write buffers and chunk cache capacity of the opened 
+     datasets, UDA cache, cache=memory cache, data staged by al_prefetch_ids and asynchronous puts), 
+     in total and per IDS. The "process" object gives the live bytes of the same components summed 
+     over all the data entries of the process, and the resident set size of the process when known.
+     Data returned by al_read_data and not released yet by the caller is not accounted.
+     @param[in] ctx Context ID (either DataEntryContext, OperationContext or ArraystructContext)
+     @param[out] json memory usage as a JSON string -> NEED TO BE FREEED!!
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+   */
+  IMAS_CORE_LIBRARY_API al_status_t al_memory_usage(int ctx, char **json);
+
 
   /**
      Get backendID from the passed Context identifier.
@@ -284,7 +447,10 @@ extern "C"
      This function gives a new operation context for the duration of an action on a DATAOBJECT.
      @param[in] ctx pulse context id (from al_begin_dataentry_action())
      @param[in] dataobjectname name of the DATAOBJECT
-     @param[in] datapath path to data node for partial get operation
+     @param[in] datapath path to data node for partial get operation, or list of path prefixes
+     separated by ';' (e.g. "profiles_1d/electrons;time", or "profiles_1d/electrons;" for a single
+     one): the backends then skip the fields and arrays of structures outside of these subtrees,
+     which are read as empty
      @param[in] rwmode mode for this operation:
      - READ_OP = read operation
      - WRITE_OP = write operation
@@ -488,8 +654,195 @@ extern "C"
   
   IMAS_CORE_LIBRARY_API al_status_t al_write_data(int ctxID, const char *field, const char *timebase, void *data, int datatype, int dim, int *size);
 
+  /**
+     Reads data into a caller provided buffer.
+     This function reads a signal as al_read_data() does, but stores it in dst instead of returning 
+     a newly allocated array, which saves one allocation and one copy when the backend can read 
+     directly in the caller memory. Use al_read_data_shape() to size the buffer first.
+     @param[in] ctxID operation context id (from al_begin_global_action() or al_begin_slice_action()) or
+     array of structure context id (from al_begin_arraystruct_action())
+     @param[in] field field path for the data
+     @param[in] timebase field path for the timebase
+     @param[out] dst buffer receiving the data (default value for a missing scalar)
+     @param[in] capacity size of dst in bytes
+     @param[in] datatype type of data to be read
+     @param[in] dim dimension of the data
+     @param[out] size passed array for storing the size of each dimension (all 0 when there is no data)
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_, failure when the data 
+     does not fit in capacity bytes, size being then filled with the shape of the data]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_read_data_into(int ctxID, const char *field, const char *timebase, void *dst, size_t capacity, int datatype, int dim, int *size);
+
+  /**
+     Reads the shape of data.
+     This function returns the shape al_read_data() would return for the same arguments, without 
+     reading the data when the backend allows it.
+     @param[in] ctxID operation context id or array of structure context id
+     @param[in] field field path for the data
+     @param[in] timebase field path for the timebase
+     @param[in] datatype type of data
+     @param[in] dim dimension of the data
+     @param[out] size passed array for storing the size of each dimension (all 0 when there is no data)
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_read_data_shape(int ctxID, const char *field, const char *timebase, int datatype, int dim, int *size);
+
+  /**
+     Writes several data in a row.
+     This function writes n signals in the same context, with the same semantic as n calls to 
+     al_write_data() (data with an empty shape are skipped), but lets the backend process all 
+     of them in a single pass.
+     @param[in] ctxID operation context id (from al_begin_global_action() or al_begin_slice_action()) or
+     array of structure context id (from al_begin_arraystruct_action())
+     @param[in] n number of fields to write
+     @param[in] fields field path of each data
+     @param[in] timebases timebase path of each data
+     @param[in] datatypes type of each data
+     @param[in] dims dimension of each data
+     @param[in] data pointer on each data to be written
+     @param[in] sizes array of the size of each dimension, for each data (can be NULL if dim=0)
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_write_data_batch(int ctxID, int n, const char **fields, const char **timebases, const int *datatypes, const int *dims, void **data, int **sizes);
+
+  /**
+     Reads several data in a row.
+     This function reads n signals from the same context, with the same semantic as n calls to 
+     al_read_data(), but lets the backend resolve all of them in a single pass.
+     @param[in] ctxID operation context id (from al_begin_global_action() or al_begin_slice_action()) or
+     array of structure context id (from al_begin_arraystruct_action())
+     @param[in] n number of fields to read
+     @param[in] fields field path of each data
+     @param[in] timebases timebase path of each data
+     @param[in] datatypes type of each data to be read
+     @param[in] dims dimension of each data to be read
+     @param[in,out] data for each field, the value *data would have in al_read_data() (pointer on the 
+     scalar to fill for 0D data, returned pointer on the read array otherwise)
+     @param[in,out] sizes for each field, passed array for storing the size of each dimension (can be NULL if dim=0)
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_read_data_batch(int ctxID, int n, const char **fields, const char **timebases, const int *datatypes, const int *dims, void **data, int **sizes);
+
+  typedef void* (*al_alloc_fn)(size_t size, void *user);
+  typedef void (*al_free_fn)(void *ptr, void *user);
+
+  /**
+     Sets the allocator of the data returned by al_read_data() and al_read_data_batch().
+     All backends allocate the arrays they return with alloc_fn(size, user), and the access layer 
+     releases the intermediate buffers it drops with free_fn(ptr, user), so that applications can 
+     route large reads to their own pools (huge pages, pinned memory, ...). The returned data must 
+     then be released with free_fn or al_free_data() instead of free(). Set the allocator before 
+     reading any data: buffers are always released with the allocator in use at that time.
+     @param[in] alloc_fn allocation function (NULL, with free_fn NULL, restores malloc and free)
+     @param[in] free_fn release function
+     @param[in] user argument passed to alloc_fn and free_fn
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_set_allocator(al_alloc_fn alloc_fn, al_free_fn free_fn, void *user);
+
+  /**
+     Releases data returned by al_read_data() or al_read_data_batch() with the allocator set by 
+     al_set_allocator() (free() by default).
+     @param[in] data pointer on the data (can be NULL)
+  */
+  IMAS_CORE_LIBRARY_API void al_free_data(void *data);
+
   IMAS_CORE_LIBRARY_API al_status_t al_get_occurrences(int pctxID, const char* ids_name, int** occurrences_list, int* size);
 
+  /**
+     Starts reading a whole IDS in the background.
+     The next al_begin_global_action() in READ_OP mode on this IDS occurrence (without datapath) is 
+     served from the data read on the background I/O thread of the data entry, so that the I/O 
+     overlaps with the work done by the caller in between. Data is read following the fields read 
+     by the previous gets of the same IDS in the process: the first get of an IDS is not accelerated.
+     Does nothing for data entries not opened with async=yes, and for backends without background
+     I/O (memory, flexbuffers, ascii).
+     @param[in] pctxID data entry context id
+     @param[in] idsname name of the IDS
+     @param[in] occurrence occurrence of the IDS
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_prefetch_ids(int pctxID, const char* idsname, int occurrence);
+
+  /**
+     Starts an asynchronous global action on a DATAOBJECT.
+     In READ_OP mode, this is al_prefetch_ids() followed by al_begin_global_action(): reads wait 
+     for the data being read in the background.
+     In WRITE_OP mode, the data written in the operation is copied and the operation is written 
+     to the backend on the background I/O thread of the data entry when al_end_action() is called 
+     on it. Errors of background writes are reported by al_wait() and al_close_pulse().
+     Same as al_begin_global_action() for data entries not opened with async=yes.
+     Same arguments as al_begin_global_action().
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_begin_global_action_async(int pctxID, const char* dataobjectname, const char* datapath, int rwmode, int *octxID);
+
+  /**
+     Waits until the background operations of a data entry are done.
+     @param[in] ctxID context id (DataEntryContext, OperationContext or ArraystructContext) of the data entry
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_], with the error of
+     the first background write that failed since the previous call
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_wait(int ctxID);
+
+  /**
+     Copies an IDS occurrence from a data entry to another.
+     The source IDS is walked following the Data Dictionary (IDSDef.xml at $IDSDEF_PATH or 
+     $IMAS_PREFIX/include/IDSDef.xml), including nested arrays of structures, and every field 
+     found is written to the destination backend as read from the source backend, without type 
+     conversion. The source is read on a separate thread while the destination is written, unless
+     flags contains COPY_SEQUENTIAL or both contexts belong to the same data entry.
+     The previous content of the destination IDS occurrence is deleted, as with a put. Nothing is
+     written when the IDS is empty in the source.
+     @param[in] srcPulseCtx source data entry context id
+     @param[in] dstPulseCtx destination data entry context id
+     @param[in] idsname name of the IDS
+     @param[in] occurrence occurrence of the IDS
+     @param[in] flags COPY_DEFAULT or COPY_SEQUENTIAL
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_copy_ids(int srcPulseCtx, int dstPulseCtx, const char* idsname, int occurrence, int flags);
+
+  /**
+     Returns the names of the IDSs of the Data Dictionary used by al_copy_ids().
+     @param[out] idsnames space separated IDS names -> NEED TO BE FREEED!!
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_list_ids(char **idsnames);
+
+  typedef void (*al_scan_fn)(int index, al_status_t status, void **data, int **sizes, void *user);
+
+  /**
+     Reads the same fields of an IDS from many data entries.
+     Each URI is opened, its IDS is read with a partial get restricted to the fields (see 
+     al_begin_global_action()) and the data entry is closed, on a pool of nthreads threads. The 
+     results are passed to the callback in the order of the URIs, one data entry at a time (the 
+     callback is never called concurrently), as callback(index, status, data, sizes, user):
+     - index: position of the URI in uris;
+     - status: status of the reads of this data entry (the data is empty when it failed);
+     - data: for each field, pointer on its value (scalar for 0D fields, array otherwise, NULL for
+       an empty array);
+     - sizes: for each field, the size of each of its dims[i] dimensions.
+     The data is released when the callback returns: the callback copies what it keeps, e.g. in 
+     row index of columns allocated beforehand. At most 2 * nthreads data entries are read ahead
+     of the one passed next to the callback, the threads wait beyond. Errors of a data entry are only reported to the 
+     callback, they do not stop the scan.
+     @param[in] uris URIs of the data entries
+     @param[in] nuris number of URIs
+     @param[in] idsname name of the IDS, with its occurrence ("<idsname>[/<occurrence>]")
+     @param[in] n number of fields to read
+     @param[in] fields field path of each data, outside of arrays of structures
+     @param[in] timebases timebase path of each data
+     @param[in] datatypes type of each data to be read
+     @param[in] dims dimension of each data to be read
+     @param[in] callback function receiving the data read from each data entry
+     @param[in] user argument passed to the callback
+     @param[in] nthreads number of threads opening and reading the data entries (0 for the number 
+     of cores)
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  */
+  IMAS_CORE_LIBRARY_API al_status_t al_scan(const char **uris, int nuris, const char *idsname, int n, const char **fields, const char **timebases, const int *datatypes, const int *dims, al_scan_fn callback, void *user, int nthreads);
+
   //IMAS_CORE_LIBRARY_API al_status_t al_close_pulse(int pctxID, int mode, const char *options);
   
   //HLI wrappers for plugins API
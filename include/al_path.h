@@ -0,0 +1,127 @@
+//-*-c++-*-
+
+/**
+   \file al_path.h
+   Interning of field and timebase paths passed to the backends.
+   Each distinct path is stored once per process and receives a stable integer identifier,
+   so that backends can key their internal maps on the identifier and reuse the precomputed
+   path components instead of splitting and hashing the same strings on every call.
+*/
+
+#ifndef AL_PATH_H
+#define AL_PATH_H 1
+
+#if defined(_WIN32)
+#  define IMAS_CORE_LIBRARY_API __declspec(dllexport)
+#else
+#  define IMAS_CORE_LIBRARY_API
+#endif
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+   Interned path. Entries are never released, their address and content are stable.
+*/
+struct IMAS_CORE_LIBRARY_API ALPathInfo
+{
+  uint32_t id;                               /**< identifier, 0 is the empty path */
+  std::string path;                          /**< full path, e.g. "profiles_1d/electrons/density" */
+  std::vector<std::string> components;       /**< path split on '/', empty components dropped */
+};
+
+/**
+   Process wide table of interned paths (thread safe).
+*/
+class IMAS_CORE_LIBRARY_API ALPathTable
+{
+public:
+  /**
+     Returns the entry of a path, creating it on first use.
+     A thread looking up again the same string (same address and content) gets the entry from a
+     per-thread cache, without hashing the path nor locking the table.
+     @param[in] path field or timebase path
+     @result interned entry
+  */
+  static const ALPathInfo& intern(std::string_view path);
+
+  /**
+     Returns the entry of an identifier.
+     @param[in] id identifier returned by a previous intern()
+     @result interned entry
+     @throw ALLowlevelException if the identifier is unknown
+  */
+  static const ALPathInfo& get(uint32_t id);
+
+  /**
+     Returns the number of interned paths (identifiers are lower than this number).
+  */
+  static size_t size();
+};
+
+/**
+   Lightweight handle on an interned path, passed by value through the Backend API.
+   It converts implicitly from the string types used by the callers, and gives access to the
+   path as a std::string_view, a std::string or its identifier.
+*/
+class IMAS_CORE_LIBRARY_API ALPath
+{
+public:
+  ALPath() : info(&ALPathTable::intern(std::string_view())) {}
+  ALPath(std::string_view path) : info(&ALPathTable::intern(path)) {}
+  ALPath(const std::string &path) : info(&ALPathTable::intern(path)) {}
+  ALPath(const char *path) : info(&ALPathTable::intern(path != NULL ? std::string_view(path) : std::string_view())) {}
+
+  /** identifier of the path, equal paths have equal identifiers */
+  uint32_t id() const { return info->id; }
+
+  std::string_view view() const { return info->path; }
+
+  const std::string& str() const { return info->path; }
+
+  const char* c_str() const { return info->path.c_str(); }
+
+  const std::vector<std::string>& components() const { return info->components; }
+
+  bool empty() const { return info->path.empty(); }
+
+  size_t length() const { return info->path.length(); }
+
+  size_t size() const { return info->path.size(); }
+
+  char operator[](size_t i) const { return info->path[i]; }
+
+  std::string_view substr(size_t pos, size_t n = std::string_view::npos) const { return view().substr(pos, n); }
+
+  size_t find(std::string_view s, size_t pos = 0) const { return view().find(s, pos); }
+
+  size_t rfind(std::string_view s, size_t pos = std::string_view::npos) const { return view().rfind(s, pos); }
+
+  operator const std::string&() const { return info->path; }
+
+  bool operator==(const ALPath &other) const { return info == other.info; }
+  bool operator!=(const ALPath &other) const { return info != other.info; }
+  bool operator==(std::string_view other) const { return view() == other; }
+  bool operator!=(std::string_view other) const { return view() != other; }
+  bool operator==(const char *other) const { return view() == other; }
+  bool operator!=(const char *other) const { return view() != other; }
+  bool operator==(const std::string &other) const { return info->path == other; }
+  bool operator!=(const std::string &other) const { return info->path != other; }
+
+private:
+  const ALPathInfo *info;
+};
+
+inline std::ostream& operator<<(std::ostream &os, const ALPath &path)
+{
+  return os << path.view();
+}
+
+#endif
+
+#endif
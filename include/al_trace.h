@@ -0,0 +1,135 @@
+/*-*-c++-*-*/
+
+/**
+   \file al_trace.h
+   Binary format of the access traces recorded by the lowlevel when the environment variable
+   IMAS_AL_TRACE is set, and replayed by the al-replay tool.
+
+   A trace starts with the 8 bytes magic "ALTRACE\0", the format version and an endianness
+   marker (two uint32). It is followed by one record per lowlevel call:
+   - uint8 operation (altrace::Op)
+   - uint32 size of the body in bytes
+   - uint64 start of the call in ns, relative to the first record
+   - uint64 duration of the call in ns
+   - int32 returned status code
+   - body: the call arguments and results, see altrace::Op
+
+   In bodies, integers are int32, times are doubles, strings are an uint16 length followed by
+   the characters and shapes are the int32 number of dimensions followed by the int32 size of
+   each dimension. Context ids are the ones of the recording process. All values are stored in
+   the byte order of the recording machine.
+*/
+
+#ifndef AL_TRACE_H
+#define AL_TRACE_H 1
+
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace altrace {
+
+  const char MAGIC[8] = {'A', 'L', 'T', 'R', 'A', 'C', 'E', '\0'};
+  const uint32_t VERSION = 1;
+  const uint32_t ENDIAN_MARKER = 0x01020304;
+  const size_t HEADER_SIZE = 8 + 4 + 4;
+  const size_t RECORD_HEADER_SIZE = 1 + 4 + 8 + 8 + 4;
+
+  /**
+     Traced lowlevel calls. Output values are stored after the inputs.
+  */
+  enum Op : uint8_t {
+    TR_BEGIN_DATAENTRY = 1,   /**< uri, mode, [ctx] */
+    TR_CLOSE_PULSE,           /**< ctx, mode */
+    TR_BEGIN_GLOBAL,          /**< ctx, ids, datapath, rwmode, [octx] */
+    TR_BEGIN_SLICE,           /**< ctx, ids, rwmode, time, interp, [octx] */
+    TR_BEGIN_TIMERANGE,       /**< ctx, ids, rwmode, tmin, tmax, n, n * dtime, interp, [octx] */
+    TR_BEGIN_ARRAYSTRUCT,     /**< ctx, path, timebase, size, [size, actx] */
+    TR_ITERATE,               /**< actx, step */
+    TR_END_ACTION,            /**< ctx */
+    TR_WRITE_DATA,            /**< ctx, field, timebase, datatype, shape, payload */
+    TR_READ_DATA,             /**< ctx, field, timebase, datatype, dim, [shape] */
+    TR_READ_DATA_INTO,        /**< ctx, field, timebase, datatype, dim, capacity (int64), [shape] */
+    TR_READ_DATA_SHAPE,       /**< ctx, field, timebase, datatype, dim, [shape] */
+    TR_WRITE_DATA_BATCH,      /**< ctx, n, n * (field, timebase, datatype, shape, payload) */
+    TR_READ_DATA_BATCH,       /**< ctx, n, n * (field, timebase, datatype, dim), [n * shape] */
+    TR_DELETE_DATA,           /**< ctx, path */
+    TR_NB_OPS
+  };
+
+  /*
+    A payload is an int32 flag, followed when it is 1 by the int64 number of bytes and the
+    data. Payloads are only recorded when IMAS_AL_TRACE_PAYLOAD=TRUE.
+  */
+
+  inline const char* opName(int op)
+  {
+    static const char* names[TR_NB_OPS] = {
+      "", "al_begin_dataentry_action", "al_close_pulse", "al_begin_global_action",
+      "al_begin_slice_action", "al_begin_timerange_action", "al_begin_arraystruct_action",
+      "al_iterate_over_arraystruct", "al_end_action", "al_write_data", "al_read_data",
+      "al_read_data_into", "al_read_data_shape", "al_write_data_batch", "al_read_data_batch",
+      "al_delete_data"
+    };
+    return (op > 0 && op < TR_NB_OPS) ? names[op] : "unknown";
+  }
+
+  /**
+     Sequential decoder of a record body. Reading past the end of the body returns zeros,
+     so that records of interrupted calls can still be decoded.
+  */
+  class Cursor
+  {
+  public:
+    Cursor(const char *data, size_t size) : p(data), end(data + size) {}
+
+    bool more() const { return p < end; }
+
+    int32_t i32() { int32_t v = 0; get(&v, sizeof(v)); return v; }
+
+    int64_t i64() { int64_t v = 0; get(&v, sizeof(v)); return v; }
+
+    double f64() { double v = 0; get(&v, sizeof(v)); return v; }
+
+    std::string str()
+    {
+      uint16_t len = 0;
+      get(&len, sizeof(len));
+      len = (p + len <= end) ? len : (uint16_t)(end - p);
+      std::string s(p, len);
+      p += len;
+      return s;
+    }
+
+    /** Returns a pointer on the next n bytes, or NULL if the body is too short */
+    const char* bytes(size_t n)
+    {
+      if (p + n > end)
+	{
+	  p = end;
+	  return NULL;
+	}
+      const char *b = p;
+      p += n;
+      return b;
+    }
+
+  private:
+    void get(void *v, size_t n)
+    {
+      if (p + n <= end)
+	memcpy(v, p, n);
+      p = (p + n <= end) ? p + n : end;
+    }
+
+    const char *p;
+    const char *end;
+  };
+
+}
+
+#endif
+
+#endif
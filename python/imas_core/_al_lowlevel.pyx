@@ -212,6 +212,63 @@ def al_context_info(ctx):
     return contextInfo
 
 
+"""
+     Return the call statistics collected for the data entry of the passed Context identifier.
+     Statistics are collected when IMAS_AL_PROFILE=<file> or IMAS_AL_STATISTICS=TRUE is set
+     before opening the data entry.
+     @param[in] ctx Context ID (either PulseContext, OperationContext or ArraystructContext)
+     @param[out] json statistics as a JSON string
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+     al_status_t al_get_statistics(int ctx, char **json)
+"""
+
+def al_get_statistics(ctx):
+
+    cdef ll.al_status_t al_status
+    cdef char * cJson = NULL
+
+    al_status = ll.al_get_statistics(ctx, & cJson)
+
+    if al_status.code < 0:
+        if exception.raise_error_flag:
+            raise get_proper_exception_class(al_status.message, al_status.code)
+        else:
+            logging.error(al_status.message)
+            return al_status.code, ""
+
+    statistics = cJson.decode('UTF-8', errors='replace')
+    free(cJson)
+    return statistics
+
+
+"""
+     Return the memory held by the Access Layer for the data entry of the passed Context
+     identifier, per component and per IDS, and the process-wide totals.
+     @param[in] ctx Context ID (either PulseContext, OperationContext or ArraystructContext)
+     @param[out] json memory usage as a JSON string
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+     al_status_t al_memory_usage(int ctx, char **json)
+"""
+
+def al_memory_usage(ctx):
+
+    cdef ll.al_status_t al_status
+    cdef char * cJson = NULL
+
+    al_status = ll.al_memory_usage(ctx, & cJson)
+
+    if al_status.code < 0:
+        if exception.raise_error_flag:
+            raise get_proper_exception_class(al_status.message, al_status.code)
+        else:
+            logging.error(al_status.message)
+            return al_status.code, ""
+
+    usage = cJson.decode('UTF-8', errors='replace')
+    free(cJson)
+    return usage
+
+
 """
      Get backendID from the passed Context identifier.
      @param[in] ctx Context ID (either PulseContext, OperationContext or ArraystructContext)
@@ -356,7 +413,8 @@ def al_close_pulse(pulseCtx, mode):
      @param[in] rwmode mode for this operation:
      - READ_OP = read operation
      - WRITE_OP = write operation
-     @param[in] datapath optional path to data node for partial_get operations
+     @param[in] datapath optional path to data node for partial_get operations, or list of path
+     prefixes of the nodes to read (e.g. ["profiles_1d/electrons", "time"])
      @param[out] opctx operation context id [_null context if = 0_]
      @result error status [_success if al_status_t.code = 0 or failure if < 0_]
   al_status_t al_begin_global_action(int ctx,
@@ -371,6 +429,9 @@ def al_begin_global_action(pulseCtx, dataobjectname, rwmode, datapath=""):
 
     cdef int opCtx = -1
 
+    if not isinstance(datapath, str):
+        datapath = ";".join(datapath) + ";"
+
     al_status = ll.al_begin_global_action(pulseCtx,
                                             dataobjectname.encode('UTF-8'),
                                             datapath.encode('UTF-8'),
@@ -387,6 +448,141 @@ def al_begin_global_action(pulseCtx, dataobjectname, rwmode, datapath=""):
     return al_status.code, opCtx
 
 
+###########################################################################################
+"""
+     Starts an asynchronous I/O action on a DATAOBJECT.
+     Same as al_begin_global_action(), except that:
+     - READ_OP: the DATAOBJECT is read in the background (see al_prefetch_ids())
+     - WRITE_OP: the DATAOBJECT is written in the background when the action ends (see al_wait())
+  al_status_t al_begin_global_action_async(int ctx,
+                    const char *dataobjectname,
+                    const char *datapath,
+                    int rwmode,
+                    int *opctx);
+
+"""
+
+
+def al_begin_global_action_async(pulseCtx, dataobjectname, rwmode, datapath=""):
+
+    cdef int opCtx = -1
+
+    al_status = ll.al_begin_global_action_async(pulseCtx,
+                                                  dataobjectname.encode('UTF-8'),
+                                                  datapath.encode('UTF-8'),
+                                                  rwmode,
+                                                  & opCtx)
+
+    if al_status.code < 0:
+        if exception.raise_error_flag:
+            raise get_proper_exception_class(al_status.message, al_status.code)
+        else:
+            logging.error(al_status.message)
+            return al_status.code, -1
+
+    return al_status.code, opCtx
+
+
+###########################################################################################
+"""
+     Starts reading a whole IDS in the background.
+     The next al_begin_global_action() in READ_OP mode on this IDS occurrence is served from
+     the data read in the background.
+     @param[in] ctx pulse context id (from al_begin_pulse_action())
+     @param[in] idsname name of the IDS
+     @param[in] occurrence occurrence of the IDS
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  al_status_t al_prefetch_ids(int ctx, const char *idsname, int occurrence);
+
+"""
+
+
+def al_prefetch_ids(pulseCtx, idsname, occurrence=0):
+
+    al_status = ll.al_prefetch_ids(pulseCtx, idsname.encode('UTF-8'), occurrence)
+    if al_status.code < 0:
+        if exception.raise_error_flag:
+            raise get_proper_exception_class(al_status.message, al_status.code)
+        else:
+            logging.error(al_status.message)
+    return al_status.code
+
+
+###########################################################################################
+"""
+     Waits until the background operations of a data entry are done.
+     @param[in] ctx context id of the data entry
+     @result error status, with the error of the first background write that failed
+  al_status_t al_wait(int ctx);
+
+"""
+
+
+def al_wait(ctx):
+
+    al_status = ll.al_wait(ctx)
+    if al_status.code < 0:
+        if exception.raise_error_flag:
+            raise get_proper_exception_class(al_status.message, al_status.code)
+        else:
+            logging.error(al_status.message)
+    return al_status.code
+
+
+###########################################################################################
+"""
+     Copies an IDS occurrence from a data entry to another, possibly of another backend.
+     @param[in] srcPulseCtx source data entry context id
+     @param[in] dstPulseCtx destination data entry context id
+     @param[in] idsname name of the IDS
+     @param[in] occurrence occurrence of the IDS
+     @param[in] flags COPY_DEFAULT or COPY_SEQUENTIAL
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  al_status_t al_copy_ids(int srcPulseCtx, int dstPulseCtx, const char* idsname, int occurrence, int flags);
+
+"""
+
+
+def al_copy_ids(srcPulseCtx, dstPulseCtx, idsname, occurrence=0, flags=0):
+
+    al_status = ll.al_copy_ids(srcPulseCtx, dstPulseCtx, idsname.encode('UTF-8'), occurrence, flags)
+    if al_status.code < 0:
+        if exception.raise_error_flag:
+            raise get_proper_exception_class(al_status.message, al_status.code)
+        else:
+            logging.error(al_status.message)
+    return al_status.code
+
+
+###########################################################################################
+"""
+     Returns the names of the IDSs of the Data Dictionary used by al_copy_ids().
+     @param[out] idsnames space separated IDS names
+     @result error status [_success if al_status_t.code = 0 or failure if < 0_]
+  al_status_t al_list_ids(char **idsnames);
+
+"""
+
+
+def al_list_ids():
+
+    cdef ll.al_status_t al_status
+    cdef char * cNames = NULL
+
+    al_status = ll.al_list_ids(& cNames)
+
+    if al_status.code < 0:
+        if exception.raise_error_flag:
+            raise get_proper_exception_class(al_status.message, al_status.code)
+        else:
+            logging.error(al_status.message)
+            return []
+
+    names = cNames.decode('UTF-8', errors='replace').split()
+    free(cNames)
+    return names
+
+
 ###########################################################################################
 """
      Starts an I/O action on a DATAOBJECT slice.
@@ -911,7 +1107,7 @@ def al_read_data_array(ctx, fieldPath, pTimebasePath, dataType, dim):
 
     arrayMemView  = view.array(shape = tuple(cSizeArray), itemsize = item_size, format = item_type,  mode="fortran", allocate_buffer=False)
     arrayMemView.data = <char*  > cData
-    arrayMemView.callback_free_data = free
+    arrayMemView.callback_free_data = ll.al_free_data
 
     return al_status.code, np.asarray(arrayMemView)
 
@@ -948,7 +1144,7 @@ def al_read_data_array_string(ctx, fieldPath, pTimebasePath, dataType, dim):
 
     retArray = convertCBufferToStringArray(cStringData, npSizeArray)
 
-    free(cStringData)
+    ll.al_free_data(cStringData)
 
     return al_status.code, retArray
 
@@ -978,7 +1174,7 @@ def al_read_data_string(ctx, fieldPath, pTimebasePath, dataType, dim):
         return al_status.code, ''
     retString = cStringData[0:cSize].decode('UTF-8', errors='replace')
 
-    free(cStringData)
+    ll.al_free_data(cStringData)
 
     return al_status.code, retString
 
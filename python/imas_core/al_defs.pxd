@@ -47,6 +47,9 @@ cdef extern from "al_defs.h":
         AL_FLEXBUFFERS_SERIALIZER_PROTOCOL "FLEXBUFFERS_SERIALIZER_PROTOCOL"
         AL_DEFAULT_SERIALIZER_PROTOCOL "DEFAULT_SERIALIZER_PROTOCOL"
 
+        AL_COPY_DEFAULT "COPY_DEFAULT"
+        AL_COPY_SEQUENTIAL "COPY_SEQUENTIAL"
+
         AL_UNKNOWN_ERR "UNKNOWN_ERR"
         AL_CONTEXT_ERR "CONTEXT_ERR"
         AL_BACKEND_ERR "BACKEND_ERR"
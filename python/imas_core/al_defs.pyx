@@ -43,6 +43,9 @@ ASCII_SERIALIZER_PROTOCOL = AL_ASCII_SERIALIZER_PROTOCOL
 FLEXBUFFERS_SERIALIZER_PROTOCOL = AL_FLEXBUFFERS_SERIALIZER_PROTOCOL
 DEFAULT_SERIALIZER_PROTOCOL = AL_DEFAULT_SERIALIZER_PROTOCOL
 
+COPY_DEFAULT = AL_COPY_DEFAULT
+COPY_SEQUENTIAL = AL_COPY_SEQUENTIAL
+
 UNKNOWN_ERR = AL_UNKNOWN_ERR
 CONTEXT_ERR = AL_CONTEXT_ERR
 BACKEND_ERR = AL_BACKEND_ERR
@@ -6,6 +6,10 @@ cdef extern from "al_lowlevel.h":
 
     al_status_t al_context_info(int ctx, char ** info)
 
+    al_status_t al_get_statistics(int ctx, char ** json)
+
+    al_status_t al_memory_usage(int ctx, char ** json)
+
     al_status_t al_get_backendID(int ctx, int * beid)
 
     al_status_t al_build_uri_from_legacy_parameters(const int backendID, const int pulse, const int run,  const char * user, const char * tokamak, const char * version, const char * options, char ** uri)
@@ -16,6 +20,16 @@ cdef extern from "al_lowlevel.h":
 
     al_status_t al_begin_global_action(int ctx, const char * dataobjectname, const char * datapath, int rwmode, int * opctx)
 
+    al_status_t al_begin_global_action_async(int ctx, const char * dataobjectname, const char * datapath, int rwmode, int * opctx)
+
+    al_status_t al_prefetch_ids(int ctx, const char * idsname, int occurrence)
+
+    al_status_t al_wait(int ctx)
+
+    al_status_t al_copy_ids(int srcPulseCtx, int dstPulseCtx, const char * idsname, int occurrence, int flags)
+
+    al_status_t al_list_ids(char ** idsnames)
+
     al_status_t al_begin_slice_action(int ctx, const char * dataobjectname, int rwmode, double time, int interpmode, int * opctx)
 
     al_status_t al_begin_timerange_action(int pctxID, const char* dataobjectname, int rwmode, double tmin, double tmax, double * dtime, int * dtime_shape, int interpmode, int *octxID)
@@ -26,6 +40,8 @@ cdef extern from "al_lowlevel.h":
     
     al_status_t al_read_data(int ctx, const char * fieldpath, const char * timebasepath, void ** data, int datatype, int dim, int * size)
 
+    void al_free_data(void * data)
+
     al_status_t al_delete_data(int ctx, const char * path)
 
     al_status_t al_begin_arraystruct_action(int ctx, const char * path, const char * timebase, int * size, int * aosctx)
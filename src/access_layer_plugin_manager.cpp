@@ -1,4 +1,5 @@
 #include "access_layer_plugin_manager.h"
+#include "al_backend.h"
 
 #include <string>
 #include <algorithm>
@@ -533,7 +534,7 @@ bool AccessLayerPluginManager::skipWriteAccess(int ctxID, const char *fieldPath)
 
 int AccessLayerPluginManager::getAccessmode(int ctxID)
 {
-    LLenv lle = Lowlevel::getLLenv(ctxID);
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
     OperationContext *ctx = NULL;
     if (lle.context->getType() == CTX_ARRAYSTRUCT_TYPE)
     {
@@ -556,7 +557,7 @@ void AccessLayerPluginManager::begin_arraystruct_action_handler(const std::strin
 {
     LLplugin &llp = LLplugin::llpluginsStore[plugin_name];
     access_layer_plugin *al_plugin = (access_layer_plugin *)llp.al_plugin;
-    LLenv lle = Lowlevel::getLLenv(ctxID);
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
     OperationContext *ctx = NULL;
     if (lle.context->getType() == CTX_ARRAYSTRUCT_TYPE)
     {
@@ -621,7 +622,7 @@ int AccessLayerPluginManager::read_data_plugin_handler(const std::string &plugin
     // printf("read_data_handler is called for path=%s, plugin=%s\n", fieldPath, plugin_name.c_str());
     LLplugin &llp = LLplugin::llpluginsStore[plugin_name];
     access_layer_plugin *al_plugin = (access_layer_plugin *)llp.al_plugin;
-    LLenv lle = Lowlevel::getLLenv(ctxID);
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
     if ((lle.context->getType() == CTX_ARRAYSTRUCT_TYPE) && datatype == CHAR_DATA && dim == 1)
     {
         ArraystructContext *arctx = dynamic_cast<ArraystructContext *>(lle.context);
@@ -639,7 +640,7 @@ int AccessLayerPluginManager::read_data_plugin_handler(const std::string &plugin
                 }
                 const std::string &path = paths[arctx->getIndex()];
                 LLplugin::getOperationPath = path;
-                *data = strdup(path.c_str());
+                *data = ALAllocator::duplicate(path.c_str());
                 *size = path.length();
                 return 1;
             }
@@ -693,32 +694,32 @@ void AccessLayerPluginManager::read_plugins_provenance_infos(const std::string &
     access_layer_plugin *al_plugin = (access_layer_plugin *)p_plugin;
     if (field == "name")
     {
-        *data = strdup(al_plugin->getName().data());
+        *data = ALAllocator::duplicate(al_plugin->getName().data());
         *size = al_plugin->getName().length();
     }
     else if (field == "description")
     {
-        *data = strdup(al_plugin->getDescription().data());
+        *data = ALAllocator::duplicate(al_plugin->getDescription().data());
         *size = al_plugin->getDescription().length();
     }
     else if (field == "commit")
     {
-        *data = strdup(al_plugin->getCommit().data());
+        *data = ALAllocator::duplicate(al_plugin->getCommit().data());
         *size = al_plugin->getCommit().length();
     }
     else if (field == "version")
     {
-        *data = strdup(al_plugin->getVersion().data());
+        *data = ALAllocator::duplicate(al_plugin->getVersion().data());
         *size = al_plugin->getVersion().length();
     }
     else if (field == "repository")
     {
-        *data = strdup(al_plugin->getRepository().data());
+        *data = ALAllocator::duplicate(al_plugin->getRepository().data());
         *size = al_plugin->getRepository().length();
     }
     else if (field == "parameters")
     {
-        *data = strdup(al_plugin->getParameters().data());
+        *data = ALAllocator::duplicate(al_plugin->getParameters().data());
         *size = al_plugin->getParameters().length();
     }
 }
@@ -735,7 +736,7 @@ void AccessLayerPluginManager::write_data_plugin_handler(const std::string &plug
 
 void AccessLayerPluginManager::end_action_plugin_handler(int ctxID)
 {
-    LLenv lle = Lowlevel::getLLenv(ctxID);
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
     OperationContext *octx = NULL;
     if (lle.context->getType() == CTX_OPERATION_TYPE)
     {
@@ -1,6 +1,9 @@
 #include "al_backend.h"
 #include "no_backend.h"
 #include "memory_backend.h"
+#include "profiling_backend.h"
+#include "async_backend.h"
+#include "cache_backend.h"
 #ifdef ASCII
 #include "ascii_backend.h"
 #endif
@@ -17,6 +20,16 @@
 
 #include "data_interpolation.h"
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string.h>
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
 
 #if !defined(__GNUC__) && !defined(__clang__)
 #define strcasecmp _stricmp
@@ -24,6 +37,352 @@
 #endif
 
 
+namespace {
+
+struct Allocator
+{
+  ALAllocator::AllocFn alloc;
+  ALAllocator::FreeFn release;
+  void *user;
+};
+
+void* mallocData(size_t size, void *)
+{
+  return malloc(size);
+}
+
+void freeData(void *ptr, void *)
+{
+  free(ptr);
+}
+
+const Allocator defaultAllocator = {mallocData, freeData, NULL};
+
+// replaced allocators are never deleted, a concurrent read may still be using them
+std::atomic<const Allocator *> currentAllocator(&defaultAllocator);
+
+}
+
+void* ALAllocator::allocate(size_t size)
+{
+  const Allocator *a = currentAllocator.load(std::memory_order_acquire);
+  void *ptr = a->alloc(size, a->user);
+  if (ptr == NULL && size != 0)
+    throw ALBackendException("Unable to allocate "+std::to_string(size)+" bytes of data",LOG);
+  return ptr;
+}
+
+void ALAllocator::release(void *ptr)
+{
+  if (ptr == NULL)
+    return;
+  const Allocator *a = currentAllocator.load(std::memory_order_acquire);
+  a->release(ptr, a->user);
+}
+
+char* ALAllocator::duplicate(const char *s)
+{
+  size_t length = strlen(s) + 1;
+  char *copy = (char *)allocate(length);
+  memcpy(copy, s, length);
+  return copy;
+}
+
+void* ALAllocator::reallocate(void *ptr, size_t size, size_t newSize)
+{
+  const Allocator *a = currentAllocator.load(std::memory_order_acquire);
+  if (a == &defaultAllocator)
+    {
+      void *grown = realloc(ptr, newSize);
+      if (grown == NULL && newSize != 0)
+	throw ALBackendException("Unable to allocate "+std::to_string(newSize)+" bytes of data",LOG);
+      return grown;
+    }
+  void *moved = allocate(newSize);
+  if (ptr != NULL)
+    {
+      memcpy(moved, ptr, std::min(size, newSize));
+      release(ptr);
+    }
+  return moved;
+}
+
+void ALAllocator::set(AllocFn alloc, FreeFn release, void *user)
+{
+  if (alloc == NULL && release == NULL)
+    {
+      currentAllocator.store(&defaultAllocator, std::memory_order_release);
+      return;
+    }
+  if (alloc == NULL || release == NULL)
+    throw ALBackendException("Both the allocation and the release functions must be given",LOG);
+  currentAllocator.store(new Allocator{alloc, release, user}, std::memory_order_release);
+}
+
+bool ALAllocator::isDefault()
+{
+  return currentAllocator.load(std::memory_order_acquire) == &defaultAllocator;
+}
+
+
+namespace {
+
+struct CounterRegistry
+{
+  std::mutex mutex;
+  std::vector<std::pair<const char *, const ALMemoryUsage::Counter *>> counters;
+};
+
+// constructed on first use, counters are static objects of other translation units
+CounterRegistry& counterRegistry()
+{
+  static CounterRegistry registry;
+  return registry;
+}
+
+// resident set size of the process, 0 when unknown
+size_t residentBytes()
+{
+#if defined(__linux__)
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0, resident = 0;
+  if (statm >> pages >> resident)
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+  return 0;
+}
+
+}
+
+ALMemoryUsage::Counter::Counter(const char *component) : live(0)
+{
+  CounterRegistry &registry = counterRegistry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  registry.counters.emplace_back(component, this);
+}
+
+void ALMemoryUsage::add(const std::string &component, const std::string &ids, size_t bytes)
+{
+  if (bytes != 0)
+    components[component][ids] += bytes;
+}
+
+size_t ALMemoryUsage::total() const
+{
+  size_t sum = 0;
+  for (auto &component : components)
+    for (auto &ids : component.second)
+      sum += ids.second;
+  return sum;
+}
+
+std::string ALMemoryUsage::toJSON() const
+{
+  std::ostringstream json;
+  json << "{\"total\": " << total() << ", \"components\": {";
+  const char *sep = "";
+  for (auto &component : components)
+    {
+      size_t sum = 0;
+      std::ostringstream ids;
+      const char *idsSep = "";
+      for (auto &kv : component.second)
+	{
+	  sum += kv.second;
+	  if (kv.first.empty())
+	    continue;
+	  ids << idsSep << "\"" << kv.first << "\": " << kv.second;
+	  idsSep = ", ";
+	}
+      json << sep << "\"" << component.first << "\": {\"total\": " << sum << ", \"ids\": {" << ids.str() << "}}";
+      sep = ", ";
+    }
+  json << "}}";
+  return json.str();
+}
+
+std::string ALMemoryUsage::processJSON()
+{
+  std::map<std::string, int64_t> live;
+  {
+    CounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    for (auto &counter : registry.counters)
+      live[counter.first] += counter.second->get();
+  }
+  int64_t sum = 0;
+  std::ostringstream components;
+  const char *sep = "";
+  for (auto &kv : live)
+    {
+      sum += kv.second;
+      components << sep << "\"" << kv.first << "\": " << kv.second;
+      sep = ", ";
+    }
+  std::ostringstream json;
+  json << "{\"total\": " << sum << ", \"components\": {" << components.str() << "}, \"resident\": "
+       << residentBytes() << "}";
+  return json.str();
+}
+
+ALIncrementalPutCounters& ALIncrementalPutCounters::operator+=(const ALIncrementalPutCounters &other)
+{
+  puts += other.puts;
+  fullRewrites += other.fullRewrites;
+  fieldsWritten += other.fieldsWritten;
+  fieldsSkipped += other.fieldsSkipped;
+  bytesWritten += other.bytesWritten;
+  bytesSaved += other.bytesSaved;
+  return *this;
+}
+
+std::string ALIncrementalPutCounters::toJSON() const
+{
+  std::ostringstream json;
+  json << "{\"puts\": " << puts
+       << ", \"full_rewrites\": " << fullRewrites
+       << ", \"fields_written\": " << fieldsWritten
+       << ", \"fields_skipped\": " << fieldsSkipped
+       << ", \"bytes_written\": " << bytesWritten
+       << ", \"bytes_saved\": " << bytesSaved << "}";
+  return json.str();
+}
+
+ALDedupCounters& ALDedupCounters::operator+=(const ALDedupCounters &other)
+{
+  arrays += other.arrays;
+  sharedArrays += other.sharedArrays;
+  bytes += other.bytes;
+  sharedBytes += other.sharedBytes;
+  return *this;
+}
+
+double ALDedupCounters::ratio() const
+{
+  return (bytes > sharedBytes) ? (double)bytes / (double)(bytes - sharedBytes) : 1.0;
+}
+
+std::string ALDedupCounters::toJSON() const
+{
+  std::ostringstream json;
+  json << "{\"arrays\": " << arrays
+       << ", \"shared_arrays\": " << sharedArrays
+       << ", \"bytes\": " << bytes
+       << ", \"shared_bytes\": " << sharedBytes
+       << ", \"ratio\": " << ratio() << "}";
+  return json.str();
+}
+
+
+size_t Backend::getDataByteSize(int datatype, int dim, const int *size)
+{
+  size_t bytes;
+  switch (datatype)
+    {
+    case alconst::char_data:
+      bytes = sizeof(char);
+      break;
+    case alconst::integer_data:
+      bytes = sizeof(int);
+      break;
+    case alconst::double_data:
+      bytes = sizeof(double);
+      break;
+    case alconst::complex_data:
+      bytes = 2*sizeof(double);
+      break;
+    default:
+      throw ALBackendException("Unknown data type="+std::to_string(datatype),LOG);
+    }
+  for (int i=0; i<dim; i++)
+    bytes *= size[i];
+  return bytes;
+}
+
+uint64_t Backend::hashData(const void *data, size_t bytes, uint64_t seed)
+{
+  // four independent multiply-xorshift lanes over 8-byte words, folded at the end
+  const uint64_t k = 0x9E3779B97F4A7C15ULL;
+  const unsigned char *p = (const unsigned char *)data;
+  uint64_t h[4] = {seed ^ bytes, seed + k, seed - k, ~seed};
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32)
+    for (int l = 0; l < 4; l++)
+      {
+	uint64_t w;
+	memcpy(&w, p + i + 8 * l, 8);
+	h[l] = (h[l] ^ w) * k;
+	h[l] ^= h[l] >> 31;
+      }
+  uint64_t r = h[0] ^ (h[1] * 3) ^ (h[2] * 5) ^ (h[3] * 7);
+  for (; i + 8 <= bytes; i += 8)
+    {
+      uint64_t w;
+      memcpy(&w, p + i, 8);
+      r = (r ^ w) * k;
+      r ^= r >> 31;
+    }
+  for (; i < bytes; i++)
+    r = (r ^ p[i]) * k;
+  r ^= r >> 29;
+  r *= k;
+  return r ^ (r >> 32);
+}
+
+int Backend::readDataInto(Context *ctx, ALPath fieldname, ALPath timebasename,
+			  void *dst, size_t capacity, void **data, int *datatype, int *dim, int *size)
+{
+  int expectedType = *datatype;
+  *data = NULL;
+  if (readData(ctx, fieldname, timebasename, data, datatype, dim, size) == 0)
+    return 0;
+  if (*datatype != expectedType || getDataByteSize(*datatype, *dim, size) > capacity)
+    return 2;
+  memcpy(dst, *data, getDataByteSize(*datatype, *dim, size));
+  ALAllocator::release(*data);
+  *data = NULL;
+  return 1;
+}
+
+int Backend::readDataShape(Context *ctx, ALPath fieldname, ALPath timebasename,
+			   int *datatype, int *dim, int *size)
+{
+  void *data = NULL;
+  int found = readData(ctx, fieldname, timebasename, &data, datatype, dim, size);
+  if (found)
+    ALAllocator::release(data);
+  return found;
+}
+
+void Backend::writeDataBatch(Context *ctx, std::vector<DataBatchItem> &items)
+{
+  for (auto &item : items)
+    writeData(ctx, item.fieldname, item.timebasename,
+	      item.data, item.datatype, item.dim, item.size);
+}
+
+void Backend::readDataBatch(Context *ctx, std::vector<DataBatchItem> &items)
+{
+  for (auto &item : items)
+    item.found = readData(ctx, item.fieldname, item.timebasename,
+			  &item.data, &item.datatype, &item.dim, item.size);
+}
+
+void Backend::getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage)
+{
+}
+
+bool Backend::getIncrementalPutCounters(DataEntryContext *ctx, ALIncrementalPutCounters &counters)
+{
+  return false;
+}
+
+bool Backend::getDedupCounters(DataEntryContext *ctx, ALDedupCounters &counters)
+{
+  return false;
+}
+
+
 Backend* Backend::initBackend(DataEntryContext *ctx)
 {
   Backend *be = NULL;
@@ -87,6 +446,27 @@ Backend* Backend::initBackend(DataEntryContext *ctx)
 
   if (be->supportsTimeDataInterpolation() || be->supportsTimeRangeOperation()) 
      be->initDataInterpolationComponent();
+
+  // backends doing actual I/O can run whole IDS gets and puts in the background, on request as
+  // the decorator learns the reads of every get
+  uri::OptionalValue maybe_async = ctx->getURI().query.get("async");
+  if ((id==alconst::hdf5_backend || id==alconst::mdsplus_backend || id==alconst::uda_backend) &&
+      maybe_async && (maybe_async.value() == "yes" || maybe_async.value() == "y"))
+    be = new AsyncBackend(be, id!=alconst::hdf5_backend);
+
+  // static data read repeatedly can be kept in memory
+  uri::OptionalValue maybe_cache = ctx->getURI().query.get("cache");
+  if (maybe_cache)
+    {
+      if (maybe_cache.value() != "memory")
+	throw ALBackendException("Unknown cache "+maybe_cache.value()+" (supported: memory)",LOG);
+      uri::OptionalValue maybe_cache_size = ctx->getURI().query.get("cache_size");
+      be = new CacheBackend(be, maybe_cache_size ? CacheBackend::parseSize(maybe_cache_size.value())
+			    : CacheBackend::DEFAULT_CAPACITY);
+    }
+
+  if (ALStatistics::enabled)
+    be = new ProfilingBackend(be);
      
   return be;
 }
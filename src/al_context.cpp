@@ -44,6 +44,11 @@ unsigned long int Context::getUid() const
   return uid;
 }
 
+bool Context::isProjected(const std::string &path, bool container) const
+{
+  return true;
+}
+
 /// DataEntryContext ///
 
 DataEntryContext::DataEntryContext(std::string uri_) : uri(checkUriHost(uri::parse_uri(uri_)))
@@ -213,6 +218,8 @@ void DataEntryContext::setBackendID(const std::string &path, const std::string &
         backend_id = MEMORY_BACKEND;
     } else if (path =="flexbuffers") {
         backend_id = FLEXBUFFERS_BACKEND;
+    } else if (path =="no") {
+        backend_id = NO_BACKEND;
     } else if (path == "uda" || !host.empty()) {
         backend_id = UDA_BACKEND;
     } else {
@@ -277,6 +284,9 @@ std::string DataEntryContext::getURIBackend(int backend_id)
     else if (backend_id == UDA_BACKEND) {
         return "uda";
     }
+    else if (backend_id == NO_BACKEND) {
+        return "no";
+    }
     else {
         throw ALContextException("getURIBackend, converting backend ID to backend URI string not yet implemented",LOG);
     }
@@ -311,6 +321,27 @@ OperationContext::OperationContext(DataEntryContext* ctx, std::string dataobject
     accessmode = access;
     pctx = ctx;
     this->uid = ++SID;
+
+    // projection: datapath items without AoS indices, e.g. "profiles_1d(3)/electrons", only for
+    // a list of items (a single datapath keeps its former meaning, nothing is skipped)
+    std::vector<std::string> items;
+    if (datapath.find(';') != std::string::npos)
+        boost::split(items, datapath, boost::is_any_of(";"));
+    for (auto &item : items) {
+        std::string prefix;
+        int depth = 0;
+        for (char c : item) {
+            if (c == '(')
+                depth++;
+            else if (c == ')')
+                depth--;
+            else if (depth == 0)
+                prefix += c;
+        }
+        boost::trim_if(prefix, boost::is_any_of(" /"));
+        if (!prefix.empty())
+            projection.push_back(prefix);
+    }
 }
 
 OperationContext::OperationContext(DataEntryContext* ctx, std::string dataobject, int access, 
@@ -431,6 +462,29 @@ std::string OperationContext::getDatapath() const
     return datapath;
 }
 
+const std::vector<std::string>& OperationContext::getProjection() const
+{
+    return projection;
+}
+
+bool OperationContext::isProjected(const std::string &path, bool container) const
+{
+    // the homogeneous_time flag tells whether the IDS exists, it is always read
+    if (projection.empty() || path == "ids_properties/homogeneous_time")
+        return true;
+    for (const auto &prefix : projection) {
+        // node within the prefix
+        if (path.compare(0, prefix.size(), prefix) == 0 &&
+            (path.size() == prefix.size() || path[prefix.size()] == '/'))
+            return true;
+        // container on the way to the prefix
+        if (container && prefix.size() > path.size() && prefix[path.size()] == '/' &&
+            prefix.compare(0, path.size(), path) == 0)
+            return true;
+    }
+    return false;
+}
+
 int OperationContext::getAccessmode() const
 { 
   return accessmode; 
@@ -535,6 +589,21 @@ std::string ArraystructContext::getTimebasePath() const
   return timebase; 
 }
 
+std::string ArraystructContext::getFullPath() const
+{
+  if (parent == NULL)
+    return path;
+  return parent->getFullPath() + "/" + path;
+}
+
+bool ArraystructContext::isProjected(const std::string &p, bool container) const
+{
+  // no path is built for an operation without projection
+  if (opctx->getProjection().empty())
+    return true;
+  return opctx->isProjected(getFullPath() + "/" + p, container);
+}
+
 bool ArraystructContext::getTimed() const 
 { 
   return !timebase.empty(); 
@@ -4,13 +4,25 @@
 #include "access_layer_plugin.h"
 #include "extended_access_layer_plugin.h"
 #include "access_layer_plugin_manager.h"
+#include "profiling_backend.h"
+#include "cache_backend.h"
+#include "async_backend.h"
+#include "ids_copy.h"
+#include "trace_recorder.h"
 #include <boost/filesystem.hpp>
 
 #include <assert.h>
 #include <string.h>
 #include <complex.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <utility>
 #include <regex>
+#include <thread>
 
 #include <signal.h>
 
@@ -30,13 +42,185 @@
 // c++ only part
 #if defined(__cplusplus)
 
-#define STORE_CHUNCK 100
+LLenvTable Lowlevel::llenvStore;
+
+/**
+   Times a lowlevel API call for the statistics of its data entry (see ALStatistics).
+   Costs a single test of ALStatistics::enabled when statistics are disabled.
+*/
+class ALStatisticsScope
+{
+public:
+  ALStatisticsScope(ALStatistics::Call c) : call(c)
+  {
+    if (ALStatistics::enabled)
+      start = ALStatistics::now();
+  }
+  ALStatisticsScope(ALStatistics::Call c, int ctxID, const char *idsName = NULL) : ALStatisticsScope(c)
+  {
+    if (ALStatistics::enabled)
+      bind(ctxID, idsName);
+  }
+  ~ALStatisticsScope()
+  {
+    if (stats)
+      stats->record(call, ids, ALStatistics::now() - start, bytesRead, bytesWritten);
+  }
+
+  // Attaches the scope to the statistics of the data entry of ctxID
+  void bind(int ctxID, const char *idsName = NULL)
+  {
+    try {
+      const LLenv &lle = Lowlevel::getLLenv(ctxID);
+      // ending a data entry context deletes its backend, and its statistics with it
+      if (call == ALStatistics::AL_END_ACTION && lle.context->getType() == CTX_PULSE_TYPE)
+	return;
+      ProfilingBackend *pbe = dynamic_cast<ProfilingBackend *>(lle.backend);
+      if (pbe == NULL)
+	return;
+      stats = &pbe->getStatistics();
+      ids = idsName ? idsName : ALStatistics::idsName(lle.context);
+    }
+    catch (const ALLowlevelException& e) {
+      // invalid context: reported by the call itself
+    }
+  }
+
+  bool active() const { return stats != NULL; }
+
+  size_t bytesRead = 0;
+  size_t bytesWritten = 0;
 
-std::mutex Lowlevel::mutex;
+private:
+  ALStatistics::Call call;
+  ALStatistics *stats = NULL;
+  std::string ids;
+  uint64_t start = 0;
+};
+
+/**
+   Records a lowlevel API call in the access trace (see ALTraceRecorder).
+   Arguments are encoded when the scope is built, results registered with atEnd() are
+   encoded when the call returns. Calls made by another traced call (e.g. plugins path of the
+   batch functions) are not recorded. Costs a single test of ALTraceRecorder::enabled when
+   tracing is disabled.
+*/
+class ALTraceScope
+{
+public:
+  ALTraceScope(altrace::Op o, const al_status_t &st) : op(o), status(st)
+  {
+    if (!ALTraceRecorder::enabled)
+      return;
+    nested = (depth++ > 0);
+    if (!nested)
+      {
+	recording = true;
+	start = ALStatistics::now();
+      }
+  }
+  ~ALTraceScope()
+  {
+    if (recording)
+      {
+	uint64_t duration = ALStatistics::now() - start;
+	if (results)
+	  results();
+	ALTraceRecorder::record(op, start, duration, status.code, body);
+      }
+    if (recording || nested)
+      depth--;
+  }
+
+  bool active() const { return recording; }
+
+  ALTraceScope& i32(int v) { return raw(&v, sizeof(int32_t)); }
+  ALTraceScope& i64(int64_t v) { return raw(&v, sizeof(v)); }
+  ALTraceScope& f64(double v) { return raw(&v, sizeof(v)); }
+  ALTraceScope& str(const char *s)
+  {
+    if (!recording)
+      return *this;
+    size_t len = (s != NULL) ? strlen(s) : 0;
+    uint16_t len16 = (len > UINT16_MAX) ? UINT16_MAX : len;
+    raw(&len16, sizeof(len16));
+    return raw(s, len16);
+  }
+  ALTraceScope& shape(int dim, const int *size)
+  {
+    if (!recording)
+      return *this;
+    i32(dim);
+    for (int i = 0; i < dim; i++)
+      i32(size != NULL ? size[i] : 0);
+    return *this;
+  }
+  ALTraceScope& payload(const void *data, int datatype, int dim, const int *size)
+  {
+    if (!recording)
+      return *this;
+    size_t n = 0;
+    try {
+      if (ALTraceRecorder::payloads && data != NULL)
+	n = Backend::getDataByteSize(datatype, dim, size);
+    }
+    catch (const ALBackendException& e) {
+      // unknown type: reported by the call itself
+    }
+    if (n == 0)
+      return i32(0);
+    i32(1);
+    i64(n);
+    return raw(data, n);
+  }
+
+  // registers the encoding of the results of the call (stored only while recording)
+  template<class F> void atEnd(F&& f) { if (recording) results = std::forward<F>(f); }
+
+private:
+  ALTraceScope& raw(const void *v, size_t n)
+  {
+    if (recording)
+      body.append(static_cast<const char *>(v), n);
+    return *this;
+  }
+
+  static thread_local int depth;
+
+  altrace::Op op;
+  const al_status_t &status;
+  bool recording = false;
+  bool nested = false;
+  uint64_t start = 0;
+  std::string body;
+  std::function<void()> results;
+};
+
+thread_local int ALTraceScope::depth = 0;
+
+/**
+   Serializes a lowlevel call with all the others while the plugins framework is enabled, as
+   registered plugins and their bindings are shared by all data entries. Costs a single test of
+   the latched IMAS_AL_ENABLE_PLUGINS flag otherwise, so that independent data entries can be
+   used in parallel.
+*/
+class LLpluginFrameworkLock
+{
+public:
+  LLpluginFrameworkLock(bool always = false) : locked(always || LLplugin::pluginsFrameworkEnabled())
+  {
+    if (locked)
+      LLplugin::frameworkMutex.lock();
+  }
+  ~LLpluginFrameworkLock()
+  {
+    if (locked)
+      LLplugin::frameworkMutex.unlock();
+  }
 
-int Lowlevel::curStoreElt = 1;
-int Lowlevel::maxStoreElt = 1; //STORE_CHUNCK;
-std::vector<LLenv> Lowlevel::llenvStore = { LLenv()}; //(STORE_CHUNCK);
+private:
+  bool locked;
+};
 
 const char Lowlevel::EMPTY_CHAR = '\0';
 const int Lowlevel::EMPTY_INT   = -999999999;
@@ -51,6 +235,50 @@ std::vector<std::string> LLplugin::readbackPlugins;
 std::string LLplugin::getOperationPath;
 std::vector<std::string> LLplugin::pluginsNames;
 std::map<std::string, std::vector<std::string>> LLplugin::get_plugins;
+LLpluginPathNode LLplugin::boundPluginsTrie;
+std::recursive_mutex LLplugin::frameworkMutex;
+
+static bool readPluginsFrameworkFlag() {
+  const char *flag = getenv("IMAS_AL_ENABLE_PLUGINS");
+  return flag != NULL && strcmp(flag, "TRUE") == 0;
+}
+
+std::atomic<bool> LLplugin::pluginsEnabled(readPluginsFrameworkFlag());
+
+const LLpluginPathNode* LLpluginPathNode::find(std::string_view path) const {
+  const LLpluginPathNode *node = this;
+  size_t start = 0;
+  while (node != NULL && start < path.size()) {
+    size_t end = path.find('/', start);
+    if (end == std::string_view::npos)
+      end = path.size();
+    if (end > start) {
+      auto got = node->children.find(path.substr(start, end - start));
+      node = (got == node->children.end()) ? NULL : got->second.get();
+    }
+    start = end + 1;
+  }
+  return node;
+}
+
+LLpluginPathNode* LLpluginPathNode::insert(std::string_view path) {
+  LLpluginPathNode *node = this;
+  size_t start = 0;
+  while (start < path.size()) {
+    size_t end = path.find('/', start);
+    if (end == std::string_view::npos)
+      end = path.size();
+    if (end > start) {
+      std::string_view component = path.substr(start, end - start);
+      auto got = node->children.find(component);
+      if (got == node->children.end())
+        got = node->children.emplace(std::string(component), std::make_unique<LLpluginPathNode>()).first;
+      node = got->second.get();
+    }
+    start = end + 1;
+  }
+  return node;
+}
 
 void LLplugin::addPluginHandler(const char* name, void *plugin_handler) {
   llpluginsStore[std::string(name)].plugin_handler = plugin_handler;
@@ -71,7 +299,7 @@ void LLplugin::addPlugin(const char* name, void *plugin) {
 
 void LLplugin::getFullPath(int ctxID, const char* fieldPath,  std::string &full_path, std::string &fullDataObjectName) {
 
-  LLenv lle = Lowlevel::getLLenv(ctxID);
+  const LLenv &lle = Lowlevel::getLLenv(ctxID);
   std::string path = "";
   OperationContext *opctx = nullptr;
   if (lle.context->getType() == CTX_ARRAYSTRUCT_TYPE) {
@@ -105,56 +333,67 @@ void LLplugin::getFullPath(int ctxID, const char* fieldPath,  std::string &full_
   full_path = path + "/" + std::string(fieldPath);
 }
 
-bool LLplugin::pluginsFrameworkEnabled(){
-  char *pluginsFrameworkEnabled =  getenv("IMAS_AL_ENABLE_PLUGINS");
-  if (!pluginsFrameworkEnabled) 
-       return false;
-  std::string b = std::string(pluginsFrameworkEnabled);
-  return  (b == "TRUE");
+void LLplugin::latchPluginsFrameworkFlag(){
+  pluginsEnabled = readPluginsFrameworkFlag();
 } 
 
 void LLplugin::checkIfPluginsFrameworkIsEnabled(){
+  latchPluginsFrameworkFlag();
   if(!pluginsFrameworkEnabled())
        throw ALLowlevelException("Plugins feature is disabled. Set the global variable 'IMAS_AL_ENABLE_PLUGINS' to 'TRUE' to enable this feature.");
 }
 
-bool LLplugin::getBoundPlugins(int ctxID, const char* fieldPath, std::vector<std::string> &pluginsNames) {
-	if(!pluginsFrameworkEnabled()) return false;
-  if(std::string(fieldPath) == "<buffer>") return false;  // Skip plugins when storing serialized buffer in Serialization Backend
+void LLplugin::resolvePrefix(int ctxID, LLpluginPrefix &prefix) {
   std::string fullPath;
   std::string dataObjectName;
-  getFullPath(ctxID, fieldPath, fullPath, dataObjectName);
-  //printf("--> getBoundPlugins::fullPath = %s\n ", fullPath.c_str());
-
-  bool t = getBoundPlugins(fullPath, pluginsNames);
-  if (t)
-    return true;
-
-  //we are searching now path like :"ids_name:occ/*" where occ is the occurrence and * is representing all nodes
-  std::string path = dataObjectName + "/*";
-  t = getBoundPlugins(path, pluginsNames);
-
-  //we bind these plugins to the current path=fieldPath
-  if (t) {
-    for (auto& pluginName:pluginsNames) {
+  getFullPath(ctxID, "", fullPath, dataObjectName);
+  prefix.node = boundPluginsTrie.insert(fullPath);
+  //paths like "ids_name:occ/*" where occ is the occurrence and * is representing all nodes
+  prefix.occurrenceWildcard = boundPluginsTrie.insert(dataObjectName + "/*");
+  //paths like "ids_name:*/*" where latest * is representing all nodes
+  prefix.idsWildcard = boundPluginsTrie.insert(idsWildcardPath(dataObjectName));
+  prefix.resolved = true;
+}
+
+std::string LLplugin::idsWildcardPath(const std::string &dataObjectName) {
+  //the IDS name is everything before the occurrence separator
+  return dataObjectName.substr(0, dataObjectName.find(":")) + ":*/*";
+}
+
+const std::vector<std::string>* LLplugin::findBoundPlugins(int ctxID, const char* fieldPath) {
+  if (!pluginsEnabled) return NULL;
+  if (strcmp(fieldPath, "<buffer>") == 0) return NULL;  // Skip plugins when storing serialized buffer in Serialization Backend
+
+  const LLenv &lle = Lowlevel::getLLenv(ctxID);
+  if (!lle.pluginPrefix.resolved)
+    resolvePrefix(ctxID, lle.pluginPrefix);
+
+  const LLpluginPathNode *node = lle.pluginPrefix.node->find(fieldPath);
+  if (node != NULL && !node->plugins.empty())
+    return &node->plugins;
+
+  for (const LLpluginPathNode *wildcard : {lle.pluginPrefix.occurrenceWildcard, lle.pluginPrefix.idsWildcard}) {
+    if (wildcard->plugins.empty())
+      continue;
+    //we bind these plugins to the current path=fieldPath, so that next lookups find it directly
+    std::string fullPath;
+    std::string dataObjectName;
+    getFullPath(ctxID, fieldPath, fullPath, dataObjectName);
+    for (auto& pluginName:wildcard->plugins) {
       //printf("binding plugin=%s to path=%s\n", pluginName.c_str(), fullPath.c_str());
       bind_plugin(pluginName.c_str(), fullPath, boundPlugins);
     }
-    return true;
-  }
-
-  //we are now searching now path like :"ids_name:*/*" where latest * is representing all nodes
-  size_t index = dataObjectName.find(":");
-  path = dataObjectName.substr(0, index - 1)  + ":*/*";
-  t = getBoundPlugins(path, pluginsNames);
-
-  if (t) {
-    for (auto& pluginName:pluginsNames)
-      bind_plugin(pluginName.c_str(), fullPath, boundPlugins);
-    return true;
+    return &boundPluginsTrie.find(fullPath)->plugins;
   }
+  return NULL;
+}
 
-  return false;
+bool LLplugin::getBoundPlugins(int ctxID, const char* fieldPath, std::vector<std::string> &pluginsNames) {
+  const std::vector<std::string> *plugins = findBoundPlugins(ctxID, fieldPath);
+  if (plugins == NULL)
+    return false;
+  pluginsNames = *plugins;
+  return true;
 }
 
 bool LLplugin::getBoundPlugins(const std::string &fullPath, std::vector<std::string> &pluginsNames) {
@@ -280,6 +519,16 @@ void LLplugin::bind_plugin(const char* pluginName, const std::string &path, std:
         //printf("bindPlugin::binding plugin %s to path=%s\n", pluginName, full_path.c_str());
 		    boundPlugins[path] = plugins;
     } 
+    syncBoundPath(path);
+}
+
+void LLplugin::syncBoundPath(const std::string &path) {
+    LLpluginPathNode *node = boundPluginsTrie.insert(path);
+    auto got = boundPlugins.find(path);
+    if (got != boundPlugins.end())
+        node->plugins = got->second;
+    else
+        node->plugins.clear();
 }
 
 bool LLplugin::isPluginBound(const char* path, const char* pluginName){
@@ -312,6 +561,8 @@ void LLplugin::unbindPlugin(const char* fieldPath, const char* pluginName, std::
                   boundPlugins_.erase(got);
             }  
 		      }
+        if (&boundPlugins_ == &boundPlugins)
+            syncBoundPath(fieldPath);
     }
 }
 
@@ -427,6 +678,7 @@ void LLplugin::unregisterPlugin(const char *plugin_name)
           v.erase(p);
       if (v.size() == 0)
           boundPlugins.erase(*it);
+      syncBoundPath(*it);
     } 
 }
 
@@ -534,59 +786,120 @@ void LLplugin::writeDataPlugin(const std::string &plugin_name, int ctxID, const
               data, datatype, dim, size);
 }
 
-int Lowlevel::addLLenv(Backend *be, Context *ctx)
+LLenvTable::LLenvTable() : freeHead(-1), nextSlot(0)
+{
+  for (unsigned int i = 0; i < MAX_PAGES; i++)
+    pages[i].store(NULL, std::memory_order_relaxed);
+}
+
+LLenvTable::~LLenvTable()
+{
+  for (unsigned int i = 0; i < MAX_PAGES; i++)
+    delete[] pages[i].load(std::memory_order_relaxed);
+}
+
+LLenvTable::Slot* LLenvTable::slot(int handle) const
 {
-  LLenv lle = LLenv(be,ctx);
+  if (handle <= 0)
+    return NULL;
+  unsigned int idx = static_cast<unsigned int>(handle) & (MAX_SLOTS - 1);
+  Slot *page = pages[idx >> PAGE_BITS].load(std::memory_order_acquire);
+  if (page == NULL)
+    return NULL;
+  return &page[idx & (PAGE_SIZE - 1)];
+}
 
-  // atomic operation
-  std::lock_guard<std::mutex> guard(Lowlevel::mutex);
+int LLenvTable::insert(Backend *be, Context *ctx)
+{
+  std::lock_guard<std::mutex> guard(mutex);
 
-  if (Lowlevel::curStoreElt == Lowlevel::maxStoreElt)
+  unsigned int idx;
+  if (freeHead >= 0)
     {
-      llenvStore.push_back(lle);
-      Lowlevel::maxStoreElt++;
+      idx = freeHead;
     }
   else
     {
-      Lowlevel::llenvStore[Lowlevel::curStoreElt].backend = be;
-      Lowlevel::llenvStore[Lowlevel::curStoreElt].context = ctx;
+      if (nextSlot == MAX_SLOTS)
+	throw ALLowlevelException("Too many opened contexts (maximum is "+
+				   std::to_string(MAX_SLOTS)+")",LOG);
+      idx = nextSlot;
+      if (pages[idx >> PAGE_BITS].load(std::memory_order_relaxed) == NULL)
+	{
+	  Slot *page = new Slot[PAGE_SIZE];
+	  for (unsigned int i = 0; i < PAGE_SIZE; i++)
+	    {
+	      page[i].handle.store(0, std::memory_order_relaxed);
+	      page[i].generation = 1;
+	      page[i].nextFree = -1;
+	    }
+	  pages[idx >> PAGE_BITS].store(page, std::memory_order_release);
+	}
     }
 
-  return Lowlevel::curStoreElt++;
+  Slot *s = &pages[idx >> PAGE_BITS].load(std::memory_order_relaxed)[idx & (PAGE_SIZE - 1)];
+  if (static_cast<int>(idx) == freeHead)
+    freeHead = s->nextFree;
+  else
+    nextSlot++;
+
+  s->env = LLenv(be, ctx);
+  s->nextFree = -1;
+  int handle = static_cast<int>((s->generation << INDEX_BITS) | idx);
+  // publish the environment before its handle becomes valid for lookups
+  s->handle.store(handle, std::memory_order_release);
+  return handle;
 }
 
-LLenv Lowlevel::getLLenv(int idx)
+const LLenv& LLenvTable::lookup(int handle) const
 {
-  LLenv lle;
-  try {
-    lle = llenvStore.at(idx);
-    if (lle.context == NULL)
-      throw ALLowlevelException("Cannot find context "+std::to_string(idx)+
-				 " in store",LOG);
-  }
-  catch (const std::exception& e) {
-    throw ALLowlevelException("Cannot find context "+std::to_string(idx)+
+  const Slot *s = slot(handle);
+  if (s == NULL)
+    throw ALLowlevelException("Cannot find context "+std::to_string(handle)+
 			       " in store",LOG);
-  }
-  return lle;
+  if (s->handle.load(std::memory_order_acquire) != handle)
+    throw ALLowlevelException("Context "+std::to_string(handle)+
+			       " is stale (action already ended)",LOG);
+  return s->env;
 }
 
-LLenv Lowlevel::delLLenv(int idx)
+LLenv LLenvTable::remove(int handle)
 {
-  // atomic operation
-  std::lock_guard<std::mutex> guard(Lowlevel::mutex);
+  std::lock_guard<std::mutex> guard(mutex);
+
+  Slot *s = slot(handle);
+  if (s == NULL)
+    throw ALLowlevelException("Cannot find context "+std::to_string(handle)+
+			       " in store",LOG);
+  if (s->handle.load(std::memory_order_relaxed) != handle)
+    throw ALLowlevelException("Context "+std::to_string(handle)+
+			       " is stale (action already ended)",LOG);
+
+  LLenv lle = s->env;
+  s->handle.store(0, std::memory_order_release);
+  // generation 0 is never used, so that a handle can never be 0
+  s->generation = s->generation % GENERATION_MASK + 1;
+  s->nextFree = freeHead;
+  freeHead = static_cast<unsigned int>(handle) & (MAX_SLOTS - 1);
+  return lle;
+}
 
-  LLenv lle = llenvStore.at(idx);
+int Lowlevel::addLLenv(Backend *be, Context *ctx)
+{
+  return llenvStore.insert(be, ctx);
+}
 
-  llenvStore[idx].backend = NULL;
-  llenvStore[idx].context = NULL;
-  if (idx == Lowlevel::curStoreElt-1)
-    Lowlevel::curStoreElt--;
+const LLenv& Lowlevel::getLLenv(int idx)
+{
+  return llenvStore.lookup(idx);
+}
 
-  return lle;
+LLenv Lowlevel::delLLenv(int idx)
+{
+  return llenvStore.remove(idx);
 }
 
-ArraystructContext* LLenv::create(const char* path, const char* timebase) {
+ArraystructContext* LLenv::create(const char* path, const char* timebase) const {
     ArraystructContext* actx;
     ArraystructContext* parent = NULL;
     if (context->getType() == CTX_ARRAYSTRUCT_TYPE)
@@ -609,7 +922,7 @@ ArraystructContext* LLenv::create(const char* path, const char* timebase) {
 }
 
 void Lowlevel::createAOS(int ctxID, int *actxID, const char* fieldPath, const char* timeBasePath, int *size){
-        LLenv lle = Lowlevel::getLLenv(ctxID);
+        const LLenv &lle = Lowlevel::getLLenv(ctxID);
         ArraystructContext* actx = lle.create(fieldPath, timeBasePath);
         lle.backend->beginArraystructAction(actx, size); 
         *actxID = Lowlevel::addLLenv(lle.backend, actx);
@@ -636,7 +949,7 @@ void Lowlevel::setValue(void *data, int type, int dim, void **var)
 	default:
 	  throw ALLowlevelException("Unknown data type="+std::to_string(type),LOG);
 	}
-      free(data);
+      ALAllocator::release(data);
     }
   else
     *var = data;
@@ -673,71 +986,312 @@ void Lowlevel::setDefaultValue(int type, int dim, void **var, int *size)
     }
 }
 
-template <typename From>
-void* Lowlevel::convertData(From* data, size_t size, int desttype)
-{
-  switch (desttype)
-    {
-    case alconst::char_data:
+namespace {
+
+  size_t elementSize(int type)
+  {
+    switch (type)
       {
-	char* convdata = (char*)malloc(size*sizeof(char));
-	std::copy_n(data, size, convdata);
-	return (void*)convdata;
+      case alconst::char_data:
+	return sizeof(char);
+      case alconst::integer_data:
+	return sizeof(int);
+      case alconst::double_data:
+	return sizeof(double);
+      case alconst::complex_data:
+	return sizeof(std::complex<double>);
+      default:
+	throw ALLowlevelException("Unknown data type="+std::to_string(type),LOG);
       }
-    case alconst::integer_data:
+  }
+
+  // elements are accessed through memcpy: the source and destination may be the same buffer
+  template <typename T>
+  inline T loadAt(const unsigned char *p, size_t i)
+  {
+    T v;
+    memcpy(&v, p + i*sizeof(T), sizeof(T));
+    return v;
+  }
+
+  template <typename T>
+  inline void storeAt(unsigned char *p, size_t i, T v)
+  {
+    memcpy(p + i*sizeof(T), &v, sizeof(T));
+  }
+
+  template <typename To, typename From>
+  inline To convertValue(From v)
+  {
+    return static_cast<To>(v);
+  }
+
+  // complex data is converted to double data with its real part
+  template <>
+  inline double convertValue<double, std::complex<double>>(std::complex<double> v)
+  {
+    return v.real();
+  }
+
+  /*
+    Converts elements [begin,end[. Elements are converted from the first one when the destination
+    type is not larger than the source type and from the last one otherwise, so that no source
+    element is overwritten before being read when src == dst.
+  */
+  template <typename From, typename To>
+  void convertRange(const unsigned char *src, unsigned char *dst, size_t begin, size_t end)
+  {
+    if (sizeof(To) <= sizeof(From))
+      for (size_t i = begin; i < end; i++)
+	storeAt<To>(dst, i, convertValue<To>(loadAt<From>(src, i)));
+    else
+      for (size_t i = end; i-- > begin;)
+	storeAt<To>(dst, i, convertValue<To>(loadAt<From>(src, i)));
+  }
+
+  /*
+    SIMD kernels of the integer <-> double conversions, the most frequent ones (e.g. for data
+    written by a code as integers and read as floats). A block of elements is loaded before being
+    stored, blocks are processed in the same order as convertRange() so that they also convert in
+    place. They return the number of elements converted, the rest is left to convertRange().
+  */
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define AL_CONVERT_SIMD 1
+
+  __attribute__((target("avx")))
+  size_t intToDoubleAVX(const unsigned char *src, unsigned char *dst, size_t n)
+  {
+    size_t blocks = n / 4;
+    for (size_t b = blocks; b-- > 0;)
       {
-	int* convdata = (int*)malloc(size*sizeof(int));
-	std::copy_n(data, size, convdata);
-	return (void*)convdata;
+	__m128i v = _mm_loadu_si128((const __m128i *)(src + b*4*sizeof(int)));
+	_mm256_storeu_pd((double *)(dst + b*4*sizeof(double)), _mm256_cvtepi32_pd(v));
       }
-    case alconst::double_data:
+    return blocks * 4;
+  }
+
+  __attribute__((target("avx")))
+  size_t doubleToIntAVX(const unsigned char *src, unsigned char *dst, size_t n)
+  {
+    size_t blocks = n / 4;
+    for (size_t b = 0; b < blocks; b++)
       {
-	double* convdata = (double*)malloc(size*sizeof(double));
-	std::copy_n(data, size, convdata);
-	return (void*)convdata;
+	__m256d v = _mm256_loadu_pd((const double *)(src + b*4*sizeof(double)));
+	_mm_storeu_si128((__m128i *)(dst + b*4*sizeof(int)), _mm256_cvttpd_epi32(v));
       }
-    case alconst::complex_data:
+    return blocks * 4;
+  }
+
+  size_t intToDoubleSSE2(const unsigned char *src, unsigned char *dst, size_t n)
+  {
+    size_t blocks = n / 2;
+    for (size_t b = blocks; b-- > 0;)
+      {
+	__m128i v = _mm_loadl_epi64((const __m128i *)(src + b*2*sizeof(int)));
+	_mm_storeu_pd((double *)(dst + b*2*sizeof(double)), _mm_cvtepi32_pd(v));
+      }
+    return blocks * 2;
+  }
+
+  size_t doubleToIntSSE2(const unsigned char *src, unsigned char *dst, size_t n)
+  {
+    size_t blocks = n / 2;
+    for (size_t b = 0; b < blocks; b++)
+      {
+	__m128d v = _mm_loadu_pd((const double *)(src + b*2*sizeof(double)));
+	_mm_storel_epi64((__m128i *)(dst + b*2*sizeof(int)), _mm_cvttpd_epi32(v));
+      }
+    return blocks * 2;
+  }
+
+  bool hasAVX()
+  {
+    static const bool avx = __builtin_cpu_supports("avx");
+    return avx;
+  }
+#endif
+
+  void intToDouble(const unsigned char *src, unsigned char *dst, size_t n)
+  {
+#ifdef AL_CONVERT_SIMD
+    // growing conversion: the elements after the SIMD blocks are converted first
+    if (hasAVX())
+      {
+	convertRange<int, double>(src, dst, (n / 4) * 4, n);
+	intToDoubleAVX(src, dst, n);
+      }
+    else
+      {
+	convertRange<int, double>(src, dst, (n / 2) * 2, n);
+	intToDoubleSSE2(src, dst, n);
+      }
+#else
+    convertRange<int, double>(src, dst, 0, n);
+#endif
+  }
+
+  void doubleToInt(const unsigned char *src, unsigned char *dst, size_t n)
+  {
+    size_t done = 0;
+#ifdef AL_CONVERT_SIMD
+    done = hasAVX() ? doubleToIntAVX(src, dst, n) : doubleToIntSSE2(src, dst, n);
+#endif
+    convertRange<double, int>(src, dst, done, n);
+  }
+
+  // returns false if the conversion is not supported
+  template <typename From>
+  bool convertFrom(const unsigned char *src, unsigned char *dst, size_t n, int desttype)
+  {
+    switch (desttype)
+      {
+      case alconst::char_data:
+	convertRange<From, char>(src, dst, 0, n);
+	return true;
+      case alconst::integer_data:
+	convertRange<From, int>(src, dst, 0, n);
+	return true;
+      case alconst::double_data:
+	convertRange<From, double>(src, dst, 0, n);
+	return true;
+      case alconst::complex_data:
+	convertRange<From, std::complex<double>>(src, dst, 0, n);
+	return true;
+      default:
+	return false;
+      }
+  }
+
+  // same cases as Lowlevel::convertDataInto, checked before the buffer is reallocated
+  bool isConvertible(int srctype, int desttype)
+  {
+    bool knownDest = desttype == alconst::char_data || desttype == alconst::integer_data ||
+      desttype == alconst::double_data || desttype == alconst::complex_data;
+    switch (srctype)
       {
-	std::complex<double>* convdata = (std::complex<double>*)malloc(size*sizeof(std::complex<double>));
-	std::copy_n(data, size, convdata);
-	return (void*)convdata;
+      case alconst::char_data:
+      case alconst::integer_data:
+      case alconst::double_data:
+	return knownDest;
+      case alconst::complex_data:
+	return desttype == alconst::double_data;
+      default:
+	return false;
       }
+  }
+
+}
+
+bool Lowlevel::convertDataInto(const void* data, int srctype, size_t size, int desttype, void* dest)
+{
+  const unsigned char *src = (const unsigned char *)data;
+  unsigned char *dst = (unsigned char *)dest;
+  switch (srctype)
+    {
+    case alconst::char_data:
+      return convertFrom<char>(src, dst, size, desttype);
+    case alconst::integer_data:
+      if (desttype == alconst::double_data)
+	{
+	  intToDouble(src, dst, size);
+	  return true;
+	}
+      return convertFrom<int>(src, dst, size, desttype);
+    case alconst::double_data:
+      if (desttype == alconst::integer_data)
+	{
+	  doubleToInt(src, dst, size);
+	  return true;
+	}
+      return convertFrom<double>(src, dst, size, desttype);
+    case alconst::complex_data:
+      // only the real part can be kept
+      if (desttype == alconst::double_data)
+	{
+	  convertRange<std::complex<double>, double>(src, dst, 0, size);
+	  return true;
+	}
+      return false;
     default:
-      throw ALLowlevelException("Unknown data type="+std::to_string(desttype),LOG);
+      return false;
+    }
+}
+
+void* Lowlevel::convertData(void* data, int srctype, size_t size, int desttype)
+{
+  // nothing is reallocated when the conversion fails, so that the caller still owns data
+  if (!isConvertible(srctype, desttype))
+    return NULL;
+  size_t srcbytes = size * elementSize(srctype);
+  size_t destbytes = size * elementSize(desttype);
+  if (destbytes > srcbytes)
+    {
+      // the allocation is extended, possibly without moving the data
+      data = ALAllocator::reallocate(data, srcbytes, destbytes);
     }
+  convertDataInto(data, srctype, size, desttype, data);
+  return data;
 }
 
 void Lowlevel::setConvertedValue(void *data, int srctype, int dim, int *size, int desttype, void** var)
 {
-  void* convdata;
   size_t totsize = 1;
 
   for (int i=0; i<dim; i++)
     totsize*=size[i];
-  
-  switch (srctype) {
-  case alconst::char_data:
-    convdata = Lowlevel::convertData((char*)data,totsize,desttype);
-    Lowlevel::setValue(convdata,desttype,dim,var);
-    break;
-      
-  case alconst::integer_data:
-    convdata = Lowlevel::convertData((int*)data,totsize,desttype);
-    Lowlevel::setValue(convdata,desttype,dim,var);
-    break;
-
-  case alconst::double_data:
-    convdata = Lowlevel::convertData((double*)data,totsize,desttype);
-    Lowlevel::setValue(convdata,desttype,dim,var);
-    break;
-    
-  case alconst::complex_data:
-    // can't convert, set default
-    Lowlevel::setDefaultValue(desttype, dim, var, size);
-    break;
+
+  if (dim == 0)
+    {
+      // scalars are converted straight into the variable
+      if (!Lowlevel::convertDataInto(data, srctype, 1, desttype, *var))
+	Lowlevel::setDefaultValue(desttype, dim, var, size);
+      ALAllocator::release(data);
+      return;
+    }
+
+  // conversion in place, the buffer is reallocated when the new type is larger
+  void *convdata = NULL;
+  try {
+    convdata = Lowlevel::convertData(data, srctype, totsize, desttype);
+  }
+  catch (...) {
+    ALAllocator::release(data);
+    throw;
   }
+  if (convdata == NULL)
+    {
+      // can't convert, set default
+      ALAllocator::release(data);
+      Lowlevel::setDefaultValue(desttype, dim, var, size);
+      return;
+    }
+  *var = convdata;
+}
 
-  free(data);
+bool Lowlevel::setReadValue(int found, void *data, int srctype, int srcdim, int desttype, int dim, int *size, void **var)
+{
+  if (found == 0)
+    {
+      // no data
+      Lowlevel::setDefaultValue(desttype, dim, var, size);
+      return false;
+    }
+  if (srcdim != dim)
+    {
+      ALAllocator::release(data);
+      throw ALLowlevelException("Wrong dimension of Data returned by backend: expected "+
+				 std::string(const2str(desttype))+" in "+
+				 std::to_string(dim)+"D but got "+
+				 std::string(const2str(srctype))+" in "+
+				 std::to_string(srcdim)+"D",LOG);
+    }
+  if (srctype != desttype)
+    {
+      Lowlevel::setConvertedValue(data, srctype, srcdim, size, desttype, var);
+      return true;
+    }
+  Lowlevel::setValue(data, desttype, dim, var);
+  return false;
 }
 
 int Lowlevel::beginUriAction(const std::string &uri)
@@ -812,7 +1366,7 @@ al_status_t al_context_info(int ctxID, char **info)
     {
       std::stringstream desc;
       try {
-	LLenv lle = Lowlevel::getLLenv(ctxID);
+	const LLenv &lle = Lowlevel::getLLenv(ctxID);
 	desc << "Context type = " 
 	     << lle.context->getType() << "\n";
 	desc << "Backend @ = " << lle.backend << "\n";
@@ -835,13 +1389,116 @@ al_status_t al_context_info(int ctxID, char **info)
 }
 
 
+al_status_t al_get_statistics(int ctxID, char **json)
+{
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
+    ProfilingBackend *pbe = dynamic_cast<ProfilingBackend *>(lle.backend);
+    CacheBackend *cbe = dynamic_cast<CacheBackend *>(pbe != NULL ? pbe->getTarget() : lle.backend);
+    DataEntryContext *dectx = NULL;
+    switch (lle.context->getType())
+      {
+      case CTX_PULSE_TYPE:
+	dectx = static_cast<DataEntryContext *>(lle.context);
+	break;
+      case CTX_OPERATION_TYPE:
+	dectx = static_cast<OperationContext *>(lle.context)->getDataEntryContext();
+	break;
+      case CTX_ARRAYSTRUCT_TYPE:
+	dectx = static_cast<ArraystructContext *>(lle.context)->getDataEntryContext();
+	break;
+      }
+    ALIncrementalPutCounters incremental;
+    bool incrementalPut = lle.backend->getIncrementalPutCounters(dectx, incremental);
+    ALDedupCounters dedupCounters;
+    bool dedup = lle.backend->getDedupCounters(dectx, dedupCounters);
+    if (pbe == NULL && cbe == NULL && !incrementalPut && !dedup)
+      throw ALLowlevelException("Statistics are not collected for this data entry: set IMAS_AL_PROFILE=<file> "
+				 "or IMAS_AL_STATISTICS=TRUE before opening it",LOG);
+    // without call statistics, only the cache, incremental put and dedup counters are reported
+    std::string str = (pbe != NULL) ? pbe->getStatistics().toJSON(dectx) : ALStatistics().toJSON(dectx);
+    if (cbe != NULL)
+      str.insert(str.size()-1, ", \"cache\": " + cbe->toJSON());
+    if (incrementalPut)
+      str.insert(str.size()-1, ", \"incremental_put\": " + incremental.toJSON());
+    if (dedup)
+      str.insert(str.size()-1, ", \"dedup\": " + dedupCounters.toJSON());
+    *json = (char *)malloc(str.size()+1);
+    memcpy(*json, str.c_str(), str.size()+1);
+  }
+  catch (const ALContextException& e) {
+    status.code = alerror::context_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  return status;
+}
+
+al_status_t al_memory_usage(int ctxID, char **json)
+{
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
+    DataEntryContext *dectx = NULL;
+    switch (lle.context->getType())
+      {
+      case CTX_PULSE_TYPE:
+	dectx = static_cast<DataEntryContext *>(lle.context);
+	break;
+      case CTX_OPERATION_TYPE:
+	dectx = static_cast<OperationContext *>(lle.context)->getDataEntryContext();
+	break;
+      case CTX_ARRAYSTRUCT_TYPE:
+	dectx = static_cast<ArraystructContext *>(lle.context)->getDataEntryContext();
+	break;
+      }
+    ALMemoryUsage usage;
+    lle.backend->getMemoryUsage(dectx, usage);
+    std::string str = "{\"data_entry\": " + usage.toJSON() + ", \"process\": " + ALMemoryUsage::processJSON() + "}";
+    *json = (char *)malloc(str.size()+1);
+    memcpy(*json, str.c_str(), str.size()+1);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALContextException& e) {
+    status.code = alerror::context_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  return status;
+}
+
+
 al_status_t al_get_backendID(int ctxID, int *beid)
 {
   al_status_t status;
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(ctxID);
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
     DataEntryContext *pctx = static_cast<DataEntryContext *>(lle.context);
     *beid = pctx->getBackendID();
   }
@@ -857,16 +1514,28 @@ al_status_t al_begin_dataentry_action(const std::string uri, int mode, int *dect
 {
   al_status_t status = { 0 };
 
+  ALStatistics::latchEnabledFlag();
+  ALTraceRecorder::latchEnabledFlag();
+  ALStatisticsScope profile(ALStatistics::AL_BEGIN_DATAENTRY_ACTION);
+  ALTraceScope trace(altrace::TR_BEGIN_DATAENTRY, status);
+  trace.str(uri.c_str()).i32(mode);
+  trace.atEnd([&]() { trace.i32(*dectxID); });
   status.code = 0;
   try {
+    LLplugin::latchPluginsFrameworkFlag();
+    LLpluginFrameworkLock pluginLock;
     *dectxID = Lowlevel::beginUriAction(uri);
-    LLenv lle = Lowlevel::getLLenv(*dectxID);
+    if (ALStatistics::enabled)
+      profile.bind(*dectxID);
+    const LLenv &lle = Lowlevel::getLLenv(*dectxID);
     DataEntryContext *pctx= dynamic_cast<DataEntryContext *>(lle.context); 
     if (pctx==NULL)
       throw ALLowlevelException("Wrong Context type stored",LOG);
 
     lle.backend->openPulse(pctx,
 			   mode);
+    if (mode == alconst::create_pulse || mode == alconst::force_create_pulse)
+      CacheBackend::notifyWrite(pctx);
 
     switch (mode) {
     case alconst::open_pulse:
@@ -907,11 +1576,14 @@ al_status_t al_begin_dataentry_action(const char *uri, int mode, int *dectxID)
 
 al_status_t al_close_pulse(int pctxID, int mode)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
+  ALTraceScope trace(altrace::TR_CLOSE_PULSE, status);
+  trace.i32(pctxID).i32(mode);
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(pctxID);
+    const LLenv &lle = Lowlevel::getLLenv(pctxID);
     DataEntryContext *pctx= dynamic_cast<DataEntryContext *>(lle.context); 
     if (pctx==NULL)
       throw ALLowlevelException("Wrong Context type stored",LOG);
@@ -937,12 +1609,13 @@ al_status_t al_close_pulse(int pctxID, int mode)
 al_status_t al_plugin_begin_global_action(int pctxID, const char* dataobjectname, const char* datapath, int rwmode,
                                             int *octxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
   OperationContext *octx=NULL;
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(pctxID); 
+    const LLenv &lle = Lowlevel::getLLenv(pctxID); 
     DataEntryContext *pctx= dynamic_cast<DataEntryContext *>(lle.context); 
     if (pctx==NULL)
       throw ALLowlevelException("Wrong Context type stored",LOG);
@@ -952,6 +1625,8 @@ al_status_t al_plugin_begin_global_action(int pctxID, const char* dataobjectname
                 std::string(datapath),
 				rwmode);
     lle.backend->beginAction(octx);
+    if (rwmode != alconst::read_op)
+      CacheBackend::notifyWrite(pctx);
 
     switch (rwmode) {
     case alconst::write_op:
@@ -991,11 +1666,12 @@ al_status_t al_plugin_begin_global_action(int pctxID, const char* dataobjectname
 al_status_t al_plugin_begin_slice_action(int pctxID, const char* dataobjectname, int rwmode, 
 				   double time, int interpmode, int *octxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(pctxID);
+    const LLenv &lle = Lowlevel::getLLenv(pctxID);
     DataEntryContext *pctx= dynamic_cast<DataEntryContext *>(lle.context); 
     if (pctx==NULL)
       throw ALLowlevelException("Wrong Context type stored",LOG);
@@ -1007,6 +1683,8 @@ al_status_t al_plugin_begin_slice_action(int pctxID, const char* dataobjectname,
 						 time, 
 						 interpmode);
     lle.backend->beginAction(octx);
+    if (rwmode != alconst::read_op)
+      CacheBackend::notifyWrite(pctx);
 
     switch (rwmode) {
     case alconst::write_op:
@@ -1045,10 +1723,11 @@ al_status_t al_plugin_begin_slice_action(int pctxID, const char* dataobjectname,
 al_status_t al_plugin_begin_timerange_action(int pctxID, const char* dataobjectname, int rwmode, 
 				   double tmin, double tmax, const double* dtime_buffer, const int* dtime_shape, int interpmode, int *octxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(pctxID);
+    const LLenv &lle = Lowlevel::getLLenv(pctxID);
 
     if (!lle.backend->supportsTimeRangeOperation()) {
       std::string message = "Selected backend does not support time range operations.";
@@ -1107,8 +1786,19 @@ al_status_t al_plugin_begin_timerange_action(int pctxID, const char* dataobjectn
 }
 
 
+// the caches of the data entries opened on the same data are emptied once a write is done
+static void notifyEndOfWrite(Context *ctx)
+{
+  if (ctx->getType() != CTX_OPERATION_TYPE)
+    return;
+  OperationContext *octx = static_cast<OperationContext *>(ctx);
+  if (octx->getAccessmode() != alconst::read_op)
+    CacheBackend::notifyWrite(octx->getDataEntryContext());
+}
+
 al_status_t al_plugin_end_action(int ctxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
 
   status.code = 0;
@@ -1117,6 +1807,7 @@ al_status_t al_plugin_end_action(int ctxID)
       try {
 	LLenv lle = Lowlevel::delLLenv(ctxID);
 	lle.backend->endAction(lle.context);
+	notifyEndOfWrite(lle.context);
 
 	if (lle.context->getType() == CTX_PULSE_TYPE) 
 	  delete(lle.backend);
@@ -1144,14 +1835,15 @@ al_status_t al_plugin_end_action(int ctxID)
 al_status_t al_plugin_write_data(int ctxID, const char *field, const char *timebase,  
 			 void *data, int datatype, int dim, int *size)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(ctxID);
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
     lle.backend->writeData(lle.context,
-			   std::string(field),
-			   std::string(timebase),
+			   ALPath(field),
+			   ALPath(timebase),
 			   data,
 			   datatype,
 			   dim,
@@ -1177,6 +1869,7 @@ al_status_t al_plugin_write_data(int ctxID, const char *field, const char *timeb
 al_status_t al_plugin_read_data(int ctxID, const char *field, const char *timebase, 
 			  void **data, int datatype, int dim, int *size)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
   void *retData=NULL;
   int retType=datatype;
@@ -1184,42 +1877,22 @@ al_status_t al_plugin_read_data(int ctxID, const char *field, const char *timeba
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(ctxID);
-
-    if (lle.backend->readData(lle.context, 
-			      std::string(field),
-			      std::string(timebase),
-			      &retData,
-			      &retType,
-			      &retDim,
-			      size) == 0)
-      {
-	// no data
-	Lowlevel::setDefaultValue(datatype, dim, data, size);
-      }
-    else
-      {
-	if (retDim!=dim)
-	  {
-	    throw ALLowlevelException("Wrong dimension of Data returned by backend: expected "+
-				       std::string(const2str(datatype))+" in "+
-				       std::to_string(dim)+"D but got "+
-				       std::string(const2str(retType))+" in "+
-				       std::to_string(retDim)+"D",LOG);
-	  }
-	else if (retType!=datatype)
-	  {
-	    Lowlevel::setConvertedValue(retData, retType, retDim, size, datatype, data);
-	    ALException::registerStatus(status.message, __func__,
-					 ALLowlevelException("Warning: " + lle.context->getURI().to_string() +
-							      "/" + field + " returned with type " +
-							      std::string(const2str(retType)) +
-							      " while we expect type " +
-							      std::string(const2str(datatype)) + "\n"));
-	  }
-	else 
-	  Lowlevel::setValue(retData, datatype, dim, data);
-      }
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
+
+    int found = lle.backend->readData(lle.context, 
+				      ALPath(field),
+				      ALPath(timebase),
+				      &retData,
+				      &retType,
+				      &retDim,
+				      size);
+    if (Lowlevel::setReadValue(found, retData, retType, retDim, datatype, dim, size, data))
+      ALException::registerStatus(status.message, __func__,
+				   ALLowlevelException("Warning: " + lle.context->getURI().to_string() +
+							"/" + field + " returned with type " +
+							std::string(const2str(retType)) +
+							" while we expect type " +
+							std::string(const2str(datatype)) + "\n"));
   }
   catch (const ALBackendException& e) {
     status.code = alerror::backend_err;
@@ -1241,11 +1914,14 @@ al_status_t al_plugin_read_data(int ctxID, const char *field, const char *timeba
 
 al_status_t al_delete_data(int octxID, const char *field)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
+  ALTraceScope trace(altrace::TR_DELETE_DATA, status);
+  trace.i32(octxID).str(field);
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(octxID);
+    const LLenv &lle = Lowlevel::getLLenv(octxID);
     OperationContext *octx= dynamic_cast<OperationContext *>(lle.context); 
     if (octx==NULL)
       throw ALLowlevelException("Wrong Context type stored",LOG);
@@ -1273,10 +1949,11 @@ al_status_t al_plugin_begin_arraystruct_action(int ctxID, const char *path,
 					 const char *timebase, int *size,
 					 int *actxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(ctxID);
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
     ArraystructContext* actx = lle.create(path, timebase);
     lle.backend->beginArraystructAction(actx, size);
     *actxID = Lowlevel::addLLenv(lle.backend, actx); 
@@ -1321,11 +1998,14 @@ al_status_t al_plugin_begin_arraystruct_action(int ctxID, const char *path,
 al_status_t al_iterate_over_arraystruct(int aosctxID, 
 					 int step)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
+  ALTraceScope trace(altrace::TR_ITERATE, status);
+  trace.i32(aosctxID).i32(step);
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(aosctxID);
+    const LLenv &lle = Lowlevel::getLLenv(aosctxID);
     ArraystructContext *actx = static_cast<ArraystructContext *>(lle.context);
     
     actx->nextIndex(step);
@@ -1416,6 +2096,7 @@ al_status_t al_build_uri_from_legacy_parameters(const int backendID,
 al_status_t al_begin_global_action(int pctxID, const char* dataobjectname, const char* datapath, int rwmode,
                     int *octxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
 
   status.code = 0;
@@ -1424,6 +2105,10 @@ al_status_t al_begin_global_action(int pctxID, const char* dataobjectname, const
   if(dataobjectnameStr.size() >= 2 && dataobjectnameStr.substr(dataobjectnameStr.size() - 2) == "/0") {
     dataobjectnameStr.erase(dataobjectnameStr.size() - 2);
   }
+  ALStatisticsScope profile(ALStatistics::AL_BEGIN_GLOBAL_ACTION, pctxID, dataobjectnameStr.c_str());
+  ALTraceScope trace(altrace::TR_BEGIN_GLOBAL, status);
+  trace.i32(pctxID).str(dataobjectname).str(datapath).i32(rwmode);
+  trace.atEnd([&]() { trace.i32(*octxID); });
 
   try {
     status = al_plugin_begin_global_action(pctxID, dataobjectnameStr.c_str(), datapath, rwmode, octxID);
@@ -1459,6 +2144,7 @@ al_status_t al_begin_global_action(int pctxID, const char* dataobjectname, const
 al_status_t al_begin_slice_action(int pctxID, const char* dataobjectname, int rwmode, 
                    double time, int interpmode, int *octxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
 
   status.code = 0;
@@ -1467,6 +2153,10 @@ al_status_t al_begin_slice_action(int pctxID, const char* dataobjectname, int rw
   if(dataobjectnameStr.size() >= 2 && dataobjectnameStr.substr(dataobjectnameStr.size() - 2) == "/0") {
     dataobjectnameStr.erase(dataobjectnameStr.size() - 2);
   }
+  ALStatisticsScope profile(ALStatistics::AL_BEGIN_SLICE_ACTION, pctxID, dataobjectnameStr.c_str());
+  ALTraceScope trace(altrace::TR_BEGIN_SLICE, status);
+  trace.i32(pctxID).str(dataobjectname).i32(rwmode).f64(time).i32(interpmode);
+  trace.atEnd([&]() { trace.i32(*octxID); });
 
   try {
     status = al_plugin_begin_slice_action(pctxID, dataobjectnameStr.c_str(), rwmode, time, interpmode, octxID);
@@ -1502,6 +2192,7 @@ al_status_t al_begin_slice_action(int pctxID, const char* dataobjectname, int rw
 al_status_t al_begin_timerange_action(int pctxID, const char* dataobjectname, int rwmode, 
                    double tmin, double tmax, const double* dtime_buffer, const int* dtime_shape, int interpmode, int *octxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
 
   status.code = 0;
@@ -1513,13 +2204,20 @@ al_status_t al_begin_timerange_action(int pctxID, const char* dataobjectname, in
   if(dataobjectnameStr.size() >= 2 && dataobjectnameStr.substr(dataobjectnameStr.size() - 2) == "/0") {
     dataobjectnameStr.erase(dataobjectnameStr.size() - 2);
   }
+  ALStatisticsScope profile(ALStatistics::AL_BEGIN_TIMERANGE_ACTION, pctxID, dataobjectnameStr.c_str());
+  ALTraceScope trace(altrace::TR_BEGIN_TIMERANGE, status);
+  trace.i32(pctxID).str(dataobjectname).i32(rwmode).f64(tmin).f64(tmax).i32(dtime.size());
+  for (double dt : dtime)
+    trace.f64(dt);
+  trace.i32(interpmode);
+  trace.atEnd([&]() { trace.i32(*octxID); });
 
   try {
     status = al_plugin_begin_timerange_action(pctxID, dataobjectnameStr.c_str(), rwmode, tmin, tmax, dtime_buffer, dtime_shape, interpmode, octxID);
     if (status.code != 0)
      return status;
 
-    LLenv lle = Lowlevel::getLLenv(*octxID);
+    const LLenv &lle = Lowlevel::getLLenv(*octxID);
   
     LLplugin::register_core_plugins(pctxID, dataobjectname, rwmode, octxID);
     std::set<std::string> pluginsNames;
@@ -1553,7 +2251,12 @@ al_status_t al_begin_arraystruct_action(int ctxID, const char *path,
                      const char *timebase, int *size,
                      int *actxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
+  ALStatisticsScope profile(ALStatistics::AL_BEGIN_ARRAYSTRUCT_ACTION, ctxID);
+  ALTraceScope trace(altrace::TR_BEGIN_ARRAYSTRUCT, status);
+  trace.i32(ctxID).str(path).str(timebase).i32(*size);
+  trace.atEnd([&]() { trace.i32(*size).i32(*actxID); });
   status.code = 0;
   try {
     *actxID = 0; //no default AOS context, plugin has to manage the creation of this object
@@ -1592,7 +2295,7 @@ al_status_t al_begin_arraystruct_action(int ctxID, const char *path,
         }
     }
     else {
-        LLenv lle = Lowlevel::getLLenv(ctxID);
+        const LLenv &lle = Lowlevel::getLLenv(ctxID);
         ArraystructContext* actx = lle.create(path, timebase);
         lle.backend->beginArraystructAction(actx, size); //TO DISCUSS
         *actxID = Lowlevel::addLLenv(lle.backend, actx);
@@ -1602,10 +2305,10 @@ al_status_t al_begin_arraystruct_action(int ctxID, const char *path,
         if (!skipAOSWriteAccess && isPluginBound)
            LLplugin::endActionPlugin(*actxID);
         assert(actxID != 0);
-        LLenv lle_aos = Lowlevel::getLLenv(*actxID);
+        const LLenv &lle_aos = Lowlevel::getLLenv(*actxID);
         assert(lle_aos.context != NULL);
         ArraystructContext* actx = dynamic_cast<ArraystructContext *>(lle_aos.context);
-        LLenv lle = Lowlevel::getLLenv(ctxID);
+        const LLenv &lle = Lowlevel::getLLenv(ctxID);
         lle.backend->endAction(actx);
         delete(actx);
         *actxID = 0;
@@ -1639,7 +2342,11 @@ al_status_t al_begin_arraystruct_action(int ctxID, const char *path,
 
 al_status_t al_end_action(int ctxID)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
+  ALStatisticsScope profile(ALStatistics::AL_END_ACTION, ctxID);
+  ALTraceScope trace(altrace::TR_END_ACTION, status);
+  trace.i32(ctxID);
   status.code = 0;
   if (ctxID!=0)
     {
@@ -1647,6 +2354,7 @@ al_status_t al_end_action(int ctxID)
         LLplugin::endActionPlugin(ctxID);
         LLenv lle = Lowlevel::delLLenv(ctxID);
         lle.backend->endAction(lle.context);
+        notifyEndOfWrite(lle.context);
 
         if (lle.context->getType() == CTX_PULSE_TYPE) 
           delete(lle.backend);
@@ -1677,14 +2385,19 @@ al_status_t al_end_action(int ctxID)
 al_status_t al_write_data(int ctxID, const char *field, const char *timebase,  
 			 void *data, int datatype, int dim, int *size)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
+  ALStatisticsScope profile(ALStatistics::AL_WRITE_DATA, ctxID);
+  ALTraceScope trace(altrace::TR_WRITE_DATA, status);
+  trace.i32(ctxID).str(field).str(timebase).i32(datatype).shape(dim, size).payload(data, datatype, dim, size);
 
   status.code = 0;
   try {
-    std::vector<std::string> pluginsNames;
-    bool isPluginBound = LLplugin::getBoundPlugins(ctxID, field, pluginsNames);
-    if (isPluginBound) {
-		  for (const auto& pluginName : pluginsNames)
+    if (profile.active())
+      profile.bytesWritten = Backend::getDataByteSize(datatype, dim, size);
+    const std::vector<std::string> *pluginsNames = LLplugin::findBoundPlugins(ctxID, field);
+    if (pluginsNames) {
+		  for (const auto& pluginName : *pluginsNames)
         LLplugin::writeDataPlugin(pluginName, ctxID, field, timebase, data, datatype, dim, size);
     }
     else {
@@ -1714,14 +2427,18 @@ al_status_t al_write_data(int ctxID, const char *field, const char *timebase,
 al_status_t al_read_data(int ctxID, const char *field, const char *timebase, 
               void **data, int datatype, int dim, int *size)
 {
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
+  ALStatisticsScope profile(ALStatistics::AL_READ_DATA, ctxID);
+  ALTraceScope trace(altrace::TR_READ_DATA, status);
+  trace.i32(ctxID).str(field).str(timebase).i32(datatype).i32(dim);
+  trace.atEnd([&]() { trace.shape(dim, size); });
   status.code = 0;
   try {
-    std::vector<std::string> pluginsNames;
-    bool isPluginBound = LLplugin::getBoundPlugins(ctxID, field, pluginsNames);
-    //printf("al_read_data::isPluginBound=%d for field = %s\n ", isPluginBound, field);
-    if (isPluginBound) {
-	   for (const auto& pluginName : pluginsNames)
+    const std::vector<std::string> *pluginsNames = LLplugin::findBoundPlugins(ctxID, field);
+    //printf("al_read_data::isPluginBound=%d for field = %s\n ", pluginsNames != NULL, field);
+    if (pluginsNames) {
+	   for (const auto& pluginName : *pluginsNames)
                 LLplugin::readDataPlugin(pluginName, ctxID, field, timebase, data, datatype, dim, size);
     }
     else {
@@ -1729,6 +2446,8 @@ al_status_t al_read_data(int ctxID, const char *field, const char *timebase,
         if (status.code != 0)
             return status;
     }
+    if (profile.active() && (dim == 0 || *data != NULL))
+      profile.bytesRead = Backend::getDataByteSize(datatype, dim, size);
   }
   catch (const ALContextException& e) {
     status.code = alerror::context_err;
@@ -1750,18 +2469,285 @@ al_status_t al_read_data(int ctxID, const char *field, const char *timebase,
    
 }
 
-al_status_t al_get_occurrences(int pctxID, const char* ids_name, int** occurrences_list, int* size)
+// Scalars are stored directly in the caller provided buffer: it must hold one
+static void checkScalarCapacity(int datatype, size_t capacity)
+{
+  if (capacity < Backend::getDataByteSize(datatype, 0, NULL))
+    throw ALLowlevelException("Destination buffer of "+std::to_string(capacity)+
+			       " bytes is too small for a scalar of type "+std::string(const2str(datatype)),LOG);
+}
+
+// Stores the default value of a missing data in a caller provided buffer
+static void setDefaultValueInto(int datatype, int dim, void *dst, size_t capacity, int *size)
 {
+  if (dim == 0)
+    checkScalarCapacity(datatype, capacity);
+  Lowlevel::setDefaultValue(datatype, dim, &dst, size);
+}
+
+al_status_t al_read_data_into(int ctxID, const char *field, const char *timebase,
+			      void *dst, size_t capacity, int datatype, int dim, int *size)
+{
+  LLpluginFrameworkLock pluginLock;
   al_status_t status;
+  ALTraceScope trace(altrace::TR_READ_DATA_INTO, status);
+  trace.i32(ctxID).str(field).str(timebase).i32(datatype).i32(dim).i64(capacity);
+  trace.atEnd([&]() { trace.shape(dim, size); });
+  void *retData = NULL;
+  int retType = datatype;
+  int retDim = dim;
 
   status.code = 0;
   try {
-    LLenv lle = Lowlevel::getLLenv(pctxID);
-    lle.backend->get_occurrences(lle.context, ids_name, occurrences_list, size);
-  }
-  catch (const ALBackendException& e) {
-    status.code = alerror::backend_err;
-    ALException::registerStatus(status.message, __func__, e);
+    if (LLplugin::findBoundPlugins(ctxID, field))
+      {
+	// plugins only know about al_read_data: copy what they return
+	if (dim == 0)
+	  checkScalarCapacity(datatype, capacity);
+	void *ptr = (dim == 0) ? dst : NULL;
+	status = al_read_data(ctxID, field, timebase, &ptr, datatype, dim, size);
+	if (status.code != 0 || dim == 0 || ptr == NULL)
+	  return status;
+	size_t bytes = Backend::getDataByteSize(datatype, dim, size);
+	if (bytes <= capacity)
+	  memcpy(dst, ptr, bytes);
+	ALAllocator::release(ptr);
+	if (bytes > capacity)
+	  throw ALLowlevelException("Destination buffer of "+std::to_string(capacity)+
+				     " bytes is too small for "+field+" ("+std::to_string(bytes)+" bytes)",LOG);
+	return status;
+      }
+
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
+    int found = lle.backend->readDataInto(lle.context, ALPath(field), ALPath(timebase),
+					  dst, capacity, &retData, &retType, &retDim, size);
+    if (found == 0)
+      {
+	setDefaultValueInto(datatype, dim, dst, capacity, size);
+	return status;
+      }
+    if (retDim != dim)
+      throw ALLowlevelException("Wrong dimension of Data returned by backend: expected "+
+				 std::string(const2str(datatype))+" in "+
+				 std::to_string(dim)+"D but got "+
+				 std::string(const2str(retType))+" in "+
+				 std::to_string(retDim)+"D",LOG);
+    if (found == 2)
+      {
+	size_t bytes = Backend::getDataByteSize(datatype, dim, size);
+	if (bytes > capacity)
+	  throw ALLowlevelException("Destination buffer of "+std::to_string(capacity)+
+				     " bytes is too small for "+field+" ("+std::to_string(bytes)+" bytes)",LOG);
+	size_t count = bytes / Backend::getDataByteSize(datatype, 0, NULL);
+	if (retType == datatype)
+	  memcpy(dst, retData, bytes);
+	else if (!Lowlevel::convertDataInto(retData, retType, count, datatype, dst))
+	  {
+	    // can't convert, set default
+	    setDefaultValueInto(datatype, dim, dst, capacity, size);
+	  }
+	if (retType != datatype)
+	  ALException::registerStatus(status.message, __func__,
+				       ALLowlevelException("Warning: " + lle.context->getURI().to_string() +
+							    "/" + field + " returned with type " +
+							    std::string(const2str(retType)) +
+							    " while we expect type " +
+							    std::string(const2str(datatype)) + "\n"));
+      }
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  ALAllocator::release(retData);
+  return status;
+}
+
+al_status_t al_read_data_shape(int ctxID, const char *field, const char *timebase,
+			       int datatype, int dim, int *size)
+{
+  LLpluginFrameworkLock pluginLock;
+  al_status_t status;
+  ALTraceScope trace(altrace::TR_READ_DATA_SHAPE, status);
+  trace.i32(ctxID).str(field).str(timebase).i32(datatype).i32(dim);
+  trace.atEnd([&]() { trace.shape(dim, size); });
+  int retType = datatype;
+  int retDim = dim;
+
+  status.code = 0;
+  try {
+    if (LLplugin::findBoundPlugins(ctxID, field))
+      {
+	// plugins only know about al_read_data: read the data to get its shape
+	if (dim == 0)
+	  return status;
+	void *ptr = NULL;
+	status = al_read_data(ctxID, field, timebase, &ptr, datatype, dim, size);
+	ALAllocator::release(ptr);
+	return status;
+      }
+
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
+    if (lle.backend->readDataShape(lle.context, ALPath(field), ALPath(timebase),
+				   &retType, &retDim, size) == 0)
+      {
+	for (int i=0; i<dim; i++)
+	  size[i] = 0;
+      }
+    else if (retDim != dim)
+      throw ALLowlevelException("Wrong dimension of Data returned by backend: expected "+
+				 std::string(const2str(datatype))+" in "+
+				 std::to_string(dim)+"D but got "+
+				 std::string(const2str(retType))+" in "+
+				 std::to_string(retDim)+"D",LOG);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  return status;
+}
+
+al_status_t al_write_data_batch(int ctxID, int n, const char **fields, const char **timebases,
+				const int *datatypes, const int *dims, void **data, int **sizes)
+{
+  LLpluginFrameworkLock pluginLock;
+  al_status_t status;
+  ALTraceScope trace(altrace::TR_WRITE_DATA_BATCH, status);
+  trace.i32(ctxID).i32(n);
+  for (int i = 0; trace.active() && i < n; i++)
+    trace.str(fields[i]).str(timebases[i]).i32(datatypes[i]).shape(dims[i], sizes[i])
+      .payload(data[i], datatypes[i], dims[i], sizes[i]);
+
+  status.code = 0;
+  try {
+    if (LLplugin::pluginsFrameworkEnabled())
+      {
+	// plugins can be bound to any of these fields, keep the per-field path
+	for (int i = 0; i < n; i++)
+	  {
+	    status = al_write_data(ctxID, fields[i], timebases[i], data[i], datatypes[i], dims[i], sizes[i]);
+	    if (status.code != 0)
+	      return status;
+	  }
+	return status;
+      }
+
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
+    std::vector<DataBatchItem> items;
+    items.reserve(n);
+    for (int i = 0; i < n; i++)
+      {
+	if (!Lowlevel::data_has_non_zero_shape(datatypes[i], data[i], dims[i], sizes[i]))
+	  continue;
+	items.emplace_back();
+	DataBatchItem &item = items.back();
+	item.fieldname = fields[i];
+	item.timebasename = timebases[i];
+	item.data = data[i];
+	item.datatype = datatypes[i];
+	item.dim = dims[i];
+	item.size = sizes[i];
+      }
+
+    if (!items.empty())
+      lle.backend->writeDataBatch(lle.context, items);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  return status;
+}
+
+al_status_t al_read_data_batch(int ctxID, int n, const char **fields, const char **timebases,
+			       const int *datatypes, const int *dims, void **data, int **sizes)
+{
+  LLpluginFrameworkLock pluginLock;
+  al_status_t status;
+  ALTraceScope trace(altrace::TR_READ_DATA_BATCH, status);
+  trace.i32(ctxID).i32(n);
+  for (int i = 0; trace.active() && i < n; i++)
+    trace.str(fields[i]).str(timebases[i]).i32(datatypes[i]).i32(dims[i]);
+  trace.atEnd([&]() {
+    for (int i = 0; i < n; i++)
+      trace.shape(dims[i], sizes[i]);
+  });
+  std::vector<DataBatchItem> items;
+  int ignoredSize[64];  // shape storage for scalars passed without size array
+  int done = 0;         // number of items already handed over to the caller
+
+  status.code = 0;
+  try {
+    if (LLplugin::pluginsFrameworkEnabled())
+      {
+	// plugins can be bound to any of these fields, keep the per-field path
+	for (int i = 0; i < n; i++)
+	  {
+	    status = al_read_data(ctxID, fields[i], timebases[i], &data[i], datatypes[i], dims[i],
+				  sizes[i] != NULL ? sizes[i] : ignoredSize);
+	    if (status.code != 0)
+	      return status;
+	  }
+	return status;
+      }
+
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
+    items.resize(n);
+    for (int i = 0; i < n; i++)
+      {
+	items[i].fieldname = fields[i];
+	items[i].timebasename = timebases[i];
+	items[i].datatype = datatypes[i];
+	items[i].dim = dims[i];
+	items[i].size = (sizes[i] != NULL) ? sizes[i] : ignoredSize;
+      }
+
+    lle.backend->readDataBatch(lle.context, items);
+
+    for (; done < n; done++)
+      {
+	DataBatchItem &item = items[done];
+	void *retData = item.data;
+	item.data = NULL;
+	if (Lowlevel::setReadValue(item.found, retData, item.datatype, item.dim,
+				   datatypes[done], dims[done], item.size, &data[done]))
+	  ALException::registerStatus(status.message, __func__,
+				       ALLowlevelException("Warning: " + lle.context->getURI().to_string() +
+							    "/" + fields[done] + " returned with type " +
+							    std::string(const2str(item.datatype)) +
+							    " while we expect type " +
+							    std::string(const2str(datatypes[done])) + "\n"));
+      }
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
   }
   catch (const ALLowlevelException& e) {
     status.code = alerror::lowlevel_err;
@@ -1772,11 +2758,456 @@ al_status_t al_get_occurrences(int pctxID, const char* ids_name, int** occurrenc
     ALException::registerStatus(status.message, __func__, e);
   }
 
+  // release what the backend returned for fields not handed over to the caller
+  for (size_t i = done; i < items.size(); i++)
+    ALAllocator::release(items[i].data);
+
+  return status;
+}
+
+al_status_t al_set_allocator(al_alloc_fn alloc_fn, al_free_fn free_fn, void *user)
+{
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    ALAllocator::set(alloc_fn, free_fn, user);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
   return status;
 }
 
+void al_free_data(void *data)
+{
+  ALAllocator::release(data);
+}
+
+al_status_t al_get_occurrences(int pctxID, const char* ids_name, int** occurrences_list, int* size)
+{
+  LLpluginFrameworkLock pluginLock;
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    const LLenv &lle = Lowlevel::getLLenv(pctxID);
+    lle.backend->get_occurrences(lle.context, ids_name, occurrences_list, size);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  return status;
+}
+
+
+al_status_t al_prefetch_ids(int pctxID, const char* idsname, int occurrence)
+{
+  LLpluginFrameworkLock pluginLock;
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    const LLenv &lle = Lowlevel::getLLenv(pctxID);
+    DataEntryContext *pctx= dynamic_cast<DataEntryContext *>(lle.context); 
+    if (pctx==NULL)
+      throw ALLowlevelException("Wrong Context type stored",LOG);
+
+    AsyncBackend *abe = AsyncBackend::find(lle.backend);
+    if (abe != NULL)
+      {
+	std::string name(idsname);
+	if (occurrence != 0)
+	  name += "/" + std::to_string(occurrence);
+	abe->prefetch(pctx, name);
+      }
+  }
+  catch (const ALContextException& e) {
+    status.code = alerror::context_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  return status;
+}
+
+al_status_t al_begin_global_action_async(int pctxID, const char* dataobjectname, const char* datapath, int rwmode,
+					 int *octxID)
+{
+  al_status_t status;
+
+  status.code = 0;
+  AsyncBackend *abe = NULL;
+  try {
+    std::string dataobjectnameStr(dataobjectname);
+    if(dataobjectnameStr.size() >= 2 && dataobjectnameStr.substr(dataobjectnameStr.size() - 2) == "/0") {
+      dataobjectnameStr.erase(dataobjectnameStr.size() - 2);
+    }
+    {
+      LLpluginFrameworkLock pluginLock;
+      const LLenv &lle = Lowlevel::getLLenv(pctxID);
+      DataEntryContext *pctx= dynamic_cast<DataEntryContext *>(lle.context); 
+      if (pctx==NULL)
+	throw ALLowlevelException("Wrong Context type stored",LOG);
+      abe = AsyncBackend::find(lle.backend);
+      if (abe != NULL && datapath[0] == '\0')
+	{
+	  if (rwmode == alconst::read_op)
+	    abe->prefetch(pctx, dataobjectnameStr);
+	  else if (rwmode == alconst::write_op)
+	    abe->setAsyncWrite(true);
+	}
+    }
+    status = al_begin_global_action(pctxID, dataobjectname, datapath, rwmode, octxID);
+  }
+  catch (const ALContextException& e) {
+    status.code = alerror::context_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  if (abe != NULL)
+    abe->setAsyncWrite(false);
+
+  return status;
+}
+
+al_status_t al_wait(int ctxID)
+{
+  LLpluginFrameworkLock pluginLock;
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    const LLenv &lle = Lowlevel::getLLenv(ctxID);
+    AsyncBackend *abe = AsyncBackend::find(lle.backend);
+    if (abe != NULL)
+      abe->wait();
+  }
+  catch (const ALContextException& e) {
+    status.code = alerror::context_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  return status;
+}
+
+al_status_t al_copy_ids(int srcPulseCtx, int dstPulseCtx, const char* idsname, int occurrence, int flags)
+{
+  LLpluginFrameworkLock pluginLock;
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    const LLenv &src = Lowlevel::getLLenv(srcPulseCtx);
+    const LLenv &dst = Lowlevel::getLLenv(dstPulseCtx);
+    DataEntryContext *srcCtx = dynamic_cast<DataEntryContext *>(src.context);
+    DataEntryContext *dstCtx = dynamic_cast<DataEntryContext *>(dst.context);
+    if (srcCtx==NULL || dstCtx==NULL)
+      throw ALLowlevelException("Wrong Context type stored",LOG);
+
+    std::pair<int,int> ver = dst.backend->getVersion(NULL);
+    std::pair<int,int> sver = dst.backend->getVersion(dstCtx);
+    if (ver.second!=sver.second)
+      throw ALLowlevelException("Compatibility between opened file version "+
+				 std::to_string(sver.first)+"."+std::to_string(sver.second)+
+				 " and backend "+dstCtx->getBackendName()+
+				 " version "+std::to_string(ver.first)+"."+std::to_string(ver.second)+
+				 " can't be ensured (minor versions should match when writing). ABORT.\n",LOG);
+
+    std::string name(idsname);
+    if (occurrence != 0)
+      name += "/" + std::to_string(occurrence);
+    IDSCopy copy(src.backend, srcCtx, dst.backend, dstCtx, flags);
+    copy.copy(name);
+  }
+  catch (const ALContextException& e) {
+    status.code = alerror::context_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALBackendException& e) {
+    status.code = alerror::backend_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  return status;
+}
+
+namespace {
+
+  // data entries of an al_scan(), delivered to the callback in the order of the URIs. At most
+  // window entries past the next one to deliver are read ahead: the workers wait for the
+  // callback beyond, so that a slow callback or a slow entry does not hold all the others.
+  struct Scan
+  {
+    struct Entry
+    {
+      bool done = false;
+      al_status_t status;
+      std::vector<void *> data;
+      std::vector<int *> sizes;
+      std::vector<int> shapes;                  // MAXDIM sizes per field
+      std::vector<std::complex<double>> scalars; // storage of the 0D fields
+    };
+
+    int n;
+    const char **fields;
+    const char **timebases;
+    const int *datatypes;
+    const int *dims;
+    std::string idsname;
+    std::string projection;
+    al_scan_fn callback;
+    void *user;
+
+    std::mutex mutex;
+    std::condition_variable delivered;
+    std::vector<Entry> entries;
+    int next = 0;                               // next entry to deliver
+    int window = 1;
+    bool delivering = false;                    // a worker is calling the callback
+
+    void admit(int index);
+    void read(const char *uri, Entry &e);
+    void release(Entry &e);
+    void finish(int index);
+  };
+
+  // the entries are handed out in order: the worker reading entry next never waits
+  void Scan::admit(int index)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    delivered.wait(lock, [&]() { return index < next + window; });
+  }
+
+  void Scan::read(const char *uri, Entry &e)
+  {
+    e.status.code = 0;
+    e.data.assign(n, NULL);
+    e.sizes.resize(n);
+    e.shapes.assign((size_t)n * MAXDIM, 0);
+    e.scalars.resize(n);
+    for (int i = 0; i < n; i++)
+      {
+	if (dims[i] == 0)
+	  e.data[i] = &e.scalars[i];
+	e.sizes[i] = &e.shapes[(size_t)i * MAXDIM];
+      }
+
+    int pctx, octx;
+    e.status = al_begin_dataentry_action(uri, OPEN_PULSE, &pctx);
+    if (e.status.code < 0)
+      return;
+    al_status_t status = al_begin_global_action(pctx, idsname.c_str(), projection.c_str(), READ_OP, &octx);
+    if (status.code >= 0)
+      {
+	status = al_read_data_batch(octx, n, fields, timebases, datatypes, dims, e.data.data(), e.sizes.data());
+	al_status_t end = al_end_action(octx);
+	if (status.code >= 0 && end.code < 0)
+	  status = end;
+      }
+    al_status_t close = al_close_pulse(pctx, CLOSE_PULSE);
+    if (status.code >= 0 && close.code < 0)
+      status = close;
+    al_end_action(pctx);
+    e.status = status;
+    if (status.code < 0)
+      release(e);
+  }
+
+  void Scan::release(Entry &e)
+  {
+    for (int i = 0; i < n && !e.data.empty(); i++)
+      {
+	if (dims[i] > 0)
+	  al_free_data(e.data[i]);
+	e.data[i] = NULL;
+      }
+  }
+
+  void Scan::finish(int index)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    entries[index].done = true;
+    if (delivering)
+      return;
+    delivering = true;
+    while (next < (int)entries.size() && entries[next].done)
+      {
+	Entry &e = entries[next];
+	lock.unlock();
+	callback(next, e.status, e.data.data(), e.sizes.data(), user);
+	release(e);
+	e = Entry();
+	e.done = true;
+	lock.lock();
+	next++;
+	delivered.notify_all();
+      }
+    delivering = false;
+  }
+
+}
+
+al_status_t al_scan(const char **uris, int nuris, const char *idsname, int n, const char **fields,
+		    const char **timebases, const int *datatypes, const int *dims, al_scan_fn callback,
+		    void *user, int nthreads)
+{
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    if (callback == NULL || nuris < 0 || n < 0)
+      throw ALLowlevelException("Invalid arguments: a callback, nuris >= 0 and n >= 0 are required",LOG);
+
+    Scan scan;
+    scan.n = n;
+    scan.fields = fields;
+    scan.timebases = timebases;
+    scan.datatypes = datatypes;
+    scan.dims = dims;
+    scan.idsname = idsname;
+    for (int i = 0; i < n; i++)
+      {
+	if (strchr(fields[i], ';') != NULL)
+	  throw ALLowlevelException("Invalid field path "+std::string(fields[i]),LOG);
+	scan.projection += (i > 0 ? ";" : "") + std::string(fields[i]);
+      }
+    scan.callback = callback;
+    scan.user = user;
+    scan.entries.resize(nuris);
+
+    if (nthreads <= 0)
+      nthreads = std::max(1u, std::thread::hardware_concurrency());
+    nthreads = std::min(nthreads, std::max(nuris, 1));
+    scan.window = 2 * nthreads;
+
+    std::atomic<int> nextUri(0);
+    auto work = [&]() {
+      for (int i; (i = nextUri++) < nuris;)
+	{
+	  scan.admit(i);
+	  try {
+	    scan.read(uris[i], scan.entries[i]);
+	  }
+	  catch (const std::exception& e) {
+	    scan.release(scan.entries[i]);
+	    scan.entries[i].status.code = alerror::unknown_err;
+	    ALException::registerStatus(scan.entries[i].status.message, __func__, e);
+	  }
+	  scan.finish(i);
+	}
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < nthreads; t++)
+      {
+	try {
+	  workers.emplace_back(work);
+	}
+	catch (const std::system_error& e) {
+	  // fewer threads available: the started ones share the data entries
+	  break;
+	}
+      }
+    work();
+    for (auto &worker : workers)
+      worker.join();
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  return status;
+}
+
+al_status_t al_list_ids(char **idsnames)
+{
+  al_status_t status;
+
+  status.code = 0;
+  try {
+    std::string str;
+    for (const auto &name : ALDataDictionary::idsNames())
+      str += (str.empty() ? "" : " ") + name;
+    *idsnames = (char *)malloc(str.size()+1);
+    memcpy(*idsnames, str.c_str(), str.size()+1);
+  }
+  catch (const ALLowlevelException& e) {
+    status.code = alerror::lowlevel_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+  catch (const std::exception& e) {
+    status.code = alerror::unknown_err;
+    ALException::registerStatus(status.message, __func__, e);
+  }
+
+  return status;
+}
 
 al_status_t al_setvalue_parameter_plugin(const char* parameter_name, int datatype, int dim, int *size, void *data, const char* pluginName) {
+    LLpluginFrameworkLock pluginLock(true);
     al_status_t status;
     status.code = 0;
     try {
@@ -1802,6 +3233,7 @@ al_status_t al_setvalue_parameter_plugin(const char* parameter_name, int datatyp
 }
 
 al_status_t al_setvalue_int_scalar_parameter_plugin(const char* parameter_name, int parameter_value, const char* pluginName) {
+    LLpluginFrameworkLock pluginLock(true);
     al_status_t status;
     status.code = 0;
     try {
@@ -1830,6 +3262,7 @@ al_status_t al_setvalue_int_scalar_parameter_plugin(const char* parameter_name,
 }
 
 al_status_t al_setvalue_double_scalar_parameter_plugin(const char* parameter_name, double parameter_value, const char* pluginName) {
+    LLpluginFrameworkLock pluginLock(true);
     al_status_t status;
     status.code = 0;
     try {
@@ -1860,6 +3293,7 @@ al_status_t al_setvalue_double_scalar_parameter_plugin(const char* parameter_nam
 //HLI wrappers for plugins API
 al_status_t al_register_plugin(const char *plugin_name)
 {
+  LLpluginFrameworkLock pluginLock(true);
   al_status_t status;
   status.code = 0;
   try {
@@ -1882,6 +3316,7 @@ al_status_t al_register_plugin(const char *plugin_name)
 
 al_status_t al_unregister_plugin(const char *plugin_name)
 {
+  LLpluginFrameworkLock pluginLock(true);
   al_status_t status;
   status.code = 0;
   try {
@@ -1903,6 +3338,7 @@ al_status_t al_unregister_plugin(const char *plugin_name)
 }
 
 al_status_t al_is_plugin_registered(const char* pluginName, bool *is_registered) {
+    LLpluginFrameworkLock pluginLock(true);
     al_status_t status;
     status.code = 0;
     try {
@@ -1924,6 +3360,7 @@ al_status_t al_is_plugin_registered(const char* pluginName, bool *is_registered)
 }
 
 al_status_t al_bind_plugin(const char* fieldPath, const char* pluginName) {
+    LLpluginFrameworkLock pluginLock(true);
     al_status_t status;
     status.code = 0;
     try {
@@ -1945,6 +3382,7 @@ al_status_t al_bind_plugin(const char* fieldPath, const char* pluginName) {
 }
 
 al_status_t al_unbind_plugin(const char* fieldPath, const char* pluginName) {
+    LLpluginFrameworkLock pluginLock(true);
     al_status_t status;
     status.code = 0;
     try {
@@ -1967,6 +3405,7 @@ al_status_t al_unbind_plugin(const char* fieldPath, const char* pluginName) {
 
 al_status_t al_write_plugins_metadata(int ctxid)
 {
+  LLpluginFrameworkLock pluginLock(true);
   al_status_t status;
   status.code = 0;
   try {
@@ -1989,6 +3428,7 @@ al_status_t al_write_plugins_metadata(int ctxid)
 
 al_status_t al_bind_readback_plugins(int ctxid)
 {
+  LLpluginFrameworkLock pluginLock(true);
   al_status_t status;
   status.code = 0;
   try {
@@ -2011,6 +3451,7 @@ al_status_t al_bind_readback_plugins(int ctxid)
 
 al_status_t al_unbind_readback_plugins(int ctxid)
 {
+  LLpluginFrameworkLock pluginLock(true);
   al_status_t status;
   status.code = 0;
   try {
@@ -0,0 +1,111 @@
+#include "al_path.h"
+#include "al_exception.h"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+
+namespace {
+
+  // entries are stored in a deque so that their address does not change when the table grows,
+  // the index keys are views on the stored paths
+  struct PathTableStorage
+  {
+    std::shared_mutex mutex;
+    std::deque<ALPathInfo> entries;
+    std::unordered_map<std::string_view, ALPathInfo *> index;
+
+    PathTableStorage()
+    {
+      add(std::string_view());
+    }
+
+    ALPathInfo& add(std::string_view path)
+    {
+      entries.emplace_back();
+      ALPathInfo &info = entries.back();
+      info.id = entries.size() - 1;
+      info.path.assign(path.data(), path.size());
+      size_t start = 0;
+      while (start <= info.path.size())
+	{
+	  size_t end = info.path.find('/', start);
+	  if (end == std::string::npos)
+	    end = info.path.size();
+	  if (end > start)
+	    info.components.push_back(info.path.substr(start, end - start));
+	  start = end + 1;
+	}
+      index.emplace(std::string_view(info.path), &info);
+      return info;
+    }
+  };
+
+  PathTableStorage& storage()
+  {
+    static PathTableStorage table;
+    return table;
+  }
+
+  // paths interned last by the thread, indexed on the address of the caller's string: the lowlevel calls of a
+  // binding pass the same few strings over and over, a hit only compares their content, without hashing it
+  // nor taking the mutex of the table shared by the threads
+  struct ThreadCacheSlot
+  {
+    const char *data = nullptr;
+    const ALPathInfo *info = nullptr;
+  };
+
+  const size_t THREAD_CACHE_SLOTS = 256;
+  thread_local ThreadCacheSlot threadCache[THREAD_CACHE_SLOTS];
+
+  const ALPathInfo& internShared(std::string_view path)
+  {
+    PathTableStorage &table = storage();
+    {
+      std::shared_lock<std::shared_mutex> guard(table.mutex);
+      auto found = table.index.find(path);
+      if (found != table.index.end())
+	return *found->second;
+    }
+    std::unique_lock<std::shared_mutex> guard(table.mutex);
+    auto found = table.index.find(path);
+    if (found != table.index.end())
+      return *found->second;
+    return table.add(path);
+  }
+
+}
+
+const ALPathInfo& ALPathTable::intern(std::string_view path)
+{
+  static const ALPathInfo &emptyPath = internShared(std::string_view());
+  if (path.empty())
+    return emptyPath;
+  uintptr_t address = reinterpret_cast<uintptr_t>(path.data());
+  ThreadCacheSlot &slot = threadCache[((address >> 3) ^ (address >> 11)) % THREAD_CACHE_SLOTS];
+  if (slot.data == path.data() && slot.info->path == path)
+    return *slot.info;
+  const ALPathInfo &info = internShared(path);
+  slot.data = path.data();
+  slot.info = &info;
+  return info;
+}
+
+const ALPathInfo& ALPathTable::get(uint32_t id)
+{
+  PathTableStorage &table = storage();
+  std::shared_lock<std::shared_mutex> guard(table.mutex);
+  if (id >= table.entries.size())
+    throw ALLowlevelException("Unknown path identifier " + std::to_string(id), LOG);
+  return table.entries[id];
+}
+
+size_t ALPathTable::size()
+{
+  PathTableStorage &table = storage();
+  std::shared_lock<std::shared_mutex> guard(table.mutex);
+  return table.entries.size();
+}
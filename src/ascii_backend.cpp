@@ -290,8 +290,8 @@ std::string AsciiBackend::getArraystructPath(ArraystructContext *aosctx)
 
 
 void AsciiBackend::writeData(Context *ctx,
-			     std::string fieldname,
-			     std::string timebasename, 
+			     ALPath fieldname,
+			     ALPath timebasename, 
 			     void* data,
 			     int datatype,
 			     int dim,
@@ -458,8 +458,8 @@ void AsciiBackend::writeData(const std::complex<double>* data, int dim, int* siz
 
 
 int AsciiBackend::readData(Context *ctx,
-			   std::string fieldname,
-			   std::string timebasename, 
+			   ALPath fieldname,
+			   ALPath timebasename, 
 			   void** data,
 			   int* datatype,
 			   int* dim,
@@ -473,11 +473,11 @@ int AsciiBackend::readData(Context *ctx,
   std::string pathname;
 
   if (ctx->getType()==CTX_OPERATION_TYPE) {
-    pathname = this->idsname + "/" + fieldname;
+    pathname = this->idsname + "/" + fieldname.str();
   }
   else { // CTX_ARRAYSTRUCT_TYPE
     ArraystructContext *aosctx = dynamic_cast<ArraystructContext *>(ctx);
-    pathname = this->idsname + this->getArraystructPath(aosctx) + "/" + fieldname;
+    pathname = this->idsname + this->getArraystructPath(aosctx) + "/" + fieldname.str();
   }
 
   auto seekpos = this->curcontent_map.find(pathname);
@@ -541,15 +541,15 @@ void AsciiBackend::readData(char **data,
 {
   switch(dim){
   case 0:
-    *data = static_cast<char *>(malloc(sizeof(char)));
+    *data = static_cast<char *>(ALAllocator::allocate(sizeof(char)));
     this->curcontent.read(&(*data[0]),1);
     break;
   case 1:
-    *data = static_cast<char *>(malloc(size[0]*sizeof(char)));
+    *data = static_cast<char *>(ALAllocator::allocate(size[0]*sizeof(char)));
     this->curcontent.read(&(*data[0]),size[0]);
     break;
   case 2:
-    *data = static_cast<char *>(malloc(size[0]*size[1]*sizeof(char)));
+    *data = static_cast<char *>(ALAllocator::allocate(size[0]*size[1]*sizeof(char)));
     for (int i=0; i<size[0]; i++) {
       if (i!=0)
 	std::getline(this->curcontent,this->curline); // consume rest of previous line
@@ -571,29 +571,29 @@ void readDataTemp(T **data,
 {
   switch(dim){
   case 0:
-    *data = static_cast<T*>(malloc(sizeof(T)));   
+    *data = static_cast<T*>(ALAllocator::allocate(sizeof(T)));   
     curcontent >> temp_imanip<T>() >> (*data)[0] >> temp_imanip<T>(); 
     break;
   case 1:
-    *data = static_cast<T*>(malloc(size[0]*sizeof(T)));
+    *data = static_cast<T*>(ALAllocator::allocate(size[0]*sizeof(T)));
     for (int i=0; i<size[0]; i++)
       curcontent >> temp_imanip<T>() >> (*data)[i] >> temp_imanip<T>();
     break;
   case 2: 
-    *data = static_cast<T*>(malloc(size[0]*size[1]*sizeof(T)));
+    *data = static_cast<T*>(ALAllocator::allocate(size[0]*size[1]*sizeof(T)));
     for (int j=0; j<size[1]; j++) 
       for (int i=0; i<size[0]; i++) 
 	curcontent >> temp_imanip<T>() >> (*data)[j*size[0]+i] >> temp_imanip<T>();
     break;
   case 3:
-    *data = static_cast<T*>(malloc(size[0]*size[1]*size[2]*sizeof(T)));
+    *data = static_cast<T*>(ALAllocator::allocate(size[0]*size[1]*size[2]*sizeof(T)));
     for (int k=0; k<size[2]; k++)
       for (int j=0; j<size[1]; j++) 
 	for (int i=0; i<size[0]; i++) 
 	  curcontent >> temp_imanip<T>() >> (*data)[k*size[0]*size[1]+j*size[0]+i] >> temp_imanip<T>();
     break;
   case 4:
-    *data = static_cast<T*>(malloc(size[0]*size[1]*size[2]*size[3]*sizeof(T)));
+    *data = static_cast<T*>(ALAllocator::allocate(size[0]*size[1]*size[2]*size[3]*sizeof(T)));
     for (int l=0; l<size[3]; l++) 
       for (int k=0; k<size[2]; k++) 
 	for (int j=0; j<size[1]; j++) 
@@ -601,7 +601,7 @@ void readDataTemp(T **data,
 	    curcontent >> temp_imanip<T>() >> (*data)[l*size[2]*size[1]*size[0]+k*size[1]*size[0]+j*size[0]+i] >> temp_imanip<T>();
     break;
   case 5:
-    *data = static_cast<T*>(malloc(size[0]*size[1]*size[2]*size[3]*size[4]*sizeof(T)));
+    *data = static_cast<T*>(ALAllocator::allocate(size[0]*size[1]*size[2]*size[3]*size[4]*sizeof(T)));
     for (int m=0; m<size[4]; m++) 
       for (int l=0; l<size[3]; l++) 
 	for (int k=0; k<size[2]; k++) 
@@ -610,7 +610,7 @@ void readDataTemp(T **data,
 	      curcontent >> temp_imanip<T>() >> (*data)[m*size[3]*size[2]*size[1]*size[0]+l*size[2]*size[1]*size[0]+k*size[1]*size[0]+j*size[0]+i] >> temp_imanip<T>();
     break;
   case 6:
-    *data = static_cast<T*>(malloc(size[0]*size[1]*size[2]*size[3]*size[4]*size[5]*sizeof(T)));
+    *data = static_cast<T*>(ALAllocator::allocate(size[0]*size[1]*size[2]*size[3]*size[4]*size[5]*sizeof(T)));
     for (int n=0; n<size[5]; n++) 
       for (int m=0; m<size[4]; m++) 
 	for (int l=0; l<size[3]; l++) 
@@ -620,7 +620,7 @@ void readDataTemp(T **data,
 		curcontent >> temp_imanip<T>() >> (*data)[n*size[4]*size[3]*size[2]*size[1]*size[0]+m*size[3]*size[2]*size[1]*size[0]+l*size[2]*size[1]*size[0]+k*size[1]*size[0]+j*size[0]+i] >> temp_imanip<T>();
     break;
   case 7:
-    *data = static_cast<T*>(malloc(size[0]*size[1]*size[2]*size[3]*size[4]*size[5]*size[6]*sizeof(T)));
+    *data = static_cast<T*>(ALAllocator::allocate(size[0]*size[1]*size[2]*size[3]*size[4]*size[5]*size[6]*sizeof(T)));
     for (int o=0; o<size[6]; o++) 
       for (int n=0; n<size[5]; n++) 
 	for (int m=0; m<size[4]; m++) 
@@ -69,16 +69,16 @@ public:
   void beginAction(OperationContext *ctx) override;
   void endAction(Context *ctx) override; 
   void writeData(Context *ctx,
-			 std::string fieldname,
-			 std::string timebasename, 
+			 ALPath fieldname,
+			 ALPath timebasename, 
 			 void* data,
 			 int datatype,
 			 int dim,
 			 int* size) override;
 
   int readData(Context *ctx,
-		       std::string fieldname,
-		       std::string timebasename, 
+		       ALPath fieldname,
+		       ALPath timebasename, 
 		       void** data,
 		       int* datatype,
 		       int* dim,
@@ -0,0 +1,1024 @@
+#include "async_backend.h"
+#include "profiling_backend.h"
+#include "cache_backend.h"
+
+#include <string.h>
+
+
+std::mutex AsyncBackend::plansMutex;
+uint64_t AsyncBackend::plansClock = 0;
+std::map<std::string, AsyncBackend::LearnedPlan> AsyncBackend::plans;
+
+
+namespace {
+
+  // serializes the backends that are not thread-safe across all data entries of the process
+  std::recursive_mutex libraryMutex;
+
+  class TargetLock
+  {
+  public:
+    TargetLock(bool serialized) : locked(serialized)
+    {
+      if (locked)
+	libraryMutex.lock();
+    }
+    ~TargetLock()
+    {
+      if (locked)
+	libraryMutex.unlock();
+    }
+  private:
+    bool locked;
+  };
+
+  ArraystructContext* newArraystructContext(Context *parent, const std::string &path, const std::string &tb)
+  {
+    if (parent->getType() == CTX_ARRAYSTRUCT_TYPE)
+      return new ArraystructContext(static_cast<ArraystructContext *>(parent), path, tb);
+    return new ArraystructContext(static_cast<OperationContext *>(parent), path, tb);
+  }
+
+  // moves an array of structure context to a given element
+  void moveTo(Context *ctx, int element)
+  {
+    if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE)
+      {
+	ArraystructContext *actx = static_cast<ArraystructContext *>(ctx);
+	actx->nextIndex(element - actx->getIndex());
+      }
+  }
+
+  int indexOf(Context *ctx)
+  {
+    if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE)
+      return static_cast<ArraystructContext *>(ctx)->getIndex();
+    return 0;
+  }
+
+  // context containing an array of structure (the operation for top-level ones)
+  Context* parentOf(ArraystructContext *actx)
+  {
+    if (actx->getParent() != NULL)
+      return actx->getParent();
+    return actx->getOperationContext();
+  }
+
+}
+
+
+void ALReadPlan::addField(ALPath field, ALPath timebase, int datatype, int dim)
+{
+  if (fieldIds.insert(field.id()).second)
+    fields.push_back(Field{field, timebase, datatype, dim});
+}
+
+ALReadPlan* ALReadPlan::addAoS(ALPath path, ALPath timebase)
+{
+  auto found = aosIndex.find(path.id());
+  if (found != aosIndex.end())
+    return aos[found->second].element.get();
+  aosIndex.emplace(path.id(), aos.size());
+  aos.push_back(AoS{path, timebase, std::unique_ptr<ALReadPlan>(new ALReadPlan())});
+  return aos.back().element.get();
+}
+
+void ALReadPlan::merge(const ALReadPlan &other)
+{
+  for (const auto &f : other.fields)
+    addField(f.field, f.timebase, f.datatype, f.dim);
+  for (const auto &a : other.aos)
+    addAoS(a.path, a.timebase)->merge(*a.element);
+}
+
+std::unique_ptr<ALReadPlan> ALReadPlan::clone() const
+{
+  std::unique_ptr<ALReadPlan> copy(new ALReadPlan());
+  copy->fields = fields;
+  copy->fieldIds = fieldIds;
+  copy->aosIndex = aosIndex;
+  for (const auto &a : aos)
+    copy->aos.push_back(AoS{a.path, a.timebase, a.element->clone()});
+  return copy;
+}
+
+
+// marks a synchronous action on the target for the duration of a call
+class AsyncBackend::SyncScope
+{
+public:
+  SyncScope(AsyncBackend &b) : backend(b) { backend.acquire(); }
+  ~SyncScope() { backend.release(); }
+private:
+  AsyncBackend &backend;
+};
+
+
+AsyncBackend::AsyncBackend(Backend *targetB, bool serializedB)
+  : target(targetB), serialized(serializedB)
+{
+}
+
+AsyncBackend::~AsyncBackend()
+{
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    stopping = true;
+  }
+  cv.notify_all();
+  if (worker.joinable())
+    worker.join();
+  delete target;
+}
+
+AsyncBackend* AsyncBackend::find(Backend *be)
+{
+  ProfilingBackend *pbe = dynamic_cast<ProfilingBackend *>(be);
+  if (pbe != NULL)
+    be = pbe->getTarget();
+  CacheBackend *cbe = dynamic_cast<CacheBackend *>(be);
+  if (cbe != NULL)
+    be = cbe->getTarget();
+  return dynamic_cast<AsyncBackend *>(be);
+}
+
+std::string AsyncBackend::planName(const std::string &dataobjectname)
+{
+  return dataobjectname.substr(0, dataobjectname.find('/'));
+}
+
+void AsyncBackend::enqueue(std::function<void()> task)
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  tasks.push_back(std::move(task));
+  if (!worker.joinable())
+    worker = std::thread(&AsyncBackend::run, this);
+  cv.notify_all();
+}
+
+void AsyncBackend::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+    {
+      cv.wait(lock, [this]() { return stopping || (!tasks.empty() && syncActions == 0); });
+      if (tasks.empty() || (syncActions > 0 && !stopping))
+	{
+	  if (stopping)
+	    return;
+	  continue;
+	}
+      std::function<void()> task = std::move(tasks.front());
+      tasks.pop_front();
+      running = true;
+      lock.unlock();
+      try {
+	TargetLock targetLock(serialized);
+	task();
+      }
+      catch (const std::exception &e) {
+	std::lock_guard<std::mutex> guard(mutex);
+	if (error.empty())
+	  error = e.what();
+      }
+      lock.lock();
+      running = false;
+      cv.notify_all();
+    }
+}
+
+void AsyncBackend::acquire()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  if (syncActions == 0)
+    cv.wait(lock, [this]() { return tasks.empty() && !running; });
+  syncActions++;
+}
+
+void AsyncBackend::release()
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  if (--syncActions == 0)
+    cv.notify_all();
+}
+
+std::string AsyncBackend::drain()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  // pending tasks cannot run while a synchronous action is in progress
+  if (syncActions == 0 || tasks.empty())
+    cv.wait(lock, [this]() { return (tasks.empty() || syncActions > 0) && !running; });
+  std::string result;
+  result.swap(error);
+  return result;
+}
+
+void AsyncBackend::wait()
+{
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (syncActions > 0 && !tasks.empty())
+      throw ALBackendException("Cannot wait for the asynchronous operations of the data entry while an action is in progress on it",LOG);
+  }
+  std::string failure = drain();
+  if (!failure.empty())
+    throw ALBackendException("Asynchronous operation failed: "+failure,LOG);
+}
+
+
+std::pair<int,int> AsyncBackend::getVersion(DataEntryContext *ctx)
+{
+  if (ctx == NULL)
+    {
+      TargetLock targetLock(serialized);
+      return target->getVersion(NULL);
+    }
+  if (!fileVersionKnown)
+    {
+      SyncScope scope(*this);
+      TargetLock targetLock(serialized);
+      fileVersion = target->getVersion(ctx);
+      fileVersionKnown = true;
+    }
+  return fileVersion;
+}
+
+void AsyncBackend::openPulse(DataEntryContext *ctx,
+			     int mode)
+{
+  SyncScope scope(*this);
+  TargetLock targetLock(serialized);
+  fileVersionKnown = false;
+  target->openPulse(ctx, mode);
+}
+
+void AsyncBackend::closePulse(DataEntryContext *ctx,
+			      int mode)
+{
+  std::string failure = drain();
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!tasks.empty())
+      {
+	tasks.clear();
+	if (failure.empty())
+	  failure = "asynchronous operations discarded by closePulse while an action is in progress";
+      }
+  }
+  prefetches.clear();
+  {
+    SyncScope scope(*this);
+    TargetLock targetLock(serialized);
+    target->closePulse(ctx, mode);
+  }
+  if (!failure.empty())
+    throw ALBackendException("Asynchronous operation failed: "+failure,LOG);
+}
+
+void AsyncBackend::beginAction(OperationContext *ctx)
+{
+  std::unique_ptr<Staging> s(new Staging());
+  s->op = ctx;
+  std::string name = ctx->getDataobjectName();
+  bool global = ctx->getRangemode() == alconst::global_op && ctx->getDatapath().empty();
+
+  if (ctx->getAccessmode() != alconst::read_op)
+    {
+      // data staged for this IDS is outdated
+      auto found = prefetches.find(name);
+      if (found != prefetches.end())
+	{
+	  {
+	    std::lock_guard<std::mutex> guard(mutex);
+	    if (found->second->state == Prefetch::QUEUED)
+	      found->second->state = Prefetch::CANCELLED;
+	  }
+	  prefetches.erase(found);
+	}
+    }
+
+  if (global && ctx->getAccessmode() == alconst::read_op)
+    {
+      auto found = prefetches.find(name);
+      if (found != prefetches.end())
+	{
+	  s->mode = Staging::PENDING;
+	  s->prefetch = found->second;
+	  prefetches.erase(found);
+	  stagings[ctx] = std::move(s);
+	  return;
+	}
+      s->learned.reset(new ALReadPlan());
+      s->planNodes[ctx] = s->learned.get();
+    }
+  else if (global && ctx->getAccessmode() == alconst::write_op && asyncWrite)
+    {
+      s->mode = Staging::WRITE;
+      s->contexts[ctx] = 0;
+      stagings[ctx] = std::move(s);
+      return;
+    }
+
+  s->mode = Staging::PASSTHROUGH;
+  acquire();
+  try {
+    TargetLock targetLock(serialized);
+    target->beginAction(ctx);
+  }
+  catch (...) {
+    release();
+    throw;
+  }
+  stagings[ctx] = std::move(s);
+}
+
+AsyncBackend::Staging* AsyncBackend::findStaging(Context *ctx)
+{
+  OperationContext *op = NULL;
+  if (ctx->getType() == CTX_OPERATION_TYPE)
+    op = static_cast<OperationContext *>(ctx);
+  else if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE)
+    op = static_cast<ArraystructContext *>(ctx)->getOperationContext();
+  else
+    return NULL;
+  auto found = stagings.find(op);
+  return (found != stagings.end()) ? found->second.get() : NULL;
+}
+
+void AsyncBackend::endAction(Context *ctx)
+{
+  if (ctx->getType() == CTX_PULSE_TYPE)
+    {
+      std::string failure = drain();
+      TargetLock targetLock(serialized);
+      target->endAction(ctx);
+      if (!failure.empty())
+	throw ALBackendException("Asynchronous operation failed: "+failure,LOG);
+      return;
+    }
+
+  Staging *s = findStaging(ctx);
+  bool isOperation = ctx->getType() == CTX_OPERATION_TYPE;
+  if (s == NULL)
+    {
+      TargetLock targetLock(serialized);
+      target->endAction(ctx);
+      return;
+    }
+
+  switch (s->mode)
+    {
+    case Staging::PASSTHROUGH:
+      s->planNodes.erase(ctx);
+      if (!isOperation)
+	{
+	  TargetLock targetLock(serialized);
+	  target->endAction(ctx);
+	  return;
+	}
+      try {
+	TargetLock targetLock(serialized);
+	target->endAction(ctx);
+      }
+      catch (...) {
+	stagings.erase(static_cast<OperationContext *>(ctx));
+	release();
+	throw;
+      }
+      learn(*s);
+      stagings.erase(static_cast<OperationContext *>(ctx));
+      release();
+      return;
+
+    case Staging::WRITE:
+      if (!isOperation)
+	{
+	  ArraystructContext *actx = static_cast<ArraystructContext *>(ctx);
+	  StagedCall call;
+	  call.kind = StagedCall::END;
+	  call.ctx = s->contexts[ctx];
+	  call.element = actx->getIndex();
+	  s->calls.push_back(std::move(call));
+	  s->contexts.erase(ctx);
+	}
+      else
+	{
+	  OperationContext *octx = static_cast<OperationContext *>(ctx);
+	  std::shared_ptr<OperationContext> op(new OperationContext(octx->getDataEntryContext(),
+								    octx->getDataobjectName(),
+								    octx->getDatapath(),
+								    octx->getAccessmode()));
+	  std::shared_ptr<std::vector<StagedCall>> calls(new std::vector<StagedCall>());
+	  calls->swap(s->calls);
+	  stagings.erase(octx);
+	  enqueue([this, op, calls]() { replay(op.get(), *calls); });
+	}
+      return;
+
+    default:
+      if (isOperation)
+	{
+	  if (s->prefetch)
+	    {
+	      std::lock_guard<std::mutex> guard(mutex);
+	      if (s->prefetch->state == Prefetch::QUEUED)
+		s->prefetch->state = Prefetch::CANCELLED;
+	    }
+	  learn(*s);
+	  stagings.erase(static_cast<OperationContext *>(ctx));
+	}
+      else
+	{
+	  s->aos.erase(ctx);
+	  s->planNodes.erase(ctx);
+	}
+      return;
+    }
+}
+
+void AsyncBackend::resolve(Staging &s)
+{
+  if (s.mode != Staging::PENDING)
+    return;
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    // the prefetch cannot run before the synchronous actions in progress end
+    if (s.prefetch->state == Prefetch::QUEUED && syncActions > 0)
+      s.prefetch->state = Prefetch::CANCELLED;
+    else
+      cv.wait(lock, [&s]() { return s.prefetch->state != Prefetch::QUEUED; });
+  }
+
+  s.learned.reset(new ALReadPlan());
+  s.planNodes[s.op] = s.learned.get();
+
+  if (s.prefetch->state == Prefetch::DONE)
+    {
+      s.mode = Staging::STAGED;
+      return;
+    }
+
+  s.prefetch.reset();
+  acquire();
+  try {
+    TargetLock targetLock(serialized);
+    target->beginAction(s.op);
+  }
+  catch (...) {
+    release();
+    throw;
+  }
+  s.mode = Staging::PASSTHROUGH;
+}
+
+ALStagedNode* AsyncBackend::stagedNode(Staging &s, Context *ctx)
+{
+  if (ctx->getType() == CTX_OPERATION_TYPE)
+    return s.prefetch->root.get();
+  auto found = s.aos.find(ctx);
+  if (found == s.aos.end() || found->second == NULL)
+    return NULL;
+  int index = static_cast<ArraystructContext *>(ctx)->getIndex();
+  if (index < 0 || index >= (int)found->second->elements.size())
+    return NULL;
+  return found->second->elements[index].get();
+}
+
+void AsyncBackend::record(Staging &s, Context *ctx, ALPath field, ALPath timebase, int datatype, int dim)
+{
+  auto found = s.planNodes.find(ctx);
+  if (found == s.planNodes.end())
+    return;
+  found->second->addField(field, timebase, datatype, dim);
+}
+
+void AsyncBackend::learn(Staging &s)
+{
+  if (!s.learned || s.learned->empty())
+    return;
+  std::lock_guard<std::mutex> guard(plansMutex);
+  LearnedPlan &learned = plans[planName(s.op->getDataobjectName())];
+  if (learned.plan)
+    learned.plan->merge(*s.learned);
+  else
+    learned.plan = std::move(s.learned);
+  learned.lastUse = ++plansClock;
+  if (plans.size() > MAX_PLANS)
+    {
+      auto oldest = plans.begin();
+      for (auto it = plans.begin(); it != plans.end(); ++it)
+	if (it->second.lastUse < oldest->second.lastUse)
+	  oldest = it;
+      plans.erase(oldest);
+    }
+}
+
+int AsyncBackend::readStaged(Staging &s, Context *ctx, ALPath field, void **data, int *datatype, int *dim, int *size)
+{
+  ALStagedNode *node = stagedNode(s, ctx);
+  if (node == NULL)
+    return -1;
+  auto found = node->fields.find(field.id());
+  if (found == node->fields.end())
+    return -1;
+  ALStagedNode::Data &d = found->second;
+  int result = d.found;
+  *datatype = d.datatype;
+  *dim = d.dim;
+  memcpy(size, d.size, sizeof(d.size));
+  *data = d.data.release();
+  // data is handed over: reading it again goes to the target
+  node->fields.erase(found);
+  return result;
+}
+
+void AsyncBackend::readThrough(Staging &s, Context *ctx, const std::function<void(Context *)> &f)
+{
+  std::vector<ArraystructContext *> chain;
+  for (Context *c = ctx; c->getType() == CTX_ARRAYSTRUCT_TYPE; c = parentOf(static_cast<ArraystructContext *>(c)))
+    chain.insert(chain.begin(), static_cast<ArraystructContext *>(c));
+
+  SyncScope scope(*this);
+  TargetLock targetLock(serialized);
+  OperationContext op(s.op->getDataEntryContext(), s.op->getDataobjectName(), "", alconst::read_op);
+  target->beginAction(&op);
+  std::vector<std::unique_ptr<ArraystructContext>> levels;
+  try {
+    Context *current = &op;
+    bool positioned = true;
+    for (ArraystructContext *a : chain)
+      {
+	levels.emplace_back(newArraystructContext(current, a->getPath(), a->getTimebasePath()));
+	int n = 0;
+	target->beginArraystructAction(levels.back().get(), &n);
+	if (a->getIndex() >= n)
+	  {
+	    positioned = false;
+	    break;
+	  }
+	levels.back()->nextIndex(a->getIndex());
+	current = levels.back().get();
+      }
+    if (positioned)
+      f(current);
+  }
+  catch (...) {
+    for (auto it = levels.rbegin(); it != levels.rend(); ++it)
+      {
+	try { target->endAction(it->get()); } catch (...) {}
+      }
+    try { target->endAction(&op); } catch (...) {}
+    throw;
+  }
+  for (auto it = levels.rbegin(); it != levels.rend(); ++it)
+    target->endAction(it->get());
+  target->endAction(&op);
+}
+
+void AsyncBackend::writeData(Context *ctx,
+			     ALPath fieldname,
+			     ALPath timebasename,
+			     void* data,
+			     int datatype,
+			     int dim,
+			     int* size)
+{
+  Staging *s = findStaging(ctx);
+  if (s == NULL || s->mode != Staging::WRITE)
+    {
+      TargetLock targetLock(serialized);
+      target->writeData(ctx, fieldname, timebasename, data, datatype, dim, size);
+      return;
+    }
+
+  StagedCall call;
+  call.kind = StagedCall::WRITE;
+  call.ctx = s->contexts[ctx];
+  call.element = indexOf(ctx);
+  call.path = fieldname;
+  call.timebase = timebasename;
+  call.datatype = datatype;
+  call.dim = dim;
+  if (dim > 0)
+    call.size.assign(size, size + dim);
+  size_t bytes = getDataByteSize(datatype, dim, size);
+  call.data.assign((char *)data, (char *)data + bytes);
+  s->calls.push_back(std::move(call));
+}
+
+int AsyncBackend::readData(Context *ctx,
+			   ALPath fieldname,
+			   ALPath timebasename,
+			   void** data,
+			   int* datatype,
+			   int* dim,
+			   int* size)
+{
+  Staging *s = findStaging(ctx);
+  if (s == NULL)
+    {
+      TargetLock targetLock(serialized);
+      return target->readData(ctx, fieldname, timebasename, data, datatype, dim, size);
+    }
+  if (s->mode == Staging::WRITE)
+    throw ALBackendException("Cannot read data from an asynchronous write operation",LOG);
+
+  resolve(*s);
+  record(*s, ctx, fieldname, timebasename, *datatype, *dim);
+  if (s->mode == Staging::PASSTHROUGH)
+    {
+      TargetLock targetLock(serialized);
+      return target->readData(ctx, fieldname, timebasename, data, datatype, dim, size);
+    }
+
+  int found = readStaged(*s, ctx, fieldname, data, datatype, dim, size);
+  if (found >= 0)
+    return found;
+  found = 0;
+  readThrough(*s, ctx, [&](Context *c) {
+      found = target->readData(c, fieldname, timebasename, data, datatype, dim, size);
+    });
+  return found;
+}
+
+int AsyncBackend::readDataInto(Context *ctx,
+			       ALPath fieldname,
+			       ALPath timebasename,
+			       void* dst,
+			       size_t capacity,
+			       void** data,
+			       int* datatype,
+			       int* dim,
+			       int* size)
+{
+  Staging *s = findStaging(ctx);
+  if (s != NULL && s->mode != Staging::WRITE)
+    resolve(*s);
+  if (s != NULL && s->mode != Staging::PASSTHROUGH)
+    return Backend::readDataInto(ctx, fieldname, timebasename, dst, capacity, data, datatype, dim, size);
+
+  if (s != NULL)
+    record(*s, ctx, fieldname, timebasename, *datatype, *dim);
+  TargetLock targetLock(serialized);
+  return target->readDataInto(ctx, fieldname, timebasename, dst, capacity, data, datatype, dim, size);
+}
+
+int AsyncBackend::readDataShape(Context *ctx,
+				ALPath fieldname,
+				ALPath timebasename,
+				int* datatype,
+				int* dim,
+				int* size)
+{
+  Staging *s = findStaging(ctx);
+  if (s != NULL && s->mode != Staging::WRITE)
+    resolve(*s);
+  if (s == NULL || s->mode == Staging::PASSTHROUGH)
+    {
+      TargetLock targetLock(serialized);
+      return target->readDataShape(ctx, fieldname, timebasename, datatype, dim, size);
+    }
+
+  if (s->mode == Staging::STAGED)
+    {
+      // metadata is peeked at, the data is left for the next read
+      ALStagedNode *node = stagedNode(*s, ctx);
+      if (node != NULL)
+	{
+	  auto found = node->fields.find(fieldname.id());
+	  if (found != node->fields.end())
+	    {
+	      *datatype = found->second.datatype;
+	      *dim = found->second.dim;
+	      memcpy(size, found->second.size, sizeof(found->second.size));
+	      return found->second.found;
+	    }
+	}
+    }
+  return Backend::readDataShape(ctx, fieldname, timebasename, datatype, dim, size);
+}
+
+void AsyncBackend::writeDataBatch(Context *ctx,
+				  std::vector<DataBatchItem> &items)
+{
+  Staging *s = findStaging(ctx);
+  if (s != NULL && s->mode == Staging::WRITE)
+    {
+      Backend::writeDataBatch(ctx, items);
+      return;
+    }
+  TargetLock targetLock(serialized);
+  target->writeDataBatch(ctx, items);
+}
+
+void AsyncBackend::readDataBatch(Context *ctx,
+				 std::vector<DataBatchItem> &items)
+{
+  Staging *s = findStaging(ctx);
+  if (s != NULL && s->mode != Staging::WRITE)
+    resolve(*s);
+  if (s != NULL && s->mode != Staging::PASSTHROUGH)
+    {
+      Backend::readDataBatch(ctx, items);
+      return;
+    }
+
+  if (s != NULL)
+    for (const auto &item : items)
+      record(*s, ctx, item.fieldname, item.timebasename, item.datatype, item.dim);
+  TargetLock targetLock(serialized);
+  target->readDataBatch(ctx, items);
+}
+
+void AsyncBackend::deleteData(OperationContext *ctx,
+			      std::string path)
+{
+  Staging *s = findStaging(ctx);
+  if (s == NULL || s->mode != Staging::WRITE)
+    {
+      TargetLock targetLock(serialized);
+      target->deleteData(ctx, path);
+      return;
+    }
+
+  StagedCall call;
+  call.kind = StagedCall::DELETE;
+  call.ctx = 0;
+  call.element = 0;
+  call.path = ALPath(path);
+  s->calls.push_back(std::move(call));
+}
+
+void AsyncBackend::beginArraystructAction(ArraystructContext *ctx,
+					  int *size)
+{
+  Staging *s = findStaging(ctx);
+  Context *parent = parentOf(ctx);
+  if (s == NULL)
+    {
+      TargetLock targetLock(serialized);
+      target->beginArraystructAction(ctx, size);
+      return;
+    }
+
+  if (s->mode == Staging::WRITE)
+    {
+      StagedCall call;
+      call.kind = StagedCall::BEGIN_ARRAYSTRUCT;
+      call.ctx = s->nextContext++;
+      call.parent = s->contexts[parent];
+      call.element = indexOf(parent);
+      call.path = ALPath(ctx->getPath());
+      call.timebase = ALPath(ctx->getTimebasePath());
+      call.dim = *size;
+      s->contexts[ctx] = call.ctx;
+      s->calls.push_back(std::move(call));
+      return;
+    }
+
+  resolve(*s);
+  ALPath path(ctx->getPath());
+  auto node = s->planNodes.find(parent);
+  if (node != s->planNodes.end())
+    s->planNodes[ctx] = node->second->addAoS(path, ALPath(ctx->getTimebasePath()));
+
+  if (s->mode == Staging::PASSTHROUGH)
+    {
+      TargetLock targetLock(serialized);
+      target->beginArraystructAction(ctx, size);
+      return;
+    }
+
+  ALStagedNode *staged = stagedNode(*s, parent);
+  if (staged != NULL)
+    {
+      auto found = staged->aos.find(path.id());
+      if (found != staged->aos.end())
+	{
+	  s->aos[ctx] = &found->second;
+	  *size = found->second.size;
+	  return;
+	}
+    }
+  s->aos[ctx] = NULL;
+  *size = 0;
+  readThrough(*s, parent, [&](Context *c) {
+      std::unique_ptr<ArraystructContext> actx(newArraystructContext(c, ctx->getPath(), ctx->getTimebasePath()));
+      target->beginArraystructAction(actx.get(), size);
+      target->endAction(actx.get());
+    });
+}
+
+void AsyncBackend::get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size)
+{
+  SyncScope scope(*this);
+  TargetLock targetLock(serialized);
+  target->get_occurrences(ctx, ids_name, occurrences_list, size);
+}
+
+size_t AsyncBackend::stagedBytes(const ALStagedNode &node)
+{
+  size_t bytes = 0;
+  for (auto &kv : node.fields)
+    if (kv.second.data)
+      bytes += getDataByteSize(kv.second.datatype, kv.second.dim, kv.second.size);
+  for (auto &kv : node.aos)
+    for (auto &element : kv.second.elements)
+      if (element)
+	bytes += stagedBytes(*element);
+  return bytes;
+}
+
+void AsyncBackend::getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage)
+{
+  SyncScope scope(*this);
+  // staged data not handed over yet: prefetched IDSs, gets in progress and puts not replayed yet
+  for (auto &kv : prefetches)
+    if (kv.second->root)
+      usage.add("async", kv.first, stagedBytes(*kv.second->root));
+  for (auto &kv : stagings)
+    {
+      size_t bytes = 0;
+      if (kv.second->prefetch && kv.second->prefetch->root)
+	bytes += stagedBytes(*kv.second->prefetch->root);
+      for (auto &call : kv.second->calls)
+	bytes += call.data.capacity();
+      usage.add("async", kv.first->getDataobjectName(), bytes);
+    }
+  TargetLock targetLock(serialized);
+  target->getMemoryUsage(ctx, usage);
+}
+
+bool AsyncBackend::getIncrementalPutCounters(DataEntryContext *ctx, ALIncrementalPutCounters &counters)
+{
+  // waits for the puts running in the background
+  SyncScope scope(*this);
+  TargetLock targetLock(serialized);
+  return target->getIncrementalPutCounters(ctx, counters);
+}
+
+bool AsyncBackend::getDedupCounters(DataEntryContext *ctx, ALDedupCounters &counters)
+{
+  // waits for the puts running in the background
+  SyncScope scope(*this);
+  TargetLock targetLock(serialized);
+  return target->getDedupCounters(ctx, counters);
+}
+
+
+void AsyncBackend::prefetch(DataEntryContext *ctx, const std::string &dataobjectname)
+{
+  std::shared_ptr<Prefetch> p(new Prefetch());
+  {
+    std::lock_guard<std::mutex> guard(plansMutex);
+    auto found = plans.find(planName(dataobjectname));
+    if (found != plans.end())
+      {
+	p->plan = found->second.plan->clone();
+	found->second.lastUse = ++plansClock;
+      }
+  }
+
+  auto previous = prefetches.find(dataobjectname);
+  if (previous != prefetches.end())
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      if (previous->second->state == Prefetch::QUEUED)
+	previous->second->state = Prefetch::CANCELLED;
+    }
+  prefetches[dataobjectname] = p;
+
+  if (!p->plan)
+    {
+      // nothing learned yet, the get reads from the target
+      p->state = Prefetch::UNAVAILABLE;
+      return;
+    }
+
+  enqueue([this, p, ctx, dataobjectname]() {
+      {
+	std::lock_guard<std::mutex> guard(mutex);
+	if (p->state == Prefetch::CANCELLED)
+	  return;
+      }
+      Prefetch::State state = Prefetch::UNAVAILABLE;
+      std::unique_ptr<ALStagedNode> root(new ALStagedNode());
+      try {
+	OperationContext op(ctx, dataobjectname, "", alconst::read_op);
+	target->beginAction(&op);
+	try {
+	  stage(&op, *p->plan, *root);
+	}
+	catch (...) {
+	  target->endAction(&op);
+	  throw;
+	}
+	target->endAction(&op);
+	state = Prefetch::DONE;
+      }
+      catch (...) {
+	// the get will read from the target and report the error
+	root.reset();
+      }
+      std::lock_guard<std::mutex> guard(mutex);
+      if (p->state == Prefetch::QUEUED)
+	{
+	  p->root = std::move(root);
+	  p->state = state;
+	}
+      cv.notify_all();
+    });
+}
+
+void AsyncBackend::stage(Context *ctx, const ALReadPlan &plan, ALStagedNode &node)
+{
+  for (const auto &f : plan.fields)
+    {
+      ALStagedNode::Data &d = node.fields[f.field.id()];
+      void *data = NULL;
+      d.datatype = f.datatype;
+      d.dim = f.dim;
+      d.found = target->readData(ctx, f.field, f.timebase, &data, &d.datatype, &d.dim, d.size);
+      d.data.reset(data);
+    }
+
+  for (const auto &a : plan.aos)
+    {
+      ALStagedNode::AoS &staged = node.aos[a.path.id()];
+      std::unique_ptr<ArraystructContext> actx(newArraystructContext(ctx, a.path, a.timebase));
+      target->beginArraystructAction(actx.get(), &staged.size);
+      try {
+	for (int i = 0; i < staged.size; i++)
+	  {
+	    staged.elements.emplace_back(new ALStagedNode());
+	    stage(actx.get(), *a.element, *staged.elements.back());
+	    actx->nextIndex(1);
+	  }
+      }
+      catch (...) {
+	target->endAction(actx.get());
+	throw;
+      }
+      target->endAction(actx.get());
+    }
+}
+
+void AsyncBackend::replay(OperationContext *op, std::vector<StagedCall> &calls)
+{
+  std::map<int, std::unique_ptr<ArraystructContext>> contexts;
+  auto context = [&](int id) -> Context * {
+    if (id == 0)
+      return op;
+    auto found = contexts.find(id);
+    if (found == contexts.end())
+      throw ALBackendException("Unknown context in staged write of "+op->getDataobjectName(),LOG);
+    return found->second.get();
+  };
+
+  target->beginAction(op);
+  try {
+    for (auto &call : calls)
+      {
+	switch (call.kind)
+	  {
+	  case StagedCall::WRITE:
+	    {
+	      Context *c = context(call.ctx);
+	      moveTo(c, call.element);
+	      target->writeData(c, call.path, call.timebase, call.data.data(), call.datatype, call.dim,
+				call.size.empty() ? NULL : call.size.data());
+	      break;
+	    }
+	  case StagedCall::DELETE:
+	    target->deleteData(op, call.path.str());
+	    break;
+	  case StagedCall::BEGIN_ARRAYSTRUCT:
+	    {
+	      Context *parent = context(call.parent);
+	      moveTo(parent, call.element);
+	      ArraystructContext *actx = newArraystructContext(parent, call.path, call.timebase);
+	      contexts[call.ctx].reset(actx);
+	      target->beginArraystructAction(actx, &call.dim);
+	      break;
+	    }
+	  case StagedCall::END:
+	    {
+	      Context *c = context(call.ctx);
+	      moveTo(c, call.element);
+	      target->endAction(c);
+	      contexts.erase(call.ctx);
+	      break;
+	    }
+	  }
+      }
+  }
+  catch (...) {
+    try { target->endAction(op); } catch (...) {}
+    CacheBackend::notifyWrite(op->getDataEntryContext());
+    throw;
+  }
+  target->endAction(op);
+  // the data entries cached on the same data may have read it before the put landed
+  CacheBackend::notifyWrite(op->getDataEntryContext());
+}
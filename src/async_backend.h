@@ -0,0 +1,299 @@
+//-*-c++-*-
+
+#ifndef ASYNC_BACKEND_H
+#define ASYNC_BACKEND_H 1
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "al_backend.h"
+
+#if defined(_WIN32)
+#  define IMAS_CORE_LIBRARY_API __declspec(dllexport)
+#else
+#  define IMAS_CORE_LIBRARY_API
+#endif
+
+#ifdef __cplusplus
+
+/**
+   Reads issued by a whole IDS get, learned from the previous gets of the same IDS.
+   One node per structure level: fields read in the structure and arrays of structures begun
+   in it, with the reads of their elements (union of the reads of all elements).
+*/
+struct IMAS_CORE_LIBRARY_API ALReadPlan
+{
+  struct Field
+  {
+    ALPath field;
+    ALPath timebase;
+    int datatype;
+    int dim;
+  };
+  struct AoS
+  {
+    ALPath path;
+    ALPath timebase;
+    std::unique_ptr<ALReadPlan> element;
+  };
+
+  std::vector<Field> fields;
+  std::vector<AoS> aos;
+  std::unordered_set<uint32_t> fieldIds;        /**< ALPath::id() of the fields */
+  std::unordered_map<uint32_t, size_t> aosIndex;  /**< position in aos of each ALPath::id() */
+
+  void addField(ALPath field, ALPath timebase, int datatype, int dim);
+  ALReadPlan* addAoS(ALPath path, ALPath timebase);
+  void merge(const ALReadPlan &other);
+  std::unique_ptr<ALReadPlan> clone() const;
+  bool empty() const { return fields.empty() && aos.empty(); }
+};
+
+/**
+   In-memory staging tree of a prefetched IDS, filled by following an ALReadPlan.
+*/
+struct IMAS_CORE_LIBRARY_API ALStagedNode
+{
+  struct FreeDeleter
+  {
+    void operator()(void *p) const { ALAllocator::release(p); }
+  };
+  struct Data
+  {
+    int found = 0;
+    int datatype = 0;
+    int dim = 0;
+    int size[MAXDIM] = {};
+    std::unique_ptr<void, FreeDeleter> data;    /**< data returned by the backend, handed over at the first read */
+  };
+  struct AoS
+  {
+    int size = 0;
+    std::vector<std::unique_ptr<ALStagedNode>> elements;
+  };
+
+  std::unordered_map<uint32_t, Data> fields;    /**< key = ALPath::id() of the field */
+  std::unordered_map<uint32_t, AoS> aos;        /**< key = ALPath::id() of the array of structures */
+};
+
+
+/**
+   Backend decorator running whole IDS gets and puts on a background I/O thread.
+   Installed by Backend::initBackend in front of the backends doing actual I/O (HDF5, MDSplus, UDA)
+   of the data entries opened with async=yes.
+   Every Backend virtual is forwarded to the target backend, except for:
+   - global read operations of a prefetched IDS (see prefetch()): reads are served from the staging
+     tree filled in the background, data missing from the staging tree are read from the target;
+   - global write operations begun after setAsyncWrite(true): calls are staged, with a copy of the
+     data, and replayed on the background thread when the operation ends.
+   Background tasks and the synchronous actions of the data entry never overlap, and tasks are
+   run in order before the next synchronous action begins. Backends that are not thread-safe
+   (MDSplus, UDA) are additionally serialized with the tasks of all the other data entries.
+*/
+class IMAS_CORE_LIBRARY_API AsyncBackend : public Backend
+{
+public:
+
+  AsyncBackend(Backend *targetB, bool serializedB);
+
+  ~AsyncBackend();
+
+  /**
+     Returns the AsyncBackend of a data entry, if any (possibly behind a ProfilingBackend).
+  */
+  static AsyncBackend* find(Backend *be);
+
+  /**
+     Starts reading a whole IDS in the background.
+     The next global read operation on this IDS (without datapath) is served from the staged data.
+     The IDS is read following the reads issued by the previous gets of the same IDS in this process:
+     the first get of an IDS is read synchronously and only teaches the plan used by the next ones.
+     @param[in] ctx pointer on pulse context
+     @param[in] dataobjectname name of the IDS, with its occurrence ("<idsname>[/<occurrence>]")
+  */
+  void prefetch(DataEntryContext *ctx, const std::string &dataobjectname);
+
+  /**
+     Selects whether the next global write operation begun is staged and written in the background.
+  */
+  void setAsyncWrite(bool async) { asyncWrite = async; }
+
+  /**
+     Waits until all the background tasks of the data entry are done.
+     @throw ALBackendException with the error of the first failed background write, if any
+  */
+  void wait();
+
+  std::pair<int,int> getVersion(DataEntryContext *ctx) override;
+
+  void openPulse(DataEntryContext *ctx,
+		 int mode) override;
+
+  void closePulse(DataEntryContext *ctx,
+		  int mode) override;
+
+  void beginAction(OperationContext *ctx) override;
+
+  void endAction(Context *ctx) override;
+
+  void writeData(Context *ctx,
+		 ALPath fieldname,
+		 ALPath timebasename,
+		 void* data,
+		 int datatype,
+		 int dim,
+		 int* size) override;
+
+  int readData(Context *ctx,
+	       ALPath fieldname,
+	       ALPath timebasename,
+	       void** data,
+	       int* datatype,
+	       int* dim,
+	       int* size) override;
+
+  int readDataInto(Context *ctx,
+		   ALPath fieldname,
+		   ALPath timebasename,
+		   void* dst,
+		   size_t capacity,
+		   void** data,
+		   int* datatype,
+		   int* dim,
+		   int* size) override;
+
+  int readDataShape(Context *ctx,
+		    ALPath fieldname,
+		    ALPath timebasename,
+		    int* datatype,
+		    int* dim,
+		    int* size) override;
+
+  void writeDataBatch(Context *ctx,
+		      std::vector<DataBatchItem> &items) override;
+
+  void readDataBatch(Context *ctx,
+		     std::vector<DataBatchItem> &items) override;
+
+  void deleteData(OperationContext *ctx,
+		  std::string path) override;
+
+  void beginArraystructAction(ArraystructContext *ctx,
+			      int *size) override;
+
+  void get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) override;
+
+  void getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage) override;
+
+  bool getIncrementalPutCounters(DataEntryContext *ctx, ALIncrementalPutCounters &counters) override;
+
+  bool getDedupCounters(DataEntryContext *ctx, ALDedupCounters &counters) override;
+
+  bool supportsTimeDataInterpolation() override { return target->supportsTimeDataInterpolation(); }
+
+  void initDataInterpolationComponent() override { target->initDataInterpolationComponent(); }
+
+  bool supportsTimeRangeOperation() override { return target->supportsTimeRangeOperation(); }
+
+private:
+  struct Prefetch
+  {
+    enum State { QUEUED, DONE, UNAVAILABLE, CANCELLED };   // UNAVAILABLE: no plan yet or read failed
+    State state = QUEUED;
+    std::unique_ptr<ALReadPlan> plan;
+    std::unique_ptr<ALStagedNode> root;
+  };
+
+  // one staged write: calls recorded with a copy of their data, contexts are numbered from 0 (operation)
+  struct StagedCall
+  {
+    enum Kind { WRITE, DELETE, BEGIN_ARRAYSTRUCT, END };
+    Kind kind;
+    int ctx;                                    /**< context of the call */
+    int parent;                                 /**< parent context of a new array of structures */
+    int element;                                /**< current element of the context (or of the parent) */
+    ALPath path;
+    ALPath timebase;
+    int datatype;
+    int dim;                                    /**< dimension of the data (size of a new array of structures) */
+    std::vector<int> size;
+    std::vector<char> data;
+  };
+
+  // state of an operation served by the decorator (staged get or staged put)
+  struct Staging
+  {
+    enum Mode { PENDING, STAGED, PASSTHROUGH, WRITE };
+    Mode mode;
+    OperationContext *op;
+    std::shared_ptr<Prefetch> prefetch;
+    std::unordered_map<Context *, ALStagedNode::AoS *> aos;           /**< staged arrays of structures (NULL if not staged) */
+    std::unique_ptr<ALReadPlan> learned;                              /**< reads of this get, merged into plans at its end */
+    std::unordered_map<Context *, ALReadPlan *> planNodes;            /**< nodes of learned */
+    std::vector<StagedCall> calls;
+    std::unordered_map<Context *, int> contexts;                      /**< staged write contexts, 0 = operation */
+    int nextContext = 1;
+  };
+
+  class SyncScope;
+
+  Staging* findStaging(Context *ctx);
+  void resolve(Staging &s);
+  ALStagedNode* stagedNode(Staging &s, Context *ctx);
+  void record(Staging &s, Context *ctx, ALPath field, ALPath timebase, int datatype, int dim);
+  void learn(Staging &s);
+  int readStaged(Staging &s, Context *ctx, ALPath field, void **data, int *datatype, int *dim, int *size);
+  void readThrough(Staging &s, Context *ctx, const std::function<void(Context *)> &f);
+  void enqueue(std::function<void()> task);
+  std::string drain();
+  void acquire();
+  void release();
+  void run();
+  void stage(Context *ctx, const ALReadPlan &plan, ALStagedNode &node);
+  void replay(OperationContext *op, std::vector<StagedCall> &calls);
+  static std::string planName(const std::string &dataobjectname);
+  static size_t stagedBytes(const ALStagedNode &node);
+
+  Backend *target;
+  bool serialized;                              /**< target is not thread-safe */
+  bool asyncWrite = false;
+  std::pair<int,int> fileVersion;
+  bool fileVersionKnown = false;
+
+  std::unordered_map<OperationContext *, std::unique_ptr<Staging>> stagings;
+  std::map<std::string, std::shared_ptr<Prefetch>> prefetches;   /**< key = IDS name with occurrence */
+
+  std::mutex mutex;                             /**< protects the task queue and the counters below */
+  std::condition_variable cv;
+  std::deque<std::function<void()>> tasks;
+  bool running = false;                         /**< a task is running */
+  bool stopping = false;
+  int syncActions = 0;                          /**< synchronous actions in progress on the target */
+  std::string error;                            /**< first error of a background write */
+  std::thread worker;
+
+  struct LearnedPlan
+  {
+    std::unique_ptr<ALReadPlan> plan;
+    uint64_t lastUse = 0;
+  };
+  static const size_t MAX_PLANS = 64;           /**< least recently used plans beyond are forgotten */
+  static std::mutex plansMutex;                 /**< taken once per get and per prefetch */
+  static uint64_t plansClock;
+  static std::map<std::string, LearnedPlan> plans;  /**< key = IDS name */
+};
+
+#endif
+
+#endif
@@ -0,0 +1,457 @@
+#include "cache_backend.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string.h>
+
+#include <boost/filesystem.hpp>
+
+
+// cached data of all the data entries
+static ALMemoryUsage::Counter liveBytes("cache");
+
+std::mutex CacheBackend::registryMutex;
+std::map<std::string, std::weak_ptr<std::atomic<uint64_t>>> CacheBackend::registry;
+std::atomic<int> CacheBackend::registered(0);
+
+size_t CacheBackend::parseSize(const std::string &value)
+{
+  size_t end = 0;
+  unsigned long long n = 0;
+  try {
+    n = std::stoull(value, &end);
+  }
+  catch (const std::exception &e) {
+    throw ALBackendException("Invalid cache_size " + value + " (expected a number of bytes, e.g. 512MB)", LOG);
+  }
+  std::string unit = value.substr(end);
+  std::transform(unit.begin(), unit.end(), unit.begin(), [](unsigned char c) { return std::toupper(c); });
+  if (unit == "" || unit == "B")
+    return n;
+  if (unit == "K" || unit == "KB")
+    return n << 10;
+  if (unit == "M" || unit == "MB")
+    return n << 20;
+  if (unit == "G" || unit == "GB")
+    return n << 30;
+  throw ALBackendException("Invalid cache_size " + value + " (expected a number of bytes, e.g. 512MB)", LOG);
+}
+
+std::string CacheBackend::dataName(DataEntryContext *ctx)
+{
+  uri::Uri uri = ctx->getURI();
+  std::string name = ctx->getBackendName() + "://" + uri.authority.host + "/";
+  uri::OptionalValue path = uri.query.get("path");
+  if (path)
+    {
+      boost::system::error_code ec;
+      boost::filesystem::path canonical =
+	boost::filesystem::weakly_canonical(boost::filesystem::absolute(path.value()), ec);
+      return name + (ec ? path.value() : canonical.string());
+    }
+  for (const char *option : {"user", "database", "version", "pulse", "run"})
+    {
+      uri::OptionalValue value = uri.query.get(option);
+      name += std::string("?") + option + "=" + (value ? value.value() : "");
+    }
+  return name;
+}
+
+void CacheBackend::notifyWrite(DataEntryContext *ctx)
+{
+  if (registered.load() == 0)
+    return;
+  std::string name = dataName(ctx);
+  std::lock_guard<std::mutex> guard(registryMutex);
+  auto found = registry.find(name);
+  if (found == registry.end())
+    return;
+  std::shared_ptr<std::atomic<uint64_t>> g = found->second.lock();
+  if (g)
+    ++*g;
+  else
+    registry.erase(found);
+}
+
+void CacheBackend::sync()
+{
+  uint64_t g = currentGeneration();
+  if (g == seen)
+    return;
+  seen = g;
+  if (entries.empty())
+    return;
+  drop();
+  counters.invalidations++;
+}
+
+std::string CacheBackend::key(Context *ctx, ALPath fieldname, ALPath timebasename, int datatype)
+{
+  if (!timebasename.empty() || !ctx->isProjected(fieldname.str(), false))
+    return "";
+
+  // AoS elements: "path[index]/" from the top-most array of structure down
+  std::string aos;
+  OperationContext *opctx;
+  if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE)
+    {
+      ArraystructContext *actx = static_cast<ArraystructContext *>(ctx);
+      opctx = actx->getOperationContext();
+      for (; actx != NULL; actx = actx->getParent())
+	{
+	  if (actx->getTimed())
+	    return "";
+	  aos = actx->getPath() + "[" + std::to_string(actx->getIndex()) + "]/" + aos;
+	}
+    }
+  else if (ctx->getType() == CTX_OPERATION_TYPE)
+    opctx = static_cast<OperationContext *>(ctx);
+  else
+    return "";
+
+  if (opctx->getAccessmode() != READ_OP || opctx->getRangemode() != GLOBAL_OP)
+    return "";
+  return opctx->getDataobjectName() + ":" + aos + fieldname.str() + ":" + std::to_string(datatype);
+}
+
+int CacheBackend::lookup(const std::string &k, void *dst, size_t dstCapacity, void **data, int *datatype,
+			 int *dim, int *size)
+{
+  int expectedType = *datatype;
+  std::lock_guard<std::mutex> guard(mutex);
+  sync();
+  auto got = entries.find(k);
+  if (got == entries.end())
+    {
+      counters.misses++;
+      return -1;
+    }
+  counters.hits++;
+  Entry &e = got->second;
+  lru.splice(lru.begin(), lru, e.lru);
+  if (!e.found)
+    return 0;
+
+  *datatype = e.datatype;
+  *dim = e.dim;
+  std::copy_n(e.size, e.dim, size);
+  size_t bytes = getDataByteSize(e.datatype, e.dim, e.size);
+  if (data == NULL)
+    return 1;
+  if (dst != NULL && e.datatype == expectedType && bytes <= dstCapacity)
+    {
+      if (e.data != NULL)
+	memcpy(dst, e.data, bytes);
+      return 1;
+    }
+  *data = NULL;
+  if (e.data != NULL)
+    {
+      *data = ALAllocator::allocate(bytes);
+      memcpy(*data, e.data, bytes);
+    }
+  return 2;
+}
+
+void CacheBackend::store(const std::string &k, uint64_t readGeneration, int found, const void *data, int datatype,
+			 int dim, const int *size)
+{
+  size_t bytes = (found && data != NULL) ? getDataByteSize(datatype, dim, size) : 0;
+  size_t accounted = bytes + k.size() + sizeof(Entry);
+  if (accounted > budget)
+    return;
+
+  Entry e;
+  e.found = found;
+  if (found)
+    {
+      e.datatype = datatype;
+      e.dim = dim;
+      std::copy_n(size, dim, e.size);
+    }
+  if (bytes > 0)
+    {
+      e.data = malloc(bytes);
+      memcpy(e.data, data, bytes);
+    }
+  e.bytes = accounted;
+
+  std::lock_guard<std::mutex> guard(mutex);
+  sync();
+  if (entries.count(k) != 0 || readGeneration != seen)
+    {
+      // read concurrently by another thread, or written meanwhile through another data entry
+      free(e.data);
+      return;
+    }
+  while (counters.bytes + accounted > budget && !lru.empty())
+    {
+      auto victim = entries.find(lru.back());
+      counters.bytes -= victim->second.bytes;
+      liveBytes.sub(victim->second.bytes);
+      free(victim->second.data);
+      entries.erase(victim);
+      lru.pop_back();
+      counters.evictions++;
+    }
+  lru.push_front(k);
+  e.lru = lru.begin();
+  entries.emplace(k, e);
+  counters.bytes += accounted;
+  liveBytes.add(accounted);
+  counters.entries = entries.size();
+}
+
+void CacheBackend::invalidate()
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  if (entries.empty())
+    return;
+  drop();
+  counters.invalidations++;
+}
+
+void CacheBackend::clear()
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  drop();
+  if (generation)
+    {
+      generation.reset();
+      registered--;
+    }
+}
+
+void CacheBackend::drop()
+{
+  for (auto &kv : entries)
+    free(kv.second.data);
+  entries.clear();
+  lru.clear();
+  liveBytes.sub(counters.bytes);
+  counters.bytes = 0;
+  counters.entries = 0;
+}
+
+CacheBackend::Counters CacheBackend::getCounters()
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  return counters;
+}
+
+std::string CacheBackend::toJSON()
+{
+  Counters c = getCounters();
+  std::ostringstream json;
+  json << "{\"hits\": " << c.hits
+       << ", \"misses\": " << c.misses
+       << ", \"evictions\": " << c.evictions
+       << ", \"invalidations\": " << c.invalidations
+       << ", \"entries\": " << c.entries
+       << ", \"bytes\": " << c.bytes
+       << ", \"capacity\": " << budget << "}";
+  return json.str();
+}
+
+
+std::pair<int,int> CacheBackend::getVersion(DataEntryContext *ctx)
+{
+  return target->getVersion(ctx);
+}
+
+void CacheBackend::openPulse(DataEntryContext *ctx,
+			     int mode)
+{
+  target->openPulse(ctx, mode);
+  if (mode == CREATE_PULSE || mode == FORCE_CREATE_PULSE)
+    invalidate();
+
+  std::lock_guard<std::mutex> guard(registryMutex);
+  std::weak_ptr<std::atomic<uint64_t>> &shared = registry[dataName(ctx)];
+  std::shared_ptr<std::atomic<uint64_t>> g = shared.lock();
+  if (!g)
+    {
+      g = std::make_shared<std::atomic<uint64_t>>(0);
+      shared = g;
+    }
+  std::lock_guard<std::mutex> cacheGuard(mutex);
+  if (!generation)
+    registered++;
+  generation = g;
+  seen = g->load();
+}
+
+void CacheBackend::closePulse(DataEntryContext *ctx,
+			      int mode)
+{
+  target->closePulse(ctx, mode);
+  clear();
+}
+
+void CacheBackend::beginAction(OperationContext *ctx)
+{
+  // puts start with a write operation, whatever is written next
+  if (ctx->getAccessmode() != READ_OP)
+    invalidate();
+  target->beginAction(ctx);
+}
+
+void CacheBackend::endAction(Context *ctx)
+{
+  target->endAction(ctx);
+}
+
+void CacheBackend::writeData(Context *ctx,
+			     ALPath fieldname,
+			     ALPath timebasename,
+			     void* data,
+			     int datatype,
+			     int dim,
+			     int* size)
+{
+  invalidate();
+  target->writeData(ctx, fieldname, timebasename, data, datatype, dim, size);
+}
+
+int CacheBackend::readData(Context *ctx,
+			   ALPath fieldname,
+			   ALPath timebasename,
+			   void** data,
+			   int* datatype,
+			   int* dim,
+			   int* size)
+{
+  std::string k = key(ctx, fieldname, timebasename, *datatype);
+  if (k.empty())
+    return target->readData(ctx, fieldname, timebasename, data, datatype, dim, size);
+
+  int found = lookup(k, NULL, 0, data, datatype, dim, size);
+  if (found >= 0)
+    return found ? 1 : 0;
+  uint64_t g = currentGeneration();
+  found = target->readData(ctx, fieldname, timebasename, data, datatype, dim, size);
+  store(k, g, found, *data, *datatype, *dim, size);
+  return found;
+}
+
+int CacheBackend::readDataInto(Context *ctx,
+			       ALPath fieldname,
+			       ALPath timebasename,
+			       void* dst,
+			       size_t dstCapacity,
+			       void** data,
+			       int* datatype,
+			       int* dim,
+			       int* size)
+{
+  std::string k = key(ctx, fieldname, timebasename, *datatype);
+  if (k.empty())
+    return target->readDataInto(ctx, fieldname, timebasename, dst, dstCapacity, data, datatype, dim, size);
+
+  int found = lookup(k, dst, dstCapacity, data, datatype, dim, size);
+  if (found >= 0)
+    return found;
+  uint64_t g = currentGeneration();
+  found = target->readDataInto(ctx, fieldname, timebasename, dst, dstCapacity, data, datatype, dim, size);
+  store(k, g, found, (found == 1) ? dst : *data, *datatype, *dim, size);
+  return found;
+}
+
+int CacheBackend::readDataShape(Context *ctx,
+				ALPath fieldname,
+				ALPath timebasename,
+				int* datatype,
+				int* dim,
+				int* size)
+{
+  std::string k = key(ctx, fieldname, timebasename, *datatype);
+  if (!k.empty())
+    {
+      int found = lookup(k, NULL, 0, NULL, datatype, dim, size);
+      if (found >= 0)
+	return found;
+    }
+  // the shape alone is not cached, the data is cached when read next
+  return target->readDataShape(ctx, fieldname, timebasename, datatype, dim, size);
+}
+
+void CacheBackend::writeDataBatch(Context *ctx,
+				  std::vector<DataBatchItem> &items)
+{
+  invalidate();
+  target->writeDataBatch(ctx, items);
+}
+
+void CacheBackend::readDataBatch(Context *ctx,
+				 std::vector<DataBatchItem> &items)
+{
+  // hits are served here, the misses are read by the backend in a single batch
+  std::vector<DataBatchItem> misses;
+  std::vector<size_t> positions;
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < items.size(); i++)
+    {
+      DataBatchItem &item = items[i];
+      std::string k = key(ctx, item.fieldname, item.timebasename, item.datatype);
+      if (!k.empty())
+	{
+	  int found = lookup(k, NULL, 0, &item.data, &item.datatype, &item.dim, item.size);
+	  if (found >= 0)
+	    {
+	      item.found = found ? 1 : 0;
+	      continue;
+	    }
+	}
+      misses.push_back(item);
+      positions.push_back(i);
+      keys.push_back(k);
+    }
+  if (misses.empty())
+    return;
+
+  uint64_t g = currentGeneration();
+  try {
+    target->readDataBatch(ctx, misses);
+  }
+  catch (...) {
+    for (size_t m = 0; m < misses.size(); m++)
+      items[positions[m]] = misses[m];
+    throw;
+  }
+  for (size_t m = 0; m < misses.size(); m++)
+    {
+      const DataBatchItem &item = misses[m];
+      items[positions[m]] = item;
+      if (!keys[m].empty())
+	store(keys[m], g, item.found, item.data, item.datatype, item.dim, item.size);
+    }
+}
+
+void CacheBackend::deleteData(OperationContext *ctx,
+			      std::string path)
+{
+  invalidate();
+  target->deleteData(ctx, path);
+}
+
+void CacheBackend::beginArraystructAction(ArraystructContext *ctx,
+					  int *size)
+{
+  target->beginArraystructAction(ctx, size);
+}
+
+void CacheBackend::get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size)
+{
+  target->get_occurrences(ctx, ids_name, occurrences_list, size);
+}
+
+void CacheBackend::getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage)
+{
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto &kv : entries)
+      usage.add("cache", kv.first.substr(0, kv.first.find(':')), kv.second.bytes);
+  }
+  target->getMemoryUsage(ctx, usage);
+}
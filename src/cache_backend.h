@@ -0,0 +1,228 @@
+//-*-c++-*-
+
+#ifndef CACHE_BACKEND_H
+#define CACHE_BACKEND_H 1
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "al_backend.h"
+
+#if defined(_WIN32)
+#  define IMAS_CORE_LIBRARY_API __declspec(dllexport)
+#else
+#  define IMAS_CORE_LIBRARY_API
+#endif
+
+#ifdef __cplusplus
+
+/**
+   Backend decorator keeping the static data read from a data entry in memory.
+   Installed by Backend::initBackend in front of the selected backend when the URI holds
+   the query option cache=memory. The non time-dependent fields (no timebase, outside of any
+   time-dependent array of structure) read in global operations are kept, decoded, keyed by
+   IDS, occurrence, path (with AoS indices) and requested type, so that the following gets
+   of the same data entry are served without going through the backend. The cache holds at
+   most cache_size bytes (default 256MB), least recently used fields are evicted first. Any
+   write to the data entry, or to another data entry of this process opened on the same data
+   (same backend, host and path or legacy parameters), empties the cache. Writes made by
+   other processes are not seen. The cache lives as long as the data entry is open, its
+   counters are reported by al_get_statistics.
+*/
+class IMAS_CORE_LIBRARY_API CacheBackend : public Backend
+{
+public:
+  static const size_t DEFAULT_CAPACITY = 256UL << 20;
+
+  /**
+     Hit, miss and occupancy counters.
+  */
+  struct Counters
+  {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;
+    size_t bytes = 0;                   /**< size of the cached data */
+    size_t entries = 0;                 /**< number of cached fields */
+  };
+
+  /**
+     Parses a cache size given in the URI (e.g. "512MB", "2GB", "1048576").
+     @param[in] value number of bytes, with an optional B, KB, MB or GB (powers of 1024) suffix
+     @result size in bytes
+     @throw ALBackendException if the value is not a size
+  */
+  static size_t parseSize(const std::string &value);
+
+  /**
+     Empties the caches of the data entries opened in this process on the same data as ctx.
+     Called by the core when a write operation on ctx begins or ends, whether or not ctx is
+     cached, and by the background puts when they are done.
+  */
+  static void notifyWrite(DataEntryContext *ctx);
+
+  CacheBackend(Backend *targetB, size_t budgetB) : target(targetB), budget(budgetB) {}
+
+  ~CacheBackend() { clear(); delete target; }
+
+  Backend* getTarget() { return target; }
+
+  size_t getCapacity() const { return budget; }
+
+  Counters getCounters();
+
+  /**
+     Serializes the counters into a JSON object, as added to the al_get_statistics output.
+  */
+  std::string toJSON();
+
+  std::pair<int,int> getVersion(DataEntryContext *ctx) override;
+
+  void openPulse(DataEntryContext *ctx,
+		 int mode) override;
+
+  void closePulse(DataEntryContext *ctx,
+		  int mode) override;
+
+  void beginAction(OperationContext *ctx) override;
+
+  void endAction(Context *ctx) override;
+
+  void writeData(Context *ctx,
+		 ALPath fieldname,
+		 ALPath timebasename,
+		 void* data,
+		 int datatype,
+		 int dim,
+		 int* size) override;
+
+  int readData(Context *ctx,
+	       ALPath fieldname,
+	       ALPath timebasename,
+	       void** data,
+	       int* datatype,
+	       int* dim,
+	       int* size) override;
+
+  int readDataInto(Context *ctx,
+		   ALPath fieldname,
+		   ALPath timebasename,
+		   void* dst,
+		   size_t capacity,
+		   void** data,
+		   int* datatype,
+		   int* dim,
+		   int* size) override;
+
+  int readDataShape(Context *ctx,
+		    ALPath fieldname,
+		    ALPath timebasename,
+		    int* datatype,
+		    int* dim,
+		    int* size) override;
+
+  void writeDataBatch(Context *ctx,
+		      std::vector<DataBatchItem> &items) override;
+
+  void readDataBatch(Context *ctx,
+		     std::vector<DataBatchItem> &items) override;
+
+  void deleteData(OperationContext *ctx,
+		  std::string path) override;
+
+  void beginArraystructAction(ArraystructContext *ctx,
+			      int *size) override;
+
+  void get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) override;
+
+  void getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage) override;
+
+  bool getIncrementalPutCounters(DataEntryContext *ctx, ALIncrementalPutCounters &counters) override
+  { return target->getIncrementalPutCounters(ctx, counters); }
+
+  bool getDedupCounters(DataEntryContext *ctx, ALDedupCounters &counters) override
+  { return target->getDedupCounters(ctx, counters); }
+
+  bool supportsTimeDataInterpolation() override { return target->supportsTimeDataInterpolation(); }
+
+  void initDataInterpolationComponent() override { target->initDataInterpolationComponent(); }
+
+  bool supportsTimeRangeOperation() override { return target->supportsTimeRangeOperation(); }
+
+private:
+  struct Entry
+  {
+    int found = 0;
+    int datatype = 0;
+    int dim = 0;
+    int size[MAXDIM] = {};
+    void *data = NULL;                  /**< malloc'd, NULL when not found or empty */
+    size_t bytes = 0;                   /**< accounted size, including the key */
+    std::list<std::string>::iterator lru;
+  };
+
+  /**
+     Returns the cache key of a field, or "" if the field cannot be cached (write operation,
+     time-dependent data, sliced read, field outside of the projection of a partial get).
+  */
+  static std::string key(Context *ctx, ALPath fieldname, ALPath timebasename, int datatype);
+
+  /**
+     Returns the name identifying the data of a data entry: backend, host and canonical path
+     (or legacy user, database, version, pulse and run).
+  */
+  static std::string dataName(DataEntryContext *ctx);
+
+  /**
+     Empties the cache if the data was written through another data entry since the last call.
+     Called with mutex held.
+  */
+  void sync();
+
+  uint64_t currentGeneration() const { return generation ? generation->load() : 0; }
+
+  /**
+     Looks a field up, with the conventions of readDataInto (dst NULL: returned in *data, data 
+     also NULL: shape only).
+     @result -1 when the field is not cached, otherwise as readDataInto
+  */
+  int lookup(const std::string &k, void *dst, size_t dstCapacity, void **data, int *datatype, int *dim,
+	     int *size);
+
+  /**
+     Keeps a field read by the backend, unless the data was written since the generation seen
+     before the read.
+  */
+  void store(const std::string &k, uint64_t readGeneration, int found, const void *data, int datatype, int dim,
+	     const int *size);
+
+  void invalidate();
+
+  void clear();
+
+  void drop();
+
+  Backend *target;
+  size_t budget;                        /**< maximum size of the cached data */
+  std::mutex mutex;
+  std::unordered_map<std::string, Entry> entries;
+  std::list<std::string> lru;           /**< most recently used first */
+  Counters counters;
+  std::shared_ptr<std::atomic<uint64_t>> generation;  /**< writes to the data, shared by the entries opened on it */
+  uint64_t seen = 0;                    /**< generation of the cached data */
+
+  static std::mutex registryMutex;
+  static std::map<std::string, std::weak_ptr<std::atomic<uint64_t>>> registry;  /**< key = dataName */
+  static std::atomic<int> registered;   /**< cached data entries open in the process */
+};
+
+#endif
+
+#endif
@@ -1,5 +1,6 @@
 #include "data_interpolation.h"
 
+#include "al_backend.h"
 #include "al_const.h"
 #include "al_exception.h"
 
@@ -307,7 +308,7 @@ int DataInterpolation::resample_timebasis(double tmin, double tmax, std::vector<
 
         if (nb_slices != 0) {
 
-            *result = (double *)malloc(nb_slices * sizeof(double));
+            *result = (double *)ALAllocator::allocate(nb_slices * sizeof(double));
             double *r = (double *)*result;
 
             if (dtime.size() == 1) {
@@ -328,7 +329,7 @@ int DataInterpolation::resample_timebasis(double tmin, double tmax, std::vector<
     else
     {
         nb_slices = 1;
-        *result = (double *)malloc(sizeof(double));
+        *result = (double *)ALAllocator::allocate(sizeof(double));
         double *r = (double *)*result;
         double requested_time;
         if (dtime.size() == 1) 
@@ -567,11 +568,11 @@ int DataInterpolation::interpolate_with_resampling(double tmin, double tmax, std
     free(slice1);
     if (interp == LINEAR_INTERP)
         free(slice2);
-    free(data);
+    ALAllocator::release(data);
     if (datatype == alconst::double_data)
     {
 
-        *result = (void *)malloc(sizeof(double) * interpolation_results.size() * time_slice_shape);
+        *result = (void *)ALAllocator::allocate(sizeof(double) * interpolation_results.size() * time_slice_shape);
         for (int i = 0; i < interpolation_results.size(); i++)
         {
             double *q = (double *)interpolation_results[i];
@@ -583,7 +584,7 @@ int DataInterpolation::interpolate_with_resampling(double tmin, double tmax, std
     else if (datatype == alconst::integer_data)
     {
 
-        *result = (void *)malloc(sizeof(int) * interpolation_results.size() * time_slice_shape);
+        *result = (void *)ALAllocator::allocate(sizeof(int) * interpolation_results.size() * time_slice_shape);
         for (int i = 0; i < interpolation_results.size(); i++)
         {
             int *q = (int *)interpolation_results[i];
@@ -595,7 +596,7 @@ int DataInterpolation::interpolate_with_resampling(double tmin, double tmax, std
     else if (datatype == alconst::char_data)
     {
 
-        *result = (void *)malloc(sizeof(char) * interpolation_results.size() * time_slice_shape);
+        *result = (void *)ALAllocator::allocate(sizeof(char) * interpolation_results.size() * time_slice_shape);
         for (int i = 0; i < interpolation_results.size(); i++)
         {
             char *q = (char *)interpolation_results[i];
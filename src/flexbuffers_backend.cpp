@@ -266,8 +266,8 @@ void FlexbuffersBackend::endAction(Context* ctx) {
 
 void FlexbuffersBackend::writeData(
     Context* ctx,
-    std::string fieldname,
-    std::string timebasename,
+    ALPath fieldname,
+    ALPath timebasename,
     void* data,
     int datatype,
     int dim,
@@ -328,8 +328,8 @@ void FlexbuffersBackend::writeData(
 
 int FlexbuffersBackend::readData(
     Context* ctx,
-    std::string fieldname,
-    std::string timebasename,
+    ALPath fieldname,
+    ALPath timebasename,
     void** data,
     int* datatype,
     int* dim,
@@ -344,7 +344,7 @@ int FlexbuffersBackend::readData(
         *dim = 1;
         *size = buffer.size() + 1;
         // allocate C memory for the data:
-        int8_t *tmp = reinterpret_cast<int8_t *>(malloc(*size));
+        int8_t *tmp = reinterpret_cast<int8_t *>(ALAllocator::allocate(*size));
         tmp[0] = static_cast<int8_t>(FLEXBUFFERS_SERIALIZER_PROTOCOL);
         memcpy(tmp + 1, buffer.data(), buffer.size());
         // Assign to data
@@ -358,6 +358,81 @@ int FlexbuffersBackend::readData(
     // First check if we're still looking at the correct AoS
     _check_aos_index(ctx);
 
+    return _read_element(fieldname, data, datatype, dim, size);
+}
+
+void FlexbuffersBackend::readDataBatch(Context* ctx, std::vector<DataBatchItem>& items) {
+    if (items.empty())
+        return;
+
+    for (auto& item : items) {
+        if (_builder || item.fieldname == "<buffer>") {
+            // special fieldname and serializing mode are handled by readData
+            Backend::readDataBatch(ctx, items);
+            return;
+        }
+    }
+
+    // all fields belong to the same AoS element: look them up in the current vector
+    _check_aos_index(ctx);
+    for (auto& item : items) {
+        item.found = _read_element(item.fieldname, &item.data, &item.datatype, &item.dim, item.size);
+    }
+}
+
+int FlexbuffersBackend::readDataInto(
+    Context* ctx,
+    ALPath fieldname,
+    ALPath timebasename,
+    void* dst,
+    size_t capacity,
+    void** data,
+    int* datatype,
+    int* dim,
+    int* size
+) {
+    if (_builder || fieldname == "<buffer>")
+        return Backend::readDataInto(ctx, fieldname, timebasename, dst, capacity, data, datatype, dim, size);
+
+    _check_aos_index(ctx);
+    return _read_element(fieldname, data, datatype, dim, size, dst, capacity);
+}
+
+int FlexbuffersBackend::readDataShape(
+    Context* ctx,
+    ALPath fieldname,
+    ALPath timebasename,
+    int* datatype,
+    int* dim,
+    int* size
+) {
+    if (_builder || fieldname == "<buffer>")
+        return Backend::readDataShape(ctx, fieldname, timebasename, datatype, dim, size);
+
+    _check_aos_index(ctx);
+    auto idx = _element_map.top().find(fieldname);
+    if (idx == _element_map.top().end())
+        return 0;
+    auto &vector = _cur_vector.top();
+    int i = idx->second;
+    *datatype = vector[i+1].AsInt32();
+    auto sizes = vector[i+2].AsTypedVector();
+    *dim = sizes.size();
+    for( int j=0; j<*dim; ++j) {
+        size[j] = sizes[j].AsInt32();
+    }
+    return 1;
+}
+
+int FlexbuffersBackend::_read_element(
+    const std::string& fieldname,
+    void** data,
+    int* datatype,
+    int* dim,
+    int* size,
+    void* dst,
+    size_t capacity
+) {
     auto idx = _element_map.top().find(fieldname);
     if (idx == _element_map.top().end()) {
         // Fieldname not found
@@ -367,6 +442,7 @@ int FlexbuffersBackend::readData(
     auto &vector = _cur_vector.top();
     int i = idx->second;
     // Set output
+    int expected_type = *datatype;
     *datatype = vector[i+1].AsInt32();
     auto sizes = vector[i+2].AsTypedVector();
     *dim = sizes.size();
@@ -374,11 +450,16 @@ int FlexbuffersBackend::readData(
         size[j] = sizes[j].AsInt32();
     }
     auto blob = vector[i+3].AsBlob();
+    if (dst && *datatype == expected_type && blob.size() <= capacity) {
+        // Copy the blob straight into the caller's buffer
+        memcpy(dst, blob.data(), blob.size());
+        return 1;
+    }
     // Copy the blob into data
-    *data = malloc(blob.size());
+    *data = ALAllocator::allocate(blob.size());
     memcpy(*data, blob.data(), blob.size());
 
-    return 1;
+    return dst ? 2 : 1;
 }
 
 void FlexbuffersBackend::deleteData(OperationContext* ctx, std::string path) {
@@ -32,19 +32,35 @@ class IMAS_CORE_LIBRARY_API FlexbuffersBackend : public Backend
     void beginAction(OperationContext *ctx) override;
     void endAction(Context *ctx) override; 
     void writeData(Context *ctx, 
-        std::string fieldname,
-        std::string timebasename, 
+        ALPath fieldname,
+        ALPath timebasename, 
         void* data,
         int datatype,
         int dim,
         int* size) override;
     int readData(Context *ctx,
-        std::string fieldname,
-        std::string timebasename, 
+        ALPath fieldname,
+        ALPath timebasename, 
         void** data,
         int* datatype,
         int* dim,
         int* size) override;
+    void readDataBatch(Context *ctx, std::vector<DataBatchItem> &items) override;
+    int readDataInto(Context *ctx,
+        ALPath fieldname,
+        ALPath timebasename,
+        void* dst,
+        size_t capacity,
+        void** data,
+        int* datatype,
+        int* dim,
+        int* size) override;
+    int readDataShape(Context *ctx,
+        ALPath fieldname,
+        ALPath timebasename,
+        int* datatype,
+        int* dim,
+        int* size) override;
     void deleteData(OperationContext *ctx, std::string path) override;
     void beginArraystructAction(ArraystructContext *ctx, int *size) override;
     void get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) override;
@@ -90,6 +106,13 @@ class IMAS_CORE_LIBRARY_API FlexbuffersBackend : public Backend
     /** Helper method to check if the current AoS index has changed and act
      * accordingly */
     void _check_aos_index(Context* ctx);
+    /** Helper method when deserializing: read an element of the current vector.
+     * When dst is provided and the element has the expected type (*datatype on input) and fits
+     * in capacity bytes, it is copied into dst and 1 is returned; otherwise it is copied into
+     * newly allocated memory (*data) and 2 is returned. When dst is NULL, 1 means *data was set.
+     */
+    int _read_element(const std::string& fieldname, void** data, int* datatype, int* dim, int* size,
+        void* dst = NULL, size_t capacity = 0);
 };
 
 #endif  // FLEXBUFFERS_BACKEND_H
@@ -19,6 +19,12 @@ HDF5Backend::HDF5Backend(Backend * targetB)
 
 HDF5Backend::~HDF5Backend()
 {
+    HDF5LibraryGuard guard;
+    // release the HDF5 objects held by the components while the guard is held
+    eventsHandler.reset();
+    incrementalPut.reset();
+    hdf5Reader.reset();
+    hdf5Writer.reset();
 }
 
 const int HDF5Backend::HDF5_BACKEND_VERSION_MAJOR = 1;
@@ -35,6 +41,7 @@ void
 
 std::pair<int,int> HDF5Backend::getVersion(DataEntryContext *ctx)
 {
+  HDF5LibraryGuard guard;
   std::pair<int,int> version;
   if(ctx==NULL)
     version = {HDF5_BACKEND_VERSION_MAJOR, HDF5_BACKEND_VERSION_MINOR};
@@ -73,6 +80,7 @@ std::string HDF5Backend::getVersion() {
 void
  HDF5Backend::openPulse(DataEntryContext * ctx, int mode)
 {
+    HDF5LibraryGuard guard;
     access_mode = mode;
 
     std::string backend_version;
@@ -99,12 +107,20 @@ void
         throw ALBackendException("Mode not yet supported", LOG);
     }
     createBackendComponents(backend_version);
+
+    incrementalPut.reset(new HDF5IncrementalPut(ctx->getURI()));
+    if (!incrementalPut->isIncremental() && !incrementalPut->isDedup())
+        incrementalPut.reset();
+    hdf5Writer->setWriteObserver(incrementalPut.get());
 }
 
 void HDF5Backend::closePulse(DataEntryContext * ctx, int mode)
 {
+    HDF5LibraryGuard guard;
     if (ctx == nullptr)
         throw ALBackendException("HDF5Backend: unexpected null context in HDF5Backend::closePulse()", LOG);
+    if (incrementalPut && file_id != -1)
+        incrementalPut->flush("", file_id, opened_IDS_files, *hdf5Writer, files_directory, relative_file_path);
     if (access_mode == OPEN_PULSE || access_mode == FORCE_OPEN_PULSE) {
         hdf5Reader->closePulse(ctx, mode, &file_id, opened_IDS_files, files_path_strategy, files_directory, relative_file_path);
     } else if (access_mode == CREATE_PULSE || access_mode == FORCE_CREATE_PULSE) {
@@ -114,28 +130,85 @@ void HDF5Backend::closePulse(DataEntryContext * ctx, int mode)
     hdf5Reader->close_datasets();
 }
 
-void HDF5Backend::writeData(Context * ctx, std::string fieldname, std::string timebasename, void *data, int datatype, int dim, int *size)
+void HDF5Backend::writeData(Context * ctx, ALPath fieldname, ALPath timebasename, void *data, int datatype, int dim, int *size)
 {
+    HDF5LibraryGuard guard;
     hdf5Writer->write_ND_Data(ctx, fieldname, timebasename, datatype, dim, size, data);
 }
 
-int HDF5Backend::readData(Context * ctx, std::string fieldname, std::string timebasename, void **data, int *datatype, int *dim, int *size)
+int HDF5Backend::readData(Context * ctx, ALPath fieldname, ALPath timebasename, void **data, int *datatype, int *dim, int *size)
 {
+    if (!ctx->isProjected(fieldname.str(), false))
+        return 0;
+    HDF5LibraryGuard guard;
     int dataAvailable = 0;      //not available by default
     dataAvailable = hdf5Reader->read_ND_Data(ctx, fieldname, timebasename, *datatype, data, dim, size);
     return dataAvailable;
 }
 
+int HDF5Backend::readDataInto(Context * ctx, ALPath fieldname, ALPath timebasename, void *dst, size_t capacity, void **data, int *datatype, int *dim, int *size)
+{
+    if (!ctx->isProjected(fieldname.str(), false))
+        return 0;
+    HDF5LibraryGuard guard;
+    void *p = NULL;
+    int status = hdf5Reader->read_ND_Data_into(ctx, fieldname, timebasename, *datatype, dst, capacity, &p, dim, size);
+    if (status == 2)
+    {
+        if (getDataByteSize(*datatype, *dim, size) <= capacity)
+        {
+            memcpy(dst, p, getDataByteSize(*datatype, *dim, size));
+            ALAllocator::release(p);
+            return 1;
+        }
+        *data = p;
+    }
+    return status;
+}
+
+void HDF5Backend::writeDataBatch(Context * ctx, std::vector < DataBatchItem > &items)
+{
+    HDF5LibraryGuard guard;
+    hdf5Writer->write_ND_Data_batch(ctx, items);
+}
+
+void HDF5Backend::readDataBatch(Context * ctx, std::vector < DataBatchItem > &items)
+{
+    HDF5LibraryGuard guard;
+    std::vector < DataBatchItem > projected;
+    std::vector < size_t > positions;
+    for (size_t i = 0; i < items.size(); i++) {
+        items[i].found = 0;
+        if (ctx->isProjected(items[i].fieldname.str(), false)) {
+            projected.push_back(items[i]);
+            positions.push_back(i);
+        }
+    }
+    if (projected.size() == items.size()) {
+        hdf5Reader->read_ND_Data_batch(ctx, items);
+        return;
+    }
+    hdf5Reader->read_ND_Data_batch(ctx, projected);
+    for (size_t k = 0; k < projected.size(); k++)
+        items[positions[k]] = projected[k];
+}
+
 
 void HDF5Backend::deleteData(OperationContext * ctx, std::string path)
 {
+    HDF5LibraryGuard guard;
     if (file_id == -1) //master file is closed
         return;
+    if (incrementalPut && ctx->getAccessmode() == WRITE_OP && ctx->getRangemode() == GLOBAL_OP) {
+        incrementalPut->deleteData(ctx);
+        return;
+    }
     hdf5Writer->deleteData(ctx, this->file_id, opened_IDS_files, files_directory, relative_file_path);
 }
 
 void HDF5Backend::beginWriteArraystructAction(ArraystructContext * ctx, int *size)
 {
+    HDF5LibraryGuard guard;
     if (*size == 0)
         return;
     hdf5Writer->beginWriteArraystructAction(ctx, size);
@@ -143,22 +216,90 @@ void HDF5Backend::beginWriteArraystructAction(ArraystructContext * ctx, int *siz
 
 void HDF5Backend::beginReadArraystructAction(ArraystructContext * ctx, int *size)
 {
+    // AoS outside of the projection: its shapes datasets are not opened
+    if (!ctx->getOperationContext()->getProjection().empty() &&
+        !ctx->getOperationContext()->isProjected(ctx->getFullPath(), true)) {
+        *size = 0;
+        return;
+    }
+    HDF5LibraryGuard guard;
     hdf5Reader->beginReadArraystructAction(ctx, size);
 }
 
 void HDF5Backend::beginAction(OperationContext * ctx)
 {
+    HDF5LibraryGuard guard;
+    if (incrementalPut) {
+        // puts are written into the scratch group, other actions see the IDS once its pending delete is done
+        if (ctx->getAccessmode() == WRITE_OP && ctx->getRangemode() == GLOBAL_OP) {
+            hdf5Writer->set_IDS_group(ctx, incrementalPut->beginPut(ctx));
+            hdf5Writer->setSliceMode(GLOBAL_OP);
+            return;
+        }
+        incrementalPut->flush(ctx->getDataobjectName(), file_id, opened_IDS_files, *hdf5Writer, files_directory, relative_file_path);
+        if (ctx->getAccessmode() == WRITE_OP)
+            incrementalPut->invalidate(ctx->getDataobjectName());
+    }
     eventsHandler->beginAction(ctx, file_id, opened_IDS_files, *hdf5Writer, *hdf5Reader, files_directory, relative_file_path, access_mode);
+    // datasets shared by a deduplicated put (whatever the options of this data entry) are not extended in place
+    // and the fingerprints of the incremental puts of other data entries no longer match their content
+    if (ctx->getAccessmode() == WRITE_OP && ctx->getRangemode() == SLICE_OP && hdf5Writer->get_IDS_group(ctx) >= 0) {
+        HDF5IncrementalPut::unshareDatasets(hdf5Writer->get_IDS_group(ctx));
+        HDF5IncrementalPut::clearStamp(hdf5Writer->get_IDS_group(ctx));
+    }
 }
 
 void HDF5Backend::endAction(Context * ctx)
 {
+    if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE) {
+        ArraystructContext *arrctx = static_cast < ArraystructContext * >(ctx);
+        if (arrctx->getOperationContext()->getAccessmode() == READ_OP &&
+            !arrctx->getOperationContext()->getProjection().empty() &&
+            !arrctx->getOperationContext()->isProjected(arrctx->getFullPath(), true))
+            return;
+    }
+    HDF5LibraryGuard guard;
     eventsHandler->endAction(ctx, file_id, *hdf5Writer, *hdf5Reader, opened_IDS_files);
+    if (incrementalPut && ctx->getType() == CTX_OPERATION_TYPE) {
+        OperationContext *opctx = static_cast < OperationContext * >(ctx);
+        if (opctx->getAccessmode() == WRITE_OP && opctx->getRangemode() == GLOBAL_OP)
+            incrementalPut->endPut(opctx, file_id, opened_IDS_files, *hdf5Writer, files_directory, relative_file_path, access_mode);
+    }
+}
+
+void HDF5Backend::getMemoryUsage(DataEntryContext * ctx, ALMemoryUsage &usage)
+{
+    HDF5LibraryGuard guard;
+    if (hdf5Writer)
+        hdf5Writer->getMemoryUsage(usage);
+    if (hdf5Reader)
+        hdf5Reader->getMemoryUsage(usage);
 }
 
 void HDF5Backend::get_occurrences(Context* ctx, const  char* ids_name, int** occurrences_list, int* size)
 {
+    HDF5LibraryGuard guard;
     if (file_id == -1) //master file not opened
         throw ALBackendException("HDF5Backend: master file not opened while calling HDF5Backend::get_occurrences()", LOG); 
+    if (incrementalPut)
+        incrementalPut->flush("", file_id, opened_IDS_files, *hdf5Writer, files_directory, relative_file_path);
     hdf5Reader->get_occurrences(ids_name, occurrences_list, size, file_id);
 }
+
+bool HDF5Backend::getIncrementalPutCounters(DataEntryContext * ctx, ALIncrementalPutCounters &counters)
+{
+    HDF5LibraryGuard guard;
+    if (!incrementalPut || !incrementalPut->isIncremental())
+        return false;
+    counters = incrementalPut->getCounters();
+    return true;
+}
+
+bool HDF5Backend::getDedupCounters(DataEntryContext * ctx, ALDedupCounters &counters)
+{
+    HDF5LibraryGuard guard;
+    if (!incrementalPut || !incrementalPut->isDedup())
+        return false;
+    counters = incrementalPut->getDedupCounters();
+    return true;
+}
@@ -6,6 +6,7 @@
 #include "hdf5_reader.h"
 #include "hdf5_writer.h"
 #include "hdf5_events_handler.h"
+#include "hdf5_incremental_put.h"
 #include <memory>
 #include <vector>
 #include <list>
@@ -28,6 +29,7 @@ class HDF5Backend:public Backend {
      std::unique_ptr < HDF5Writer > hdf5Writer;
      std::unique_ptr < HDF5Reader > hdf5Reader;
      std::unique_ptr < HDF5EventsHandler > eventsHandler;
+     std::unique_ptr < HDF5IncrementalPut > incrementalPut;    // set for data entries opened with incremental_put=yes or dedup=yes
 
     int access_mode;
     int files_path_strategy;
@@ -90,7 +92,7 @@ class HDF5Backend:public Backend {
      @param[in] size array of the size of each dimension (NULL is dim=0)
      @throw BackendException
 	 */
-    void writeData(Context * ctx, std::string fieldname, std::string timebasename, void *data, int datatype, int dim, int *size) override;
+    void writeData(Context * ctx, ALPath fieldname, ALPath timebasename, void *data, int datatype, int dim, int *size) override;
 
         /**
      Reads data.
@@ -108,7 +110,42 @@ class HDF5Backend:public Backend {
      @param[out] size array returned with elements filled at the size of each dimension 
      @throw BackendException
 	 */
-    int readData(Context * ctx, std::string fieldname, std::string timebase, void **data, int *datatype, int *dim, int *size) override;
+    int readData(Context * ctx, ALPath fieldname, ALPath timebasename, void **data, int *datatype, int *dim, int *size) override;
+
+        /**
+     Writes several data in a row.
+     The fields of the batch are written in one pass over the current structure level.
+     @param[in] ctx pointer on operation context
+     @param[in] items fields to write
+     @throw BackendException
+	 */
+    void writeDataBatch(Context * ctx, std::vector < DataBatchItem > &items) override;
+
+        /**
+     Reads several data in a row.
+     The IDS group and its homogeneous_time flag are resolved once for the whole batch.
+     @param[in] ctx pointer on operation context
+     @param[in,out] items fields to read
+     @throw BackendException
+	 */
+    void readDataBatch(Context * ctx, std::vector < DataBatchItem > &items) override;
+
+        /**
+     Reads data into a caller provided buffer.
+     Hyperslab reads of global operations are done straight into dst, other reads are copied.
+     @param[in] ctx pointer on operation context
+     @param[in] fieldname field name
+     @param[in] timebase time base field name
+     @param[in] dst caller provided buffer
+     @param[in] capacity size of dst in bytes
+     @param[out] data newly allocated data, when they could not be stored in dst
+     @param[in,out] datatype expected type of the data
+     @param[out] dim returned dimension of the data
+     @param[out] size array returned with elements filled at the size of each dimension
+     @result 0 if no data, 1 if data are stored in dst, 2 if they are returned in *data
+     @throw BackendException
+	 */
+    int readDataInto(Context * ctx, ALPath fieldname, ALPath timebasename, void *dst, size_t capacity, void **data, int *datatype, int *dim, int *size) override;
 
         /**
     Deletes data.
@@ -132,6 +169,18 @@ class HDF5Backend:public Backend {
 
     void get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) override;
 
+        /**
+     Reports the read and write buffers and the chunk caches of the datasets opened by the
+     operation in progress.
+     @param[in] ctx pointer on pulse context
+     @param[in,out] usage accounted memory
+	 */
+    void getMemoryUsage(DataEntryContext * ctx, ALMemoryUsage &usage) override;
+
+    bool getIncrementalPutCounters(DataEntryContext * ctx, ALIncrementalPutCounters &counters) override;
+
+    bool getDedupCounters(DataEntryContext * ctx, ALDedupCounters &counters) override;
+
     bool supportsTimeDataInterpolation() {
       return true;
     }
@@ -7,6 +7,39 @@
 #include <math.h>
 
 
+// read and write buffers of all the opened datasets
+static ALMemoryUsage::Counter liveBuffers("hdf5_buffers");
+// capacity of the chunk caches set on the opened datasets, filled by the HDF5 library
+static ALMemoryUsage::Counter liveChunkCaches("hdf5_chunk_cache");
+
+static void account(ALMemoryUsage::Counter &counter, size_t &accounted, size_t bytes)
+{
+    counter.add(bytes);
+    counter.sub(accounted);
+    accounted = bytes;
+}
+
+static size_t stringsBytes(const std::vector<char *> &strings)
+{
+    size_t bytes = strings.size() * sizeof(char *);
+    for (char *s : strings)
+        if (s != NULL)
+            bytes += strlen(s) + 1;
+    return bytes;
+}
+
+// the datasets of the in-memory file of an incremental put are compressed once copied into the IDS file,
+// unless the file is marked to be copied as it is
+static bool uncompressedFile(hid_t loc_id)
+{
+    hid_t file_id = H5Iget_file_id(loc_id);
+    hid_t fapl = H5Fget_access_plist(file_id);
+    bool uncompressed = (H5Pget_driver(fapl) == H5FD_CORE && H5Aexists(file_id, COMPRESSED_SCRATCH_ATTRIBUTE) <= 0);
+    H5Pclose(fapl);
+    H5Fclose(file_id);
+    return uncompressed;
+}
+
 HDF5DataSetHandler::HDF5DataSetHandler(bool writing_mode_, uri::Uri uri):dataset_rank(-1), AOSRank(0), immutable(true), 
 shape_dataset(false), slice_mode(false), slices_extension(0), timed_AOS_index(-1), isTimed(false), timeWriteOffset(0), datatype(-1), dataset_id(-1), 
 dtype_id(-1), request_dim(-1), dataspace_id(-1), compression_enabled(true), useBuffering(true), chunk_cache_size(READ_CHUNK_CACHE_SIZE), 
@@ -17,8 +50,10 @@ write_chunk_cache_size(WRITE_CHUNK_CACHE_SIZE), requests_arrctx_indices(), reque
     bool readBuffering;
 	bool writeBuffering;
 	hdf5_utils.setDefaultOptions(&chunk_cache_size, &write_chunk_cache_size, &readBuffering, &writeBuffering);
+	bool debug = HDF5Utils::debug;
 	hdf5_utils.readOptions(uri, &compression_enabled, &readBuffering, &chunk_cache_size,  &writeBuffering,  &write_chunk_cache_size, 
-    &HDF5Utils::debug);
+    &debug);
+	HDF5Utils::debug = debug;
 
 	if (writing_mode_) {
 		useBuffering = writeBuffering;
@@ -30,6 +65,9 @@ write_chunk_cache_size(WRITE_CHUNK_CACHE_SIZE), requests_arrctx_indices(), reque
 
 HDF5DataSetHandler::~HDF5DataSetHandler()
 {
+    account(liveBuffers, pending_bytes, 0);
+    account(liveBuffers, full_bytes, 0);
+    account(liveChunkCaches, chunk_cache_bytes, 0);
     if (!immutable)
         H5Tclose(dtype_id);
     if (dataspace_id != -1) {
@@ -201,6 +239,7 @@ int *size, int datatype, bool shape_dataset, bool create_chunk_cache, uri::Uri u
             size_t rdcc_nbytes = chunk_cache_size;
             size_t rdcc_nslots = H5D_CHUNK_CACHE_NSLOTS_DEFAULT;
             H5Pset_chunk_cache(dapl, rdcc_nslots, rdcc_nbytes, H5D_CHUNK_CACHE_W0_DEFAULT);
+            account(liveChunkCaches, chunk_cache_bytes, rdcc_nbytes);
             //printf("opening %s with chunk cache size = %d\n", dataset_name, (int) rdcc_nbytes);
 		    *dataset_id = H5Dopen2(loc_id, dataset_name, dapl);
             H5Pclose(dapl);
@@ -420,7 +459,7 @@ void HDF5DataSetHandler::create(const char *dataset_name, hid_t * dataset_id, in
         //printf("dataset_name=%s, volume=%d\n", dataset_name, v);
 		hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
 		H5Pset_chunk(dcpl_id, dataset_rank, chunk_dims);
-		if (compression_enabled) {
+		if (compression_enabled && !uncompressedFile(loc_id)) {
 			H5Pset_shuffle(dcpl_id);
 			H5Pset_deflate (dcpl_id, 1);
 		}
@@ -445,6 +484,7 @@ void HDF5DataSetHandler::create(const char *dataset_name, hid_t * dataset_id, in
 		hid_t dapl = H5Pcreate(H5P_DATASET_ACCESS);
 		//printf("using rdcc_nbytes=%d for dataset=%s\n", (int) rdcc_nbytes, getName().c_str());
 		H5Pset_chunk_cache(dapl, rdcc_nslots, rdcc_nbytes, H5D_CHUNK_CACHE_W0_DEFAULT);
+		account(liveChunkCaches, chunk_cache_bytes, rdcc_nbytes);
 
 		*dataset_id = H5Dcreate2(loc_id, dataset_name, dtype_id, dataspace_id, H5P_DEFAULT, dcpl_id, dapl);
 		H5Pclose(dapl);
@@ -717,7 +757,10 @@ void HDF5DataSetHandler::close()
                 break;
             }
         }
+        account(liveBuffers, pending_bytes, 0);
+        account(liveBuffers, full_bytes, 0);
     }
+    account(liveChunkCaches, chunk_cache_bytes, 0);
 
     herr_t status = H5Dclose (dataset_id);
     if (status < 0) {
@@ -728,6 +771,15 @@ void HDF5DataSetHandler::close()
 
 }
 
+void HDF5DataSetHandler::addMemoryUsage(ALMemoryUsage &usage, const std::string &ids,
+                                        const std::unordered_map < std::string, std::unique_ptr < HDF5DataSetHandler > > &data_sets)
+{
+    for (auto &kv : data_sets) {
+        usage.add("hdf5_buffers", ids, kv.second->getBuffersSize());
+        usage.add("hdf5_chunk_cache", ids, kv.second->getChunkCacheSize());
+    }
+}
+
 void HDF5DataSetHandler::setBuffering(bool useBufferingOption) {
 
     if (useBufferingOption && !slice_mode) {
@@ -848,6 +900,8 @@ void HDF5DataSetHandler::fillFullBuffers() {
                 free(buffer);
             }
             full_int_data_set_buffer = v;
+            account(liveBuffers, pending_bytes, 0);
+            account(liveBuffers, full_bytes, getSize() * sizeof(int));
             break;
         }
     case alconst::double_data: 
@@ -906,6 +960,8 @@ void HDF5DataSetHandler::fillFullBuffers() {
                 free(buffer);
             }
             full_double_data_set_buffer = v;
+            account(liveBuffers, pending_bytes, 0);
+            account(liveBuffers, full_bytes, getSize() * sizeof(double));
             break;
         }
 
@@ -946,6 +1002,7 @@ void HDF5DataSetHandler::fillFullBuffers() {
                 ++it;
                 request++; 
             }
+            account(liveBuffers, full_bytes, stringsBytes(full_data_sets_buffers));
             break;
         }
     }
@@ -956,6 +1013,7 @@ void HDF5DataSetHandler::appendStringToBuffer(const std::vector < int >&current_
     std::vector<char *> &v = data_sets_buffers;
     char *c = strdup((char*) *data);
     v.push_back(c);
+    account(liveBuffers, pending_bytes, pending_bytes + sizeof(char *) + strlen(c) + 1);
 }
 
 void HDF5DataSetHandler::appendInt0DToBuffer(const std::vector < int >&current_arrctx_indices, void *data) {
@@ -964,6 +1022,7 @@ void HDF5DataSetHandler::appendInt0DToBuffer(const std::vector < int >&current_a
     int* p = (int*) malloc(sizeof(int));
     *p = *data_int;
     v.push_back(p);
+    account(liveBuffers, pending_bytes, pending_bytes + sizeof(int));
 }
 
 void HDF5DataSetHandler::appendIntNDToBuffer(const std::vector < int >&current_arrctx_indices, void *data, int dim) {
@@ -975,6 +1034,7 @@ void HDF5DataSetHandler::appendIntNDToBuffer(const std::vector < int >&current_a
     int* p = (int*) malloc(sizeof(int)*shape);
     memcpy(p, data_int, shape*sizeof(int));
     v.push_back(p);
+    account(liveBuffers, pending_bytes, pending_bytes + shape*sizeof(int));
 }
 
 void HDF5DataSetHandler::appendDouble0DToBuffer(const std::vector < int >&current_arrctx_indices, void *data) {
@@ -983,6 +1043,7 @@ void HDF5DataSetHandler::appendDouble0DToBuffer(const std::vector < int >&curren
     double* p = (double*) malloc(sizeof(double));
     *p = *data_double;
     v.push_back(p);
+    account(liveBuffers, pending_bytes, pending_bytes + sizeof(double));
 }
 
 void HDF5DataSetHandler::appendDoubleNDToBuffer(const std::vector < int >&current_arrctx_indices, void *data, int dim) {
@@ -994,6 +1055,7 @@ void HDF5DataSetHandler::appendDoubleNDToBuffer(const std::vector < int >&curren
     double* p = (double*) malloc(sizeof(double)*shape);
     memcpy(p, data_double, shape*sizeof(double));
     v.push_back(p);
+    account(liveBuffers, pending_bytes, pending_bytes + shape*sizeof(double));
 }
 
 void HDF5DataSetHandler::writeUsingHyperslabs(const std::vector < int >&current_arrctx_indices, int slice_mode, int dynamic_AOS_slices_extension, void *data) {
@@ -1037,12 +1099,12 @@ void HDF5DataSetHandler::read0DStringsFromBuffer(HDF5HsSelectionReader & hsSelec
         int index = hdf5_utils.indices_to_flat_index(current_arrctx_indices, hsSelectionReader.getDataSpaceDims());
         if (full_data_sets_buffers[index] == NULL)
              full_data_sets_buffers[index] = strdup("");
-        *data = strdup(full_data_sets_buffers[index]);
+        *data = ALAllocator::duplicate(full_data_sets_buffers[index]);
     }
     else {
          if (full_data_sets_buffers[0] == NULL)
              full_data_sets_buffers[0] = strdup("");
-        *data = strdup(full_data_sets_buffers[0]);
+        *data = ALAllocator::duplicate(full_data_sets_buffers[0]);
     }
 }
 
@@ -1055,13 +1117,14 @@ void HDF5DataSetHandler::create0DStringsBuffer(HDF5HsSelectionReader & hsSelecti
         sprintf(error_message, "Unable to read dataset: %s\n", getName().c_str());
         throw ALBackendException(error_message, LOG);
     }
+    account(liveBuffers, full_bytes, stringsBytes(full_data_sets_buffers));
 }
 
 void HDF5DataSetHandler::readInt0DFromBuffer(HDF5HsSelectionReader & hsSelectionReader, const std::vector < int >&current_arrctx_indices, void **data) {
     int *v = full_int_data_set_buffer;
     if (full_int_data_set_buffer == NULL)
         throw ALBackendException("HDF5Backend: unexpected NULL buffer in HDF5DataSetHandler::readInt0DFromBuffer()", LOG);
-    *data = (void*) malloc(sizeof(int));
+    *data = (void*) ALAllocator::allocate(sizeof(int));
     int* data_int = (int*) *data;
     if (hsSelectionReader.getRank() != 0) {
         HDF5Utils hdf5_utils;
@@ -1082,7 +1145,7 @@ void HDF5DataSetHandler::readIntNDFromBuffer(HDF5HsSelectionReader & hsSelection
     size_t shape = 1;
     for (int i = 0; i < dim; i++)
         shape *= (size_t) hsSelectionReader.getShape(rank - i - 1);
-    *data = (void*) malloc(shape*sizeof(int));
+    *data = (void*) ALAllocator::allocate(shape*sizeof(int));
     if (rank != dim) {
         HDF5Utils hdf5_utils;
         std::vector < int > indices = current_arrctx_indices;
@@ -1105,7 +1168,7 @@ void HDF5DataSetHandler::readDoubleNDFromBuffer(HDF5HsSelectionReader & hsSelect
     size_t shape = 1;
     for (int i = 0; i < dim; i++)
         shape *= (size_t) hsSelectionReader.getShape(rank - i - 1);
-    *data = (void*) malloc(shape*sizeof(double));
+    *data = (void*) ALAllocator::allocate(shape*sizeof(double));
     if (rank != dim) {
         HDF5Utils hdf5_utils;
         std::vector < int > indices = current_arrctx_indices;
@@ -1121,6 +1184,7 @@ void HDF5DataSetHandler::readDoubleNDFromBuffer(HDF5HsSelectionReader & hsSelect
 void HDF5DataSetHandler::createIntBuffer(HDF5HsSelectionReader & hsSelectionReader, const std::vector < int >&current_arrctx_indices, void **data) {
     size_t s = hsSelectionReader.getSize2();
     full_int_data_set_buffer = (int*) malloc(s* sizeof(int));
+    account(liveBuffers, full_bytes, s * sizeof(int));
     herr_t status = H5Dread(dataset_id, hsSelectionReader.dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, full_int_data_set_buffer);
     if (status < 0) {
         char error_message[200];
@@ -1130,7 +1194,7 @@ void HDF5DataSetHandler::createIntBuffer(HDF5HsSelectionReader & hsSelectionRead
 }
 
 void HDF5DataSetHandler::readDouble0DFromBuffer(HDF5HsSelectionReader & hsSelectionReader, const std::vector < int >&current_arrctx_indices, void **data) {
-    *data = (void*) malloc(sizeof(double));
+    *data = (void*) ALAllocator::allocate(sizeof(double));
     double* data_double = (double*) *data;
     if (hsSelectionReader.getRank() != 0) {
         HDF5Utils hdf5_utils;
@@ -1146,6 +1210,7 @@ void HDF5DataSetHandler::createDoubleBuffer(HDF5HsSelectionReader & hsSelectionR
     size_t s = hsSelectionReader.getSize2();
     //printf("calling createDoubleBuffer for %s, id=%d, size(MB)=%f\n", getName().c_str(), (int) dataset_id, (double) ((s * sizeof(double))/1024./1024.));
     full_double_data_set_buffer = (double*) malloc(s* sizeof(double));
+    account(liveBuffers, full_bytes, s * sizeof(double));
     herr_t status = H5Dread(dataset_id, hsSelectionReader.dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, full_double_data_set_buffer);
     if (status < 0) {
         char error_message[200];
@@ -1154,14 +1219,14 @@ void HDF5DataSetHandler::createDoubleBuffer(HDF5HsSelectionReader & hsSelectionR
     }
 }
 
-void HDF5DataSetHandler::readUsingHyperslabs(const std::vector < int >&current_arrctx_indices, int slice_mode, bool is_dynamic, bool isTimed, int timed_AOS_index, int slice_index, void **data, bool read_strings) {
+void HDF5DataSetHandler::readUsingHyperslabs(const std::vector < int >&current_arrctx_indices, int slice_mode, bool is_dynamic, bool isTimed, int timed_AOS_index, int slice_index, void **data, bool read_strings, void *user_buffer, size_t user_buffer_capacity) {
     HDF5HsSelectionReader & hsSelectionReader = *selection_reader;
     hsSelectionReader.setHyperSlabs(slice_mode, is_dynamic, isTimed, slice_index, timed_AOS_index, current_arrctx_indices);
    
     herr_t status = -1;
     //printf("inside readUsingHyperslabs\n");
     if (!read_strings) {
-         hsSelectionReader.allocateBuffer(data, slice_mode, is_dynamic, isTimed, slice_index);
+         hsSelectionReader.allocateBuffer(data, slice_mode, is_dynamic, isTimed, slice_index, user_buffer, user_buffer_capacity);
         status = H5Dread(dataset_id, hsSelectionReader.dtype_id, hsSelectionReader.memspace, hsSelectionReader.dataspace, H5P_DEFAULT, *data);
     }
     else {
@@ -1185,7 +1250,7 @@ void HDF5DataSetHandler::readUsingHyperslabs(const std::vector < int >&current_a
                 maxlength = strs[i].length();
         }
         // allocate 1 additional char so all strings are definitely null-terminated:
-        *data = (void*) malloc(sizeof(char) * (strings_count * maxlength + 1));
+        *data = (void*) ALAllocator::allocate(sizeof(char) * (strings_count * maxlength + 1));
         char* p = (char *) *data;
         memset(p, 0, strings_count * maxlength + 1);
         for(int i=0; i < strings_count; i++)
@@ -1206,11 +1271,11 @@ void HDF5DataSetHandler::readUsingHyperslabs(const std::vector < int >&current_a
     }
 }
 
-void HDF5DataSetHandler::readData(const std::vector < int >&current_arrctx_indices, int datatype, int dim, int slice_mode, bool is_dynamic, bool isTimed, int timed_AOS_index, int slice_index, void **data) {
+void HDF5DataSetHandler::readData(const std::vector < int >&current_arrctx_indices, int datatype, int dim, int slice_mode, bool is_dynamic, bool isTimed, int timed_AOS_index, int slice_index, void **data, void *user_buffer, size_t user_buffer_capacity) {
     HDF5HsSelectionReader & hsSelectionReader = *selection_reader;
 
     if (hsSelectionReader.time_range.enabled) {
-         readUsingHyperslabs(current_arrctx_indices, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data, datatype == alconst::char_data);
+         readUsingHyperslabs(current_arrctx_indices, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data, datatype == alconst::char_data, user_buffer, user_buffer_capacity);
          return;
     }
 
@@ -1238,7 +1303,7 @@ void HDF5DataSetHandler::readData(const std::vector < int >&current_arrctx_indic
                 readDoubleNDFromBuffer(hsSelectionReader, current_arrctx_indices, data);
             }
             else {
-                readUsingHyperslabs(current_arrctx_indices, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data, false);
+                readUsingHyperslabs(current_arrctx_indices, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data, false, user_buffer, user_buffer_capacity);
             }
         } else {
             if (dim == 1 && slice_mode != SLICE_OP) {
@@ -1247,12 +1312,12 @@ void HDF5DataSetHandler::readData(const std::vector < int >&current_arrctx_indic
                 read0DStringsFromBuffer(hsSelectionReader, current_arrctx_indices, data);
             }
             else {
-                readUsingHyperslabs(current_arrctx_indices, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data, datatype == alconst::char_data);
+                readUsingHyperslabs(current_arrctx_indices, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data, datatype == alconst::char_data, user_buffer, user_buffer_capacity);
             }
         }
     }
     else {
-        readUsingHyperslabs(current_arrctx_indices, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data, datatype == alconst::char_data);
+        readUsingHyperslabs(current_arrctx_indices, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data, datatype == alconst::char_data, user_buffer, user_buffer_capacity);
     }
 }
 
@@ -9,12 +9,16 @@
 #include <string>
 #include <set>
 #include <unordered_map>
+#include <memory>
 
 #define UINT_DATA   61
 
 #define READ_CHUNK_CACHE_SIZE 5*1024*1024
 #define WRITE_CHUNK_CACHE_SIZE 100*1024*1024
 
+// attribute of the in-memory files of the puts whose datasets are compressed as they are written
+#define COMPRESSED_SCRATCH_ATTRIBUTE "compressed"
+
 typedef struct {
    double re;   /*real part */
    double im;   /*imaginary part */
@@ -63,7 +67,12 @@ class HDF5DataSetHandler {
     void createIntBuffer(HDF5HsSelectionReader & hsSelectionReader, const std::vector < int >&current_arrctx_indices, void **data);
     void readDouble0DFromBuffer(HDF5HsSelectionReader & hsSelectionReader, const std::vector < int >&current_arrctx_indices, void **data);
     void createDoubleBuffer(HDF5HsSelectionReader & hsSelectionReader, const std::vector < int >&current_arrctx_indices, void **data);
-    void readUsingHyperslabs(const std::vector < int >&current_arrctx_indices, int slice_mode, bool is_dynamic, bool isTimed, int timed_AOS_index, int slice_index, void **data, bool read_strings);
+    void readUsingHyperslabs(const std::vector < int >&current_arrctx_indices, int slice_mode, bool is_dynamic, bool isTimed, int timed_AOS_index, int slice_index, void **data, bool read_strings, void *user_buffer = NULL, size_t user_buffer_capacity = 0);
+
+    //memory accounting (see al_memory_usage)
+    size_t pending_bytes = 0;           //buffered writes not yet gathered into the full buffer
+    size_t full_bytes = 0;              //full buffer of the dataset
+    size_t chunk_cache_bytes = 0;       //capacity of the chunk cache of the dataset
 
   public:
 
@@ -141,6 +150,12 @@ class HDF5DataSetHandler {
         tensorized_path = p;
     }
     void close();
+    size_t getBuffersSize() const { return pending_bytes + full_bytes; }
+    size_t getChunkCacheSize() const { return chunk_cache_bytes; }
+
+    //Accounts the buffers and chunk caches of the passed datasets to the passed IDS
+    static void addMemoryUsage(ALMemoryUsage &usage, const std::string &ids,
+                               const std::unordered_map < std::string, std::unique_ptr < HDF5DataSetHandler > > &data_sets);
     bool isRequestInExtent(const std::vector < int >&current_arrctx_indices);
     void write_buffers();
     void fillFullBuffers() ;
@@ -148,8 +163,8 @@ class HDF5DataSetHandler {
     void writeUsingHyperslabs(const std::vector < int >&current_arrctx_indices, int slice_mode, int dynamic_AOS_slices_extension, void *data);
     void appendToBuffer(const std::vector < int >&current_arrctx_indices, bool dataSetAlreadyOpened, int datatype, int dim, int slice_mode, int dynamic_AOS_slices_extension, char**p, void *data);
 
-    //Reading operation
-    void readData(const std::vector < int >&current_arrctx_indices, int datatype, int dim, int slice_mode, bool is_dynamic, bool isTimed, int timed_AOS_index, int slice_index, void **data);
+    //Reading operation. When large enough, user_buffer receives the data read with hyperslabs instead of a newly allocated buffer
+    void readData(const std::vector < int >&current_arrctx_indices, int datatype, int dim, int slice_mode, bool is_dynamic, bool isTimed, int timed_AOS_index, int slice_index, void **data, void *user_buffer = NULL, size_t user_buffer_capacity = 0);
 
 };
 
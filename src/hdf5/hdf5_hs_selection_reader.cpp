@@ -151,12 +151,12 @@ void HDF5HsSelectionReader::allocateGlobalOpBuffer(void **data)
 void HDF5HsSelectionReader::allocateInhomogeneousTimeDataSet(void **data, int timed_AOS_index)
 {
     if (timed_AOS_index != -1)
-        *data = malloc(dtype_size*dataspace_dims[timed_AOS_index]);
+        *data = ALAllocator::allocate(dtype_size*dataspace_dims[timed_AOS_index]);
     else
         allocateGlobalOpBuffer(data);
 }
 
-int HDF5HsSelectionReader::allocateBuffer(void **data, int slice_mode, bool is_dynamic, bool isTimed, int slice_index)
+int HDF5HsSelectionReader::allocateBuffer(void **data, int slice_mode, bool is_dynamic, bool isTimed, int slice_index, void *user_buffer, size_t user_buffer_capacity)
 {
     size_t buffer = buffer_size;
     
@@ -167,8 +167,10 @@ int HDF5HsSelectionReader::allocateBuffer(void **data, int slice_mode, bool is_d
 
     //printf("buffer size = %d\n", buffer);
 
-    if (datatype != alconst::char_data) {
-        *data = malloc(buffer);
+    if (datatype != alconst::char_data && user_buffer != NULL && buffer <= user_buffer_capacity) {
+        *data = user_buffer;    //caller provided buffer is large enough
+    } else if (datatype != alconst::char_data) {
+        *data = ALAllocator::allocate(buffer);
         if (*data == nullptr) {
              char error_message[200];
              sprintf(error_message, "Unable to allocate memory.\n");
@@ -193,10 +195,10 @@ int HDF5HsSelectionReader::allocateFullBuffer(void **data)
     }
 	//std::cout << "total buffer size = " << buffer * dtype_size << std::endl;
     if (datatype != alconst::char_data) {
-        *data = malloc(size * dtype_size);
+        *data = ALAllocator::allocate(size * dtype_size);
     }
     else {
-        *data = malloc(size * sizeof(char*));
+        *data = ALAllocator::allocate(size * sizeof(char*));
     }
     return size;
 }
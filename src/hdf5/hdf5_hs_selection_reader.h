@@ -61,7 +61,7 @@ class HDF5HsSelectionReader {
     int getShape(int axis_index) const;
     bool isRequestInExtent(const std::vector < int >&current_arrctx_indices);
     void allocateGlobalOpBuffer(void **data);
-    int allocateBuffer(void **data, int slice_mode, bool is_dynamic, bool isTimed, int slice_index);
+    int allocateBuffer(void **data, int slice_mode, bool is_dynamic, bool isTimed, int slice_index, void *user_buffer = NULL, size_t user_buffer_capacity = 0);
     int allocateFullBuffer(void **data);
     void allocateInhomogeneousTimeDataSet(void **data, int timed_AOS_index);
     void setHyperSlabsGlobalOp(std::vector < int >current_arrctx_indices, int timed_AOS_index = -1, bool count_along_dynamic_aos = false);
@@ -0,0 +1,588 @@
+#include "hdf5_incremental_put.h"
+
+#include <string.h>
+#include <algorithm>
+#include <stdint.h>
+#include <random>
+#include "hdf5_utils.h"
+
+// growth step of the in-memory scratch file
+#define SCRATCH_FILE_INCREMENT (4 * 1024 * 1024)
+// attribute of the IDS groups holding datasets shared by deduplication
+#define DEDUP_ATTRIBUTE "dedup"
+// attribute of the IDS groups holding the stamp of the last incremental put
+#define STAMP_ATTRIBUTE "incremental_put_stamp"
+
+static bool enabled(uri::Uri & uri, const std::string & option)
+{
+    uri::OptionalValue value = uri.query.get(option);
+    return value && (value.value() == "yes" || value.value() == "y");
+}
+
+// random, so that the puts of other data entries and processes leave a different stamp
+static uint64_t newStamp()
+{
+    std::random_device random;
+    uint64_t stamp = ((uint64_t) random() << 32) ^ random();
+    return (stamp != 0) ? stamp : 1;
+}
+
+// 0 if the group has no stamp
+static uint64_t readStamp(hid_t gid)
+{
+    uint64_t stamp = 0;
+    if (H5Aexists(gid, STAMP_ATTRIBUTE) <= 0)
+        return 0;
+    hid_t att_id = H5Aopen(gid, STAMP_ATTRIBUTE, H5P_DEFAULT);
+    if (att_id < 0 || H5Aread(att_id, H5T_NATIVE_UINT64, &stamp) < 0)
+        stamp = 0;
+    if (att_id >= 0)
+        H5Aclose(att_id);
+    return stamp;
+}
+
+static void writeStamp(hid_t gid, uint64_t stamp)
+{
+    HDF5IncrementalPut::clearStamp(gid);
+    hid_t dataspace_id = H5Screate(H5S_SCALAR);
+    hid_t att_id = H5Acreate2(gid, STAMP_ATTRIBUTE, H5T_NATIVE_UINT64, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
+    herr_t status = (att_id >= 0) ? H5Awrite(att_id, H5T_NATIVE_UINT64, &stamp) : -1;
+    if (att_id >= 0)
+        H5Aclose(att_id);
+    H5Sclose(dataspace_id);
+    if (status < 0)
+        throw ALBackendException("HDF5Backend: unable to write the stamp of the incremental put", LOG);
+}
+
+void HDF5IncrementalPut::clearStamp(hid_t gid)
+{
+    if (H5Aexists(gid, STAMP_ATTRIBUTE) > 0 && H5Adelete(gid, STAMP_ATTRIBUTE) < 0)
+        throw ALBackendException("HDF5Backend: unable to remove the stamp of the incremental put", LOG);
+}
+
+HDF5IncrementalPut::HDF5IncrementalPut(uri::Uri uri)
+:  previous_puts(), pending_deletes(), written(), scratch_file_id(-1), scratch_gid(-1), scratch_compressed(false), compression_enabled(true), incremental(false), dedup(false), counters(), dedup_counters()
+{
+    uri::OptionalValue compression = uri.query.get("hdf5_compression");
+    if (compression && (compression.value() == "no" || compression.value() == "n"))
+        compression_enabled = false;
+    incremental = enabled(uri, "incremental_put");
+    dedup = enabled(uri, "dedup");
+}
+
+HDF5IncrementalPut::~HDF5IncrementalPut()
+{
+    closeScratchFile();
+}
+
+void HDF5IncrementalPut::closeScratchFile()
+{
+    if (scratch_file_id >= 0)
+        H5Fclose(scratch_file_id);
+    scratch_file_id = -1;
+    scratch_gid = -1;
+    written.clear();
+}
+
+hid_t HDF5IncrementalPut::beginPut(OperationContext * ctx)
+{
+    closeScratchFile();
+    // the file only lives in memory (no backing store), its name must be unique within the process
+    std::string scratch_file_name = "incremental_put_" + std::to_string((uintptr_t) this);
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    H5Pset_fapl_core(fapl, SCRATCH_FILE_INCREMENT, 0);
+    scratch_file_id = H5Fcreate(scratch_file_name.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    H5Pclose(fapl);
+    if (scratch_file_id < 0) {
+        char error_message[200];
+        sprintf(error_message, "Unable to create the in-memory file of the incremental put of IDS: %s.\n", ctx->getDataobjectName().c_str());
+        throw ALBackendException(error_message, LOG);
+    }
+    // without incremental_put, every put rewrites the IDS file: its datasets are compressed once, when written
+    scratch_compressed = compression_enabled && !incremental;
+    if (scratch_compressed) {
+        hid_t dataspace_id = H5Screate(H5S_SCALAR);
+        hid_t att_id = H5Acreate2(scratch_file_id, COMPRESSED_SCRATCH_ATTRIBUTE, H5T_NATIVE_INT, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
+        H5Sclose(dataspace_id);
+        if (att_id < 0) {
+            closeScratchFile();
+            throw ALBackendException("Unable to mark the in-memory file of the put of IDS " + ctx->getDataobjectName() + " as compressed", LOG);
+        }
+        H5Aclose(att_id);
+    }
+    HDF5Utils hdf5_utils;
+    scratch_gid = hdf5_utils.createOrOpenHDF5Group(ctx->getDataobjectName(), scratch_file_id);
+    return scratch_gid;
+}
+
+void HDF5IncrementalPut::dataWritten(hid_t gid, const std::string & tensorized_path, const std::vector < int > &arrctx_indices, int datatype, int dim, const int *size, const void *data)
+{
+    if (gid < 0 || gid != scratch_gid)
+        return;
+    size_t bytes = Backend::getDataByteSize(datatype, dim, size);
+    uint64_t hash = Backend::hashData(&datatype, sizeof(datatype));
+    hash = Backend::hashData(size, dim * sizeof(int), hash);
+    hash = Backend::hashData(data, bytes, hash);
+    Written & w = written[tensorized_path];
+    uint64_t & row = w.rows[arrctx_indices];
+    row = Backend::hashData(&hash, sizeof(hash), row);
+    w.bytes += bytes;
+}
+
+void HDF5IncrementalPut::deleteData(OperationContext * ctx)
+{
+    pending_deletes.insert(ctx->getDataobjectName());
+}
+
+void HDF5IncrementalPut::invalidate(const std::string & dataobjectname)
+{
+    previous_puts.erase(dataobjectname);
+}
+
+void HDF5IncrementalPut::flush(const std::string & dataobjectname, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, HDF5Writer & writer, std::string & files_directory, std::string & relative_file_path)
+{
+    auto it = pending_deletes.begin();
+    while (it != pending_deletes.end()) {
+        if (dataobjectname.empty() || *it == dataobjectname) {
+            writer.deleteIDSFile(*it, file_id, opened_IDS_files, files_directory, relative_file_path);
+            previous_puts.erase(*it);
+            it = pending_deletes.erase(it);
+        }
+        else
+            it++;
+    }
+}
+
+HDF5IncrementalPut::Fingerprint HDF5IncrementalPut::fingerprint(hid_t dataset_id)
+{
+    Fingerprint fp;
+    hid_t dtype_id = H5Dget_type(dataset_id);
+    hid_t dataspace_id = H5Dget_space(dataset_id);
+    fp.type_class = H5Tget_class(dtype_id);
+    fp.type_size = H5Tget_size(dtype_id);
+    fp.dims.resize(H5Sget_simple_extent_ndims(dataspace_id));
+    H5Sget_simple_extent_dims(dataspace_id, fp.dims.data(), NULL);
+    size_t npoints = (size_t) H5Sget_simple_extent_npoints(dataspace_id);
+
+    herr_t status = 0;
+    fp.hash = Backend::hashData(fp.dims.data(), fp.dims.size() * sizeof(hsize_t));
+    if (H5Tis_variable_str(dtype_id) > 0) {
+        std::vector < char *>strings(npoints, NULL);
+        fp.bytes = 0;
+        if (npoints > 0)
+            status = H5Dread(dataset_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, strings.data());
+        for (size_t i = 0; status >= 0 && i < npoints; i++) {
+            size_t length = (strings[i] != NULL) ? strlen(strings[i]) : 0;
+            fp.hash = Backend::hashData(&length, sizeof(length), fp.hash);
+            fp.hash = Backend::hashData(strings[i], length, fp.hash);
+            fp.bytes += length;
+        }
+        if (status >= 0 && npoints > 0)
+            H5Dvlen_reclaim(dtype_id, dataspace_id, H5P_DEFAULT, strings.data());
+    }
+    else {
+        fp.bytes = npoints * fp.type_size;
+        std::vector < unsigned char >buffer(fp.bytes);
+        if (npoints > 0)
+            status = H5Dread(dataset_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data());
+        fp.hash = Backend::hashData(buffer.data(), buffer.size(), fp.hash);
+    }
+    H5Sclose(dataspace_id);
+    H5Tclose(dtype_id);
+    if (status < 0)
+        throw ALBackendException("HDF5Backend: unable to read a dataset of the incremental put", LOG);
+    return fp;
+}
+
+HDF5IncrementalPut::Fingerprint HDF5IncrementalPut::fingerprint(hid_t dataset_id, const Written & data)
+{
+    // the content is known from the buffers written, only the layout is read
+    Fingerprint fp;
+    hid_t dtype_id = H5Dget_type(dataset_id);
+    hid_t dataspace_id = H5Dget_space(dataset_id);
+    fp.type_class = H5Tget_class(dtype_id);
+    fp.type_size = H5Tget_size(dtype_id);
+    fp.dims.resize(H5Sget_simple_extent_ndims(dataspace_id));
+    H5Sget_simple_extent_dims(dataspace_id, fp.dims.data(), NULL);
+    if (H5Tis_variable_str(dtype_id) > 0)
+        fp.bytes = data.bytes;
+    else
+        fp.bytes = (size_t) H5Sget_simple_extent_npoints(dataspace_id) * fp.type_size;
+    H5Sclose(dataspace_id);
+    H5Tclose(dtype_id);
+
+    fp.rows = data.rows;
+    fp.hash = Backend::hashData(fp.dims.data(), fp.dims.size() * sizeof(hsize_t));
+    for (auto & row : fp.rows) {
+        fp.hash = Backend::hashData(row.first.data(), row.first.size() * sizeof(int), fp.hash);
+        fp.hash = Backend::hashData(&row.second, sizeof(row.second), fp.hash);
+    }
+    return fp;
+}
+
+bool HDF5IncrementalPut::sameContent(hid_t dataset_id, hid_t other_dataset_id)
+{
+    // both datasets have the same layout, checked by the caller
+    hid_t dtype_id = H5Dget_type(dataset_id);
+    hid_t dataspace_id = H5Dget_space(dataset_id);
+    size_t npoints = (size_t) H5Sget_simple_extent_npoints(dataspace_id);
+    bool variable_str = H5Tis_variable_str(dtype_id) > 0;
+    size_t bytes = npoints * (variable_str ? sizeof(char *) : H5Tget_size(dtype_id));
+    std::vector < unsigned char >buffer(bytes), other_buffer(bytes);
+    herr_t status = 0, other_status = 0;
+    bool same = true;
+    if (npoints > 0) {
+        status = H5Dread(dataset_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data());
+        other_status = H5Dread(other_dataset_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, other_buffer.data());
+        if (status >= 0 && other_status >= 0 && variable_str) {
+            char **strings = (char **) buffer.data();
+            char **other_strings = (char **) other_buffer.data();
+            for (size_t i = 0; same && i < npoints; i++)
+                same = strcmp(strings[i] != NULL ? strings[i] : "", other_strings[i] != NULL ? other_strings[i] : "") == 0;
+        }
+        else if (status >= 0 && other_status >= 0)
+            same = memcmp(buffer.data(), other_buffer.data(), bytes) == 0;
+        if (status >= 0 && variable_str)
+            H5Dvlen_reclaim(dtype_id, dataspace_id, H5P_DEFAULT, buffer.data());
+        if (other_status >= 0 && variable_str)
+            H5Dvlen_reclaim(dtype_id, dataspace_id, H5P_DEFAULT, other_buffer.data());
+    }
+    H5Sclose(dataspace_id);
+    H5Tclose(dtype_id);
+    if (status < 0 || other_status < 0)
+        throw ALBackendException("HDF5Backend: unable to read a dataset of the deduplicated put", LOG);
+    return same;
+}
+
+void HDF5IncrementalPut::copyContent(hid_t src_dataset_id, hid_t dst_dataset_id)
+{
+    hid_t dtype_id = H5Dget_type(src_dataset_id);
+    hid_t dataspace_id = H5Dget_space(src_dataset_id);
+    size_t npoints = (size_t) H5Sget_simple_extent_npoints(dataspace_id);
+    bool variable_str = H5Tis_variable_str(dtype_id) > 0;
+    std::vector < unsigned char >buffer(npoints * (variable_str ? sizeof(char *) : H5Tget_size(dtype_id)));
+    herr_t status = 0;
+    if (npoints > 0) {
+        status = H5Dread(src_dataset_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data());
+        if (status >= 0) {
+            status = H5Dwrite(dst_dataset_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data());
+            if (variable_str)
+                H5Dvlen_reclaim(dtype_id, dataspace_id, H5P_DEFAULT, buffer.data());
+        }
+    }
+    H5Sclose(dataspace_id);
+    H5Tclose(dtype_id);
+    if (status < 0)
+        throw ALBackendException("HDF5Backend: unable to update a dataset of the incremental put", LOG);
+}
+
+size_t HDF5IncrementalPut::copyRow(hid_t src_dataset_id, hid_t dst_dataset_id, const std::vector < int > &row)
+{
+    // the AoS dimensions come first in the dataset, followed by the dimensions of the field
+    hid_t dtype_id = H5Dget_type(src_dataset_id);
+    hid_t file_space_id = H5Dget_space(src_dataset_id);
+    int rank = H5Sget_simple_extent_ndims(file_space_id);
+    std::vector < hsize_t > dims(rank), offset(rank, 0), count(rank);
+    H5Sget_simple_extent_dims(file_space_id, dims.data(), NULL);
+    for (int i = 0; i < rank; i++) {
+        offset[i] = (i < (int) row.size()) ? row[i] : 0;
+        count[i] = (i < (int) row.size()) ? 1 : dims[i];
+    }
+    herr_t status = H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, offset.data(), NULL, count.data(), NULL);
+    hid_t mem_space_id = H5Screate_simple(rank, count.data(), NULL);
+    size_t npoints = (size_t) H5Sget_select_npoints(file_space_id);
+    bool variable_str = H5Tis_variable_str(dtype_id) > 0;
+    std::vector < unsigned char >buffer(npoints * (variable_str ? sizeof(char *) : H5Tget_size(dtype_id)));
+    size_t bytes = buffer.size();
+    if (status >= 0 && npoints > 0) {
+        status = H5Dread(src_dataset_id, dtype_id, mem_space_id, file_space_id, H5P_DEFAULT, buffer.data());
+        if (status >= 0) {
+            status = H5Dwrite(dst_dataset_id, dtype_id, mem_space_id, file_space_id, H5P_DEFAULT, buffer.data());
+            if (variable_str) {
+                char **strings = (char **) buffer.data();
+                bytes = 0;
+                for (size_t i = 0; i < npoints; i++)
+                    bytes += (strings[i] != NULL) ? strlen(strings[i]) : 0;
+                H5Dvlen_reclaim(dtype_id, mem_space_id, H5P_DEFAULT, buffer.data());
+            }
+        }
+    }
+    H5Sclose(mem_space_id);
+    H5Sclose(file_space_id);
+    H5Tclose(dtype_id);
+    if (status < 0)
+        throw ALBackendException("HDF5Backend: unable to update an AoS element of the incremental put", LOG);
+    return bytes;
+}
+
+void HDF5IncrementalPut::copyDataset(hid_t src_dataset_id, hid_t loc_id, const std::string & dataset_name)
+{
+    // same layout and fill value as written by the backend, compressed as it would have been
+    hid_t dcpl_id = H5Dget_create_plist(src_dataset_id);
+    if (compression_enabled && H5Pget_layout(dcpl_id) == H5D_CHUNKED) {
+        H5Pset_shuffle(dcpl_id);
+        H5Pset_deflate(dcpl_id, 1);
+    }
+    hid_t dtype_id = H5Dget_type(src_dataset_id);
+    hid_t dataspace_id = H5Dget_space(src_dataset_id);
+    hid_t dst_dataset_id = H5Dcreate2(loc_id, dataset_name.c_str(), dtype_id, dataspace_id, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+    H5Sclose(dataspace_id);
+    H5Tclose(dtype_id);
+    H5Pclose(dcpl_id);
+    if (dst_dataset_id < 0)
+        throw ALBackendException("HDF5Backend: unable to create " + dataset_name + " in the IDS file", LOG);
+    try {
+        copyContent(src_dataset_id, dst_dataset_id);
+    }
+    catch(...) {
+        H5Dclose(dst_dataset_id);
+        throw;
+    }
+    H5Dclose(dst_dataset_id);
+}
+
+void HDF5IncrementalPut::unshareDatasets(hid_t gid)
+{
+    if (H5Aexists(gid, DEDUP_ATTRIBUTE) <= 0)
+        return;
+    H5G_info_t group_info;
+    H5Gget_info(gid, &group_info);
+    std::vector < std::string > names;
+    for (hsize_t i = 0; i < group_info.nlinks; i++) {
+        ssize_t length = H5Lget_name_by_idx(gid, ".", H5_INDEX_NAME, H5_ITER_INC, i, NULL, 0, H5P_DEFAULT);
+        std::vector < char >name(length + 1);
+        H5Lget_name_by_idx(gid, ".", H5_INDEX_NAME, H5_ITER_INC, i, name.data(), name.size(), H5P_DEFAULT);
+        names.push_back(name.data());
+    }
+    // each name still linked to a shared object gets its own copy, the last one keeps the object
+    for (const std::string & name : names) {
+        H5O_info_t object_info;
+#if H5_VERSION_GE(1, 12, 0)
+        herr_t status = H5Oget_info_by_name(gid, name.c_str(), &object_info, H5O_INFO_BASIC, H5P_DEFAULT);
+#else
+        herr_t status = H5Oget_info_by_name(gid, name.c_str(), &object_info, H5P_DEFAULT);
+#endif
+        if (status < 0 || object_info.rc < 2)
+            continue;
+        std::string copy_name = name + "&unshared";
+        if (H5Ocopy(gid, name.c_str(), gid, copy_name.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0
+            || H5Ldelete(gid, name.c_str(), H5P_DEFAULT) < 0
+            || H5Lmove(gid, copy_name.c_str(), gid, name.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0)
+            throw ALBackendException("HDF5Backend: unable to unshare the deduplicated dataset " + name, LOG);
+    }
+    H5Adelete(gid, DEDUP_ATTRIBUTE);
+}
+
+void HDF5IncrementalPut::endPut(OperationContext * ctx, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, HDF5Writer & writer, std::string & files_directory, std::string & relative_file_path, int access_mode)
+{
+    if (scratch_file_id < 0)
+        return;
+    const std::string & dataobjectname = ctx->getDataobjectName();
+    std::string group_name = dataobjectname;
+    std::replace(group_name.begin(), group_name.end(), '/', '_');
+    hid_t put_gid = H5Gopen2(scratch_file_id, group_name.c_str(), H5P_DEFAULT);
+    if (put_gid < 0) {
+        closeScratchFile();
+        throw ALBackendException("HDF5Backend: unable to open the group of the incremental put", LOG);
+    }
+
+    try {
+        // fingerprints of the datasets of this put, any other object (not written by the backend) forces a full rewrite
+        std::vector < std::string > names;
+        Fingerprints current;
+        bool full_rewrite = false;
+        H5G_info_t group_info;
+        H5Gget_info(put_gid, &group_info);
+        for (hsize_t i = 0; i < group_info.nlinks; i++) {
+            ssize_t length = H5Lget_name_by_idx(put_gid, ".", H5_INDEX_NAME, H5_ITER_INC, i, NULL, 0, H5P_DEFAULT);
+            std::vector < char >name(length + 1);
+            H5Lget_name_by_idx(put_gid, ".", H5_INDEX_NAME, H5_ITER_INC, i, name.data(), name.size(), H5P_DEFAULT);
+            names.push_back(name.data());
+            hid_t object_id = H5Oopen(put_gid, name.data(), H5P_DEFAULT);
+            auto data = written.find(names.back());
+            if (H5Iget_type(object_id) == H5I_DATASET && data != written.end())
+                current[names.back()] = fingerprint(object_id, data->second);
+            else if (H5Iget_type(object_id) == H5I_DATASET)
+                current[names.back()] = fingerprint(object_id);
+            else
+                full_rewrite = true;
+            H5Oclose(object_id);
+        }
+
+        // nothing written (e.g. the operation deleting the IDS before a put)
+        if (names.empty()) {
+            H5Gclose(put_gid);
+            closeScratchFile();
+            return;
+        }
+
+        // datasets with the same type, shape, hash and bytes as a dataset before them are linked to it
+        size_t shared = 0;
+        if (dedup) {
+            std::unordered_multimap < uint64_t, std::string > seen;
+            for (auto & kv : current) {
+                auto range = seen.equal_range(kv.second.hash);
+                for (auto it = range.first; it != range.second && kv.second.link.empty(); it++) {
+                    if (!current[it->second].sameLayout(kv.second))
+                        continue;
+                    hid_t dataset_id = H5Dopen2(put_gid, kv.first.c_str(), H5P_DEFAULT);
+                    hid_t other_dataset_id = H5Dopen2(put_gid, it->second.c_str(), H5P_DEFAULT);
+                    bool same = false;
+                    try {
+                        same = sameContent(dataset_id, other_dataset_id);
+                    }
+                    catch(...) {
+                        H5Dclose(other_dataset_id);
+                        H5Dclose(dataset_id);
+                        throw;
+                    }
+                    H5Dclose(other_dataset_id);
+                    H5Dclose(dataset_id);
+                    if (same)
+                        kv.second.link = it->second;
+                }
+                if (kv.second.link.empty())
+                    seen.emplace(kv.second.hash, kv.first);
+                else
+                    shared++;
+                dedup_counters.arrays++;
+                dedup_counters.bytes += kv.second.bytes;
+                if (!kv.second.link.empty()) {
+                    dedup_counters.sharedArrays++;
+                    dedup_counters.sharedBytes += kv.second.bytes;
+                }
+            }
+        }
+
+        // without incremental_put, or when the links changed, the IDS file is rewritten entirely
+        auto previous = previous_puts.find(dataobjectname);
+        if (!incremental || previous == previous_puts.end() || previous->second.fingerprints.size() != current.size())
+            full_rewrite = true;
+        for (auto it = current.begin(); !full_rewrite && it != current.end(); it++) {
+            auto got = previous->second.fingerprints.find(it->first);
+            full_rewrite = (got == previous->second.fingerprints.end() || !got->second.sameLayout(it->second) || got->second.link != it->second.link);
+        }
+
+        // the IDS file must still be as the previous put left it: another data entry or process may have written it since
+        if (!full_rewrite) {
+            writer.create_IDS_group(ctx, file_id, opened_IDS_files, files_directory, relative_file_path, access_mode);
+            if (readStamp(writer.get_IDS_group(ctx)) != previous->second.stamp) {
+                writer.close_group(ctx);
+                full_rewrite = true;
+            }
+        }
+
+        if (full_rewrite) {
+            writer.deleteIDSFile(dataobjectname, file_id, opened_IDS_files, files_directory, relative_file_path);
+            writer.create_IDS_group(ctx, file_id, opened_IDS_files, files_directory, relative_file_path, access_mode);
+            hid_t gid = writer.get_IDS_group(ctx);
+            for (const std::string & name : names) {
+                if (current.count(name) > 0 && !current[name].link.empty())
+                    continue;
+                if (current.count(name) == 0 || scratch_compressed) {
+                    if (H5Ocopy(put_gid, name.c_str(), gid, name.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0)
+                        throw ALBackendException("HDF5Backend: unable to copy " + name + " into the IDS file", LOG);
+                    continue;
+                }
+                hid_t src_dataset_id = H5Dopen2(put_gid, name.c_str(), H5P_DEFAULT);
+                try {
+                    copyDataset(src_dataset_id, gid, name);
+                }
+                catch(...) {
+                    H5Dclose(src_dataset_id);
+                    throw;
+                }
+                H5Dclose(src_dataset_id);
+            }
+            if (shared > 0) {
+                for (auto & kv : current) {
+                    if (!kv.second.link.empty() && H5Lcreate_hard(gid, kv.second.link.c_str(), gid, kv.first.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0)
+                        throw ALBackendException("HDF5Backend: unable to link " + kv.first + " in the IDS file", LOG);
+                }
+                hid_t dataspace_id = H5Screate(H5S_SCALAR);
+                hid_t att_id = H5Acreate2(gid, DEDUP_ATTRIBUTE, H5T_NATIVE_INT, dataspace_id, H5P_DEFAULT, H5P_DEFAULT);
+                int one = 1;
+                herr_t status = (att_id >= 0) ? H5Awrite(att_id, H5T_NATIVE_INT, &one) : -1;
+                if (att_id >= 0)
+                    H5Aclose(att_id);
+                H5Sclose(dataspace_id);
+                if (status < 0)
+                    throw ALBackendException("HDF5Backend: unable to mark the IDS group as deduplicated", LOG);
+            }
+            for (auto & kv : current) {
+                counters.fieldsWritten++;
+                counters.bytesWritten += kv.second.bytes;
+            }
+            counters.fullRewrites++;
+        }
+        else {
+            hid_t gid = writer.get_IDS_group(ctx);
+            for (auto & kv : current) {
+                // linked datasets follow the dataset they are linked to
+                const Fingerprint & before = previous->second.fingerprints[kv.first];
+                if (before.hash == kv.second.hash || !kv.second.link.empty()) {
+                    counters.fieldsSkipped++;
+                    counters.bytesSaved += kv.second.bytes;
+                    continue;
+                }
+                // the same AoS elements as before were written: only the changed ones are copied
+                bool by_rows = !kv.second.rows.empty() && !kv.second.rows.begin()->first.empty() && before.rows.size() == kv.second.rows.size()
+                    && std::equal(before.rows.begin(), before.rows.end(), kv.second.rows.begin(),[](const RowHashes::value_type & a, const RowHashes::value_type & b) {
+                                  return a.first == b.first;});
+                hid_t src_dataset_id = H5Dopen2(put_gid, kv.first.c_str(), H5P_DEFAULT);
+                hid_t dst_dataset_id = H5Dopen2(gid, kv.first.c_str(), H5P_DEFAULT);
+                if (dst_dataset_id < 0) {
+                    H5Dclose(src_dataset_id);
+                    throw ALBackendException("HDF5Backend: dataset " + kv.first + " of the previous put not found in the IDS file", LOG);
+                }
+                size_t bytes = 0;
+                try {
+                    if (by_rows) {
+                        auto row = before.rows.begin();
+                        for (auto & current_row : kv.second.rows) {
+                            if (current_row.second != row->second)
+                                bytes += copyRow(src_dataset_id, dst_dataset_id, current_row.first);
+                            row++;
+                        }
+                    }
+                    else {
+                        copyContent(src_dataset_id, dst_dataset_id);
+                        bytes = kv.second.bytes;
+                    }
+                }
+                catch(...) {
+                    H5Dclose(src_dataset_id);
+                    H5Dclose(dst_dataset_id);
+                    throw;
+                }
+                H5Dclose(src_dataset_id);
+                H5Dclose(dst_dataset_id);
+                counters.fieldsWritten++;
+                counters.bytesWritten += bytes;
+                counters.bytesSaved += (kv.second.bytes > bytes) ? kv.second.bytes - bytes : 0;
+            }
+        }
+        counters.puts++;
+        if (incremental && names.size() == current.size()) {
+            uint64_t stamp = newStamp();
+            writeStamp(writer.get_IDS_group(ctx), stamp);
+            previous_puts[dataobjectname] = PreviousPut {current, stamp};
+        }
+        else
+            previous_puts.erase(dataobjectname);
+        pending_deletes.erase(dataobjectname);
+    }
+    catch(...) {
+        // the IDS file is in an unknown state: the next put rewrites it entirely
+        previous_puts.erase(dataobjectname);
+        writer.close_group(ctx);
+        writer.close_file_handler(dataobjectname, opened_IDS_files);
+        H5Gclose(put_gid);
+        closeScratchFile();
+        throw;
+    }
+    writer.close_group(ctx);
+    writer.close_file_handler(dataobjectname, opened_IDS_files);
+    H5Gclose(put_gid);
+    closeScratchFile();
+}
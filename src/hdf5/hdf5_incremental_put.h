@@ -0,0 +1,139 @@
+#ifndef HDF5_INCREMENTAL_PUT_H
+#define HDF5_INCREMENTAL_PUT_H 1
+
+#include <hdf5.h>
+#include "al_backend.h"
+#include "hdf5_writer.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+   Incremental and deduplicated puts (URI options incremental_put=yes and dedup=yes).
+   A put is written into a scratch group of an in-memory file, without compression. The buffers
+   given to the writer are hashed as they are written, per dataset and AoS element. At the end of
+   the put, each dataset is fingerprinted (type and shape, and the hashes of what was written; the
+   few datasets written otherwise, such as the shapes, are read back and hashed) and compared with
+   the fingerprints of the previous put of the same IDS: unchanged datasets are left untouched in
+   the IDS file, only the changed AoS elements of the changed ones are rewritten in place. Each
+   incremental put leaves a random stamp in the IDS group, removed by put_slice and by the other
+   puts: the fingerprints are only trusted while the stamp in the file is the one of the previous
+   put. The IDS file is rewritten entirely (and the scratch group copied into it) for the first put
+   of the IDS, or when a dataset was added, removed or changed type or shape.
+   With dedup=yes, the IDS file is always written from the scratch group (unless incremental_put=yes
+   leaves it in place; without it, the scratch datasets are compressed as they are written and copied
+   as they are), and a dataset with the same type, shape, hash and bytes as a dataset written
+   before it is stored as a hard link to that dataset. The IDS group is then marked with an
+   attribute, and the linked datasets are made independent again before the IDS is extended by
+   a put_slice.
+   The delete preceding a put is deferred until the put ends, it is carried out when another
+   action on the IDS comes first.
+**/
+class HDF5IncrementalPut : public HDF5WriteObserver {
+  private:
+
+    typedef std::map < std::vector < int >, uint64_t > RowHashes;    // key = AoS indices (empty outside AoSs)
+
+    struct Fingerprint {
+        H5T_class_t type_class;
+        size_t type_size;
+        std::vector < hsize_t > dims;
+        uint64_t hash;
+        size_t bytes;
+        std::string link;       // dataset with the same content this one is a hard link to (dedup), empty if none
+        RowHashes rows;         // hashes of the AoS elements written, empty if the dataset was read back
+
+        bool sameLayout(const Fingerprint & other) const {
+            return type_class == other.type_class && type_size == other.type_size && dims == other.dims;
+        }
+    };
+    typedef std::map < std::string, Fingerprint > Fingerprints; // key = dataset name
+
+    struct Written {
+        RowHashes rows;
+        size_t bytes = 0;
+    };
+
+    struct PreviousPut {
+        Fingerprints fingerprints;
+        uint64_t stamp;         // stamp the put left in the IDS group
+    };
+
+    std::unordered_map < std::string, PreviousPut > previous_puts;      // key = IDS name (with occurrence)
+    std::set < std::string > pending_deletes;
+    std::unordered_map < std::string, Written > written;       // datasets written in the scratch group, key = dataset name
+    hid_t scratch_file_id;
+    hid_t scratch_gid;
+    bool scratch_compressed;
+    bool compression_enabled;
+    bool incremental;
+    bool dedup;
+    ALIncrementalPutCounters counters;
+    ALDedupCounters dedup_counters;
+
+    static Fingerprint fingerprint(hid_t dataset_id);
+    static Fingerprint fingerprint(hid_t dataset_id, const Written & data);
+    static bool sameContent(hid_t dataset_id, hid_t other_dataset_id);
+    static void copyContent(hid_t src_dataset_id, hid_t dst_dataset_id);
+    static size_t copyRow(hid_t src_dataset_id, hid_t dst_dataset_id, const std::vector < int > &row);
+    void copyDataset(hid_t src_dataset_id, hid_t loc_id, const std::string & dataset_name);
+    void closeScratchFile();
+
+  public:
+
+    HDF5IncrementalPut(uri::Uri uri);
+    ~HDF5IncrementalPut();
+
+    /**
+     Starts a put: creates the scratch group receiving the datasets of the IDS.
+     @result identifier of the scratch group
+     **/
+    hid_t beginPut(OperationContext * ctx);
+
+    /**
+     Ends a put: updates the IDS file from the scratch group, opened with writer.create_IDS_group().
+     Puts which wrote nothing leave the IDS file as it is.
+     **/
+    void endPut(OperationContext * ctx, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, HDF5Writer & writer, std::string & files_directory, std::string & relative_file_path, int access_mode);
+
+    /**
+     Hashes a buffer written into the scratch group.
+     **/
+    void dataWritten(hid_t gid, const std::string & tensorized_path, const std::vector < int > &arrctx_indices, int datatype, int dim, const int *size, const void *data) override;
+
+    /**
+     Defers the delete of an IDS to the end of the put following it.
+     **/
+    void deleteData(OperationContext * ctx);
+
+    /**
+     Carries out the pending delete of an IDS (of all the IDSs if dataobjectname is empty).
+     **/
+    void flush(const std::string & dataobjectname, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, HDF5Writer & writer, std::string & files_directory, std::string & relative_file_path);
+
+    /**
+     Forgets the fingerprints of the previous put of an IDS, when it is written by other means.
+     **/
+    void invalidate(const std::string & dataobjectname);
+
+    /**
+     Makes the datasets of an IDS group shared by deduplication independent again, before they are extended.
+     Groups not marked as deduplicated are left untouched.
+     **/
+    static void unshareDatasets(hid_t gid);
+
+    /**
+     Removes the stamp of the last incremental put from an IDS group, before it is written by other means.
+     **/
+    static void clearStamp(hid_t gid);
+
+    bool isIncremental() const { return incremental; }
+    bool isDedup() const { return dedup; }
+    ALIncrementalPutCounters getCounters() const { return counters; }
+    ALDedupCounters getDedupCounters() const { return dedup_counters; }
+};
+
+#endif
@@ -16,7 +16,8 @@
 HDF5Reader::HDF5Reader(std::string backend_version_)
     : backend_version(backend_version_), opened_data_sets(), opened_shapes_data_sets(), aos_opened_shapes_data_sets(), existing_data_sets(),
       tensorized_paths_per_context(), tensorized_paths_per_op_context(), arrctx_shapes_per_context(), homogeneous_time(-1),
-      IDS_group_id(), slice_mode(GLOBAL_OP), data_interpolation_component()
+      IDS_group_id(), slice_mode(GLOBAL_OP), data_interpolation_component(), homogeneous_time_loaded(false),
+      user_buffer(NULL), user_buffer_capacity(0)
 {
     // H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
     INTERPOLATION_WARNING = (std::getenv("IMAS_AL_DISABLE_INTERPOLATION_WARNING") == nullptr);
@@ -42,6 +43,15 @@ void HDF5Reader::closePulse(DataEntryContext *ctx, int mode, hid_t *file_id, std
     hdf5_utils.closeMasterFile(file_id);
 }
 
+void HDF5Reader::getMemoryUsage(ALMemoryUsage &usage)
+{
+    // datasets are opened by the operation in progress
+    std::string ids = (IDS_group_id.size() == 1) ? IDS_group_id.begin()->first->getDataobjectName() : "";
+    HDF5DataSetHandler::addMemoryUsage(usage, ids, opened_data_sets);
+    HDF5DataSetHandler::addMemoryUsage(usage, ids, opened_shapes_data_sets);
+    HDF5DataSetHandler::addMemoryUsage(usage, ids, aos_opened_shapes_data_sets);
+}
+
 void HDF5Reader::close_datasets()
 {
     auto it_ds = opened_data_sets.begin();
@@ -239,7 +249,7 @@ void HDF5Reader::beginReadArraystructAction(ArraystructContext *ctx, int *size)
     }
 
     *size = shapes[0];
-    free(shapes);
+    ALAllocator::release(shapes);
 
     auto got_arrctx_shapes = arrctx_shapes_per_context.find(ctx);
     if (got_arrctx_shapes != arrctx_shapes_per_context.end())
@@ -440,7 +450,7 @@ void HDF5Reader::getTimeVector(OperationContext *opCtx, std::unique_ptr<HDF5Data
             time_basis.resize(index);
         }
         time_basis_vector = time_basis;
-        free(time_vector);
+        ALAllocator::release(time_vector);
     }
 }
 
@@ -457,8 +467,13 @@ bool HDF5Reader::ends_with(const std::string &str, const std::string &suffix)
     return false;
 }
 
-int HDF5Reader::read_ND_Data(Context *ctx, std::string &att_name, std::string &timebasename, int datatype, void **data, int *dim, int *size)
+int HDF5Reader::read_ND_Data(Context *ctx, const ALPath &att_name, const ALPath &timebase_path, int datatype, void **data, int *dim, int *size)
 {
+    // the caller provided buffer only applies to this request, not to the nested reads (time vectors, shapes)
+    void *dst = user_buffer;
+    size_t dst_capacity = user_buffer_capacity;
+    user_buffer = NULL;
+    user_buffer_capacity = 0;
 
     OperationContext *opctx = nullptr;
     if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE)
@@ -477,9 +492,8 @@ int HDF5Reader::read_ND_Data(Context *ctx, std::string &att_name, std::string &t
     if (gid == -1) // IDS does not exist in the file
         return 0;
 
-    std::string &dataset_name = att_name;
-    std::replace(dataset_name.begin(), dataset_name.end(), '/', '&'); // character '/' is not supported in datasets names
-    std::replace(timebasename.begin(), timebasename.end(), '/', '&');
+    const std::string &dataset_name = HDF5Utils::getDataSetName(att_name, dataset_names);
+    const std::string &timebasename = HDF5Utils::getDataSetName(timebase_path, dataset_names);
 
     hid_t dataset_id = -1;
     std::string tensorized_path = dataset_name;
@@ -501,7 +515,8 @@ int HDF5Reader::read_ND_Data(Context *ctx, std::string &att_name, std::string &t
     bool homogeneous_time_basis_dataset_with_resampling = (opctx->getRangemode() == TIMERANGE_OP) && resampling && is_homogeneous_time_basis_dataset;
     bool inhomogeneous_time_basis_dataset_with_resampling = (opctx->getRangemode() == TIMERANGE_OP) && resampling && is_inhomogeneous_time_basis_dataset;
 
-    read_homogeneous_time(&homogeneous_time, gid);
+    if (!homogeneous_time_loaded)
+        read_homogeneous_time(&homogeneous_time, gid);
 
     if (homogeneous_time_basis_dataset_with_resampling)
     {
@@ -777,7 +792,8 @@ int HDF5Reader::read_ND_Data(Context *ctx, std::string &att_name, std::string &t
             // printf("NOT setting time range size to :%d\n", time_range_size);
         }
 
-        data_set->readData(current_arrctx_indices, datatype, *dim, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data);
+        data_set->readData(current_arrctx_indices, datatype, *dim, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data,
+                           opctx->getRangemode() == GLOBAL_OP ? dst : NULL, dst_capacity);
         data_set->selection_reader->getSize(size, slice_mode, is_dynamic);
     }
     else
@@ -866,7 +882,8 @@ int HDF5Reader::read_ND_Data(Context *ctx, std::string &att_name, std::string &t
         }
 
         data_set->selection_reader = std::move(hsSelectionReader);
-        data_set->readData(current_arrctx_indices, datatype, *dim, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data);
+        data_set->readData(current_arrctx_indices, datatype, *dim, slice_mode, is_dynamic, isTimed, timed_AOS_index, slice_index, data,
+                           opctx->getRangemode() == GLOBAL_OP ? dst : NULL, dst_capacity);
         data_set->selection_reader->getSize(size, slice_mode, is_dynamic);
     }
 
@@ -945,7 +962,13 @@ int HDF5Reader::read_ND_Data(Context *ctx, std::string &att_name, std::string &t
             this->data_interpolation_component.interpolate(datatype, N, y_slices, slices_times,
                                                            requested_time, data, interp);
             if (slice_inf != slice_sup)
-                free(next_slice_data);
+            {
+                // strings are allocated by the HDF5 library
+                if (datatype == alconst::char_data)
+                    free(next_slice_data);
+                else
+                    ALAllocator::release(next_slice_data);
+            }
 
             if (datatype == alconst::char_data)
             {
@@ -977,7 +1000,7 @@ int HDF5Reader::read_ND_Data(Context *ctx, std::string &att_name, std::string &t
         else if (is_homogeneous_time_basis_dataset)
         {
             // printf("calling resample_timebasis for: %s\n", data_set->getName().c_str());
-            free(*data);
+            ALAllocator::release(*data);
             int nb_slices = this->data_interpolation_component.resample_timebasis(tmin, tmax, dtime, timed_AOS_index_current_value, time_basis_vector, data);
             // printf("nb_slices=%d for dataset=%s\n", nb_slices, data_set->getName().c_str());
             size[*dim - 1] = nb_slices;
@@ -1005,8 +1028,8 @@ int HDF5Reader::fixCharDataSet(int datatype, void **data, int *size, int dim)
         {
             if (*p == nullptr)
             {
-                char ch = '\0';
-                *data = strdup(&ch);
+                *data = ALAllocator::allocate(1);
+                *(char *)*data = '\0';
                 size[0] = 1;
             }
             else
@@ -1118,10 +1141,10 @@ int HDF5Reader::checkSlicesShapes(Context *ctx, hid_t gid, const std::string &te
         {
             if (this->INTERPOLATION_WARNING)
                 printf("WARNING: Linear interpolation not possible for node: %s at time index %d\n", tensorized_path.c_str(), slice_sup);
-            free(first_slice_data);
+            ALAllocator::release(first_slice_data);
             return 0;
         }
-        free(first_slice_data);
+        ALAllocator::release(first_slice_data);
         return 1;
     }
 
@@ -1226,7 +1249,7 @@ int HDF5Reader::getPersistentShapes(Context *ctx, hid_t gid, const std::string &
 
         if (*zero_shape)
         {
-            free(shapes);
+            ALAllocator::release(shapes);
             return shapesDataSetExists;
         }
 
@@ -1244,7 +1267,7 @@ int HDF5Reader::getPersistentShapes(Context *ctx, hid_t gid, const std::string &
                     size[i] = shapes[dim - i - 1];
             }
         }
-        free(shapes);
+        ALAllocator::release(shapes);
     }
     return shapesDataSetExists;
 }
@@ -1575,6 +1598,53 @@ herr_t HDF5Reader::iterate_callback(hid_t loc_id, const char *name, const H5L_in
     return 0;
 }
 
+void HDF5Reader::read_ND_Data_batch(Context *ctx, std::vector<DataBatchItem> &items)
+{
+    OperationContext *opctx = nullptr;
+    if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE)
+        opctx = (static_cast<ArraystructContext *>(ctx))->getOperationContext();
+    else
+        opctx = static_cast<OperationContext *>(ctx);
+
+    auto got_gid = IDS_group_id.find(opctx);
+    if (got_gid == IDS_group_id.end() || got_gid->second == -1) // IDS does not exist in the file
+    {
+        for (auto &item : items)
+            item.found = 0;
+        return;
+    }
+
+    // the homogeneous_time flag is read once for the whole batch instead of once per field
+    read_homogeneous_time(&homogeneous_time, got_gid->second);
+    homogeneous_time_loaded = true;
+    try
+    {
+        for (auto &item : items)
+            item.found = read_ND_Data(ctx, item.fieldname, item.timebasename, item.datatype, &item.data, &item.dim, item.size);
+    }
+    catch (...)
+    {
+        homogeneous_time_loaded = false;
+        throw;
+    }
+    homogeneous_time_loaded = false;
+}
+
+int HDF5Reader::read_ND_Data_into(Context *ctx, const ALPath &att_name, const ALPath &timebase_path, int datatype, void *dst, size_t capacity, void **data, int *dim, int *size)
+{
+    // hyperslab reads of global operations go straight into dst when it is large enough
+    void *p = NULL;
+    user_buffer = (datatype != alconst::char_data) ? dst : NULL;
+    user_buffer_capacity = capacity;
+    int status = read_ND_Data(ctx, att_name, timebase_path, datatype, &p, dim, size);
+    if (status == 0)
+        return 0;
+    if (p == dst)
+        return 1;
+    *data = p;
+    return 2;
+}
+
 void HDF5Reader::read_homogeneous_time(int *homogenenous_time, hid_t gid)
 {
 
@@ -8,6 +8,7 @@
 #include "data_interpolation.h"
 
 #include <memory>
+#include <deque>
 #include <vector>
 #include <list>
 #include <unordered_map>
@@ -31,6 +32,7 @@ class HDF5Reader {
     std::unordered_map < ArraystructContext *,  std::vector<int>> arrctx_shapes_per_context;
     
     std::unordered_map < OperationContext *,  hid_t> IDS_group_id;
+    std::deque < std::string > dataset_names;   // dataset names of the interned paths, indexed by ALPath::id()
     
     int slice_mode;
 
@@ -77,6 +79,9 @@ class HDF5Reader {
 
     bool INTERPOLATION_WARNING;
     std::vector<double> time_basis_vector;
+    bool homogeneous_time_loaded;   // homogeneous_time already read for the current batch
+    void *user_buffer;              // caller provided buffer for the next read_ND_Data (see read_ND_Data_into)
+    size_t user_buffer_capacity;
 
   public:
 
@@ -86,13 +91,16 @@ class HDF5Reader {
     int homogeneous_time;
 
     virtual void closePulse(DataEntryContext * ctx, int mode, hid_t *file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, int files_path_strategy, std::string & files_directory, std::string & relative_file_path);
-    virtual int read_ND_Data(Context * ctx, std::string & att_name, std::string & timebasename, int datatype, void **data, int *dim, int *size);
+    virtual int read_ND_Data(Context * ctx, const ALPath & att_name, const ALPath & timebase_path, int datatype, void **data, int *dim, int *size);
+    virtual void read_ND_Data_batch(Context * ctx, std::vector < DataBatchItem > &items);
+    virtual int read_ND_Data_into(Context * ctx, const ALPath & att_name, const ALPath & timebase_path, int datatype, void *dst, size_t capacity, void **data, int *dim, int *size);
     virtual void beginReadArraystructAction(ArraystructContext * ctx, int *size);
     virtual void get_occurrences(const char* ids_name, int** occurrences_list, int* size, hid_t master_file_id);
 
     void open_IDS_group(OperationContext * ctx, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, std::string & files_directory, std::string & relative_file_path);
     void close_file_handler(std::string external_link_name, std::unordered_map < std::string, hid_t > &opened_IDS_files);
     void close_datasets();
+    void getMemoryUsage(ALMemoryUsage &usage);
     void close_group(OperationContext *ctx);
     void endAction(Context * ctx);
     void setSliceMode(OperationContext *ctx);
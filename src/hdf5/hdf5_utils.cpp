@@ -21,7 +21,37 @@ HDF5Utils::~HDF5Utils()
 {
 }
 
-bool HDF5Utils::debug = false;
+std::atomic<bool> HDF5Utils::debug(false);
+
+std::recursive_mutex HDF5LibraryGuard::mutex;
+
+bool HDF5LibraryGuard::isLibraryThreadSafe()
+{
+    static const bool threadsafe = []() {
+        hbool_t ts = 0;
+        H5is_library_threadsafe(&ts);
+        return ts > 0;
+    }();
+    return threadsafe;
+}
+
+HDF5LibraryGuard::HDF5LibraryGuard():locked(!isLibraryThreadSafe())
+{
+    if (locked)
+        mutex.lock();
+    // error stacks are per thread in thread-safe builds: turn off error printing in each calling thread
+    static thread_local bool errorsSilenced = false;
+    if (!errorsSilenced && !HDF5Utils::debug) {
+        H5Eset_auto(H5E_DEFAULT, NULL, NULL);
+        errorsSilenced = true;
+    }
+}
+
+HDF5LibraryGuard::~HDF5LibraryGuard()
+{
+    if (locked)
+        mutex.unlock();
+}
 
 int
  HDF5Utils::openPulse(DataEntryContext * ctx, int mode, std::string & backend_version, hid_t * file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, int files_paths_strategy, std::string & files_directory, std::string & relative_file_path, std::string &pulseFilePath)
@@ -554,6 +584,18 @@ void HDF5Utils::setTensorizedPaths(ArraystructContext * ctx, std::vector < std::
 }
 
 
+const std::string & HDF5Utils::getDataSetName(const ALPath & path, std::deque < std::string > &dataset_names)
+{
+    if (path.id() >= dataset_names.size())
+        dataset_names.resize(path.id() + 1);
+    std::string & name = dataset_names[path.id()];
+    if (name.empty() && !path.empty()) {
+        name = path.str();
+        std::replace(name.begin(), name.end(), '/', '&');   // character '/' is not supported in datasets names
+    }
+    return name;
+}
+
 hid_t HDF5Utils::createOrOpenHDF5Group(const std::string & path, const hid_t & parent_loc_id)
 {
     hid_t loc_id = -1;
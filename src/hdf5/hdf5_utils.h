@@ -3,7 +3,10 @@
 
 #include <hdf5.h>
 #include "al_backend.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <deque>
 #include <vector>
 #include <list>
 #include <unordered_map>
@@ -25,6 +28,21 @@
 
 extern "C" herr_t file_info(hid_t loc_id, const char *name, const H5L_info_t * linfo, void *opdata);
 
+/* Guard of the HDF5 library calls made by a HDF5Backend method.
+   Data entries using distinct HDF5 backends can be accessed from concurrent threads when the HDF5 
+   library is built thread-safe (the library serializes its own calls in that case). Otherwise all 
+   the HDF5 backends of the process are serialized through a global lock. */
+class HDF5LibraryGuard {
+  public:
+    HDF5LibraryGuard();
+    ~HDF5LibraryGuard();
+    static bool isLibraryThreadSafe();
+
+  private:
+    bool locked;
+    static std::recursive_mutex mutex;
+};
+
 struct opdata {
     bool mode;                  //0=writing, 1=reading
      std::string files_directory;
@@ -47,7 +65,7 @@ class HDF5Utils {
      HDF5Utils();
     ~HDF5Utils();
 
-    static bool debug;
+    static std::atomic<bool> debug;
 
     static int openPulse(DataEntryContext * ctx, int mode, std::string & backend_version, hid_t * file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, int files_paths_strategy, std::string & files_directory, std::string & relative_file_path, std::string &pulseFilePath);
 
@@ -79,6 +97,9 @@ class HDF5Utils {
     void getAOSIndices(Context * ctx, std::vector < int >&indices, int *timedAOS_index);
     int getAOSIndicesSize(Context * ctx);
     void setTensorizedPaths(ArraystructContext * ctx, std::vector < std::string > &tensorized_paths);
+    /* Returns the dataset name ('/' replaced by '&') of an interned path, computed once per path id.
+       References to the names stay valid while dataset_names is only grown by this function. */
+    static const std::string & getDataSetName(const ALPath & path, std::deque < std::string > &dataset_names);
     void showStatus(hid_t file_id);
     enum Files_paths_strategies { FULL_MDSPLUS_STRATEGY = 1, MODIFIED_MDSPLUS_STRATEGY = 2, FREE_PATH_STRATEGY = 3};
     void setDefaultOptions(size_t *read_cache, size_t *write_cache, bool *readBuffering, bool *writeBuffering);
@@ -14,7 +14,7 @@ using namespace boost::filesystem;
 
 HDF5Writer::HDF5Writer(std::string backend_version_)
 :  backend_version(backend_version_), opened_data_sets(), existing_data_sets(), tensorized_paths_per_context(), arrctx_shapes_per_context(), 
-dynamic_AOS_slices_extension(), homogeneous_time(-1), IDS_group_id(), slice_mode(GLOBAL_OP)
+dynamic_AOS_slices_extension(), homogeneous_time(-1), IDS_group_id(), slice_mode(GLOBAL_OP), write_observer(nullptr)
 {
     //H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
 }
@@ -99,6 +99,17 @@ void HDF5Writer::deleteData(OperationContext * ctx, hid_t file_id, std::unordere
     }
 }
 
+void HDF5Writer::deleteIDSFile(const std::string & dataobjectname, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, std::string & files_directory, std::string & relative_file_path)
+{
+    std::string IDS_link_name = dataobjectname;
+    std::replace(IDS_link_name.begin(), IDS_link_name.end(), '/', '_');
+    close_file_handler(IDS_link_name, opened_IDS_files);
+    HDF5Utils hdf5_utils;
+    std::string IDSpulseFile = hdf5_utils.getIDSPulseFilePath(files_directory, relative_file_path, IDS_link_name);
+    if (exists(IDSpulseFile.c_str()))
+        hdf5_utils.deleteIDSFile(IDSpulseFile);
+}
+
 void HDF5Writer::read_homogeneous_time(int* homogenenous_time, hid_t gid) {
 
 	if (gid == -1) {
@@ -123,6 +134,18 @@ hid_t > &opened_IDS_files, std::string & files_directory, std::string & relative
         IDS_group_id[ctx] = *gid;
 }
 
+hid_t HDF5Writer::get_IDS_group(OperationContext * ctx)
+{
+    auto got = IDS_group_id.find(ctx);
+    return (got != IDS_group_id.end()) ? got->second : -1;
+}
+
+void HDF5Writer::set_IDS_group(OperationContext * ctx, hid_t gid)
+{
+    close_group(ctx);
+    IDS_group_id[ctx] = gid;
+}
+
 void HDF5Writer::create_IDS_group(OperationContext * ctx, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, std::string & files_directory, std::string & relative_file_path, int access_mode)
 {
     HDF5Utils hdf5_utils;
@@ -178,6 +201,13 @@ void HDF5Writer::create_IDS_group(OperationContext * ctx, hid_t file_id, std::un
     IDS_group_id[ctx] = loc_id;
 }
 
+void HDF5Writer::getMemoryUsage(ALMemoryUsage &usage)
+{
+    // datasets are opened by the operation in progress
+    std::string ids = (IDS_group_id.size() == 1) ? IDS_group_id.begin()->first->getDataobjectName() : "";
+    HDF5DataSetHandler::addMemoryUsage(usage, ids, opened_data_sets);
+}
+
 void HDF5Writer::close_datasets()
 {
     HDF5Utils hdf5_utils;
@@ -273,7 +303,7 @@ int HDF5Writer::readTimedAOSShape(hid_t loc_id, std::string &tensorized_path, co
     }
 
     shape = AOS_shapes[0];
-    free(AOS_shapes);
+    ALAllocator::release(AOS_shapes);
     return shape;
 }
 
@@ -340,45 +370,77 @@ ArraystructContext* HDF5Writer::getDynamicAOS(Context * ctx) {
 }
 
 
-void HDF5Writer::write_ND_Data(Context * ctx, std::string & att_name, std::string & timebasename, int datatype, int dim, int *size, void *data)
+void HDF5Writer::getWriteLevel(Context * ctx, WriteLevel & level)
 {
-    std::string & dataset_name = att_name;
-    std::replace(dataset_name.begin(), dataset_name.end(), '/', '&');   // character '/' is not supported in datasets names
-    std::replace(timebasename.begin(), timebasename.end(), '/', '&');
-
-    OperationContext *opctx = nullptr;
     if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE) {
-        opctx = (static_cast<ArraystructContext*> (ctx))->getOperationContext();
+        level.opctx = (static_cast<ArraystructContext*> (ctx))->getOperationContext();
     }
     else {
-        opctx = static_cast<OperationContext*> (ctx);
+        level.opctx = static_cast<OperationContext*> (ctx);
     }
-    DataEntryContext *dec = opctx->getDataEntryContext();
-    hid_t gid = -1;
-    auto got_gid = IDS_group_id.find(opctx);
+    level.gid = -1;
+    auto got_gid = IDS_group_id.find(level.opctx);
     if (got_gid != IDS_group_id.end())
-        gid = got_gid->second;
+        level.gid = got_gid->second;
 
-    if (! (gid >= 0))
+    if (! (level.gid >= 0))
         throw ALBackendException("HDF5Backend: unexpected value for gid in HDF5Writer::write_ND_Data()", LOG);
 
+    HDF5Utils hdf5_utils;
+    level.timed_AOS_index = -1;
+    level.current_arrctx_indices.clear();
+    hdf5_utils.getAOSIndices(ctx, level.current_arrctx_indices, &level.timed_AOS_index);    //getting current AOS indices    
+
+    level.tensorized_prefix.clear();
+    if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE) {
+      auto &tensorized_paths = tensorized_paths_per_context[static_cast<ArraystructContext*> (ctx)];
+      level.tensorized_prefix = tensorized_paths.back() + "&";
+    }
+
+    level.arrctx_shapes.clear();
+    auto got_arrctx_shapes = arrctx_shapes_per_context.find(static_cast<ArraystructContext*> (ctx));
+    if (got_arrctx_shapes != arrctx_shapes_per_context.end()) 
+      level.arrctx_shapes = (*got_arrctx_shapes).second;
+}
+
+void HDF5Writer::write_ND_Data(Context * ctx, const ALPath & att_name, const ALPath & timebase_path, int datatype, int dim, int *size, void *data)
+{
+    WriteLevel level;
+    getWriteLevel(ctx, level);
+    write_ND_Data(ctx, level, att_name, timebase_path, datatype, dim, size, data);
+}
+
+void HDF5Writer::write_ND_Data_batch(Context * ctx, std::vector < DataBatchItem > &items)
+{
+    // all fields of the batch belong to the same structure level: the IDS group, AOS indices 
+    // and shapes are resolved once
+    WriteLevel level;
+    getWriteLevel(ctx, level);
+    for (auto &item : items)
+        write_ND_Data(ctx, level, item.fieldname, item.timebasename, item.datatype, item.dim, item.size, item.data);
+}
+
+void HDF5Writer::write_ND_Data(Context * ctx, const WriteLevel & level, const ALPath & att_name, const ALPath & timebase_path, int datatype, int dim, int *size, void *data)
+{
+    const std::string & dataset_name = HDF5Utils::getDataSetName(att_name, dataset_names);
+    const std::string & timebasename = HDF5Utils::getDataSetName(timebase_path, dataset_names);
+
+    DataEntryContext *dec = level.opctx->getDataEntryContext();
+    hid_t gid = level.gid;
+
     if (dataset_name == "ids_properties&homogeneous_time") {
         int *v = (int *) data;
         homogeneous_time = v[0];
     }
 
-    HDF5Utils hdf5_utils;
-    int timed_AOS_index = -1;
-    std::vector < int > current_arrctx_indices;
-    hdf5_utils.getAOSIndices(ctx, current_arrctx_indices, &timed_AOS_index);    //getting current AOS indices    
+    int timed_AOS_index = level.timed_AOS_index;
+    const std::vector < int > &current_arrctx_indices = level.current_arrctx_indices;
 
     int AOSRank = current_arrctx_indices.size();
-    std::string tensorized_path = dataset_name;
+    std::string tensorized_path = level.tensorized_prefix + dataset_name;
 
-    if (ctx->getType() == CTX_ARRAYSTRUCT_TYPE) {
-      auto &tensorized_paths = tensorized_paths_per_context[static_cast<ArraystructContext*> (ctx)];
-      tensorized_path = tensorized_paths.back() + "&" + dataset_name;
-    }
+    if (write_observer != nullptr && slice_mode != SLICE_OP)
+        write_observer->dataWritten(gid, tensorized_path, current_arrctx_indices, datatype, dim, size, data);
 
     hid_t dataset_id = -1;
     bool dataSetAlreadyOpened = false;
@@ -393,12 +455,7 @@ void HDF5Writer::write_ND_Data(Context * ctx, std::string & att_name, std::strin
     for (int i = 0; i < dim; i++)
         initial_size[i] = size[i];
 
-    std::vector<int> arrctx_shapes;
-    
-    auto got_arrctx_shapes = arrctx_shapes_per_context.find(static_cast<ArraystructContext*> (ctx));
-    
-    if (got_arrctx_shapes != arrctx_shapes_per_context.end()) 
-      arrctx_shapes = (*got_arrctx_shapes).second;
+    std::vector<int> arrctx_shapes = level.arrctx_shapes;
     
     bool shapes_dataset = false;
 
@@ -524,7 +581,7 @@ void HDF5Writer::write_buffers() {
 
 
 hid_t HDF5Writer::createOrUpdateShapesDataSet(Context * ctx, hid_t loc_id, const std::string & field_tensorized_path, HDF5DataSetHandler & fieldHandler, 
-std::string & timebasename, int timed_AOS_index, const std::vector < int > &current_arrctx_indices, const std::vector < int > &arrctx_shapes)
+const std::string & timebasename, int timed_AOS_index, const std::vector < int > &current_arrctx_indices, const std::vector < int > &arrctx_shapes)
 {
     hid_t dataset_id = -1;
     int AOSRank = current_arrctx_indices.size();
@@ -819,3 +876,7 @@ void HDF5Writer::endAction(Context * ctx)
 void HDF5Writer::setSliceMode(int slice_mode) {
 	this->slice_mode = slice_mode;
 }
+
+void HDF5Writer::setWriteObserver(HDF5WriteObserver * observer) {
+	this->write_observer = observer;
+}
@@ -6,12 +6,39 @@
 #include "hdf5_dataset_handler.h"
 
 #include <memory>
+#include <deque>
 #include <vector>
 #include <unordered_map>
 
+/**
+   Receives the buffers written by a put, before they are converted and written into their dataset.
+**/
+class HDF5WriteObserver {
+  public:
+    virtual ~HDF5WriteObserver() {}
+
+    /**
+     Called for each field written in global mode.
+     @param[in] gid group the dataset is written into
+     @param[in] tensorized_path name of the dataset in the group
+     @param[in] arrctx_indices indices of the AoS element written (empty outside AoSs)
+     **/
+    virtual void dataWritten(hid_t gid, const std::string & tensorized_path, const std::vector < int > &arrctx_indices, int datatype, int dim, const int *size, const void *data) = 0;
+};
+
 class HDF5Writer {
   private:
 
+    /* Context information shared by all the fields written at the same structure level */
+    struct WriteLevel {
+        OperationContext *opctx;
+        hid_t gid;
+        int timed_AOS_index;
+        std::vector < int > current_arrctx_indices;
+        std::vector < int > arrctx_shapes;
+        std::string tensorized_prefix;
+    };
+
     std::string backend_version;
     std::unordered_map < std::string, std::unique_ptr < HDF5DataSetHandler > > opened_data_sets;
     std::unordered_map < std::string, hid_t > existing_data_sets;
@@ -21,17 +48,21 @@ class HDF5Writer {
     
     int homogeneous_time;
     std::unordered_map < OperationContext *,  hid_t> IDS_group_id;
+    std::deque < std::string > dataset_names;   // dataset names of the interned paths, indexed by ALPath::id()
     
     int slice_mode;
+    HDF5WriteObserver *write_observer;
     
     hid_t createOrUpdateShapesDataSet(Context * ctx, hid_t loc_id, const std::string & field_tensorized_path, HDF5DataSetHandler & fieldHandler, 
-				      std::string & timebasename, int timed_AOS_index, const std::vector < int > &arrctx_indices, const std::vector < int > &arrctx_shapes);
+				      const std::string & timebasename, int timed_AOS_index, const std::vector < int > &arrctx_indices, const std::vector < int > &arrctx_shapes);
     void createOrUpdateAOSShapesDataSet(ArraystructContext * ctx, hid_t loc_id, int timedAOS_shape, const std::vector < int > &arrctx_indices, const std::vector < int > &arrctx_shapes);
     int readTimedAOSShape(Context * ctx, hid_t loc_id, const std::vector < int > &current_arrctx_indices);
     int readTimedAOSShape(hid_t loc_id, std::string &tensorized_path, const std::vector < int > &current_arrctx_indices, uri::Uri uri);
     int getDynamic_AOS_slices_extension(Context *ctx);
     int getDynamic_slices_extension(Context *ctx, int timed_AOS_index, int time_vector_length);
     ArraystructContext* getDynamicAOS(Context * ctx);
+    void getWriteLevel(Context * ctx, WriteLevel & level);
+    void write_ND_Data(Context * ctx, const WriteLevel & level, const ALPath & att_name, const ALPath & timebase_path, int datatype, int dim, int *size, void *data);
  
   public:
 
@@ -45,16 +76,22 @@ class HDF5Writer {
 
     virtual void closePulse(DataEntryContext * ctx, int mode, hid_t *file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, int files_path_strategy, std::string & files_directory, std::string & relative_file_path);
     virtual void deleteData(OperationContext * ctx, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, std::string & files_directory, std::string & relative_file_path);
-    virtual void write_ND_Data(Context * ctx, std::string & att_name, std::string & timebasename, int datatype, int dim, int *size, void *data);
+    virtual void write_ND_Data(Context * ctx, const ALPath & att_name, const ALPath & timebase_path, int datatype, int dim, int *size, void *data);
+    virtual void write_ND_Data_batch(Context * ctx, std::vector < DataBatchItem > &items);
     virtual void beginWriteArraystructAction(ArraystructContext * ctx, int *size);
 
 	void setSliceMode(int slice_mode);
+    void setWriteObserver(HDF5WriteObserver * observer);
     void write_buffers();
     void read_homogeneous_time(int* homogenenous_time, hid_t gid);
     void close_file_handler(std::string external_link_name, std::unordered_map < std::string, hid_t > &opened_IDS_files);
     void create_IDS_group(OperationContext * ctx, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, std::string & files_directory, std::string & relative_file_path, int access_mode);
     void open_IDS_group(OperationContext * ctx, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, std::string & files_directory, std::string & relative_file_path, hid_t *loc_id);
+    hid_t get_IDS_group(OperationContext * ctx);
+    void set_IDS_group(OperationContext * ctx, hid_t gid);
+    void deleteIDSFile(const std::string & dataobjectname, hid_t file_id, std::unordered_map < std::string, hid_t > &opened_IDS_files, std::string & files_directory, std::string & relative_file_path);
     void close_datasets();
+    void getMemoryUsage(ALMemoryUsage &usage);
     void close_group(OperationContext *ctx);
     void endAction(Context * ctx);
 };
@@ -0,0 +1,386 @@
+#include "ids_copy.h"
+#include "pugixml.hpp"
+
+#include <cctype>
+#include <map>
+#include <thread>
+#include <utility>
+
+
+namespace {
+
+  // events queued by the reader before it waits for the writer
+  const size_t MAX_QUEUED_BYTES = 64 << 20;
+
+  struct Dictionary
+  {
+    std::mutex mutex;
+    std::unique_ptr<pugi::xml_document> doc;
+    std::map<std::pair<std::string, bool>, std::unique_ptr<ALReadPlan>> plans;
+  };
+
+  Dictionary& dictionary()
+  {
+    static Dictionary dd;
+    return dd;
+  }
+
+  // to be called with the dictionary locked
+  pugi::xml_node dictionaryRoot(Dictionary &dd)
+  {
+    if (!dd.doc)
+      {
+	std::string path;
+	const char *env = getenv("IDSDEF_PATH");
+	if (env != NULL)
+	  path = env;
+	else if ((env = getenv("IMAS_PREFIX")) != NULL)
+	  path = std::string(env) + "/include/IDSDef.xml";
+	else
+	  throw ALLowlevelException("Cannot find the Data Dictionary: neither IDSDEF_PATH nor IMAS_PREFIX is set",LOG);
+
+	std::unique_ptr<pugi::xml_document> doc(new pugi::xml_document());
+	pugi::xml_parse_result result = doc->load_file(path.c_str());
+	if (!result)
+	  throw ALLowlevelException("Cannot load the Data Dictionary "+path+": "+result.description(),LOG);
+	dd.doc = std::move(doc);
+      }
+    return dd.doc->document_element();
+  }
+
+  // type and dimension of a leaf (INT_0D, FLT_1D, STR_0D, flt_1d_type, int_type, ...)
+  bool leafType(const std::string &type, int *datatype, int *dim)
+  {
+    if (type.size() < 3)
+      return false;
+    std::string prefix = type.substr(0, 3);
+    for (auto &c : prefix)
+      c = tolower(c);
+    if (prefix == "int")
+      *datatype = INTEGER_DATA;
+    else if (prefix == "flt")
+      *datatype = DOUBLE_DATA;
+    else if (prefix == "str")
+      *datatype = CHAR_DATA;
+    else if (prefix == "cpx")
+      *datatype = COMPLEX_DATA;
+    else
+      return false;
+    *dim = 0;
+    for (size_t i = 0; i + 1 < type.size(); i++)
+      if (isdigit(type[i]) && tolower(type[i + 1]) == 'd')
+	*dim = type[i] - '0';
+    // strings are passed as arrays of characters
+    if (*datatype == CHAR_DATA)
+      (*dim)++;
+    return true;
+  }
+
+  // timebase passed by the high level interfaces: the IDS time for homogeneous IDSs
+  std::string timebaseOf(const pugi::xml_node &node, bool homogeneous)
+  {
+    std::string timebase = node.attribute("timebasepath").value();
+    if (homogeneous && !timebase.empty())
+      return "/time";
+    return timebase;
+  }
+
+  void addNodes(ALReadPlan &plan, const pugi::xml_node &node, const std::string &prefix, bool homogeneous)
+  {
+    for (const auto &child : node.children("field"))
+      {
+	std::string name = prefix + child.attribute("name").value();
+	std::string type = child.attribute("data_type").value();
+	int datatype, dim;
+	if (type == "structure")
+	  addNodes(plan, child, name + "/", homogeneous);
+	else if (type == "struct_array")
+	  addNodes(*plan.addAoS(name, timebaseOf(child, homogeneous)), child, "", homogeneous);
+	else if (leafType(type, &datatype, &dim))
+	  plan.addField(name, timebaseOf(child, homogeneous), datatype, dim);
+      }
+  }
+
+  ArraystructContext* newArraystructContext(Context *parent, const std::string &path, const std::string &tb)
+  {
+    if (parent->getType() == CTX_ARRAYSTRUCT_TYPE)
+      return new ArraystructContext(static_cast<ArraystructContext *>(parent), path, tb);
+    return new ArraystructContext(static_cast<OperationContext *>(parent), path, tb);
+  }
+
+}
+
+
+std::vector<std::string> ALDataDictionary::idsNames()
+{
+  Dictionary &dd = dictionary();
+  std::lock_guard<std::mutex> guard(dd.mutex);
+  std::vector<std::string> names;
+  for (const auto &ids : dictionaryRoot(dd).children("IDS"))
+    names.push_back(ids.attribute("name").value());
+  return names;
+}
+
+const ALReadPlan& ALDataDictionary::plan(const std::string &idsname, bool homogeneous)
+{
+  Dictionary &dd = dictionary();
+  std::lock_guard<std::mutex> guard(dd.mutex);
+  std::unique_ptr<ALReadPlan> &plan = dd.plans[std::make_pair(idsname, homogeneous)];
+  if (!plan)
+    {
+      pugi::xml_node ids = dictionaryRoot(dd).find_child_by_attribute("IDS", "name", idsname.c_str());
+      if (!ids)
+	{
+	  dd.plans.erase(std::make_pair(idsname, homogeneous));
+	  throw ALLowlevelException("IDS "+idsname+" is not in the Data Dictionary",LOG);
+	}
+      plan.reset(new ALReadPlan());
+      addNodes(*plan, ids, "", homogeneous);
+    }
+  return *plan;
+}
+
+
+IDSCopy::IDSCopy(Backend *srcB, DataEntryContext *srcC, Backend *dstB, DataEntryContext *dstC, int flags)
+  : src(srcB), srcCtx(srcC), dst(dstB), dstCtx(dstC),
+    pipelined(!(flags & COPY_SEQUENTIAL) && srcB != dstB)
+{
+}
+
+bool IDSCopy::copy(const std::string &dataobjectname)
+{
+  // unknown IDSs are reported even when they are absent from the source
+  std::string idsname = dataobjectname.substr(0, dataobjectname.find('/'));
+  const ALReadPlan *plan = &ALDataDictionary::plan(idsname, false);
+
+  OperationContext in(srcCtx, dataobjectname, "", alconst::read_op);
+  src->beginAction(&in);
+
+  // homogeneous_time is always set in a non empty IDS, it selects the timebases
+  int homogeneous = -1;
+  try {
+    void *data = NULL;
+    int datatype = INTEGER_DATA, dim = 0, size[MAXDIM] = {0};
+    if (src->readData(&in, "ids_properties/homogeneous_time", "", &data, &datatype, &dim, size) &&
+	data != NULL && datatype == INTEGER_DATA && dim == 0)
+      homogeneous = *(int *)data;
+    ALAllocator::release(data);
+  }
+  catch (...) {
+    src->endAction(&in);
+    throw;
+  }
+  if (homogeneous < 0 || homogeneous > 2)
+    {
+      src->endAction(&in);
+      return false;
+    }
+  if (homogeneous == 1)
+    plan = &ALDataDictionary::plan(idsname, true);
+
+  aborted = false;
+  std::exception_ptr readError;
+  auto produce = [&]() {
+    try {
+      read(&in, *plan);
+      src->endAction(&in);
+    }
+    catch (const Aborted &) {
+      try { src->endAction(&in); } catch (...) {}
+    }
+    catch (...) {
+      readError = std::current_exception();
+      try { src->endAction(&in); } catch (...) {}
+    }
+    Event done;
+    done.kind = Event::DONE;
+    done.data = NULL;
+    std::lock_guard<std::mutex> guard(mutex);
+    events.push_back(std::move(done));
+    cv.notify_all();
+  };
+
+  std::thread reader;
+  if (pipelined)
+    reader = std::thread(produce);
+  else
+    produce();
+
+  OperationContext out(dstCtx, dataobjectname, "", alconst::write_op);
+  try {
+    // the previous content of the destination IDS is replaced, as with a put
+    {
+      OperationContext erase(dstCtx, dataobjectname, "", alconst::write_op);
+      dst->beginAction(&erase);
+      try {
+	dst->deleteData(&erase, "");
+      }
+      catch (...) {
+	try { dst->endAction(&erase); } catch (...) {}
+	throw;
+      }
+      dst->endAction(&erase);
+    }
+    dst->beginAction(&out);
+    try {
+      write(&out);
+    }
+    catch (...) {
+      try { dst->endAction(&out); } catch (...) {}
+      throw;
+    }
+    dst->endAction(&out);
+  }
+  catch (...) {
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      aborted = true;
+    }
+    cv.notify_all();
+    if (reader.joinable())
+      reader.join();
+    discard();
+    throw;
+  }
+  if (reader.joinable())
+    reader.join();
+  if (readError)
+    std::rethrow_exception(readError);
+  return true;
+}
+
+void IDSCopy::read(Context *ctx, const ALReadPlan &plan)
+{
+  for (const auto &f : plan.fields)
+    {
+      Event e;
+      e.kind = Event::WRITE;
+      e.path = f.field;
+      e.timebase = f.timebase;
+      e.datatype = f.datatype;
+      e.dim = f.dim;
+      e.data = NULL;
+      int found = src->readData(ctx, f.field, f.timebase, &e.data, &e.datatype, &e.dim, e.size);
+      if (found && e.data != NULL)
+	push(std::move(e));
+      else
+	ALAllocator::release(e.data);
+    }
+
+  for (const auto &a : plan.aos)
+    {
+      std::unique_ptr<ArraystructContext> actx(newArraystructContext(ctx, a.path, a.timebase));
+      int size = 0;
+      src->beginArraystructAction(actx.get(), &size);
+      try {
+	if (size > 0)
+	  {
+	    Event begin;
+	    begin.kind = Event::BEGIN_ARRAYSTRUCT;
+	    begin.path = a.path;
+	    begin.timebase = a.timebase;
+	    begin.dim = size;
+	    begin.data = NULL;
+	    push(std::move(begin));
+	    for (int i = 0; i < size; i++)
+	      {
+		read(actx.get(), *a.element);
+		Event next;
+		next.kind = Event::NEXT;
+		next.data = NULL;
+		push(std::move(next));
+		actx->nextIndex(1);
+	      }
+	    Event end;
+	    end.kind = Event::END;
+	    end.data = NULL;
+	    push(std::move(end));
+	  }
+      }
+      catch (...) {
+	try { src->endAction(actx.get()); } catch (...) {}
+	throw;
+      }
+      src->endAction(actx.get());
+    }
+}
+
+void IDSCopy::push(Event &&event)
+{
+  size_t bytes = (event.kind == Event::WRITE) ? Backend::getDataByteSize(event.datatype, event.dim, event.size) : 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  if (pipelined)
+    cv.wait(lock, [this]() { return aborted || queuedBytes < MAX_QUEUED_BYTES; });
+  if (aborted)
+    {
+      ALAllocator::release(event.data);
+      throw Aborted();
+    }
+  queuedBytes += bytes;
+  events.push_back(std::move(event));
+  cv.notify_all();
+}
+
+IDSCopy::Event IDSCopy::pop()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [this]() { return !events.empty(); });
+  Event event = std::move(events.front());
+  events.pop_front();
+  if (event.kind == Event::WRITE)
+    queuedBytes -= Backend::getDataByteSize(event.datatype, event.dim, event.size);
+  cv.notify_all();
+  return event;
+}
+
+void IDSCopy::discard()
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  for (auto &e : events)
+    ALAllocator::release(e.data);
+  events.clear();
+  queuedBytes = 0;
+}
+
+void IDSCopy::write(OperationContext *op)
+{
+  std::vector<std::unique_ptr<ArraystructContext>> contexts;
+  Context *current = op;
+  try {
+    while (true)
+      {
+	Event e = pop();
+	switch (e.kind)
+	  {
+	  case Event::WRITE:
+	    {
+	      std::unique_ptr<void, ALStagedNode::FreeDeleter> data(e.data);
+	      dst->writeData(current, e.path, e.timebase, e.data, e.datatype, e.dim, e.size);
+	      break;
+	    }
+	  case Event::BEGIN_ARRAYSTRUCT:
+	    contexts.emplace_back(newArraystructContext(current, e.path, e.timebase));
+	    current = contexts.back().get();
+	    dst->beginArraystructAction(contexts.back().get(), &e.dim);
+	    break;
+	  case Event::NEXT:
+	    contexts.back()->nextIndex(1);
+	    break;
+	  case Event::END:
+	    dst->endAction(current);
+	    contexts.pop_back();
+	    current = contexts.empty() ? static_cast<Context *>(op) : contexts.back().get();
+	    break;
+	  case Event::DONE:
+	    return;
+	  }
+      }
+  }
+  catch (...) {
+    for (auto it = contexts.rbegin(); it != contexts.rend(); ++it)
+      {
+	try { dst->endAction(it->get()); } catch (...) {}
+      }
+    throw;
+  }
+}
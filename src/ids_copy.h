@@ -0,0 +1,113 @@
+//-*-c++-*-
+
+#ifndef IDS_COPY_H
+#define IDS_COPY_H 1
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "al_backend.h"
+#include "async_backend.h"
+
+#if defined(_WIN32)
+#  define IMAS_CORE_LIBRARY_API __declspec(dllexport)
+#else
+#  define IMAS_CORE_LIBRARY_API
+#endif
+
+#ifdef __cplusplus
+
+/**
+   Description of the IDSs, loaded from the Data Dictionary (IDSDef.xml) found at $IDSDEF_PATH
+   or $IMAS_PREFIX/include/IDSDef.xml. The file is loaded once per process, at first use.
+*/
+class IMAS_CORE_LIBRARY_API ALDataDictionary
+{
+public:
+  /**
+     Returns the names of the IDSs of the Data Dictionary.
+     @throw ALLowlevelException if the Data Dictionary cannot be loaded
+  */
+  static std::vector<std::string> idsNames();
+
+  /**
+     Returns the reads of a whole IDS get: every leaf field and array of structures of the IDS,
+     with the paths, timebases, types and dimensions passed to the backends by the high level
+     interfaces.
+     @param[in] idsname name of the IDS
+     @param[in] homogeneous homogeneous_time of the IDS (dynamic fields then use the IDS time)
+     @result plan, owned by the dictionary
+     @throw ALLowlevelException if the Data Dictionary cannot be loaded or the IDS is unknown
+  */
+  static const ALReadPlan& plan(const std::string &idsname, bool homogeneous);
+};
+
+
+/**
+   Copy of one IDS occurrence from a data entry to another, at the Backend level.
+   The source IDS is walked following ALDataDictionary::plan() and every field found is written
+   to the destination as returned by the source backend (no type conversion). Reading and writing
+   are pipelined: the source is read on a separate thread while the calling thread writes.
+*/
+class IMAS_CORE_LIBRARY_API IDSCopy
+{
+public:
+  /**
+     @param[in] srcB backend of the source data entry
+     @param[in] srcCtx source data entry context
+     @param[in] dstB backend of the destination data entry
+     @param[in] dstCtx destination data entry context
+     @param[in] flags COPY_DEFAULT or COPY_SEQUENTIAL
+  */
+  IDSCopy(Backend *srcB, DataEntryContext *srcCtx, Backend *dstB, DataEntryContext *dstCtx, int flags);
+
+  /**
+     Copies an IDS occurrence.
+     @param[in] dataobjectname name of the IDS, with its occurrence ("<idsname>[/<occurrence>]")
+     @result false when the IDS is empty in the source (nothing is written)
+     @throw ALBackendException, ALLowlevelException
+  */
+  bool copy(const std::string &dataobjectname);
+
+private:
+  // one call to replay on the destination, data is malloc'd and owned by the event
+  struct Event
+  {
+    enum Kind { WRITE, BEGIN_ARRAYSTRUCT, NEXT, END, DONE };
+    Kind kind;
+    ALPath path;
+    ALPath timebase;
+    int datatype;
+    int dim;
+    int size[MAXDIM];
+    void *data;
+  };
+
+  struct Aborted {};
+
+  void read(Context *ctx, const ALReadPlan &plan);
+  void push(Event &&event);
+  Event pop();
+  void write(OperationContext *op);
+  void discard();
+
+  Backend *src;
+  DataEntryContext *srcCtx;
+  Backend *dst;
+  DataEntryContext *dstCtx;
+  bool pipelined;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Event> events;
+  size_t queuedBytes = 0;
+  bool aborted = false;                         /**< writer failed, the reader stops */
+};
+
+#endif
+
+#endif
@@ -1114,7 +1114,7 @@ static char *getPathInfo(MDSplus::Data *data, MDSplus::TreeNode *refNode)
 	  for(retIdx = 0; retIdx < numTimes - 1; retIdx++)
 	      if(times[retIdx] <= time && times[retIdx + 1] >= time)
 	          break;
-          free(times);
+          ALAllocator::release(times);
 	  return retIdx;
         }catch(MDSplus::MdsException& exc)
 	{
@@ -1249,7 +1249,7 @@ static char *getPathInfo(MDSplus::Data *data, MDSplus::TreeNode *refNode)
 //	nDim = (segIdx < numSegments - 1)?segDims[segNDims - 1]:nextRow;
 	memcpy(retTimes, &times[prevSlices], sizeof(double)* nDim);
 	if(!timebaseCached) 
-	    free(times);
+	    ALAllocator::release(times);
 	else
 	    delete[] times;
 	return retTimes;
@@ -1334,7 +1334,7 @@ static char *getPathInfo(MDSplus::Data *data, MDSplus::TreeNode *refNode)
 	default: throw ALBackendException("Unexpected Data type in disassembleData",LOG);
 	}
 	
-	//Everything outside the backend has to be freed with free() 
+	//Everything outside the backend is allocated with ALAllocator 
 	
 	//Old AL COmpatibility: invert dimensions
 	//memcpy(retDims, dims, nDims * sizeof(int));
@@ -1347,7 +1347,7 @@ static char *getPathInfo(MDSplus::Data *data, MDSplus::TreeNode *refNode)
 	*retNumDims = nDims;
 	if(nDims == 0)
 	{
-	    *retDataPtr = malloc(length);
+	    *retDataPtr = ALAllocator::allocate(length);
 	    memcpy(*retDataPtr, dataPtr, length);
 	    retDims[0] = 1;
 	    // For string, store the length
@@ -1358,7 +1358,7 @@ static char *getPathInfo(MDSplus::Data *data, MDSplus::TreeNode *refNode)
 	    int nItems = 1;
 	    for(int i = 0; i < nDims; i++)
 		nItems *= (retDims)[i];
-	    *retDataPtr = malloc(length * nItems);
+	    *retDataPtr = ALAllocator::allocate(length * nItems);
 	    memcpy(*retDataPtr, dataPtr, length * nItems);
 	}
     }
@@ -1828,7 +1828,7 @@ void MDSplusBackend::resetIdsPath(std::string strTree) {
 	int segInfoDims[64];
 	char segNDims, segType;
 	firstSegment->getInfo(&clazz, &dtype, &length, &nDims, &segDims, &ptr);
-	//Only free() is used outside)
+	//Only ALAllocator::release() is used outside)
 	int numSlices = segDims[0];
 	int  nextRow;
 	int actSlices; //keep into account the fact that the last segment may be not yet filled
@@ -1858,7 +1858,7 @@ void MDSplusBackend::resetIdsPath(std::string strTree) {
 //	for(int i = 0; i < nDims-1; i++)  //The last dimension represents the time dimension
 	  sliceSize *= segDims[i];  
 	sliceSize *= length;   //slice size in bytes
-	char *currDataPtr = (char *)malloc((long)numSlices * (long)sliceSize);
+	char *currDataPtr = (char *)ALAllocator::allocate((long)numSlices * (long)sliceSize);
 	*dataPtr = currDataPtr;
 	delete[] segDims;
 	for(int i = 0; i < numSegments; i++)
@@ -2472,7 +2472,7 @@ void MDSplusBackend::resetIdsPath(std::string strTree) {
 //		for(int i = 0; i < nDims - 1; i++)
 		for(int i = 1; i < nDims; i++)
 		    rowSize *= ddims[i];
-		*data = malloc(rowSize);
+		*data = ALAllocator::allocate(rowSize);
 		memcpy(*data, ((char *)dataPtr)+(idxInSegment * rowSize), rowSize);
 
 		switch(dtype)  {
@@ -2499,7 +2499,7 @@ void MDSplusBackend::resetIdsPath(std::string strTree) {
 	      	    case DTYPE_B:
 	            case DTYPE_BU:  
 		    currData = sliceData->getByteArray(&nSamples);
-		    *data = malloc(nSamples);
+		    *data = ALAllocator::allocate(nSamples);
 		    memcpy(*data, currData, nSamples);
 		    delete [] currData;
 		    *datatype = alconst::char_data;
@@ -2508,13 +2508,13 @@ void MDSplusBackend::resetIdsPath(std::string strTree) {
 		    if(dimct == 1)//Scalar slice
 		    {
 		  	nSamples = 1;
-		  	*data = malloc(sizeof(int));;
+		  	*data = ALAllocator::allocate(sizeof(int));;
 		  	*((int *)*data) = sliceData->getInt();
 		    }
 		    else
 		    {
 		        currData = (char *)sliceData->getIntArray(&nSamples);
-		  	*data = malloc(nSamples * sizeof(int));
+		  	*data = ALAllocator::allocate(nSamples * sizeof(int));
 		  	memcpy(*data, currData, nSamples * sizeof(int));
 		  	delete [] currData;
 		    }
@@ -2525,13 +2525,13 @@ void MDSplusBackend::resetIdsPath(std::string strTree) {
 		    if(dimct == 1)//Scalar slice
 		    {
 		  	nSamples = 1;
-		  	*data = malloc(sizeof(double));
+		  	*data = ALAllocator::allocate(sizeof(double));
 		  	*((double *)*data) = sliceData->getDouble();
 		    }
 		    else
 		    {
 		  	currData = (char *)sliceData->getDoubleArray(&nSamples);
-		  	*data = malloc(nSamples * sizeof(double));
+		  	*data = ALAllocator::allocate(nSamples * sizeof(double));
 		  	memcpy(*data, currData, nSamples * sizeof(double));
 		  	delete [] currData;
 		    }
@@ -2542,14 +2542,14 @@ void MDSplusBackend::resetIdsPath(std::string strTree) {
 		    {
 		  	nSamples = 1;
 		  	std::complex<double> complexData = sliceData->getComplex();
-		  	*data = malloc(2*sizeof(double));
+		  	*data = ALAllocator::allocate(2*sizeof(double));
 		  	((double *)(*data))[0] = complexData.real();
 		  	((double *)(*data))[1] = complexData.imag();
 		    }
 		    else
 		    {
 		  	std::complex<double> *complexData = sliceData->getComplexArray(&nSamples);
-		  	*data = malloc(2 * nSamples*sizeof(double));
+		  	*data = ALAllocator::allocate(2 * nSamples*sizeof(double));
 		  	for(int i = 0; i < nSamples; i++)
 		  	{
 		    	    ((double *)(*data))[2*i] = complexData[i].real();
@@ -3403,7 +3403,7 @@ std::cout<<"FINSCE INFLATE" << std::endl;
 			    }
 			}
 	    	    }
-	    	    free((char *)timebase);
+	    	    ALAllocator::release((char *)timebase);
 	    	    MDSplus::Apd *retApd = getApdSliceAt(inNode, sliceIdx);
  	    	    return retApd;
 		}
@@ -3423,7 +3423,7 @@ std::cout<<"FINSCE INFLATE" << std::endl;
 				break;
 			}
 	    	    }
-	    	    free((char *)timebase);
+	    	    ALAllocator::release((char *)timebase);
 	    	    MDSplus::Apd *retApd = getApdSliceAt(inNode, sliceIdx);
  	    	    return retApd;
 		}
@@ -3450,7 +3450,7 @@ std::cout<<"FINSCE INFLATE" << std::endl;
 	    	    }
 		    if(sliceIdx == sliceIdx1)
 		    {
-	    	    	free((char *)timebase);
+	    	    	ALAllocator::release((char *)timebase);
 	    	    	MDSplus::Apd *retApd = getApdSliceAt(inNode, sliceIdx);
  	    	    	return retApd;
 		    }
@@ -3463,7 +3463,7 @@ std::cout<<"FINSCE INFLATE" << std::endl;
 			//if(checkStruct(apd, apd1)) //Gabriele June 2022: let check be performed during interpolation itself
 			{
    			    MDSplus::Apd *retApd = MDSplusBackend::interpolateStruct(apd, apd1, time, timebase[sliceIdx], timebase[sliceIdx1], currPath, ctx);
-	    	    	    free((char *)timebase);
+	    	    	    ALAllocator::release((char *)timebase);
 			    MDSplus::deleteData(apd);
 			    MDSplus::deleteData(apd1);
 		    	    return retApd; //Already an array of structures
@@ -4545,8 +4545,8 @@ std::string MDSplusBackend::getTimedNode(ArraystructContext *ctx, std::string fu
 
 
   void MDSplusBackend::writeData(OperationContext *ctx,
-			 std::string fieldname,
-			 std::string timebase, 
+			 ALPath fieldname,
+			 ALPath timebase,
 			 void* data,
 			 int datatype,
 			 int dim,
@@ -4575,8 +4575,8 @@ std::string MDSplusBackend::getTimedNode(ArraystructContext *ctx, std::string fu
     
    
    int MDSplusBackend::readData(OperationContext *ctx,
-			std::string fieldname,
-			std::string timebase,
+			ALPath fieldname,
+			ALPath timebase,
 			void** data,
 			int* datatype,
 			int* dim,
@@ -4659,6 +4659,11 @@ std::string MDSplusBackend::getTimedNode(ArraystructContext *ctx, std::string fu
 				    int* size)
   {
     MDSplus::Apd *currApd;
+    if(!ctx->getOperationContext()->isProjected(ctx->getFullPath(), true)) //Outside of the projection: the Apd is not read nor decoded
+    {
+	*size = 0;
+	return;
+    }
     if(ctx->getParent()) //We are going to start reading a nested array of structures
     {
 	MDSplus::Apd *parentApd = getApdFromContext(ctx->getParent());
@@ -4993,7 +4998,7 @@ void MDSplusBackend::get_occurrences(Context* ctx, const char* ids_name, int** o
 		      int dims[64];
     		      readTimedData((MDSplus::TreeNode *)currDescr, &dataPtr, &datatype, &numDims, (int *)dims);
     		      MDSplus::Data *currData = assembleData(dataPtr, datatype, numDims, dims);
-		      free(dataPtr);
+		      ALAllocator::release(dataPtr);
 
 		      retApd->appendDesc(currData);
 		  }catch(MDSplus::MdsException &exc){std::cout << exc.what() << std::endl;}
@@ -5057,7 +5062,7 @@ void MDSplusBackend::get_occurrences(Context* ctx, const char* ids_name, int** o
 		      throw ALBackendException("Internal error: expected valid slice in resolveApdSliceFields",LOG);
 
 		  MDSplus::Data *currData = assembleData(data, datatype, numDims, dims);
-		  free((char *)data);
+		  ALAllocator::release((char *)data);
 		  currData->incRefCount();
 		  retApd->appendDesc(currData);
 	      }
@@ -5101,7 +5106,7 @@ void MDSplusBackend::get_occurrences(Context* ctx, const char* ids_name, int** o
 	      int dims[64];
     	      readTimedData((MDSplus::TreeNode *)currDescr, &dataPtr, &datatype, &numDims, (int *)dims);
     	      MDSplus::Data *currData = assembleData(dataPtr, datatype, numDims, dims);
-	      free(dataPtr);
+	      ALAllocator::release(dataPtr);
 	      MDSplus::Data **dscs = apd->getDscArray();
 	      MDSplus::deleteData(dscs[1]);
 	      dscs[1] = currData;	
@@ -5120,7 +5125,7 @@ void MDSplusBackend::get_occurrences(Context* ctx, const char* ids_name, int** o
 		      throw ALBackendException("Internal error: expected valid slice in resolveApdField",LOG);
 
 	  MDSplus::Data *currData = assembleData(data, datatype, numDims, dims);
-	  free((char *)data);
+	  ALAllocator::release((char *)data);
 	  MDSplus::Data **dscs = apd->getDscArray();
 	  MDSplus::deleteData(dscs[1]);
 	  dscs[1] = currData;	
@@ -158,15 +158,15 @@ class IMAS_CORE_LIBRARY_API MDSplusBackend:public Backend
     void endAction(Context *ctx) override;
 
     virtual void writeData(OperationContext *ctx,
-			   std::string fieldname,
-			   std::string timebase,
+			   ALPath fieldname,
+			   ALPath timebase,
 			   void* data,
 			   int datatype,
 			   int dim,
 			   int* size);
     void writeData(Context *ctx,
-			   std::string fieldname,
-			   std::string timebase,
+			   ALPath fieldname,
+			   ALPath timebase,
 			   void* data,
 			   int datatype,
 			   int dim,
@@ -180,13 +180,15 @@ class IMAS_CORE_LIBRARY_API MDSplusBackend:public Backend
     }
     
     int readData(Context *ctx,
-			  std::string fieldname,
-			  std::string timebase,
+			  ALPath fieldname,
+			  ALPath timebase,
 			  void** data,
 			  int* datatype,
 			  int* dim,
 			  int* size) override
     {
+	if(!ctx->isProjected(fieldname.str(), false))  //Outside of the projection of a partial get
+	  return 0;
 	if(ctx->getType() == CTX_ARRAYSTRUCT_TYPE)
 	  return getFromArraystruct((ArraystructContext *)ctx, fieldname,
 			     ((ArraystructContext *)ctx)->getIndex(), data, datatype, dim, size);
@@ -195,8 +197,8 @@ class IMAS_CORE_LIBRARY_API MDSplusBackend:public Backend
     }
 
     virtual int readData(OperationContext *ctx,
-			std::string fieldname,
-			std::string timebase,
+			ALPath fieldname,
+			ALPath timebase,
 			void** data,
 			int* datatype,
 			int* dim,
@@ -1,12 +1,103 @@
 #include "memory_backend.h"
 
+#include <algorithm>
+#include <new>
+
 #define MAX_DIM 64
+//Buffers smaller than this are not deduplicated
+#define DEDUP_MIN_BYTES 64
+
+std::unordered_map<std::string, InternalCtx * > MemoryBackend::ctxMap;
+std::mutex MemoryBackend::ctxMapMutex;
+
+// data stored by all the memory data entries
+static ALMemoryUsage::Counter liveBytes("memory");
+
+// tree nodes of all the IDSs (pools of ALNodePool)
+static ALMemoryUsage::Counter liveTreeBytes("memory_tree");
+
+// IDS locks held by the calls in progress in the thread, exclusive or not
+static thread_local std::vector<std::pair<std::shared_mutex *, bool>> heldIdsLocks;
+
+    void *ALNodePool::Upstream::do_allocate(size_t bytes, size_t alignment)
+    {
+	void *p = ::operator new(bytes, std::align_val_t(alignment));
+	this->bytes += bytes;
+	liveTreeBytes.add(bytes);
+	return p;
+    }
 
+    void ALNodePool::Upstream::do_deallocate(void *p, size_t bytes, size_t alignment)
+    {
+	::operator delete(p, bytes, std::align_val_t(alignment));
+	this->bytes -= bytes;
+	liveTreeBytes.sub(bytes);
+    }
+
+    void *ALNodePool::do_allocate(size_t bytes, size_t alignment)
+    {
+	if(bytes > MAX_NODE_BYTES || alignment > NODE_ALIGN)
+	    return upstream.allocate(bytes, alignment);
+	size_t sizeClass = (bytes == 0) ? 0 : (bytes - 1) / NODE_ALIGN;
+	std::lock_guard<std::mutex> guard(mutex);
+	void *p = freeLists[sizeClass];
+	if(p == NULL)
+	    return arena.allocate((sizeClass + 1) * NODE_ALIGN, NODE_ALIGN);
+	freeLists[sizeClass] = *(void **)p;
+	return p;
+    }
+
+    void ALNodePool::do_deallocate(void *p, size_t bytes, size_t alignment)
+    {
+	if(bytes > MAX_NODE_BYTES || alignment > NODE_ALIGN)
+	{
+	    upstream.deallocate(p, bytes, alignment);
+	    return;
+	}
+	size_t sizeClass = (bytes == 0) ? 0 : (bytes - 1) / NODE_ALIGN;
+	std::lock_guard<std::mutex> guard(mutex);
+	*(void **)p = freeLists[sizeClass];
+	freeLists[sizeClass] = p;
+    }
+
+    IdsLockGuard::IdsLockGuard(std::shared_mutex *idsLock, bool exclusive)
+    {
+	this->exclusive = exclusive;
+	this->idsLock = NULL;
+	for(auto &held: heldIdsLocks)
+	{
+	    if(held.first == idsLock)
+	    {
+		if(exclusive && !held.second)
+		    throw ALBackendException("Internal error: IDS written by a call nested in a read of the same IDS",LOG);
+		return;
+	    }
+	}
+	if(exclusive)
+	    idsLock->lock();
+	else
+	    idsLock->lock_shared();
+	heldIdsLocks.push_back({idsLock, exclusive});
+	this->idsLock = idsLock;
+    }
+
+    IdsLockGuard::~IdsLockGuard()
+    {
+	if(idsLock == NULL)
+	    return;
+	//Guards are nested, the last lock taken by the thread is this one
+	heldIdsLocks.pop_back();
+	if(exclusive)
+	    idsLock->unlock();
+	else
+	    idsLock->unlock_shared();
+    }
 
 
 
     void ALAoS::addSlice(ALAoS &sliceAos, ArraystructContext *ctx)
     {
+	invalidateTimes();
 //	if(ctx->getTimebasePath().length() > 0)
 	if(timebase != "")
 	{
@@ -16,8 +107,9 @@
 	    	return;
 	    }
 */
-	    for(size_t i = 0; i < sliceAos.aos.size(); i++)
-	    	aos.push_back(sliceAos.aos[i]->clone());
+	    //The elements of the slice are moved, not copied
+	    aos.insert(aos.end(), sliceAos.aos.begin(), sliceAos.aos.end());
+	    sliceAos.aos.clear();
 
 	    //aos.push_back(sliceAos.aos[0]->clone());
 	}
@@ -25,8 +117,8 @@
 	{
 	    if(aos.size() == 0) //First time a slice is added
 	    {
-		for(size_t i = 0; i < sliceAos.aos.size(); i++)
-		    aos.push_back(sliceAos.aos[i]->clone());
+		aos.insert(aos.end(), sliceAos.aos.begin(), sliceAos.aos.end());
+		sliceAos.aos.clear();
 	    }
 	    else
 	    {
@@ -49,7 +141,7 @@
 			std::cout << "INTERNAL ERROR IN MEMORY BACKEND: addSlice for an AoS with non consistent static AoS" << std::endl;
 			return;
 		    }
-		    aos[i]->addSlice(*sliceAos.aos[i], ctx);
+		    getElement(i)->addSlice(*sliceAos.aos[i], ctx);
 		}
 
 	    }
@@ -99,8 +191,8 @@
      @throw BackendException
   */
     void MemoryBackend::writeData(OperationContext *ctx,
-			 std::string fieldname,
-			 std::string timebasename, 
+			 ALPath fieldname,
+			 ALPath timebasename, 
 			 void* data,
 			 int datatype,
 			 int dim,
@@ -113,13 +205,12 @@ else if (datatype == INTEGER_DATA || datatype == COMPLEX_DATA)
 else
     std::cout << "WRITE DATA IDS:" << ctx->getDataobjectName() << "   FIELD: " << fieldname << (char *)data << std::endl;
 */	
-      internalCtx->lock();
-      try  {
-
+	IdsLockGuard guard(getIdsLock(ctx), true);
 	ALStruct *ids = getIds(ctx);
 	ALData *alData = ids->getData(fieldname);
+	ALDedupTable *dedupTable = getDedupTable(ctx);
 	if(ctx->getRangemode() == GLOBAL_OP)
-	    alData->writeData(datatype, dim, size, (unsigned char *)data, timebasename);
+	    putData(alData, datatype, dim, size, data, timebasename, dedupTable);
 	else
         {
 	    //alData->addSlice(datatype, dim, size, (unsigned char *)data); Gabriele May 2020: more than one slice can be written
@@ -141,13 +232,6 @@ else
 	    	alData->addSlice(datatype, dim, currDims, ((unsigned char *)data)+(i * sliceSize));
 	    delete[] currDims;
 	}
-      } 
-      catch(...)
-      {
-	internalCtx->unlock();
-	throw;
-      }
-      internalCtx->unlock();
     }
    /**
      Reads data.
@@ -166,22 +250,18 @@ else
      @throw BackendException
   */
   int MemoryBackend::readData(OperationContext *ctx,
-			std::string fieldname,
-			std::string timebase,
+			ALPath fieldname,
+			ALPath timebase,
 			void** data,
 			int* datatype,
 			int* dim,
 			int* size)
   {
-    internalCtx->lock();  
-    try {
+	IdsLockGuard guard(getIdsLock(ctx), false);
 	ALStruct *ids = getIds(ctx);
-	ALData *alData = ids->getData(fieldname);
-	if(alData->isEmpty())
-	{
-	    internalCtx->unlock();
+	ALData *alData = ids->findData(fieldname);
+	if(alData == NULL || alData->isEmpty())
 	    return 0;
-	}
 
 
 	int status = 1;
@@ -222,10 +302,23 @@ else
 	    int timeNumDims;
 	    int timeDims[16];
 	    if(timebase.length() == 0)  //handle empty time and /time
+		return alData->readData(data, datatype, dim, size);  //Not time dependent
+	    //The time vector is kept by the timebase field until it is written again, instead of being read for each slice
+	    ALData *timeField = ids->findData((timebase[0] == '/') ? timebase.substr(1) : timebase);
+	    if(timeField == NULL)
+		return 0;
+	    if(timeField->getMapState() == ALData::MAPPING::MAPPED)
 	    {
-		int status = alData->readData(data, datatype, dim, size);  //Not time dependent
-		internalCtx->unlock();
-                return status; 
+		if(!timeField->readShape(&timeDatatype, &timeNumDims, timeDims))
+		    return 0;
+		if(timeDatatype != alconst::double_data || timeNumDims != 1)
+		{
+		    std::cout << "INTERNAL ERROR: Inconsistent timebase information " << ctx->getDataobjectName() << "  " << timebase << std::endl;
+		    throw  ALBackendException("Internal error: Inconsistent timebase information",LOG);
+		}
+		const std::vector<double> &times = timeField->getTimes();
+		alData->readTimeSlice(times.data(), times.size(), ctx->getTime(), data, datatype, dim, size, ctx->getInterpmode());
+		return status;
 	    }
 	    else
 	    {
@@ -235,10 +328,7 @@ else
     	    	    status = readData(&newCtx, timebase, timebase, (void **)&timeData, &timeDatatype, &timeNumDims, timeDims);
 	    }
 	    if(!status)
-	    {
-		internalCtx->unlock();
 		return 0;
-	    }
 	    //Check timebase consistency
 	    if(timeDatatype != alconst::double_data || timeNumDims != 1)
 	    {
@@ -246,7 +336,7 @@ else
 		throw  ALBackendException("Internal error: Inconsistent timebase information",LOG);
 	    }
 	    alData->readTimeSlice(timeData, timeDims[0], ctx->getTime(), data, datatype, dim, size, ctx->getInterpmode());
-	    free((char *)timeData);
+	    ALAllocator::release((char *)timeData);
 	}
 /* if(*datatype == DOUBLE_DATA)
     std::cout << "READ DATA IDS:" << ctx->getDataobjectName() << "   FIELD: " << fieldname << **(double **)data << std::endl;
@@ -255,14 +345,112 @@ else if (*datatype == INTEGER_DATA || *datatype == COMPLEX_DATA)
 else
     std::cout << "READ DATA IDS:" << ctx->getDataobjectName() << "   FIELD: " << fieldname << *(char **)data << std::endl;
 */
-	internalCtx->unlock();
         return status;
-    }
-    catch(...)
-    {
-	internalCtx->unlock();
-	throw;
-    }
+  }
+  /**
+     Reads data into a caller provided buffer.
+     For global operations on fields already mapped in memory, the stored slices are copied 
+     directly into dst without any intermediate allocation. Other cases go through readData.
+  */
+  int MemoryBackend::readDataInto(Context *ctx,
+			ALPath fieldname,
+			ALPath timebase,
+			void* dst,
+			size_t capacity,
+			void** data,
+			int* datatype,
+			int* dim,
+			int* size)
+  {
+    if(ctx->getType() != CTX_OPERATION_TYPE || ((OperationContext *)ctx)->getRangemode() != GLOBAL_OP)
+	return Backend::readDataInto(ctx, fieldname, timebase, dst, capacity, data, datatype, dim, size);
+    IdsLockGuard guard(getIdsLock(ctx), false);
+	int status;
+	int expectedType = *datatype;
+	ALData *alData = getIds((OperationContext *)ctx)->findData(fieldname);
+	if(alData == NULL || alData->isEmpty())
+	    status = 0;
+	else if(alData->getMapState() != ALData::MAPPING::MAPPED)
+	    status = Backend::readDataInto(ctx, fieldname, timebase, dst, capacity, data, datatype, dim, size);
+	else
+	{
+	    status = alData->readShape(datatype, dim, size);
+	    if(*datatype == expectedType)
+		status = alData->readDataInto(dst, capacity, datatype, dim, size);
+	    else
+		status = 2;
+	    if(status == 2)
+		alData->readData(data, datatype, dim, size);
+	}
+	return status;
+  }
+
+  int MemoryBackend::readDataShape(Context *ctx,
+			ALPath fieldname,
+			ALPath timebase,
+			int* datatype,
+			int* dim,
+			int* size)
+  {
+    if(ctx->getType() != CTX_OPERATION_TYPE || ((OperationContext *)ctx)->getRangemode() != GLOBAL_OP)
+	return Backend::readDataShape(ctx, fieldname, timebase, datatype, dim, size);
+    IdsLockGuard guard(getIdsLock(ctx), false);
+	int status;
+	ALData *alData = getIds((OperationContext *)ctx)->findData(fieldname);
+	if(alData == NULL || alData->isEmpty())
+	    status = 0;
+	else if(alData->getMapState() == ALData::MAPPING::MAPPED)
+	    status = alData->readShape(datatype, dim, size);
+	else
+	    status = Backend::readDataShape(ctx, fieldname, timebase, datatype, dim, size);
+	return status;
+  }
+
+  /**
+     Writes several data in a row.
+     All the fields are inserted under a single lock of the IDS and, for global 
+     operations, the IDS is resolved only once.
+  */
+  void MemoryBackend::writeDataBatch(Context *ctx,
+			std::vector<DataBatchItem> &items)
+  {
+    IdsLockGuard guard(getIdsLock(ctx), true);
+	if(ctx->getType() == CTX_OPERATION_TYPE && ((OperationContext *)ctx)->getRangemode() == GLOBAL_OP)
+	{
+	    ALStruct *ids = getIds((OperationContext *)ctx);
+	    ALDedupTable *dedupTable = getDedupTable((OperationContext *)ctx);
+	    for(auto &item: items)
+		putData(ids->getData(item.fieldname), item.datatype, item.dim, item.size, item.data, item.timebasename, dedupTable);
+	}
+	else
+	{
+	    for(auto &item: items)
+		writeData(ctx, item.fieldname, item.timebasename, item.data, item.datatype, item.dim, item.size);
+	}
+  }
+
+  /**
+     Reads several data in a row.
+     The IDS is locked once for the whole batch and, for global operations, the 
+     IDS is resolved only once and fields already mapped are read directly.
+  */
+  void MemoryBackend::readDataBatch(Context *ctx,
+			std::vector<DataBatchItem> &items)
+  {
+    IdsLockGuard guard(getIdsLock(ctx), false);
+	ALStruct *ids = NULL;
+	if(ctx->getType() == CTX_OPERATION_TYPE && ((OperationContext *)ctx)->getRangemode() == GLOBAL_OP)
+	    ids = getIds((OperationContext *)ctx);
+	for(auto &item: items)
+	{
+	    ALData *alData = (ids) ? ids->findData(item.fieldname) : NULL;
+	    if(ids && (alData == NULL || alData->isEmpty()))
+		item.found = 0;
+	    else if(alData && alData->getMapState() == ALData::MAPPING::MAPPED)
+		item.found = alData->readData(&item.data, &item.datatype, &item.dim, item.size);
+	    else
+		item.found = readData(ctx, item.fieldname, item.timebasename, &item.data, &item.datatype, &item.dim, item.size);
+	}
   }
   /*
     Deletes data.
@@ -275,8 +463,7 @@ else
     void MemoryBackend::deleteData(OperationContext *ctx,
 			  std::string fieldname)
     {
-      internalCtx->lock();
-      try  {
+	IdsLockGuard guard(getIdsLock(ctx), true);
 	ALStruct *ids = getIds(ctx);
 	if(ctx->getType() == CTX_ARRAYSTRUCT_TYPE) //Only in this case actions are required 
         {
@@ -297,13 +484,6 @@ else
 	      alData->deleteData();
 	    }
 	}
-        internalCtx->unlock();
-      }
-      catch(...)
-      {
-	internalCtx->unlock();
-	throw;
-      }
     }
 
 
@@ -323,44 +503,39 @@ else
 	    return;
 	}
 
+	IdsLockGuard guard(getIdsLock(ctx), true);
 //If it is to topomost ArrayStructContext, prepare currentAos 
 	if(!ctx->getParent()) //If it is the topmost AoS
 	{
-	    internalCtx->lock();
-	    try {
-	    	currentAos.deleteData();
+	    currentAos.deleteData();
 	//prepare empty structure if not existing
-	    	ALStruct *ids = getIds(ctx->getOperationContext());	
-	    	ALAoS *aos = ids->getSubAoS(ctx->getPath());
-	    	if(ctx->getOperationContext()->getRangemode() == GLOBAL_OP) 
-	    	    aos->deleteData();
-
-            	if(size > (int)aos->aos.size())
+	    ALStruct *ids = getIds(ctx->getOperationContext());	
+	    ALAoS *aos = ids->getSubAoS(ctx->getPath());
+	    if(ctx->getOperationContext()->getRangemode() == GLOBAL_OP) 
+	    {
+		//Incremental put: the elements are kept and updated, what is not written again is swept at endAction
+		if(incrementalPut)
 		{
-		    int prevSize = (int)aos->aos.size();
-		    aos->aos.resize(size);
-		    for(int i = prevSize; i < size; i++)
-		   	if(!aos->aos[i]) aos->aos[i] = new ALStruct;
+		    aos->timebase = "";
+		    //Stamps are unique across the data entries writing concurrently other IDSs of the same content
+		    aos->stamp = putStamp = ++internalCtx->putStamp;
+		    aos->resize(size);
 		}
-
-		internalCtx->unlock();
+		else
+		    aos->deleteData();
 	    }
-      	    catch(...)
-      	    {
-		internalCtx->unlock();
-		throw;
-      	    }
+
+	    if(size > (int)aos->aos.size())
+		aos->resize(size);
 	}
 	else
 	{
 //Gabriele May 2021
 	  ALAoS *aos = (ctx->getOperationContext()->getRangemode() == SLICE_OP)?getAoS(ctx, true):getAoS(ctx, false);  
+	    if(incrementalPut && ctx->getOperationContext()->getRangemode() == GLOBAL_OP)
+		aos->stamp = putStamp;
 	    if(size != (int)aos->aos.size())
-	    {
-	    	aos->aos.resize(size);
-	    	for(int i = 0; i < size; i++)
-	    	    if(!aos->aos[i]) aos->aos[i] = new ALStruct;
-	    }
+	    	aos->resize(size);
 	}
 
 //No write propagated to target backend
@@ -394,30 +569,28 @@ else
 	    prepareSlice(ctx);
 	}
 */
-	internalCtx->lock();
-        try {
-	  if(ctx->getOperationContext()->getRangemode() == SLICE_OP && !ctx->getParent())
-	    {
-	    	prepareSlice(ctx);
-	    	ALAoS *aos = getAoS(ctx, true);  //Gabriele Jan 2019
-            	if(aos->timebase == "")
-	            *size = aos->aos.size();  //Static AoS
-	    	else
-		    *size = 1;
-	    }
+	IdsLockGuard guard(getIdsLock(ctx), false);
+	if(ctx->getOperationContext()->getRangemode() == SLICE_OP && !ctx->getParent())
+	{
+	    prepareSlice(ctx);
+	    ALAoS *aos = &currentAos;  //Gabriele Jan 2019
+            if(aos->timebase == "")
+	        *size = aos->aos.size();  //Static AoS
 	    else
-	    {
-    //Get the  AoS referred to the passed ArrayStructContext. If isCurrent, then the currentAoS is considered, otherwise the corresponding AoS in the main IDS ALStruct is condiered.
-	      ALAoS *aos = (ctx->getOperationContext()->getRangemode() == SLICE_OP)?getAoS(ctx, true):getAoS(ctx, false);
-	    	*size = aos->aos.size();
-	    }
-	    internalCtx->unlock();
+		*size = 1;
+	}
+	else if(ctx->getOperationContext()->getRangemode() == SLICE_OP)
+	{
+	    //The elements of the slice may be shared with the main IDS, they are not modified
+	    ALAoS *aos = findAoS(ctx, true);
+	    *size = (aos) ? aos->aos.size() : 0;
+	}
+	else
+	{
+	    //The AoS is looked up without being created in the main IDS
+	    ALAoS *aos = findAoS(ctx);
+	    *size = (aos) ? aos->aos.size() : 0;
 	}
-      	catch(...)
-      	{
-	    internalCtx->unlock();
-	    throw;
-        }
     }
 
   /**
@@ -437,8 +610,8 @@ else
      @throw BackendException
   */
   void MemoryBackend::putInArraystruct(ArraystructContext *ctx,
-				std::string fieldname,
-				std::string timebase,  //Added to handle time dependent signals as firlds of static AoS
+				ALPath fieldname,
+				ALPath timebase,  //Added to handle time dependent signals as firlds of static AoS
 				int idx,
 				void* data,
 				int datatype,
@@ -451,13 +624,12 @@ else
 	{
 	    return;
 	}
-	ALData *alData;
+	IdsLockGuard guard(getIdsLock(ctx), true);
+	ALDedupTable *dedupTable = getDedupTable(ctx->getOperationContext());
 	if(ctx->getOperationContext()->getRangemode() == SLICE_OP)
-	    alData = getData(ctx, idx, fieldname, true);  //We are going to write in currentAos
+	    getData(ctx, idx, fieldname, true)->writeData(datatype, dim, size, (unsigned char *)data, timebase, dedupTable);  //We are going to write in currentAos
 	else
-	    alData = getData(ctx, idx, fieldname, false);  //We are going in AoS in main IDS
-
-	alData->writeData(datatype, dim, size, (unsigned char *)data, timebase);
+	    putData(getData(ctx, idx, fieldname, false), datatype, dim, size, data, timebase, dedupTable);  //We are going in AoS in main IDS
     }
 
   /**
@@ -477,8 +649,8 @@ else
      @throw BackendException
   */
     int MemoryBackend::getFromArraystruct(ArraystructContext *ctx,
-				  std::string fieldname,
-				  std::string timebase,
+				  ALPath fieldname,
+				  ALPath timebase,
 				  int idx,
 				  void** data,
 				  int* datatype,
@@ -518,21 +690,17 @@ else
 
     void MemoryBackend::endAction(Context *inCtx)
     {
-      internalCtx->lock();
-      try  {
         if(inCtx->getType() == CTX_ARRAYSTRUCT_TYPE) //Only in this case actions are required 
         {
 	    ArraystructContext *ctx = (ArraystructContext *)inCtx;
 //If we are startng a writeArrayStruct for a SLICE_OP and the AoS is NOT mapped, take NO action
 	    if(ctx->getOperationContext()->getRangemode() == SLICE_OP && !isMappedAoS(ctx))
-	    {
-		internalCtx->unlock();
 	        return;
-	    }
 	    if(ctx->getParent() == NULL)
 	    {
 	      if(ctx->getOperationContext()->getAccessmode() == alconst::write_op)
 	        {
+		    IdsLockGuard guard(getIdsLock(ctx), true);
 		    ALAoS *aos = getAoS(ctx, false);   //AoS stored in main IDS ALStruct 
 		    ALAoS *currAos = getAoS(ctx, true);  //Current AoS being written
 		    if(ctx->getOperationContext()->getRangemode() == SLICE_OP)
@@ -542,9 +710,10 @@ else
 			aos->addSlice(*currAos, ctx);
 //			aos->addSlice(*(currAos->clone()), ctx);
 		    }
+		    else if(incrementalPut)
+			aos->sweep(aos->stamp);
 	        }
 	    }
-	    internalCtx->unlock();
 	    return;
         }
         if(inCtx->getType() == CTX_OPERATION_TYPE) //Here it is only necessary to free possibly allocated IdsInfo
@@ -553,19 +722,23 @@ else
 	  {
      		delete kv.second;
 	  }*/
-      	auto oldItem = internalCtx->idsInfoMap.find(inCtx->getUid()); 
-      	if (oldItem!=internalCtx->idsInfoMap.end()) 
+	OperationContext *opCtx = (OperationContext *)inCtx;
+	if(incrementalPut && opCtx->getAccessmode() == alconst::write_op && opCtx->getRangemode() == GLOBAL_OP)
+	{
+	    uint64_t fields = incrementalCounters.fieldsWritten + incrementalCounters.fieldsSkipped;
+	    if(fields > fieldsAtBeginPut)
+	    {
+		incrementalCounters.puts++;
+		if(incrementalCounters.fieldsSkipped == fieldsSkippedAtBeginPut)
+		    incrementalCounters.fullRewrites++;
+	    }
+	}
+      	auto oldItem = idsInfoMap.find(inCtx->getUid()); 
+      	if (oldItem!=idsInfoMap.end()) 
 	    delete oldItem->second;
 
-	  internalCtx->idsInfoMap.erase(inCtx->getUid());
+	  idsInfoMap.erase(inCtx->getUid());
 	}
-	internalCtx->unlock();
-      }
-      catch(...)
-      {
-	    internalCtx->unlock();
-	    throw;
-      }
 //Everything outside AoS is expected to be mapped, so no action is required in write
 //Only in read mode target end action is called NOTE: in MDSplus backend this is neutral, for others we shopuld check whether 
     }
@@ -573,16 +746,27 @@ else
     void MemoryBackend::beginAction(OperationContext *ctx)  
     {
 //If reading or writing slices for non mapped AoS, pass to target backend
-	internalCtx->lock();
-	try  {
-	    if((ctx->getType() != CTX_ARRAYSTRUCT_TYPE && ctx->getAccessmode() == alconst::read_op) || (ctx->getType() == CTX_ARRAYSTRUCT_TYPE && !isMappedAoS((ArraystructContext *)ctx)))	
-	    internalCtx->unlock();
+//Nothing to prepare: the IDS is looked up (and created when written) at its first access
+	if(incrementalPut && ctx->getAccessmode() == alconst::write_op && ctx->getRangemode() == GLOBAL_OP)
+	{
+	    fieldsAtBeginPut = incrementalCounters.fieldsWritten + incrementalCounters.fieldsSkipped;
+	    fieldsSkippedAtBeginPut = incrementalCounters.fieldsSkipped;
 	}
-     	catch(...)
-      	{
-	    internalCtx->unlock();
-	    throw;
-        }
+    }
+
+    void MemoryBackend::putData(ALData *alData, int datatype, int dim, int *size, void *data, std::string timebase, ALDedupTable *dedupTable)
+    {
+	if(incrementalPut)
+	    alData->updateData(datatype, dim, size, (unsigned char *)data, timebase, putStamp, incrementalCounters, dedupTable);
+	else
+	    alData->writeData(datatype, dim, size, (unsigned char *)data, timebase, dedupTable);
+    }
+
+    ALDedupTable *MemoryBackend::getDedupTable(OperationContext *ctx)
+    {
+	if(!dedup)
+	    return NULL;
+	return &dedupTables[getIdsPath(ctx)];
     }
 
 
@@ -590,10 +774,10 @@ else
     void MemoryBackend::flush(DataEntryContext *ctx, std::string dataobjectName)
     {
 	OperationContext newCtx(ctx, dataobjectName, "", GLOBAL_OP);
+	IdsLockGuard guard(getIdsLock(&newCtx), false);
 	ALStruct *ids = getIds(&newCtx);
 	for(auto &field: ids->dataFields)
 	{
-	    std::string fieldName = field.first;
 	    ALData *fieldData = field.second;
 	    void *data;
 	    int datatype, numDims;
@@ -624,7 +808,6 @@ else
 	{
 	    for(auto &field: alAos.aos[idx]->dataFields)
 	    {
-		std::string fieldName = field.first;
 		ALData *fieldData = field.second;
 		void *data;
 		int datatype;
@@ -649,28 +832,33 @@ else
 
 
     int MemoryBackend::getFromAoS(ArraystructContext *ctx,
-				  std::string fieldname,
+				  ALPath fieldname,
 				  int idx,
 				  void** data,
 				  int* datatype,
 				  int* dim,
 				  int* size) 
     {
-	ALData *alData = getData(ctx, idx, fieldname, false);  //We are going to read the AoS in main structure
+	IdsLockGuard guard(getIdsLock(ctx), false);
+	ALData *alData = findData(ctx, idx, fieldname);  //We are going to read the AoS in main structure
+	if(alData == NULL)
+	    return 0;
 	return alData->readData(data, datatype, dim, size);
     }
 
 
 
     int MemoryBackend::getSliceFromAoS(ArraystructContext *ctx,
-				  std::string fieldname,
+				  ALPath fieldname,
 				  int idx,
 				  void** data,
 				  int* datatype,
 				  int* dim,
 				  int* size) 
     {
-	ALData *alData = getData(ctx, idx, fieldname, true);  //We are going to read the AoS slice in the memory struture prepared by prepareSlice()
+	ALData *alData = findData(ctx, idx, fieldname, true);  //We are going to read the AoS slice in the memory struture prepared by prepareSlice()
+	if(alData == NULL)
+	    return 0;
 	return alData->readData(data, datatype, dim, size);
     }
 
@@ -681,16 +869,16 @@ else
         OperationContext *opctx = ctx->getOperationContext();
         double time = opctx->getTime();
 	ALStruct *ids = getIds(opctx);
-	ALAoS *topAos = ids->getSubAoS(ctx->getPath());
+	ALAoS *topAos = ids->findSubAoS(ctx->getPath());
 
 	currentAos.deleteData();  //Prapere currentAoS that is going to contain the selected slice
 
-	if(topAos->aos.size() > 0)
+	if(topAos && topAos->aos.size() > 0)
 	{
 	    std::vector<StructPath> ctxV;
 	    StructPath topSp(ids, opctx->getDataobjectName());
 	    ctxV.push_back(topSp);
-	    StructPath sp(topAos->aos[ctx->getIndex()], ctx->getPath());
+	    StructPath sp(topAos->aos[ctx->getIndex()].get(), ctx->getPath());
 	    ctxV.push_back(sp);
 	    if(topAos->timebase != "") //if the top AoS is timed
 	    {
@@ -705,27 +893,28 @@ else
 
  	        getSliceIdxs(currTimebase, time, ctxV, sliceIdx1, sliceIdx2, topAos);
 
+		//The element of the slice is shared with the IDS, which copies it before modifying it
 		if (ctx->getOperationContext()->getInterpmode() == alconst::previous_interp || sliceIdx1 == sliceIdx2)
 		{
-		     currentAos.aos.push_back(topAos->aos[sliceIdx1]->clone());
+		     currentAos.aos.push_back(topAos->aos[sliceIdx1]);
 		}
 		else if (ctx->getOperationContext()->getInterpmode() == alconst::closest_interp)
 		{
-		    std::vector<double> timesV = getTimebaseVect(currTimebase, ctxV, topAos);
+		    const std::vector<double> &timesV = getTimebaseVect(currTimebase, ctxV, topAos);
 		    if (time - timesV[sliceIdx1] < timesV[sliceIdx2] - time)
 		    {
-		     	currentAos.aos.push_back(topAos->aos[sliceIdx1]->clone());
+		     	currentAos.aos.push_back(topAos->aos[sliceIdx1]);
 		    }
 		    else
 		    {
-		     	currentAos.aos.push_back(topAos->aos[sliceIdx2]->clone());
+		     	currentAos.aos.push_back(topAos->aos[sliceIdx2]);
 		    }
 		}
 		else //alconst::linear_interp not yet supported
 		{
-		    std::vector<double> timesV = getTimebaseVect(currTimebase, ctxV, topAos);
+		    const std::vector<double> &timesV = getTimebaseVect(currTimebase, ctxV, topAos);
 //	            currentAos.aos.push_back(topAos->aos[sliceIdx1]->clone());
-	            currentAos.aos.push_back(topAos->aos[sliceIdx1]->linearInterpol(topAos->aos[sliceIdx2], time, timesV[sliceIdx1], timesV[sliceIdx2]));
+	            currentAos.aos.push_back(std::shared_ptr<ALStruct>(topAos->aos[sliceIdx1]->linearInterpol(topAos->aos[sliceIdx2].get(), time, timesV[sliceIdx1], timesV[sliceIdx2])));
 		}
  	    //getSliceIdxs(topAos->timebase, time, ctxV, sliceIdx1, sliceIdx2, topAos);
 //std::cout << "******************************************************" <<std::endl;
@@ -736,9 +925,9 @@ else
 	    }
 	    for(size_t i = 0; i < topAos->aos.size(); i++)
 	    {
-	   	StructPath currSp(topAos->aos[i], ctx->getPath()); //Gabriele May 2022
+	   	StructPath currSp(topAos->aos[i].get(), ctx->getPath()); //Gabriele May 2022
 		ctxV[ctxV.size() - 1] = currSp;
-	        currentAos.aos.push_back(prepareSliceRec(ctx, *topAos->aos[i], *ids, time, ctxV, topAos));
+	        currentAos.aos.push_back(std::shared_ptr<ALStruct>(prepareSliceRec(ctx, *topAos->aos[i], *ids, time, ctxV, topAos)));
 	    }
 	}
     }		
@@ -760,11 +949,11 @@ else
 //	inData.readTimeSlice((double *)timeData, timeDims[0],  time,  &data, &datatype, &numDims, dims, alconst::previous_interp);
 	inData.readTimeSlice((double *)timeData, timeDims[0],  time,  &data, &datatype, &numDims, dims, ctx->getOperationContext()->getInterpmode());
     	retData->writeData(datatype, numDims, dims, (unsigned char *)data, "");
-	free((char *)data);
-	free((char *)timeData);
+	ALAllocator::release((char *)data);
+	ALAllocator::release((char *)timeData);
 	return retData;
     }
-    ALData *MemoryBackend::getAlSlice(ArraystructContext *ctx, ALData &inData, double time, std::vector<double> timebaseV)
+    ALData *MemoryBackend::getAlSlice(ArraystructContext *ctx, ALData &inData, double time, const std::vector<double> &timebaseV)
     {
 	ALData *retData = new ALData;
 	void *data;
@@ -775,7 +964,7 @@ else
 //	inData.readTimeSlice(timebaseV.data(), timebaseV.size(),  time,  &data, &datatype, &numDims, dims, alconst::previous_interp);
 	inData.readTimeSlice(timebaseV.data(), timebaseV.size(),  time,  &data, &datatype, &numDims, dims, ctx->getOperationContext()->getInterpmode());
     	retData->writeData(datatype, numDims, dims, (unsigned char *)data, "");
-	free((char *)data);
+	ALAllocator::release((char *)data);
 	return retData;
     }
 
@@ -789,7 +978,7 @@ else
 		retAlStruct->dataFields[field.first] = field.second->clone();
 	    else
 	    {
-		std::vector<double> timebaseV = getTimebaseVect(field.second->getTimebase(), ctxV);
+		const std::vector<double> &timebaseV = getTimebaseVect(field.second->getTimebase(), ctxV);
 		ALData *retData = getAlSlice(ctx, *field.second, time, timebaseV);
 ////NOTE: FOR COMPATIBILITY WITH CURRENT MDSplus backend, may be removed later
 		retData->shrinkDimension();
@@ -807,7 +996,7 @@ else
 	    	int sliceIdx1, sliceIdx2;
 
 		std::vector<StructPath> newCtxV = ctxV;
-		StructPath sp(currAos->aos[0], aosField.first);
+		StructPath sp(currAos->aos[0].get(), aosField.first);
 		newCtxV.push_back(sp);
 
 	        getSliceIdxs(currAos->timebase, time, newCtxV, sliceIdx1, sliceIdx2, currAos);
@@ -815,23 +1004,23 @@ else
 		newAos = new ALAoS;
 		if (ctx->getOperationContext()->getInterpmode() == alconst::previous_interp || sliceIdx1 == sliceIdx2)
 		{
-		     newAos->aos.push_back(currAos->aos[sliceIdx1]->clone());
+		     newAos->aos.push_back(currAos->aos[sliceIdx1]);
 		}
 		else if (ctx->getOperationContext()->getInterpmode() == alconst::closest_interp)
 		{
-		    std::vector<double> timesV = getTimebaseVect(currAos->timebase, newCtxV, currAos);
+		    const std::vector<double> &timesV = getTimebaseVect(currAos->timebase, newCtxV, currAos);
 		    if (time - timesV[sliceIdx1] < timesV[sliceIdx2] - time)
 		    {
-		     	newAos->aos.push_back(currAos->aos[sliceIdx1]->clone());
+		     	newAos->aos.push_back(currAos->aos[sliceIdx1]);
 		    }
 		    else
 		    {
-		     	newAos->aos.push_back(currAos->aos[sliceIdx2]->clone());
+		     	newAos->aos.push_back(currAos->aos[sliceIdx2]);
 		    }
 		}
 		else //alconst::linear_interp not yet supported
 		{
-	            newAos->aos.push_back(currAos->aos[sliceIdx1]->clone());
+	            newAos->aos.push_back(currAos->aos[sliceIdx1]);
 		}
 //For the moment only PREVIOUS SAMPLE is supported
 		//newAos->aos.push_back(currAos->aos[sliceIdx1]->clone());
@@ -842,9 +1031,9 @@ else
 		for(size_t i = 0; i < currAos->aos.size(); i++)
 	  	{	
 		    std::vector<StructPath> newCtxV = ctxV;
-		    StructPath sp(currAos->aos[i], aosField.first);
+		    StructPath sp(currAos->aos[i].get(), aosField.first);
 		    newCtxV.push_back(sp);
-	    	    newAos->aos.push_back(prepareSliceRec(ctx, *currAos->aos[i], ids, time, newCtxV, currAos));
+	    	    newAos->aos.push_back(std::shared_ptr<ALStruct>(prepareSliceRec(ctx, *currAos->aos[i], ids, time, newCtxV, currAos)));
 		}
 	    }
  	    retAlStruct->aosFields[aosField.first] = newAos;
@@ -853,7 +1042,20 @@ else
     }
 
 
-    std::vector<double> MemoryBackend::getTimebaseVect(std::string path, std::vector<StructPath> &ctxV, ALAoS *aos)
+    //Time vector of a timebase field of the main IDS, looked up without creating the field as reads run concurrently
+    static const std::vector<double> &timebaseTimes(ALStruct *alStruct, ALPath path)
+    {
+	ALData *alData = alStruct->findData(path);
+	if(alData == NULL)
+	{
+	    std::cout << "FATAL ERROR: time reference is not a double array" << std::endl;
+	    throw ALBackendException("FATAL ERROR: time reference is not a double array",LOG); 
+	}
+	return alData->getTimes();
+    }
+
+    //The time vectors returned are kept by the timebase fields (and timed AoS), until they are written again
+    const std::vector<double> &MemoryBackend::getTimebaseVect(std::string path, std::vector<StructPath> &ctxV, ALAoS *aos)
     {
 //First step: go up of as many including AoS as occurrences of ../
 	std::string currPath = path;
@@ -884,12 +1086,12 @@ else
 		{
 		    ALStruct *alStruct = ctxV[currIdx-1].alStruct;
 		    std::string actPath = currAosPath+"/"+currPath;
-		    return alStruct->getData(actPath)->getDoubleVect();
+		    return timebaseTimes(alStruct, actPath);
 		}
 		else
 		{
 		    ALStruct *alStruct = ctxV[currIdx].alStruct;
-	    	    return alStruct->getData(currPath)->getDoubleVect();
+	    	    return timebaseTimes(alStruct, currPath);
 		}
 	    }
 	    else //Time definition inside the IDS but outside the AoS
@@ -906,27 +1108,19 @@ else
 			aosPath = aosPath.substr(0, aosPos);
 	    	}
 		if(aosPath == "")
-		    return ctxV[0].alStruct->getData(currPath)->getDoubleVect();
+		    return timebaseTimes(ctxV[0].alStruct, currPath);
 		else
-		    return ctxV[0].alStruct->getData(aosPath+"/"+currPath)->getDoubleVect();
+		    return timebaseTimes(ctxV[0].alStruct, aosPath+"/"+currPath);
 	    }
 	}
 	else if(path[0] == '/')
-	    return ctxV[0].alStruct->getData(currPath.substr(1))->getDoubleVect();   //OCIO CHE QUI SCIOPA TUTO
+	    return timebaseTimes(ctxV[0].alStruct, currPath.substr(1));   //OCIO CHE QUI SCIOPA TUTO
 	else //it is the reference to internal field time
 	{
 	    if(!aos) //We are dealing with time dependent firlds of static AoS
-	    	return ctxV[ctxV.size()-1].alStruct->getData(currPath)->getDoubleVect();
+	    	return timebaseTimes(ctxV[ctxV.size()-1].alStruct, currPath);
 	    else
-	    {
-	    	std::vector<double> retTimeV;
-		std::string path1 = path.substr(path.find_last_of("/")+1);
-	    	for(size_t i = 0; i < aos->aos.size(); i++)
-	    	{
-		    retTimeV.push_back(aos->aos[i]->getData(path1)->getDouble());
-	    	}
-	    	return retTimeV; 
-	    }
+	    	return aos->getTimes(path.substr(path.find_last_of("/")+1));
 	}
     }
 
@@ -982,36 +1176,14 @@ else
 */ 
     void MemoryBackend::getSliceIdxs(std::string timebase, double time, std::vector<StructPath> &ctxV, int &sliceIdx1, int &sliceIdx2, ALAoS *aos)
     {
-	std::vector<double> timesV = getTimebaseVect(timebase, ctxV, aos);
-	if(time <= timesV[0])
-	{
-	    sliceIdx1 = sliceIdx2 = 0;
-	}
-	else if(time >= timesV[timesV.size() - 1])
-	{
-	    sliceIdx1 = sliceIdx2 = timesV.size() - 1;
-	}
-	else
-	{
-//	    for(int currSlice = 0; currSlice < timesV[timesV.size() - 1]; currSlice++)
-	    for(size_t currSlice = 0; currSlice < timesV.size(); currSlice++)
-	    {
-		if(time >= timesV[currSlice] && time < timesV[currSlice+1])
-		{
-		    sliceIdx1 = currSlice;
-		    sliceIdx2 = sliceIdx1 + 1;
-		    break;
-		}
-	    }
-	}
+	const std::vector<double> &timesV = getTimebaseVect(timebase, ctxV, aos);
+	ALData::getSliceIdxs(timesV.data(), timesV.size(), time, sliceIdx1, sliceIdx2);
     }
 
     std::string MemoryBackend::getIdsPath(OperationContext *ctx)
     {
-//      auto search = idsInfoMap.find(ctx->getUid()); 
-      auto search = internalCtx->idsInfoMap.find(ctx->getUid()); 
-//      if (search!=idsInfoMap.end()) 
-      if (search!=internalCtx->idsInfoMap.end())
+      auto search = idsInfoMap.find(ctx->getUid()); 
+      if (search!=idsInfoMap.end()) 
 	  return search->second->idsPath;
 
       lastIdsPath = ctx->getURI().query.get("path").value() + "#" + ctx->getDataobjectName();
@@ -1021,41 +1193,42 @@ else
     //Get the IDS (in ALStruct) 
     ALStruct  *MemoryBackend::getIds(OperationContext *ctx)
     {
-//      auto search = /*idsInfoMap*/.find(ctx->getUid());
-      auto search = internalCtx->idsInfoMap.find(ctx->getUid());
-//      if (search!=idsInfoMap.end())
-      if (search!=internalCtx->idsInfoMap.end())
-	return search->second->ids;
+	return getIdsInfo(ctx)->ids;
+    }
 
-      //      std::cout << "GET IDS FOR " << ctx->getDataobjectName() << std::endl;
+    IdsInfo *MemoryBackend::getIdsInfo(OperationContext *ctx)
+    {
+	auto search = idsInfoMap.find(ctx->getUid());
+	if (search!=idsInfoMap.end())
+	    return search->second;
 
 	ALStruct *retIds;
 	std::string idsPath = getIdsPath(ctx);
-//	auto searchids = idsMap.find(idsPath);
+	//The table of the IDSs is shared by the data entries of the same path: only its lookup is done under the mutex
+	internalCtx->lock();
 	auto searchids = internalCtx->idsMap.find(idsPath);
-//	if(searchids != idsMap.end())
 	if(searchids != internalCtx->idsMap.end())
-	{
 	  retIds = searchids->second; 
-	} 
 	else
 	{
-	  retIds = new ALStruct;
-//	  idsMap[idsPath] = retIds;
+	  std::shared_ptr<ALNodePool> &pool = internalCtx->idsPools[idsPath];
+	  pool = std::make_shared<ALNodePool>();
+	  retIds = new ALStruct(pool.get());
 	  internalCtx->idsMap[idsPath] = retIds;
 	}
-//	idsInfoMap.insert({ctx->getUid(),new IdsInfo(idsPath, retIds)});
-	internalCtx->idsInfoMap.insert({ctx->getUid(),new IdsInfo(idsPath, retIds)});
-	return retIds;
-/*	try {
-	   // return idsMap.at(ctx->getDataobjectName());
-	    return idsMap.at(idsPath);
-	} catch (const std::out_of_range& oor) 
-	{
-	    idsMap[idsPath] = new ALStruct;
-	    return idsMap.at(idsPath);
-	}
-*/    }
+	std::shared_mutex *idsLock = &internalCtx->idsLocks[idsPath];
+	internalCtx->unlock();
+	IdsInfo *idsInfo = new IdsInfo(idsPath, retIds, idsLock);
+	idsInfoMap.insert({ctx->getUid(), idsInfo});
+	return idsInfo;
+    }
+
+    std::shared_mutex *MemoryBackend::getIdsLock(Context *ctx)
+    {
+	if(ctx->getType() == CTX_ARRAYSTRUCT_TYPE)
+	    return getIdsInfo(((ArraystructContext *)ctx)->getOperationContext())->idsLock;
+	return getIdsInfo((OperationContext *)ctx)->idsLock;
+    }
 
 
 
@@ -1082,14 +1255,11 @@ else
 	    if(topAos->aos.size() <= (size_t)(currCtxV[i]->getParent()->getIndex()))  
 //	    if(topAos->aos.size() <= (size_t)(currCtxV[i]->getIndex()))
 	    {
-		int prevSize = topAos->aos.size();
 //		topAos->aos.resize(currCtxV[i]->getIndex()+1);
-		topAos->aos.resize(currCtxV[i]->getParent()->getIndex()+1);  
-		for(int j = prevSize; j <= currCtxV[i]->getParent()->getIndex(); j++) 
-//		for(int j = prevSize; j <= currCtxV[i]->getIndex(); j++)
-		    topAos->aos[j] = new ALStruct;
+		topAos->resize(currCtxV[i]->getParent()->getIndex()+1);
 	    }
-	    topAos = topAos->aos[currCtxV[i]->getParent()->getIndex()]->getSubAoS(currCtxV[i]->getPath()); 
+	    //The elements on the path are copied if shared with a slice
+	    topAos = topAos->getElement(currCtxV[i]->getParent()->getIndex())->getSubAoS(currCtxV[i]->getPath()); 
 //	    topAos = topAos->aos[currCtxV[i]->getIndex()]->getSubAoS(currCtxV[i]->getPath());
 
 	    if(topAos->timebase != currCtxV[i]->getTimebasePath())
@@ -1104,14 +1274,47 @@ else
 	ALAoS *aos = getAoS(ctx, isCurrent);
 	if(aos->timebase != ctx->getTimebasePath())
 	    aos->timebase = ctx->getTimebasePath();
+	//The field returned may be written, changing the times of the elements
+	if(ctx->getOperationContext()->getAccessmode() == alconst::write_op)
+	    aos->invalidateTimes();
 	if(aos->aos.size() <= (size_t)idx)
 	{
-	    int prevSize = aos->aos.size();
-	    aos->aos.resize(idx+1);
-	    for(int j = prevSize; j <= idx; j++)
-		aos->aos[j] = new ALStruct;
+	    aos->resize(idx+1);
 	}
-	return aos->aos[idx]->getData(path);
+	return aos->getElement(idx)->getData(path);
+    }
+
+    ALAoS *MemoryBackend::findAoS(ArraystructContext *ctx, bool isCurrent)
+    {
+	std::vector<ArraystructContext *>currCtxV;
+	ArraystructContext *currCtx = ctx;
+	do {
+	    currCtxV.push_back(currCtx);
+	    currCtx = currCtx->getParent();
+	} while(currCtx);
+	ALAoS *topAos;
+	if(isCurrent)
+	    topAos = &currentAos;
+	else
+	{
+	    ALStruct *alStruct = getIds(currCtxV[currCtxV.size() - 1]->getOperationContext());
+	    topAos = alStruct->findSubAoS(currCtxV[currCtxV.size() - 1]->getPath());
+	}
+	for(int i = currCtxV.size() - 2; i >= 0 && topAos; i--)
+	{
+	    if(topAos->aos.size() <= (size_t)(currCtxV[i]->getParent()->getIndex()))
+		return NULL;
+	    topAos = topAos->aos[currCtxV[i]->getParent()->getIndex()]->findSubAoS(currCtxV[i]->getPath());
+	}
+	return topAos;
+    }
+
+    ALData *MemoryBackend::findData(ArraystructContext *ctx, int idx, std::string path, bool isCurrent)
+    {
+	ALAoS *aos = findAoS(ctx, isCurrent);
+	if(aos == NULL || aos->aos.size() <= (size_t)idx)
+	    return NULL;
+	return aos->aos[idx]->findData(path);
     }
 
 //Check if the passed context refers to an AoS that is mapped in memory (i.e. for which deleteData or putData has been issued)
@@ -1148,15 +1351,122 @@ else
 		throw ALBackendException(message, LOG);
 	}
 
+	void MemoryBackend::getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage)
+	{
+	    if(internalCtx == NULL)
+		return;
+	    std::unordered_set<const unsigned char *> seen;
+	    //The IDSs are walked out of the table mutex, each one under its lock
+	    std::vector<std::pair<std::string, IdsInfo>> idsV;
+	    internalCtx->lock();
+	    std::vector<std::shared_ptr<ALNodePool>> pools;
+	    for(auto &ids: internalCtx->idsMap)
+	    {
+		idsV.push_back({ids.first, IdsInfo(ids.first, ids.second, &internalCtx->idsLocks[ids.first])});
+		pools.push_back(internalCtx->idsPools[ids.first]);
+	    }
+	    internalCtx->unlock();
+	    for(size_t i = 0; i < idsV.size(); i++)
+	    {
+		auto &ids = idsV[i];
+		IdsLockGuard guard(ids.second.idsLock, false);
+		//idsMap is keyed by <path>#<IDS name>[/<occurrence>]
+		std::string idsName = ids.first.substr(ids.first.rfind('#') + 1);
+		usage.add("memory", idsName, ids.second.ids->getBufferBytes(seen));
+		//Tree of the IDS: nodes, AoS and field tables held by its pool
+		if(pools[i])
+		    usage.add("memory_tree", idsName, pools[i]->getHeapBytes());
+	    }
+	    usage.add("memory", "", currentAos.getBufferBytes(seen));
+	}
+
+	bool MemoryBackend::getIncrementalPutCounters(DataEntryContext *ctx, ALIncrementalPutCounters &counters)
+	{
+	    if(internalCtx == NULL || !incrementalPut)
+		return false;
+	    counters = incrementalCounters;
+	    return true;
+	}
+
+	bool MemoryBackend::getDedupCounters(DataEntryContext *ctx, ALDedupCounters &counters)
+	{
+	    if(internalCtx == NULL || !dedup)
+		return false;
+	    counters = ALDedupCounters();
+	    for(auto &table: dedupTables)
+		counters += table.second.counters;
+	    return true;
+	}
+
 
 
 //////////////////////////////////////////////////////////////////////////
 
-    ALData* ALData::clone()
+    void ALData::BufferDeleter::operator()(unsigned char *p) const
+    {
+	liveBytes.sub(size);
+	delete[] p;
+    }
+
+    std::shared_ptr<unsigned char> ALData::allocBuffer(size_t size)
     {
-	ALData *newData = new ALData;
-	*newData = *this;
-	return newData;
+	std::shared_ptr<unsigned char> sp(new unsigned char[size], BufferDeleter{size});
+	liveBytes.add(size);
+	return sp;
+    }
+
+    std::shared_ptr<unsigned char> ALData::copyBuffer(const unsigned char *buf, size_t size, ALDedupTable *dedup)
+    {
+	if(dedup != NULL)
+	    return dedup->copyBuffer(buf, size);
+	std::shared_ptr<unsigned char> sp = allocBuffer(size);
+	memcpy(sp.get(), buf, size);
+	return sp;
+    }
+
+    std::shared_ptr<unsigned char> ALDedupTable::copyBuffer(const unsigned char *buf, size_t size)
+    {
+	counters.arrays++;
+	counters.bytes += size;
+	//Small buffers (scalars) are not worth an entry of the table
+	if(size < DEDUP_MIN_BYTES)
+	    return ALData::copyBuffer(buf, size, NULL);
+	uint64_t hash = Backend::hashData(buf, size);
+	auto range = buffers.equal_range(hash);
+	for(auto it = range.first; it != range.second; it++)
+	{
+	    std::shared_ptr<unsigned char> sp = it->second.buffer.lock();
+	    //Buffers updated in place by an incremental put no longer match their hash, hence the comparison
+	    if(sp && it->second.size == size && memcmp(sp.get(), buf, size) == 0)
+	    {
+		counters.sharedArrays++;
+		counters.sharedBytes += size;
+		return sp;
+	    }
+	}
+	//Entries of released buffers are purged when the table doubled since the last purge
+	if(buffers.size() >= purgeSize)
+	{
+	    for(auto it = buffers.begin(); it != buffers.end(); )
+		it = it->second.buffer.expired() ? buffers.erase(it) : std::next(it);
+	    purgeSize = std::max((size_t)1024, 2 * buffers.size());
+	}
+	std::shared_ptr<unsigned char> sp = ALData::copyBuffer(buf, size, NULL);
+	buffers.emplace(hash, Entry{size, sp});
+	return sp;
+    }
+
+    size_t ALData::getBufferBytes(std::unordered_set<const unsigned char *> &seen)
+    {
+	//The capacity kept to append slices is counted
+	if(!dataBuf || !seen.insert(dataBuf.get()).second)
+	    return 0;
+	return getCapacity();
+    }
+
+    ALData* ALData::clone(ALNodePool *pool)
+    {
+	return ALNodePool::create<ALData>(pool, *this);
     }
 
 
@@ -1175,7 +1485,10 @@ else
     ALData::ALData()
     {
 	timed = false;
+	type = 0;
+	numSlices = 0;
 	mapState = MAPPING::UNMAPPED;
+	timesCache.valid = false;
     }
     std::vector<double> ALData::getDoubleVect()
     {
@@ -1185,10 +1498,28 @@ else
 	    throw ALBackendException("FATAL ERROR: time reference is not a double array",LOG); 
 	}
 	std::vector<double>res;
-	for(size_t i = 0; i < bufV.size(); i++)
-	    res.push_back(*(double *)(static_cast<unsigned char *>(bufV[i].get())));
+	size_t sliceBytes = getSliceBytes();
+	for(size_t i = 0; i < numSlices; i++)
+	    res.push_back(*(double *)(dataBuf.get() + i * sliceBytes));
 	return res;
     }
+    const std::vector<double> &ALData::getTimes()
+    {
+	std::lock_guard<std::mutex> guard(timesCache.mutex);
+	if(!timesCache.valid)
+	{
+	    //A 1D timebase is taken whole, timed or not, as readData would return it
+	    if(type == alconst::double_data && dimensionV.size() <= 1)
+	    {
+		const double *times = (const double *)dataBuf.get();
+		timesCache.times.assign(times, times + numSlices * getSliceBytes() / sizeof(double));
+	    }
+	    else
+		timesCache.times = getDoubleVect();
+	    timesCache.valid = true;
+	}
+	return timesCache.times;
+    }
     double ALData::getDouble()
     {
 	if(type != alconst::double_data)
@@ -1196,7 +1527,7 @@ else
 	    std::cout  << "FATAL ERROR: time reference is not double" << std::endl;
 	    throw ALBackendException("FATAL ERROR: time reference is not double ",LOG); 
 	}
-	return *(double *)(static_cast<unsigned char *>(bufV[0].get()));
+	return *(double *)dataBuf.get();
     }
 
 
@@ -1208,18 +1539,17 @@ else
     }
     void ALData::deleteData()
     {
+	timesCache.valid = false;
 	timebase = "";
 	mapState = MAPPING::MAPPED;
 	dimensionV.clear();
-	bufV.clear();
+	dataBuf.reset();
+	numSlices = 0;
     }
 
-    void ALData::writeData(int type, int numDims, int *dims, unsigned char *buf, std::string timebase)
+    void ALData::writeData(int type, int numDims, int *dims, unsigned char *buf, std::string timebase, ALDedupTable *dedup)
     {
-	//Free previous data
-
-
-	bufV.clear();
+	timesCache.valid = false;
 	mapState = MAPPING::MAPPED;
 	this->type = type;
 	this->timebase = timebase;
@@ -1232,48 +1562,93 @@ else
 	    totSize *= dims[i];
 	    dimensionV.push_back(dims[i]);
 	}
-	if(timed)
-	{
 //Handle  the case a simple scalar is passed (it should be a 1D array with one element)
-	    int sliceSize = 1;
-	    if(numDims == 0)
-	    {
-		sliceSize = 1;
-	    	unsigned char *currBuf = new unsigned char[sliceSize*getItemSize(type)];
-		memcpy(currBuf, buf, sliceSize * getItemSize(type));
-		std::shared_ptr<unsigned char>sp(currBuf, [](unsigned char *p) { delete[] p; });
-		bufV.push_back(sp);
-		dimensionV.push_back(1);
-	    }
-	    else  //Normal case in which the slice is passed as array
+	if(timed && numDims == 0)
+	    dimensionV.push_back(1);
+	numSlices = timed ? dimensionV[dimensionV.size() - 1] : 1;
+	//The previous buffer is released, the whole signal is copied in a single buffer
+	dataBuf = copyBuffer(buf, totSize * getItemSize(type), dedup);
+    }
+
+    void ALData::updateData(int type, int numDims, int *dims, unsigned char *buf, std::string timebase, uint64_t stamp, ALIncrementalPutCounters &counters, ALDedupTable *dedup)
+    {
+	this->stamp = stamp;
+	timesCache.valid = false;
+	bool newTimed = timebase != "";
+	//Shape as stored by writeData: a timed scalar is kept as a 1D array with one element
+	std::vector<int> newDims(dims, dims + numDims);
+	if(newTimed && numDims == 0)
+	    newDims.push_back(1);
+	size_t totSize = getItemSize(type);
+	for(size_t i = 0; i < newDims.size(); i++)
+	    totSize *= newDims[i];
+	size_t newSlices = newTimed ? newDims[newDims.size() - 1] : 1;
+	if(mapState != MAPPING::MAPPED || this->type != type || this->timebase != timebase || timed != newTimed 
+	   || dimensionV != newDims || numSlices != newSlices)
+	{
+	    writeData(type, numDims, dims, buf, timebase, dedup);
+	    counters.fieldsWritten++;
+	    counters.bytesWritten += totSize;
+	    return;
+	}
+	size_t sliceBytes = (newSlices > 0) ? totSize / newSlices : 0;
+	size_t changed = 0;
+	for(size_t i = 0; i < newSlices; i++)
+	{
+	    if(memcmp(dataBuf.get() + i * sliceBytes, &buf[i * sliceBytes], sliceBytes) == 0)
+		continue;
+	    //A buffer shared with clones and equal buffers is copied before being overwritten
+	    if(dedup == NULL)
 	    {
-		for(int i = 0; i < numDims - 1; i++)
-		{
-			sliceSize *= dims[i];
-		} 
-		for(int i = 0; i < dims[numDims-1]; i++)
-		{
-			unsigned char *currBuf = new unsigned char[sliceSize*getItemSize(type)];
-			memcpy(currBuf, &buf[i * sliceSize * getItemSize(type)], sliceSize * getItemSize(type));
-			std::shared_ptr<unsigned char>sp(currBuf, [](unsigned char *p) { delete[] p; });
-			bufV.push_back(sp);
-		}
+		reserveSlices(0, sliceBytes);
+		memcpy(dataBuf.get() + i * sliceBytes, &buf[i * sliceBytes], sliceBytes);
 	    }
+	    changed += sliceBytes;
 	}
+	if(changed > 0 && dedup != NULL)
+	    dataBuf = dedup->copyBuffer(buf, totSize);
+	if(changed > 0)
+	    counters.fieldsWritten++;
 	else
-	{
-	    unsigned long long currSize = totSize * getItemSize(type);
-	    unsigned char *currBuf = new unsigned char[currSize];
-	    memcpy(currBuf, buf, currSize);
-	    bufV.push_back(std::shared_ptr<unsigned char>(currBuf, [](unsigned char *p) { delete[] p; }));
-	}
+	    counters.fieldsSkipped++;
+	counters.bytesWritten += changed;
+	counters.bytesSaved += totSize - changed;
+    }
+
+    size_t ALData::getSliceBytes()
+    {
+	size_t bytes = getItemSize(type);
+	size_t numDims = (timed && dimensionV.size() > 0) ? dimensionV.size() - 1 : dimensionV.size();
+	for(size_t i = 0; i < numDims; i++)
+	    bytes *= dimensionV[i];
+	return bytes;
+    }
+
+    size_t ALData::getCapacity()
+    {
+	BufferDeleter *deleter = std::get_deleter<BufferDeleter>(dataBuf);
+	return (deleter != NULL) ? deleter->size : 0;
+    }
+
+    unsigned char *ALData::reserveSlices(size_t n, size_t sliceBytes)
+    {
+	size_t used = numSlices * sliceBytes;
+	size_t needed = used + n * sliceBytes;
+	if(dataBuf && dataBuf.use_count() == 1 && needed <= getCapacity())
+	    return dataBuf.get() + used;
+	//Appends double the capacity, so that a series of appends copies each slice a constant number of times on average
+	size_t capacity = (n > 0) ? std::max(needed, 2 * used) : std::max(needed, getCapacity());
+	std::shared_ptr<unsigned char> sp = allocBuffer(capacity);
+	if(used > 0)
+	    memcpy(sp.get(), dataBuf.get(), used);
+	dataBuf = sp;
+	return sp.get() + used;
     }
 
 //Called only when in state SLICE_MAPPED, that is, only when it contains only the most recent slices
     void ALData::prependData(int type, int numDims, int *dims, unsigned char *buf)
     {
-	std::vector<std::shared_ptr<unsigned char>>newBufV;
-
+	timesCache.valid = false;
 	mapState = MAPPING::MAPPED;
 	this->type = type;
 	if(dimensionV.size() != (size_t)numDims)
@@ -1281,27 +1656,24 @@ else
 	    std::cout << "Internal error in Memory backend: wrong number of dimensions in prependData" << std::endl;
 	    exit(0);
 	}
+	size_t sliceBytes = getSliceBytes();
+	size_t prependBytes = dims[numDims - 1] * sliceBytes;
+	size_t used = numSlices * sliceBytes;
+	std::shared_ptr<unsigned char> sp = allocBuffer(prependBytes + used);
+	memcpy(sp.get(), buf, prependBytes);
+	if(used > 0)
+	    memcpy(sp.get() + prependBytes, dataBuf.get(), used);
+	dataBuf = sp;
 	dimensionV[numDims - 1] += dims[numDims - 1];
-	unsigned long long sliceSize = 1;
-	for(int i = 0; i < (int)dimensionV.size()-1; i++)
-	    sliceSize *= dimensionV[i];
-	for(int i = 0; i < dims[numDims - 1]; i++)
-	{
-	    unsigned long long currSize = sliceSize * getItemSize(type);
-	    unsigned char *currBuf = new unsigned char[currSize];
-	    memcpy(currBuf, &buf[i * currSize], currSize);
-	    newBufV.push_back(std::shared_ptr<unsigned char>(currBuf, [](unsigned char *p) { delete[] p; }));
-	}
-	for(size_t i = 0; i < bufV.size(); i++)
-	    newBufV.push_back(bufV[i]);
-	bufV = newBufV;
+	numSlices += dims[numDims - 1];
     }
     void ALData::addSlice(int type, int numDims, int *dims, unsigned char *buf)
     {
+	timesCache.valid = false;
 	if(mapState == MAPPING::UNMAPPED)
 	    mapState = MAPPING::SLICE_MAPPED;
 	timed = true;
-	if(bufV.size() == 0) //Yet an initialized data object
+	if(numSlices == 0) //Yet an initialized data object
 	{
 	    dimensionV.clear();
 	    this->type = type;
@@ -1311,21 +1683,22 @@ else
 	    }
 	    dimensionV.push_back(0);
 	}
-	int sliceSize = 1;
-	for(size_t i = 0; i < dimensionV.size() - 1; i++)
-	    sliceSize *= dimensionV[i];
-
-	unsigned char *currBuf = new unsigned char[sliceSize*getItemSize(type)];
-	memcpy(currBuf, buf, sliceSize*getItemSize(type));
+	size_t sliceBytes = getSliceBytes();
+	memcpy(reserveSlices(1, sliceBytes), buf, sliceBytes);
 	dimensionV[dimensionV.size() - 1]++;
-	bufV.push_back(std::shared_ptr<unsigned char>(currBuf, [](unsigned char *p) { delete[] p; }));
+	numSlices++;
     }
     void ALData::addSlice(ALData &slice)
     {
+	if(slice.numSlices == 0)
+	    return;
+	timesCache.valid = false;
 	if(mapState == MAPPING::UNMAPPED)
 	    mapState = MAPPING::SLICE_MAPPED;
 	timed = true;
-	if(bufV.size() == 0) //Yet an initialized data object
+	//Number of slices brought by slice: a scalar slice counts as one
+	size_t count = (slice.dimensionV.size() == 0) ? 1 : slice.dimensionV[slice.dimensionV.size() - 1];
+	if(numSlices == 0) //Yet an initialized data object
 	{
 	    dimensionV.clear();
 	    this->type = slice.type;
@@ -1333,72 +1706,69 @@ else
 	    {
 	    	dimensionV.push_back(slice.dimensionV[i]);
 	    }
-	}
-	if(slice.dimensionV.size() == 0)
-	{
 	    if(dimensionV.size() == 0)
-		dimensionV.push_back(1);
+		dimensionV.push_back(0);
 	    else
-		dimensionV[0]++;
-	    bufV.push_back(slice.bufV[0]);
-	}
-	else
-	{
-	    for(int i = 0; i < slice.dimensionV[slice.dimensionV.size() - 1]; i++)
-	    {
-	    	dimensionV[dimensionV.size()-1]++;
-		bufV.push_back(slice.bufV[i]);
-	    }
+		dimensionV[dimensionV.size() - 1] = 0;
 	}
+	size_t sliceBytes = getSliceBytes();
+	memcpy(reserveSlices(count, sliceBytes), slice.dataBuf.get(), count * sliceBytes);
+	dimensionV[dimensionV.size() - 1] += count;
+	numSlices += count;
     }
 
     int ALData::readData(void **retDataPtr, int *datatype, int *retNumDims, int *retDims)
     {
-	if(mapState != MAPPING::MAPPED || bufV.size() == 0)
+	if(mapState != MAPPING::MAPPED || numSlices == 0)
 	    return 0;
 	*datatype  = type;
-	unsigned long long totSize = 1;
+	//Slices are contiguous: the whole signal is returned with a single copy
+	size_t bytes = numSlices * getSliceBytes();
+	unsigned char *currBuf = (unsigned char *)ALAllocator::allocate(bytes);
+	memcpy(currBuf, dataBuf.get(), bytes);
+	*retDataPtr = currBuf;
+	*retNumDims = dimensionV.size();
 	for(size_t i = 0; i < dimensionV.size(); i++)
-	    totSize *= dimensionV[i];
-	unsigned char *currBuf = (unsigned char *)malloc(totSize * getItemSize(type));
-	if(timed)
-	{
-	    unsigned long long sliceSize = totSize * getItemSize(type)/dimensionV[dimensionV.size()-1];
-	    for(size_t i = 0; i < bufV.size(); i++)
-	    {
-		memcpy(&currBuf[i * sliceSize], bufV[i].get(), sliceSize);
-	    }
-	    *retDataPtr = currBuf;
-	    for(size_t i = 0; i < dimensionV.size(); i++)
-	        retDims[i] = dimensionV[i];
-	    *retNumDims = dimensionV.size();
-	}
-	else
-	{
-	    memcpy(currBuf, bufV[0].get(), totSize * getItemSize(type));
-	    *retDataPtr = currBuf;
-	    *retNumDims = dimensionV.size();
-	    for(size_t i = 0; i < dimensionV.size(); i++)
-	    	retDims[i] = dimensionV[i];
-	}
+	    retDims[i] = dimensionV[i];
+	return 1;
+    }
+    int ALData::readShape(int *datatype, int *retNumDims, int *retDims)
+    {
+	if(mapState != MAPPING::MAPPED || numSlices == 0)
+	    return 0;
+	*datatype = type;
+	*retNumDims = dimensionV.size();
+	for(size_t i = 0; i < dimensionV.size(); i++)
+	    retDims[i] = dimensionV[i];
+	return 1;
+    }
+    //Copies the data straight into dst. Returns 2 (with only the shape filled) when it does not fit
+    int ALData::readDataInto(void *dst, size_t capacity, int *datatype, int *retNumDims, int *retDims)
+    {
+	if(!readShape(datatype, retNumDims, retDims))
+	    return 0;
+	size_t bytes = numSlices * getSliceBytes();
+	if(bytes > capacity)
+	    return 2;
+	memcpy(dst, dataBuf.get(), bytes);
 	return 1;
     }
     int ALData::readSlice(int sliceIdx, void **retDataPtr, int *datatype, int *retNumDims, int *retDims)
     {
-	if(mapState != MAPPING::MAPPED || bufV.size() == 0)
+	if(mapState != MAPPING::MAPPED || numSlices == 0)
 	    return 0;
 
-	if((size_t)sliceIdx >= bufV.size())
+	if((size_t)sliceIdx >= numSlices)
 	{
 //	    std::cout << "Warning: You are asking a time outside the samples stored in the IDS.  Last available sample returned." << std::endl;
-	    sliceIdx = bufV.size() - 1;
+	    sliceIdx = numSlices - 1;
 	}
 	int sliceSize = 1;
 	for(int i = 0; i < (int)dimensionV.size()-1; i++)
 	    sliceSize *= dimensionV[i];	
 //	unsigned char *currBuf = new unsigned char[sliceSize * getItemSize(type)];
-	unsigned char *currBuf = (unsigned char *)malloc(sliceSize * getItemSize(type));
-	memcpy(currBuf, bufV[sliceIdx].get(), sliceSize * getItemSize(type));
+	unsigned char *currBuf = (unsigned char *)ALAllocator::allocate(sliceSize * getItemSize(type));
+	memcpy(currBuf, dataBuf.get() + (size_t)sliceIdx * sliceSize * getItemSize(type), sliceSize * getItemSize(type));
 	*retDataPtr = currBuf;
 	*datatype = type;
 	*retNumDims = dimensionV.size();
@@ -1409,28 +1779,28 @@ else
 	    retDims[dimensionV.size()-1] = 1;
 	return 1;
     }
-    void ALData::readTimeSlice(double *times, int numTimes, double time, void **retDataPtr, int *datatype, int *retNumDims, int *retDims, int interpolation)
+    void ALData::getSliceIdxs(const double *times, size_t numTimes, double time, int &sliceIdx1, int &sliceIdx2)
     {
-	int sliceIdx1, sliceIdx2 = -1;
 	if(time <= times[0])
 	    sliceIdx1 = sliceIdx2 = 0;
 	else if (time >= times[numTimes - 1])
 	    sliceIdx1 = sliceIdx2 = numTimes - 1;
 	else
 	{
-	    for(sliceIdx1 = 0; sliceIdx1 < numTimes - 1; sliceIdx1++)
-	    {
-		if(time >= times[sliceIdx1] && time < times[sliceIdx1+1])
-		{
-		    sliceIdx2 = sliceIdx1 + 1;
-		    break;
-		}
-	    }
+	    //First slice after time, the previous one is at or before time
+	    sliceIdx2 = std::upper_bound(times, times + numTimes, time) - times;
+	    sliceIdx1 = sliceIdx2 - 1;
 	}
+    }
+
+    void ALData::readTimeSlice(const double *times, int numTimes, double time, void **retDataPtr, int *datatype, int *retNumDims, int *retDims, int interpolation)
+    {
+	int sliceIdx1, sliceIdx2;
+	getSliceIdxs(times, numTimes, time, sliceIdx1, sliceIdx2);
 	if(sliceIdx1 == sliceIdx2)
 	{
-	    if(bufV.size() > 0 && (size_t)sliceIdx1 >= bufV.size())
-	    	std::cout << "Warning: You are asking a time outside the samples stored in the IDS.  Last available sample is at time " << times[bufV.size() - 1] <<  std::endl;
+	    if(numSlices > 0 && (size_t)sliceIdx1 >= numSlices)
+	    	std::cout << "Warning: You are asking a time outside the samples stored in the IDS.  Last available sample is at time " << times[numSlices - 1] <<  std::endl;
 	    readSlice(sliceIdx1, retDataPtr, datatype, retNumDims, retDims);
 	}
 	else
@@ -1463,7 +1833,7 @@ else
 			    break;
 			case alconst::integer_data:
 			{
-			    int *retData = (int *)malloc(sizeof(int) * numSamples);
+			    int *retData = (int *)ALAllocator::allocate(sizeof(int) * numSamples);
 			    for(int i = 0; i < numSamples; i++)
 				retData[i] = ((int *)data1)[i] + delta * (((int *)data2)[i] - ((int *)data1)[i]),
 			    *retDataPtr = retData;
@@ -1471,7 +1841,7 @@ else
 			}
 			case alconst::double_data:
 			{
-			    double *retData = (double *)malloc(sizeof(double) * numSamples);
+			    double *retData = (double *)ALAllocator::allocate(sizeof(double) * numSamples);
 			    for(int i = 0; i < numSamples; i++)
 				retData[i] = ((double *)data1)[i] + delta * (((double *)data2)[i] - ((double *)data1)[i]),
 			    *retDataPtr = retData;
@@ -1479,7 +1849,7 @@ else
 			}
 			case alconst::complex_data:
 			{
-			    double *retData = (double *)malloc(2*sizeof(double) * numSamples);
+			    double *retData = (double *)ALAllocator::allocate(2*sizeof(double) * numSamples);
 			    for(int i = 0; i < numSamples * 2; i++)
 				retData[i] = ((double *)data1)[i] + delta * (((double *)data2)[i] - ((double *)data1)[i]),
 			    *retDataPtr = retData;
@@ -1487,45 +1857,106 @@ else
 			}
 			default: {}
 		    }
-		    free((char *)data1);
-		    free((char *)data2);
+		    ALAllocator::release((char *)data1);
+		    ALAllocator::release((char *)data2);
 		}
 		default: {}
 	    }
 	}
     }
 
-    ALAoS * ALAoS::clone()
+    size_t ALAoS::getBufferBytes(std::unordered_set<const unsigned char *> &seen)
     {
-	ALAoS *newAos = new ALAoS;
+	size_t bytes = 0;
 	for(size_t i = 0; i < aos.size(); i++)
-	    newAos->aos.push_back(aos[i]->clone());
+	    bytes += aos[i]->getBufferBytes(seen);
+	return bytes;
+    }
+
+    ALAoS * ALAoS::clone(ALNodePool *pool)
+    {
+	ALAoS *newAos = ALNodePool::create<ALAoS>(pool, pool);
+	newAos->aos = aos;
 	newAos->timebase = timebase;
+	newAos->stamp = stamp;
 	return newAos;
     }
 
+    ALStruct *ALAoS::getElement(size_t idx)
+    {
+	if(aos[idx].use_count() > 1)
+	{
+	    std::shared_ptr<ALStruct> copy = newElement();
+	    aos[idx]->copyTo(*copy);
+	    aos[idx] = copy;
+	}
+	else
+	    std::atomic_thread_fence(std::memory_order_acquire);  //Reads of a slice that just released the element are done
+	return aos[idx].get();
+    }
 
-    void ALAoS::deleteData()
+
+    const std::vector<double> &ALAoS::getTimes(const std::string &path)
     {
-	timebase = "";
+	std::lock_guard<std::mutex> guard(timesMutex);
+	auto search = timesCache.find(path);
+	if(search != timesCache.end())
+	    return search->second;
+	std::vector<double> times;
 	for(size_t i = 0; i < aos.size(); i++)
 	{
-	    aos[i]->deleteData();
-	    delete aos[i];
+	    ALData *alData = aos[i]->findData(path);
+	    if(alData == NULL)
+	    {
+		std::cout  << "FATAL ERROR: time reference is not double" << std::endl;
+		throw ALBackendException("FATAL ERROR: time reference is not double ",LOG); 
+	    }
+	    times.push_back(alData->getDouble());
 	}
+	return timesCache[path] = std::move(times);
+    }
+
+    void ALAoS::deleteData()
+    {
+	invalidateTimes();
+	timebase = "";
+	//The elements are freed with their last reference, they may still be used by a slice
 	aos.clear();
     }
-    ALData *ALStruct::getData(std::string path)
+    void ALAoS::resize(size_t size)
+    {
+	invalidateTimes();
+	size_t prevSize = aos.size();
+	aos.resize(size);
+	for(size_t i = prevSize; i < size; i++)
+	    aos[i] = newElement();
+    }
+
+    std::shared_ptr<ALStruct> ALAoS::newElement()
     {
-      auto search = dataFields.find(path);
+	if(pool == NULL)
+	    return std::make_shared<ALStruct>();
+	return std::allocate_shared<ALStruct>(ALNodeAllocator<ALStruct>(pool->shared_from_this()), pool);
+    }
+
+    void ALAoS::sweep(uint64_t stamp)
+    {
+	invalidateTimes();
+	for(size_t i = 0; i < aos.size(); i++)
+	    getElement(i)->sweep(stamp);
+    }
+
+    ALData *ALStruct::getData(ALPath path)
+    {
+      auto search = dataFields.find(path.id());
       if (search!=dataFields.end())
 	{  
 	  return search->second; 
 	} 
 	else
 	{
-	  ALData * d = new ALData; 
-	  dataFields[path] = d;
+	  ALData * d = ALNodePool::create<ALData>(pool); 
+	  dataFields[path.id()] = d;
 	  return d;
 	}
 /*	try  {  
@@ -1537,18 +1968,38 @@ else
 	} */
     }
 
-    ALStruct *ALStruct::clone()
+    ALData *ALStruct::findData(ALPath path)
+    {
+	auto search = dataFields.find(path.id());
+	return (search != dataFields.end()) ? search->second : NULL;
+    }
+
+    ALAoS *ALStruct::findSubAoS(const std::string &path)
+    {
+	auto search = aosFields.find(path);
+	return (search != aosFields.end()) ? search->second : NULL;
+    }
+
+    size_t ALStruct::getBufferBytes(std::unordered_set<const unsigned char *> &seen)
+    {
+	size_t bytes = 0;
+	for(auto &field:dataFields)
+	    bytes += field.second->getBufferBytes(seen);
+	for(auto &field:aosFields)
+	    bytes += field.second->getBufferBytes(seen);
+	return bytes;
+    }
+
+    void ALStruct::copyTo(ALStruct &newStruct)
     {
-	ALStruct *newStruct = new ALStruct;
 	for(auto &field:dataFields)
 	{
-	    newStruct->dataFields[field.first] = field.second->clone();
+	    newStruct.dataFields[field.first] = field.second->clone(newStruct.pool);
 	}
 	for(auto &field:aosFields)
 	{
-	    newStruct->aosFields[field.first] = field.second->clone();
+	    newStruct.aosFields[field.first] = field.second->clone(newStruct.pool);
 	}
-	return newStruct;
     }
 
 
@@ -1558,7 +2009,7 @@ else
 	for(auto &field:dataFields)
 	{
 	    dataFields[field.first]->deleteData();
-	    delete dataFields[field.first];
+	    ALNodePool::destroy(pool, dataFields[field.first]);
 	}
 	dataFields.clear();
 
@@ -1566,10 +2017,37 @@ else
 	{
 	    if(aosFields[field.first])
 	    	aosFields[field.first]->deleteData();
-	    delete aosFields[field.first];
+	    ALNodePool::destroy(pool, aosFields[field.first]);
 	}
 	aosFields.clear();
     }
+    void ALStruct::sweep(uint64_t stamp)
+    {
+	for(auto it = dataFields.begin(); it != dataFields.end(); )
+	{
+	    if(it->second->stamp != stamp)
+	    {
+		ALNodePool::destroy(pool, it->second);
+		it = dataFields.erase(it);
+	    }
+	    else
+		it++;
+	}
+	for(auto it = aosFields.begin(); it != aosFields.end(); )
+	{
+	    if(it->second->stamp != stamp)
+	    {
+		ALNodePool::destroy(pool, it->second);
+		it = aosFields.erase(it);
+	    }
+	    else
+	    {
+		it->second->sweep(stamp);
+		it++;
+	    }
+	}
+    }
+
     ALAoS *ALStruct::getSubAoS(std::string path)
     {
       //if(aosFields.find(path) != aosFields.end())
@@ -1579,7 +2057,7 @@ else
 	return search->second;
       else
 	{
-	  ALAoS *aos = new ALAoS;
+	  ALAoS *aos = ALNodePool::create<ALAoS>(pool, pool);
 	  aosFields[path]=aos; //new ALAoS;
 	  return aos; //aosFields[path];
 	}
@@ -1625,19 +2103,13 @@ else
 
 
 
-    ALAoS::~ALAoS()
-    {
-        for(size_t i = 0; i < aos.size(); i++)
-	    delete aos[i];
-    }
-
     ALAoS * ALAoS::linearInterpol(ALAoS *alAos, double t, double t1, double t2) 
     {
 	ALAoS *retAos = new ALAoS();
 	if(aos.size() != alAos->aos.size())
 	    return retAos;
 	for( size_t i = 0; i < aos.size(); i++)
-	    retAos->aos.push_back(aos[i]->linearInterpol(alAos->aos[i], t, t1, t2));
+	    retAos->aos.push_back(std::shared_ptr<ALStruct>(aos[i]->linearInterpol(alAos->aos[i].get(), t, t1, t2)));
 	return retAos;
     }
     ALStruct *ALStruct::linearInterpol(ALStruct *alStruct, double t, double t1, double t2)
@@ -3,11 +3,15 @@
 
 #include <string.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <iostream>
 #include <vector>
-#include <pthread.h>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 
 #include "al_backend.h"
 #include "al_context.h"
@@ -24,44 +28,175 @@
 
 #ifdef __cplusplus
 
-//Global lock management (used only when opening databases)
-static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-static void lock() {pthread_mutex_lock(&mutex);}
-static void unlock() {pthread_mutex_unlock(&mutex);}
+//Support classes for memory mapping
 
-// custom deleter for [] allocated objects
-template< typename T >
-struct array_deleter
+//Memory of the nodes of an IDS (AoS elements, AoS and fields with their tables), one pool per IDS. Nodes are carved
+//one after the other from large chunks (monotonic arena), a freed node is kept in a free list and reused by the next
+//node of the same size class, and the chunks are released at once with the pool, when the IDS and the last slice
+//referring to its elements are gone. Blocks larger than MAX_NODE_BYTES (tables of large AoS) come from the heap.
+//Elements may be released by the slices of readers while the IDS is written: the pool has its own mutex.
+//Data buffers are not in the pool, they are shared across IDSs (see ALData::allocBuffer)
+class IMAS_CORE_LIBRARY_API ALNodePool: public std::pmr::memory_resource, public std::enable_shared_from_this<ALNodePool>
 {
-  void operator ()( T const * p)
-  {
-    delete[] p;
-  }
+    static const size_t NODE_ALIGN = 16;  //Size classes are multiples of NODE_ALIGN bytes
+    static const size_t MAX_NODE_BYTES = 512;
+
+    //Heap memory of the pool (chunks of the arena and large blocks), counted for al_memory_usage
+    class Upstream: public std::pmr::memory_resource
+    {
+    public:
+	std::atomic<size_t> bytes{0};
+    protected:
+	void *do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+    };
+
+    std::mutex mutex;
+    Upstream upstream;
+    std::pmr::monotonic_buffer_resource arena{&upstream};
+    void *freeLists[MAX_NODE_BYTES / NODE_ALIGN] = {};  //Freed blocks of each size class, linked through their first word
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+public:
+    //Heap bytes held by the nodes of the IDS, in use or free
+    size_t getHeapBytes() const { return upstream.bytes; }
+
+    //Resource of the tables of a node, the heap when pool is NULL
+    static std::pmr::memory_resource *resource(ALNodePool *pool)
+    {
+	return (pool) ? pool : std::pmr::get_default_resource();
+    }
+
+    //Node allocated from pool, or with new when pool is NULL
+    template<typename T, typename... Args> static T *create(ALNodePool *pool, Args&&... args)
+    {
+	if(pool == NULL)
+	    return new T(std::forward<Args>(args)...);
+	void *p = pool->allocate(sizeof(T), alignof(T));
+	try {
+	    return new(p) T(std::forward<Args>(args)...);
+	} catch(...) {
+	    pool->deallocate(p, sizeof(T), alignof(T));
+	    throw;
+	}
+    }
+
+    //Frees a node allocated by create with the same pool
+    template<typename T> static void destroy(ALNodePool *pool, T *node)
+    {
+	if(pool == NULL)
+	    delete node;
+	else if(node)
+	{
+	    node->~T();
+	    pool->deallocate(node, sizeof(T), alignof(T));
+	}
+    }
 };
 
+//Allocator of the AoS elements (std::allocate_shared): the control block of an element keeps the pool of its nodes
+template<typename T> class ALNodeAllocator
+{
+public:
+    typedef T value_type;
+    std::shared_ptr<ALNodePool> pool;
+
+    ALNodeAllocator(std::shared_ptr<ALNodePool> pool): pool(std::move(pool)) {}
+    template<typename U> ALNodeAllocator(const ALNodeAllocator<U> &other): pool(other.pool) {}
+    T *allocate(size_t n) { return (T *)pool->allocate(n * sizeof(T), alignof(T)); }
+    void deallocate(T *p, size_t n) { pool->deallocate(p, n * sizeof(T), alignof(T)); }
+    template<typename U> bool operator==(const ALNodeAllocator<U> &other) const { return pool == other.pool; }
+    template<typename U> bool operator!=(const ALNodeAllocator<U> &other) const { return pool != other.pool; }
+};
 
-//Support classes for memory mapping
+//Deduplication of the buffers of an IDS (URI option dedup=yes): buffers with the same content are allocated once and shared.
+//Only weak references are kept, so that a buffer leaves the table when the last field holding it releases it
+class IMAS_CORE_LIBRARY_API ALDedupTable
+{
+    struct Entry
+    {
+	size_t size;
+	std::weak_ptr<unsigned char> buffer;
+    };
+    std::unordered_multimap<uint64_t, Entry> buffers;  //Keyed on the hash of the content
+    size_t purgeSize = 1024;
+
+public:
+    ALDedupCounters counters;
+
+    //Returns a buffer holding a copy of buf, shared with an equal buffer of the table when there is one
+    std::shared_ptr<unsigned char> copyBuffer(const unsigned char *buf, size_t size);
+};
 
 class IMAS_CORE_LIBRARY_API ALData
 {
     bool timed;
     int type;
     int mapState;
-    //If timed, dimensionsV refers to a single slice
+    //If timed, the last dimension is the number of slices
     std::vector<int> dimensionV;
-    //If non timed bufV contains only one element
-    std::vector <std::shared_ptr<unsigned char>> bufV;  
+    //Timed data is kept contiguous, slice after slice, in a buffer with room to append more slices. Non timed data 
+    //has a buffer of its exact size. A buffer shared with other ALData (clones, dedup) is copied before being modified
+    std::shared_ptr<unsigned char> dataBuf;
+    //Number of slices if timed, 1 if non timed, 0 when empty
+    size_t numSlices;
     std::string timebase;
     int getItemSize(int inType);
 
+    // releases dataBuf and updates the process-wide count of the memory backend
+    struct BufferDeleter
+    {
+	size_t size;
+	void operator()(unsigned char *p) const;
+    };
+
+    //Size in bytes of a slice (of the whole data if not timed)
+    size_t getSliceBytes();
+    //Size in bytes allocated for dataBuf
+    size_t getCapacity();
+    //Makes dataBuf unshared with room for n more slices of sliceBytes, growing it geometrically. Returns the end of the stored slices
+    unsigned char *reserveSlices(size_t n, size_t sliceBytes);
+
+    //Values of the field when used as a timebase (getTimes), valid until the field is modified. Filled by concurrent
+    //reads under its own lock, it starts empty in a copy of the field
+    struct TimesCache
+    {
+	std::mutex mutex;
+	std::vector<double> times;
+	bool valid = false;
+	TimesCache() {}
+	TimesCache(const TimesCache &) {}
+	TimesCache &operator=(const TimesCache &) { times.clear(); valid = false; return *this; }
+    };
+    TimesCache timesCache;
 
 public:
     enum MAPPING { UNMAPPED = 1, MAPPED = 2, SLICE_MAPPED = 3 };
     ALData();
+
+    //Stamp of the last incremental put that wrote the field
+    uint64_t stamp = 0;
+
+    //Allocates a data buffer, possibly shared by several ALData (clones and dedup)
+    static std::shared_ptr<unsigned char> allocBuffer(size_t size);
+
+    //Copy of a buffer, shared with an equal buffer of the dedup table if any
+    static std::shared_ptr<unsigned char> copyBuffer(const unsigned char *buf, size_t size, ALDedupTable *dedup);
+
+    //Size of the buffers not counted yet in seen (buffers are shared between clones)
+    size_t getBufferBytes(std::unordered_set<const unsigned char *> &seen);
+
     bool isTimed() { return timed;}
     int getMapState() {return mapState;}
 
     std::vector<double> getDoubleVect();
+    //Time vector of a timebase field, computed once and kept until the field is written again
+    const std::vector<double> &getTimes();
     double getDouble();
     std::vector<int> getIntVect();
     double getInt();
@@ -70,24 +205,33 @@ public:
     std::string getTimebase() { return timebase;}
     void setTimebase(std::string timebase);
     void deleteData();
-    void writeData(int type, int numDims, int *dims, unsigned char *buf, std::string timebase);
+    void writeData(int type, int numDims, int *dims, unsigned char *buf, std::string timebase, ALDedupTable *dedup = NULL);
+    //Incremental put: only the slices whose content changed are copied, in place unless shared. Falls back to writeData when the shape changes
+    void updateData(int type, int numDims, int *dims, unsigned char *buf, std::string timebase, uint64_t stamp, ALIncrementalPutCounters &counters, ALDedupTable *dedup = NULL);
 
 //Called only when in state SLICE_MAPPED, that is, only when it contains only the most recent slices
     void prependData(int type, int numDims, int *dims, unsigned char *buf);
+    //Appends slices in amortized constant time
     void addSlice(int type, int numDims, int *dims, unsigned char *buf);
     void addSlice(ALData &slice);
 
-    bool isEmpty() { return bufV.size() == 0;}
+    bool isEmpty() { return numSlices == 0;}
     void shrinkDimension() //TEMPORARY , MAY BE REMOVED LATER
     {
+	timesCache.valid = false;
 	if(dimensionV.size() > 0)
 	    dimensionV.resize(dimensionV.size() - 1);
     }
 
     int readData(void **retDataPtr, int *datatype, int *retNumDims, int *retDims);
+    int readDataInto(void *dst, size_t capacity, int *datatype, int *retNumDims, int *retDims);
+    int readShape(int *datatype, int *retNumDims, int *retDims);
     int readSlice(int sliceIdx, void **retDataPtr, int *datatype, int *retNumDims, int *retDims);
-    void readTimeSlice(double *times, int numTimes, double time, void **retDataPtr, int *datatype, int *retNumDims, int *retDims, int interpolation);
-    ALData *clone();
+    void readTimeSlice(const double *times, int numTimes, double time, void **retDataPtr, int *datatype, int *retNumDims, int *retDims, int interpolation);
+    //Indexes of the slices bracketing time in the sorted times (equal at and beyond the bounds), found by binary search
+    static void getSliceIdxs(const double *times, size_t numTimes, double time, int &sliceIdx1, int &sliceIdx2);
+    //Copy sharing the data buffer, allocated from pool (NULL: the heap)
+    ALData *clone(ALNodePool *pool = NULL);
     bool isCompatible(ALData *alData)
     {
 	if(type != alData->type)
@@ -106,7 +250,7 @@ public:
     ALData *linearInterpol(ALData *alData, double t, double t1, double t2)
     {
 	ALData *retData = new ALData();
-	if(bufV.size() != 1)
+	if(numSlices != 1)
 	{
 	    std::cout << "INTERNAL ERROR: unexpected number of slices > 1 when interpolating AoS\n";
 	    return retData;
@@ -126,49 +270,50 @@ public:
 	switch (type)  {
 	    case CHAR_DATA:
 	    {
-		char *data1 = (char *)bufV[0].get();
-		char *data2 = (char *)alData->bufV[0].get();
-	    	char *currBuf = new char[numItems];
+		char *data1 = (char *)dataBuf.get();
+		char *data2 = (char *)alData->dataBuf.get();
+		std::shared_ptr<unsigned char>sp = allocBuffer(numItems * sizeof(char));
+	    	char *currBuf = (char *)sp.get();
 		for(int i = 0; i < numItems; i++)
 		    currBuf[i] = ((char *)data1)[i] + delta * (((char *)data2)[i] - ((char *)data1)[i]);
-		std::shared_ptr<unsigned char>sp((unsigned char *)currBuf, array_deleter<unsigned char>());
-		retData->bufV.push_back(sp);
+		retData->dataBuf = sp;
 		break;
 	    }
 	    case INTEGER_DATA:
 	    {
-		int *data1 = (int *)bufV[0].get();
-		int *data2 = (int *)alData->bufV[0].get();
-	    	int *currBuf = new int[numItems];
+		int *data1 = (int *)dataBuf.get();
+		int *data2 = (int *)alData->dataBuf.get();
+		std::shared_ptr<unsigned char>sp = allocBuffer(numItems * sizeof(int));
+	    	int *currBuf = (int *)sp.get();
 		for(int i = 0; i < numItems; i++)
 		    currBuf[i] = ((int *)data1)[i] + delta * (((int *)data2)[i] - ((int *)data1)[i]);
-		std::shared_ptr<unsigned char>sp((unsigned char *)currBuf, array_deleter<unsigned char>());
-		retData->bufV.push_back(sp);
+		retData->dataBuf = sp;
 		break;
 	    }
 	    case DOUBLE_DATA:
 	    {
-		double *data1 = (double *)bufV[0].get();
-		double *data2 = (double *)alData->bufV[0].get();
-	    	double *currBuf = new double[numItems];
+		double *data1 = (double *)dataBuf.get();
+		double *data2 = (double *)alData->dataBuf.get();
+		std::shared_ptr<unsigned char>sp = allocBuffer(numItems * sizeof(double));
+	    	double *currBuf = (double *)sp.get();
 		for(int i = 0; i < numItems; i++)
 		    currBuf[i] = ((double *)data1)[i] + delta * (((double *)data2)[i] - ((double *)data1)[i]);
-		std::shared_ptr<unsigned char>sp((unsigned char *)currBuf, array_deleter<unsigned char>());
-		retData->bufV.push_back(sp);
+		retData->dataBuf = sp;
 		break;
 	    }
 	    case COMPLEX_DATA:
 	    {
-		double *data1 = (double *)bufV[0].get();
-		double *data2 = (double *)alData->bufV[0].get();
-	    	double *currBuf = new double[2*numItems];
+		double *data1 = (double *)dataBuf.get();
+		double *data2 = (double *)alData->dataBuf.get();
+		std::shared_ptr<unsigned char>sp = allocBuffer(2*numItems * sizeof(double));
+	    	double *currBuf = (double *)sp.get();
 		for(int i = 0; i < 2*numItems; i++)
 		    currBuf[i] = ((double *)data1)[i] + delta * (((double *)data2)[i] - ((double *)data1)[i]);
-		std::shared_ptr<unsigned char>sp((unsigned char *)currBuf, array_deleter<unsigned char>());
-		retData->bufV.push_back(sp);
+		retData->dataBuf = sp;
 		break;
 	    }
 	}
+	retData->numSlices = 1;
 	return retData;
     }
     std::string toString()
@@ -179,21 +324,22 @@ public:
 	for (size_t i = 0; i < dimensionV.size(); i++)
 	    numItems *= dimensionV[i];
 	std::string retStr = "";
-	if(bufV.size() * numItems > 1)
+	if(numItems > 1)
 	    retStr += "[";
-	for(size_t i = 0; i < bufV.size(); i++)
+	//Timed data is contiguous: all the slices are printed in a row
+	if(numSlices > 0)
 	{
 	    switch (type)  {
 	    	case CHAR_DATA:
 		{
-		    char *data = (char *)bufV[i].get();
+		    char *data = (char *)dataBuf.get();
 		    for(int j = 0; j < numItems; j++)
 			retStr += data[j];
 		    break;
 		}
 	    	case INTEGER_DATA:
 		{
-		    int *data = (int *)bufV[i].get();
+		    int *data = (int *)dataBuf.get();
 		    for(int j = 0; j < numItems; j++)
 		    {
 			retStr += std::to_string(data[j]);
@@ -204,7 +350,7 @@ public:
 		}
 	    	case DOUBLE_DATA:
 		{
-		    double *data = (double *)bufV[i].get();
+		    double *data = (double *)dataBuf.get();
 		    for(int j = 0; j < numItems; j++)
 		    {
 			retStr += std::to_string(data[j]);
@@ -215,7 +361,7 @@ public:
 		}
 	    	case COMPLEX_DATA:
 		{
-		    double *data = (double *)bufV[i].get();
+		    double *data = (double *)dataBuf.get();
 		    for(int j = 0; j < numItems; j++)
 		    {
 			retStr += "(";
@@ -230,7 +376,7 @@ public:
 		}
 	    }
 	}
-	if(bufV.size() * numItems > 1)
+	if(numItems > 1)
 	    retStr += "]";
 	return retStr;
     }
@@ -240,14 +386,33 @@ class ALStruct;
 class IMAS_CORE_LIBRARY_API ALAoS
 {
 public:
+    ALNodePool *pool;  //Pool of the IDS, where the elements are allocated. NULL for the AoS of slices, on the heap
     std::string timebase;
-    std::vector<ALStruct *> aos;
+    //Elements, shared with the slices prepared by get_slice that refer to them instead of copying them. A shared element
+    //is never modified: writers get it with getElement
+    std::pmr::vector<std::shared_ptr<ALStruct>> aos;
+    uint64_t stamp = 0;  //Stamp of the last incremental put that wrote the AoS
+    //Times of the elements of a timed AoS (getTimes), by time field, valid until the AoS or the fields of its elements are written.
+    //Kept per field, so that a vector returned to a reader is not refilled by a concurrent reader asking for another field
+    std::unordered_map<std::string, std::vector<double>> timesCache;
+    std::mutex timesMutex;  //Held by getTimes, which runs in concurrent reads
+    const std::vector<double> &getTimes(const std::string &path);
+    ALAoS(ALNodePool *pool = NULL): pool(pool), aos(ALNodePool::resource(pool)) {}
+    void invalidateTimes() {timesCache.clear();}
     void setTimebase(std::string timebase) {this->timebase = timebase;}
     void addSlice(ALAoS &sliceAos, ArraystructContext *ctx);
     void deleteData();
-    ALAoS *clone();
+    void resize(size_t size);
+    //New empty element, allocated from the pool of the AoS
+    std::shared_ptr<ALStruct> newElement();
+    void sweep(uint64_t stamp);
+    //Copy sharing the elements, allocated from pool
+    ALAoS *clone(ALNodePool *pool);
+    //Element to be modified, replaced first by a copy if shared. The copy shares the elements of its own AoS, so that
+    //only the elements on the path to the modified field are copied
+    ALStruct *getElement(size_t idx);
+    size_t getBufferBytes(std::unordered_set<const unsigned char *> &seen);
     void dump(int tabs);
-    ~ALAoS();
     ALAoS * linearInterpol(ALAoS *alAos, double t, double t1, double t2); 
 };
 
@@ -258,28 +423,36 @@ class IMAS_CORE_LIBRARY_API ALStruct
     ALStruct& operator=(const ALStruct&) = delete;
 	
 public:
-     std::unordered_map<std::string, ALData *> dataFields;
-    std::unordered_map<std::string, ALAoS *>aosFields;
-
-    ALData *getData(std::string path);
+    ALNodePool *pool;  //Pool of the IDS, where the fields and AoS are allocated. NULL for the slices, on the heap
+    std::pmr::unordered_map<uint32_t, ALData *> dataFields;   // keyed on the interned path id (see al_path.h)
+    std::pmr::unordered_map<std::string, ALAoS *>aosFields;
+
+    ALData *getData(ALPath path);
+    //Lookups of the reads, which run concurrently: NULL when missing, nothing is created
+    ALData *findData(ALPath path);
+    ALAoS *findSubAoS(const std::string &path);
  //   void setData(std::string path, ALData &data);
     void deleteData();
+    //Removes the fields and AoS not written by the incremental put with the given stamp
+    void sweep(uint64_t stamp);
     ALAoS *getSubAoS(std::string path);
     void addSlice(ALStruct &alSlice, ArraystructContext *ctx);
     bool isAoSMapped(std::string path);
-    ALStruct *clone();
-    ALStruct()
+    //Copies the fields into the empty newStruct, sharing the data buffers and the elements of the AoS
+    void copyTo(ALStruct &newStruct);
+    size_t getBufferBytes(std::unordered_set<const unsigned char *> &seen);
+    ALStruct(ALNodePool *pool = NULL): pool(pool), dataFields(ALNodePool::resource(pool)), aosFields(ALNodePool::resource(pool))
 	{
 	}
     ~ALStruct()
     {
   	for ( auto it = dataFields.cbegin(); it != dataFields.cend(); ++it )
 	{
-	    delete it->second;
+	    ALNodePool::destroy(pool, it->second);
 	}
   	for ( auto it = aosFields.cbegin(); it != aosFields.cend(); ++it )
 	{
-	    delete it->second;
+	    ALNodePool::destroy(pool, it->second);
 	}
     }
 
@@ -322,51 +495,61 @@ class IMAS_CORE_LIBRARY_API IdsInfo
 public:
     std::string idsPath;
     ALStruct *ids;
-    IdsInfo(std::string idsPath, ALStruct *ids)
+    std::shared_mutex *idsLock;
+    IdsInfo(std::string idsPath, ALStruct *ids, std::shared_mutex *idsLock)
     {
 	this->idsPath = idsPath;
 	this->ids = ids;
+	this->idsLock = idsLock;
     }
 };
 
 
+//Content of a memory data entry, shared by all the data entries opened with the same path.
+//Each IDS has its own reader-writer lock: the calls reading an IDS run concurrently, a call writing it excludes the
+//others on the same IDS only. mutex protects the tables of IDSs, it is held briefly and never while waiting for an IDS lock
 class InternalCtx  
 {
 public:
     std::unordered_map<std::string, ALStruct *> idsMap;
-    std::unordered_map<unsigned long int, IdsInfo *> idsInfoMap;
-    pthread_mutex_t mutex;
+    //Pools of the nodes of the IDSs, keyed as idsMap. A pool outlives its IDS while slices hold some of its elements
+    std::unordered_map<std::string, std::shared_ptr<ALNodePool>> idsPools;
+    //Locks of the IDSs, keyed as idsMap. An IDS and its lock are kept until the content is closed by its last data entry
+    std::unordered_map<std::string, std::shared_mutex> idsLocks;
+    std::mutex mutex;
     int refCount;
     std::string fullName;
+    std::atomic<uint64_t> putStamp;  //Last stamp given to an incremental put of an AoS
     InternalCtx()
     {
 	refCount = 1;
-//Mutex must be recursive as readData can be called recursively
-	pthread_mutexattr_t attr;
-	pthread_mutexattr_init(&attr);
-	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-	pthread_mutex_init(&mutex, &attr);
-    }
-    ~InternalCtx()
-    {
-	pthread_mutex_destroy(&mutex);
+	putStamp = 0;
     }
     void lock()
     {
-	pthread_mutex_lock(&mutex);
+	mutex.lock();
     }
     void unlock()
     {
-	pthread_mutex_lock(&mutex);
+	mutex.unlock();
     }
    
 };
 
+//Lock of an IDS for the duration of a backend call: shared for reads, exclusive for writes. A call nested in another 
+//call of the same thread on the same IDS (readData reading the timebase, batches, ...) reuses the lock already held
+class IMAS_CORE_LIBRARY_API IdsLockGuard
+{
+    IdsLockGuard(const IdsLockGuard&) = delete;
+    IdsLockGuard& operator=(const IdsLockGuard&) = delete;
 
+    std::shared_mutex *idsLock;  //NULL when the lock was already held by the thread
+    bool exclusive;
 
-//Hash Context, addressed by exp name+shot+run. Same behavior as pulse files: new: creates a new one, open: open an existing memory content, if any report error otherwise. 
-    static std::unordered_map<std::string, InternalCtx * > ctxMap;
-
+public:
+    IdsLockGuard(std::shared_mutex *idsLock, bool exclusive);
+    ~IdsLockGuard();
+};
 
 
 
@@ -378,12 +561,34 @@ class IMAS_CORE_LIBRARY_API MemoryBackend:public Backend
 
     bool isCreated;
     InternalCtx *internalCtx;
-    //std::unordered_map<std::string, ALStruct *> idsMap;
-    //std::unordered_map<unsigned long int, IdsInfo *> idsInfoMap;
+    //IDS of the operations in progress on this data entry, keyed on the context uid
+    std::unordered_map<unsigned long int, IdsInfo *> idsInfoMap;
+
+//Hash Context, addressed by exp name+shot+run. Same behavior as pulse files: new: creates a new one, open: open an existing memory content, if any report error otherwise. 
+//Shared by all the instances (defined once in memory_backend.cpp), ctxMapMutex is only taken when opening and closing databases
+    static std::unordered_map<std::string, InternalCtx * > ctxMap;
+    static std::mutex ctxMapMutex;
 
 //currentAoS will containg the fields being written when assembing a new AoS (or AoS slice)
     ALAoS currentAos;
 
+//Incremental put (URI option incremental_put=yes): unchanged fields are not copied again and AoS are updated instead of rebuilt
+    bool incrementalPut;
+    uint64_t putStamp;  //Stamp of the current incremental put of an AoS
+    ALIncrementalPutCounters incrementalCounters;
+    uint64_t fieldsAtBeginPut;
+    uint64_t fieldsSkippedAtBeginPut;
+
+//Deduplication (URI option dedup=yes): one table per IDS path, the buffers written with equal content are shared
+    bool dedup;
+    std::unordered_map<std::string, ALDedupTable> dedupTables;
+
+    //Writes a field of a global put
+    void putData(ALData *alData, int datatype, int dim, int *size, void *data, std::string timebase, ALDedupTable *dedupTable);
+
+    //Dedup table of the IDS written by the operation, NULL when dedup is not enabled
+    ALDedupTable *getDedupTable(OperationContext *ctx);
+
 
     //Get the full pathname (internal) of the IDS root 
     std::string getIdsPath(OperationContext *ctx);
@@ -391,11 +596,21 @@ class IMAS_CORE_LIBRARY_API MemoryBackend:public Backend
     //Get the IDS (in ALStruct) 
     ALStruct *getIds(OperationContext *ctx);
 
+    //Get the IDS of an operation with its path and lock, looked up once per operation
+    IdsInfo *getIdsInfo(OperationContext *ctx);
+
+    //Lock of the IDS of an operation or AoS context
+    std::shared_mutex *getIdsLock(Context *ctx);
+
     //Get the  AoS referred to the passed ArrayStructContext. If isCurrent, then the currentAoS is considered, otherwise the corresponding AoS in the main IDS ALStruct is condiered.
     ALAoS *getAoS(ArraystructContext *ctx, bool isCurrent = false);
 
     ALData *getData(ArraystructContext *ctx, int idx, std::string path, bool isCurrent);
 
+    //Lookups of getAoS and getData for reads: NULL when missing, nothing is created
+    ALAoS *findAoS(ArraystructContext *ctx, bool isCurrent = false);
+    ALData *findData(ArraystructContext *ctx, int idx, std::string path, bool isCurrent = false);
+
 
 //Optimization info
     std::string lastIdsPath; 
@@ -410,11 +625,20 @@ public:
     MemoryBackend() 
     {
 	internalCtx = NULL;
+	incrementalPut = false;
+	putStamp = 0;
+	fieldsAtBeginPut = 0;
+	fieldsSkippedAtBeginPut = 0;
+	dedup = false;
     }
     ~MemoryBackend()
     {
 // Gabriele Sept 2020 Deallocate and remove from ctxMap the InternalCtx instance if refCount reaches 0;
-	lock();
+	for(auto &info: idsInfoMap)
+	    delete info.second;
+	if(internalCtx == NULL)  //openPulse failed
+	    return;
+	std::lock_guard<std::mutex> guard(ctxMapMutex);
 	internalCtx->refCount--;
 	if(internalCtx->refCount <= 0)
 	{
@@ -423,17 +647,22 @@ public:
 	    {
 	    	delete it->second;
 	    }
+	    ctxMap.erase(internalCtx->fullName);
+	    delete internalCtx;
 	}
-	ctxMap.erase(internalCtx->fullName);
-	delete internalCtx;
-	unlock();
     } 
     void dump(std::string ids)
     {
 //	idsMap[ids]->dump();
-        internalCtx->lock();
-	internalCtx->idsMap[ids]->dump();
+	internalCtx->lock();
+	ALStruct *alStruct = internalCtx->idsMap[ids];
+	std::shared_mutex *idsLock = &internalCtx->idsLocks[ids];
 	internalCtx->unlock();
+	if(alStruct)
+	{
+	    IdsLockGuard guard(idsLock, false);
+	    alStruct->dump();
+	}
     }
 
 
@@ -453,15 +682,19 @@ public:
 			 int mode) override
     {
 	isCreated = (mode == alconst::create_pulse || mode == alconst::force_create_pulse);
+	uri::OptionalValue incremental = ctx->getURI().query.get("incremental_put");
+	incrementalPut = incremental && (incremental.value() == "yes" || incremental.value() == "y");
+	uri::OptionalValue dedupOption = ctx->getURI().query.get("dedup");
+	dedup = dedupOption && (dedupOption.value() == "yes" || dedupOption.value() == "y");
 
     std::string fullName = ctx->getURI().query.get("path").value();
 	
-	lock();  //Global Lock
+	std::lock_guard<std::mutex> guard(ctxMapMutex);  //Global Lock
 	try {
 	    internalCtx = ctxMap.at(fullName);
 	    if(mode == alconst::create_pulse)
 	    {
-		unlock();
+		internalCtx = NULL;
 		throw  ALBackendException("CreatePulse: a pulse file already exists",LOG);
 	    }
 	    internalCtx->refCount++;
@@ -475,22 +708,23 @@ public:
 	    }
             else
 	    {
-		unlock();
 		throw  ALBackendException("Missing pulse",LOG);
 	    }
 	}
 	if (mode == alconst::force_create_pulse)  //Empty previous content, if any
 	{
-   	    internalCtx->lock();
-
+	    //The IDSs are emptied under their lock, and kept since other data entries may be using them
+	    internalCtx->lock();
+	    std::vector<std::pair<ALStruct *, std::shared_mutex *>> idsV;
 	    for ( auto it = internalCtx->idsMap.cbegin(); it != internalCtx->idsMap.cend(); ++it )
-	    {
-		delete it->second;
-	    }  
-	    internalCtx->idsMap.clear();
+		idsV.push_back({it->second, &internalCtx->idsLocks[it->first]});
 	    internalCtx->unlock();
+	    for(auto &ids: idsV)
+	    {
+		IdsLockGuard guard(ids.second, true);
+		ids.first->deleteData();
+	    }
 	}
-	unlock();
     }
 
   /**
@@ -509,16 +743,16 @@ public:
     }
 
      virtual void writeData(OperationContext *ctx,
-			   std::string fieldname,
-			   std::string timebase,
+			   ALPath fieldname,
+			   ALPath timebase,
 			   void* data,
 			   int datatype,
 			   int dim,
 			   int* size);
 
     void writeData(Context *ctx,
-			   std::string fieldname,
-			   std::string timebase,
+			   ALPath fieldname,
+			   ALPath timebase,
 			   void* data,
 			   int datatype,
 			   int dim,
@@ -532,15 +766,15 @@ public:
     }
     
    virtual int readData(OperationContext *ctx,
-			  std::string fieldname,
-			  std::string timebase,
+			  ALPath fieldname,
+			  ALPath timebase,
 			  void** data,
 			  int* datatype,
 			  int* dim,
 			  int* size);
     int readData(Context *ctx,
-			  std::string fieldname,
-			  std::string timebase,
+			  ALPath fieldname,
+			  ALPath timebase,
 			  void** data,
 			  int* datatype,
 			  int* dim,
@@ -552,6 +786,25 @@ public:
 	else
     	    return readData((OperationContext *)ctx, fieldname, timebase, data, datatype, dim, size);
     }
+    int readDataInto(Context *ctx,
+			  ALPath fieldname,
+			  ALPath timebase,
+			  void* dst,
+			  size_t capacity,
+			  void** data,
+			  int* datatype,
+			  int* dim,
+			  int* size) override;
+    int readDataShape(Context *ctx,
+			  ALPath fieldname,
+			  ALPath timebase,
+			  int* datatype,
+			  int* dim,
+			  int* size) override;
+    void writeDataBatch(Context *ctx,
+			std::vector<DataBatchItem> &items) override;
+    void readDataBatch(Context *ctx,
+			std::vector<DataBatchItem> &items) override;
   /*
     Deletes data.
     This function deletes some data (can be a signal, a structure, the whole DATAOBJECT) in the database 
@@ -600,8 +853,8 @@ public:
      @throw BackendException
   */
   virtual void putInArraystruct(ArraystructContext *ctx,
-				std::string fieldname,
-				std::string timebase,  //Gabriele 2017: Added to handle time dependent signals as firlds of static AoS
+				ALPath fieldname,
+				ALPath timebase,  //Gabriele 2017: Added to handle time dependent signals as firlds of static AoS
 				int idx,
 				void* data,
 				int datatype,
@@ -625,8 +878,8 @@ public:
      @throw BackendException
   */
     virtual int getFromArraystruct(ArraystructContext *ctx,
-				  std::string fieldname,
-				  std::string timebase,
+				  ALPath fieldname,
+				  ALPath timebase,
 				  int idx,
 				  void** data,
 				  int* datatype,
@@ -651,14 +904,14 @@ public:
     void flushAoS(OperationContext *ctx, std::string fieldName, ALAoS &alAos);
     void recFlushAoS(ALAoS &alAos, OperationContext *opCtx, ArraystructContext *ctx);
     int getFromAoS(ArraystructContext *ctx,
-					std::string fieldname,
+					ALPath fieldname,
 					int idx,
 					void** data,
 					int* datatype,
 					int* dim,
 					int* size);
     int getSliceFromAoS(ArraystructContext *ctx,
-					std::string fieldname,
+					ALPath fieldname,
 					int idx,
 					void** data,
 					int* datatype,
@@ -667,13 +920,19 @@ public:
 	
     void prepareSlice(ArraystructContext *ctx);
     ALStruct *prepareSliceRec(ArraystructContext *ctx, ALStruct &alStruct, ALStruct &ids, double time, std::vector<StructPath> &parentV, ALAoS *aos);
-	std::vector<double> getTimebaseVect(std::string path, std::vector<StructPath> &ctxV, ALAoS *aos = NULL);
+	const std::vector<double> &getTimebaseVect(std::string path, std::vector<StructPath> &ctxV, ALAoS *aos = NULL);
     void getSliceIdxs(std::string path, double time, std::vector<StructPath> &ctxV, int &sliceIdx1, int &sliceIdx2, ALAoS *aos = NULL);
     ALData *getAlSlice(ArraystructContext *ctx, ALData &inData, double time);
-    ALData *getAlSlice(ArraystructContext *ctx, ALData &inData, double time, std::vector<double> timebaseV);
+    ALData *getAlSlice(ArraystructContext *ctx, ALData &inData, double time, const std::vector<double> &timebaseV);
 
 	void get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) override;
 
+	void getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage) override;
+
+	bool getIncrementalPutCounters(DataEntryContext *ctx, ALIncrementalPutCounters &counters) override;
+
+	bool getDedupCounters(DataEntryContext *ctx, ALDedupCounters &counters) override;
+
 	bool supportsTimeDataInterpolation() {
       return false;
     }
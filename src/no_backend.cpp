@@ -32,8 +32,8 @@ void NoBackend::endAction(Context *ctx)
 } 
 
 void NoBackend::writeData(Context *ctx,
-			  std::string fieldname,
-			  std::string timebasename,
+			  ALPath fieldname,
+			  ALPath timebasename,
 			  void* data,
 			  int datatype,
 			  int dim,
@@ -44,8 +44,8 @@ void NoBackend::writeData(Context *ctx,
 }
 
 int NoBackend::readData(Context *ctx,
-			std::string fieldname,
-			std::string timebasename,
+			ALPath fieldname,
+			ALPath timebasename,
 			void** data,
 			int* datatype,
 			int* dim,
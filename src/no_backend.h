@@ -39,16 +39,16 @@ public:
   void endAction(Context *ctx);
 
   void writeData(Context *ctx,
-		 std::string fieldname,
-		 std::string timebasename,
+		 ALPath fieldname,
+		 ALPath timebasename,
 		 void* data,
 		 int datatype,
 		 int dim,
 		 int* size);
 
   int readData(Context *ctx,
-	       std::string fieldname,
-	       std::string timebasename,
+	       ALPath fieldname,
+	       ALPath timebasename,
 	       void** data,
 	       int* datatype,
 	       int* dim,
@@ -0,0 +1,302 @@
+#include "profiling_backend.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+
+
+static bool readEnabledFlag()
+{
+  const char *profile = getenv("IMAS_AL_PROFILE");
+  const char *statistics = getenv("IMAS_AL_STATISTICS");
+  return (profile != NULL && profile[0] != '\0') ||
+    (statistics != NULL && strcmp(statistics, "TRUE") == 0);
+}
+
+std::atomic<bool> ALStatistics::enabled(readEnabledFlag());
+
+void ALStatistics::latchEnabledFlag()
+{
+  enabled = readEnabledFlag();
+}
+
+const char* ALStatistics::callName(Call call)
+{
+  static const char* names[NB_CALLS] = {
+    "al_begin_dataentry_action", "al_begin_global_action", "al_begin_slice_action",
+    "al_begin_timerange_action", "al_begin_arraystruct_action", "al_read_data", "al_write_data",
+    "al_end_action",
+    "getVersion", "openPulse", "closePulse", "beginAction", "endAction", "writeData", "readData",
+    "readDataInto", "readDataShape", "writeDataBatch", "readDataBatch", "deleteData",
+    "beginArraystructAction", "get_occurrences"
+  };
+  return names[call];
+}
+
+std::string ALStatistics::idsName(Context *ctx)
+{
+  if (ctx == NULL)
+    return "";
+  switch (ctx->getType())
+    {
+    case CTX_OPERATION_TYPE:
+      return static_cast<OperationContext *>(ctx)->getDataobjectName();
+    case CTX_ARRAYSTRUCT_TYPE:
+      return static_cast<ArraystructContext *>(ctx)->getOperationContext()->getDataobjectName();
+    default:
+      return "";
+    }
+}
+
+void ALStatistics::record(Call call, const std::string &ids, uint64_t ns, size_t bytesRead, size_t bytesWritten)
+{
+  int bucket = 0;
+  for (uint64_t v = ns; v != 0 && bucket < NB_BUCKETS - 1; v >>= 1)
+    bucket++;
+
+  std::lock_guard<std::mutex> guard(mutex);
+  auto got = entries.find(ids);
+  if (got == entries.end())
+    got = entries.emplace(ids, std::array<Entry, NB_CALLS>()).first;
+  Entry &e = got->second[call];
+  e.count++;
+  e.totalNs += ns;
+  if (ns < e.minNs)
+    e.minNs = ns;
+  if (ns > e.maxNs)
+    e.maxNs = ns;
+  e.bytesRead += bytesRead;
+  e.bytesWritten += bytesWritten;
+  e.histogram[bucket]++;
+}
+
+static std::string jsonString(const std::string &s)
+{
+  std::string out = "\"";
+  for (char c : s)
+    {
+      if (c == '"' || c == '\\')
+	out += '\\';
+      if ((unsigned char)c < 0x20)
+	{
+	  char esc[8];
+	  snprintf(esc, sizeof(esc), "\\u%04x", c);
+	  out += esc;
+	}
+      else
+	out += c;
+    }
+  return out + "\"";
+}
+
+std::string ALStatistics::toJSON(DataEntryContext *ctx) const
+{
+  std::ostringstream json;
+  json << "{\"uri\": " << jsonString(ctx ? ctx->getURI().to_string() : "")
+       << ", \"backend_id\": " << (ctx ? ctx->getBackendID() : -1)
+       << ", \"backend\": " << jsonString(ctx ? ctx->getBackendName() : "")
+       << ", \"calls\": [";
+
+  std::lock_guard<std::mutex> guard(mutex);
+  bool first = true;
+  for (const auto &kv : entries)
+    {
+      for (int call = 0; call < NB_CALLS; call++)
+	{
+	  const Entry &e = kv.second[call];
+	  if (e.count == 0)
+	    continue;
+	  json << (first ? "" : ", ")
+	       << "{\"call\": \"" << callName((Call)call) << "\""
+	       << ", \"ids\": " << jsonString(kv.first)
+	       << ", \"count\": " << e.count
+	       << ", \"total_ns\": " << e.totalNs
+	       << ", \"mean_ns\": " << e.totalNs / e.count
+	       << ", \"min_ns\": " << e.minNs
+	       << ", \"max_ns\": " << e.maxNs
+	       << ", \"bytes_read\": " << e.bytesRead
+	       << ", \"bytes_written\": " << e.bytesWritten
+	       << ", \"histogram_ns\": {";
+	  // keys are the (exclusive) upper bounds of the buckets
+	  bool firstBucket = true;
+	  for (int b = 0; b < NB_BUCKETS; b++)
+	    {
+	      if (e.histogram[b] == 0)
+		continue;
+	      json << (firstBucket ? "" : ", ") << "\"" << (1ULL << b) << "\": " << e.histogram[b];
+	      firstBucket = false;
+	    }
+	  json << "}}";
+	  first = false;
+	}
+    }
+  json << "]}";
+  return json.str();
+}
+
+
+/**
+   Times a backend call and records it when going out of scope, also when the call throws.
+*/
+class ProfilingScope
+{
+public:
+  ProfilingScope(ALStatistics &s, ALStatistics::Call c, Context *ctx)
+    : stats(s), call(c), ids(ALStatistics::idsName(ctx)), start(ALStatistics::now()) {}
+
+  ~ProfilingScope()
+  {
+    stats.record(call, ids, ALStatistics::now() - start, bytesRead, bytesWritten);
+  }
+
+  size_t bytesRead = 0;
+  size_t bytesWritten = 0;
+
+private:
+  ALStatistics &stats;
+  ALStatistics::Call call;
+  std::string ids;
+  uint64_t start;
+};
+
+
+std::pair<int,int> ProfilingBackend::getVersion(DataEntryContext *ctx)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_GET_VERSION, ctx);
+  return target->getVersion(ctx);
+}
+
+void ProfilingBackend::openPulse(DataEntryContext *ctx,
+				 int mode)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_OPEN_PULSE, ctx);
+  target->openPulse(ctx, mode);
+}
+
+void ProfilingBackend::closePulse(DataEntryContext *ctx,
+				  int mode)
+{
+  {
+    ProfilingScope scope(statistics, ALStatistics::BE_CLOSE_PULSE, ctx);
+    target->closePulse(ctx, mode);
+  }
+
+  const char *profile = getenv("IMAS_AL_PROFILE");
+  if (profile != NULL && profile[0] != '\0')
+    {
+      // one JSON report per line, so that several data entries can share the file
+      std::ofstream report(profile, std::ios::app);
+      if (report)
+	report << statistics.toJSON(ctx) << std::endl;
+      else
+	std::cerr << "Warning: cannot write access layer profile to " << profile << std::endl;
+    }
+}
+
+void ProfilingBackend::beginAction(OperationContext *ctx)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_BEGIN_ACTION, ctx);
+  target->beginAction(ctx);
+}
+
+void ProfilingBackend::endAction(Context *ctx)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_END_ACTION, ctx);
+  target->endAction(ctx);
+}
+
+void ProfilingBackend::writeData(Context *ctx,
+				 ALPath fieldname,
+				 ALPath timebasename,
+				 void* data,
+				 int datatype,
+				 int dim,
+				 int* size)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_WRITE_DATA, ctx);
+  target->writeData(ctx, fieldname, timebasename, data, datatype, dim, size);
+  scope.bytesWritten = getDataByteSize(datatype, dim, size);
+}
+
+int ProfilingBackend::readData(Context *ctx,
+			       ALPath fieldname,
+			       ALPath timebasename,
+			       void** data,
+			       int* datatype,
+			       int* dim,
+			       int* size)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_READ_DATA, ctx);
+  int found = target->readData(ctx, fieldname, timebasename, data, datatype, dim, size);
+  if (found)
+    scope.bytesRead = getDataByteSize(*datatype, *dim, size);
+  return found;
+}
+
+int ProfilingBackend::readDataInto(Context *ctx,
+				   ALPath fieldname,
+				   ALPath timebasename,
+				   void* dst,
+				   size_t capacity,
+				   void** data,
+				   int* datatype,
+				   int* dim,
+				   int* size)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_READ_DATA_INTO, ctx);
+  int found = target->readDataInto(ctx, fieldname, timebasename, dst, capacity, data, datatype, dim, size);
+  if (found)
+    scope.bytesRead = getDataByteSize(*datatype, *dim, size);
+  return found;
+}
+
+int ProfilingBackend::readDataShape(Context *ctx,
+				    ALPath fieldname,
+				    ALPath timebasename,
+				    int* datatype,
+				    int* dim,
+				    int* size)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_READ_DATA_SHAPE, ctx);
+  return target->readDataShape(ctx, fieldname, timebasename, datatype, dim, size);
+}
+
+void ProfilingBackend::writeDataBatch(Context *ctx,
+				      std::vector<DataBatchItem> &items)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_WRITE_DATA_BATCH, ctx);
+  target->writeDataBatch(ctx, items);
+  for (const auto &item : items)
+    scope.bytesWritten += getDataByteSize(item.datatype, item.dim, item.size);
+}
+
+void ProfilingBackend::readDataBatch(Context *ctx,
+				     std::vector<DataBatchItem> &items)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_READ_DATA_BATCH, ctx);
+  target->readDataBatch(ctx, items);
+  for (const auto &item : items)
+    if (item.found)
+      scope.bytesRead += getDataByteSize(item.datatype, item.dim, item.size);
+}
+
+void ProfilingBackend::deleteData(OperationContext *ctx,
+				  std::string path)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_DELETE_DATA, ctx);
+  target->deleteData(ctx, path);
+}
+
+void ProfilingBackend::beginArraystructAction(ArraystructContext *ctx,
+					      int *size)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_BEGIN_ARRAYSTRUCT_ACTION, ctx);
+  target->beginArraystructAction(ctx, size);
+}
+
+void ProfilingBackend::get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size)
+{
+  ProfilingScope scope(statistics, ALStatistics::BE_GET_OCCURRENCES, ctx);
+  target->get_occurrences(ctx, ids_name, occurrences_list, size);
+}
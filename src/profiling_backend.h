@@ -0,0 +1,201 @@
+//-*-c++-*-
+
+#ifndef PROFILING_BACKEND_H
+#define PROFILING_BACKEND_H 1
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "al_backend.h"
+
+#if defined(_WIN32)
+#  define IMAS_CORE_LIBRARY_API __declspec(dllexport)
+#else
+#  define IMAS_CORE_LIBRARY_API
+#endif
+
+#ifdef __cplusplus
+
+/**
+   Per data entry call statistics.
+   Counts, cumulated and extreme latencies, log2 latency histograms and transferred bytes,
+   recorded per call and per IDS name. Statistics are collected only when the environment
+   variable IMAS_AL_PROFILE (name of the report file) is set or IMAS_AL_STATISTICS=TRUE.
+*/
+class IMAS_CORE_LIBRARY_API ALStatistics
+{
+public:
+  enum Call {
+    // lowlevel API
+    AL_BEGIN_DATAENTRY_ACTION, AL_BEGIN_GLOBAL_ACTION, AL_BEGIN_SLICE_ACTION,
+    AL_BEGIN_TIMERANGE_ACTION, AL_BEGIN_ARRAYSTRUCT_ACTION, AL_READ_DATA, AL_WRITE_DATA,
+    AL_END_ACTION,
+    // Backend virtuals
+    BE_GET_VERSION, BE_OPEN_PULSE, BE_CLOSE_PULSE, BE_BEGIN_ACTION, BE_END_ACTION, BE_WRITE_DATA,
+    BE_READ_DATA, BE_READ_DATA_INTO, BE_READ_DATA_SHAPE, BE_WRITE_DATA_BATCH, BE_READ_DATA_BATCH,
+    BE_DELETE_DATA, BE_BEGIN_ARRAYSTRUCT_ACTION, BE_GET_OCCURRENCES,
+    NB_CALLS
+  };
+
+  static const int NB_BUCKETS = 40;     /**< bucket i counts latencies in [2^(i-1), 2^i) ns */
+
+  static std::atomic<bool> enabled;     /**< statistics requested through the environment */
+
+  /**
+     Reads IMAS_AL_PROFILE and IMAS_AL_STATISTICS again.
+  */
+  static void latchEnabledFlag();
+
+  /**
+     Returns the name of a call, as reported in the JSON output.
+  */
+  static const char* callName(Call call);
+
+  /**
+     Returns the name of the IDS targeted by a context ("" for data entry contexts).
+  */
+  static std::string idsName(Context *ctx);
+
+  static uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	     std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+     Records one call.
+     @param[in] call called function
+     @param[in] ids name of the targeted IDS
+     @param[in] ns duration of the call in nanoseconds
+     @param[in] bytesRead number of bytes returned to the caller
+     @param[in] bytesWritten number of bytes passed by the caller
+  */
+  void record(Call call, const std::string &ids, uint64_t ns, size_t bytesRead = 0, size_t bytesWritten = 0);
+
+  /**
+     Serializes the statistics collected so far into a JSON object.
+     @param[in] ctx data entry context, used to describe the backend
+  */
+  std::string toJSON(DataEntryContext *ctx) const;
+
+private:
+  struct Entry
+  {
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t minNs = UINT64_MAX;
+    uint64_t maxNs = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t histogram[NB_BUCKETS] = {};
+  };
+
+  mutable std::mutex mutex;
+  std::map<std::string, std::array<Entry, NB_CALLS>, std::less<>> entries;   /**< key = IDS name */
+};
+
+
+/**
+   Backend decorator collecting ALStatistics.
+   Installed by Backend::initBackend in front of the selected backend when statistics are
+   enabled. Every Backend virtual is timed and forwarded to the target backend. When
+   IMAS_AL_PROFILE is set, a JSON report is appended to that file at closePulse.
+*/
+class IMAS_CORE_LIBRARY_API ProfilingBackend : public Backend
+{
+private:
+  Backend *target;
+  ALStatistics statistics;
+
+public:
+
+  ProfilingBackend(Backend *targetB) : target(targetB) {}
+
+  ~ProfilingBackend() { delete target; }
+
+  ALStatistics& getStatistics() { return statistics; }
+
+  Backend* getTarget() { return target; }
+
+  std::pair<int,int> getVersion(DataEntryContext *ctx) override;
+
+  void openPulse(DataEntryContext *ctx,
+		 int mode) override;
+
+  void closePulse(DataEntryContext *ctx,
+		  int mode) override;
+
+  void beginAction(OperationContext *ctx) override;
+
+  void endAction(Context *ctx) override;
+
+  void writeData(Context *ctx,
+		 ALPath fieldname,
+		 ALPath timebasename,
+		 void* data,
+		 int datatype,
+		 int dim,
+		 int* size) override;
+
+  int readData(Context *ctx,
+	       ALPath fieldname,
+	       ALPath timebasename,
+	       void** data,
+	       int* datatype,
+	       int* dim,
+	       int* size) override;
+
+  int readDataInto(Context *ctx,
+		   ALPath fieldname,
+		   ALPath timebasename,
+		   void* dst,
+		   size_t capacity,
+		   void** data,
+		   int* datatype,
+		   int* dim,
+		   int* size) override;
+
+  int readDataShape(Context *ctx,
+		    ALPath fieldname,
+		    ALPath timebasename,
+		    int* datatype,
+		    int* dim,
+		    int* size) override;
+
+  void writeDataBatch(Context *ctx,
+		      std::vector<DataBatchItem> &items) override;
+
+  void readDataBatch(Context *ctx,
+		     std::vector<DataBatchItem> &items) override;
+
+  void deleteData(OperationContext *ctx,
+		  std::string path) override;
+
+  void beginArraystructAction(ArraystructContext *ctx,
+			      int *size) override;
+
+  void get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) override;
+
+  void getMemoryUsage(DataEntryContext *ctx, ALMemoryUsage &usage) override { target->getMemoryUsage(ctx, usage); }
+
+  bool getIncrementalPutCounters(DataEntryContext *ctx, ALIncrementalPutCounters &counters) override
+  { return target->getIncrementalPutCounters(ctx, counters); }
+
+  bool getDedupCounters(DataEntryContext *ctx, ALDedupCounters &counters) override
+  { return target->getDedupCounters(ctx, counters); }
+
+  bool supportsTimeDataInterpolation() override { return target->supportsTimeDataInterpolation(); }
+
+  void initDataInterpolationComponent() override { target->initDataInterpolationComponent(); }
+
+  bool supportsTimeRangeOperation() override { return target->supportsTimeRangeOperation(); }
+};
+
+#endif
+
+#endif
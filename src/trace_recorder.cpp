@@ -0,0 +1,85 @@
+#include "trace_recorder.h"
+
+#include <iostream>
+#include <string.h>
+
+
+static std::string readTraceFileName()
+{
+  const char *trace = getenv("IMAS_AL_TRACE");
+  return (trace != NULL) ? trace : "";
+}
+
+static bool readPayloadsFlag()
+{
+  const char *flag = getenv("IMAS_AL_TRACE_PAYLOAD");
+  return flag != NULL && strcmp(flag, "TRUE") == 0;
+}
+
+std::atomic<bool> ALTraceRecorder::enabled(!readTraceFileName().empty());
+std::atomic<bool> ALTraceRecorder::payloads(readPayloadsFlag());
+std::mutex ALTraceRecorder::mutex;
+FILE *ALTraceRecorder::file = NULL;
+std::string ALTraceRecorder::fileName;
+std::string ALTraceRecorder::requestedFileName = readTraceFileName();
+uint64_t ALTraceRecorder::origin = 0;
+
+// closes the trace file at exit, so that buffered records are not lost
+static struct TraceFileCloser
+{
+  ~TraceFileCloser() { ALTraceRecorder::flush(); }
+} traceFileCloser;
+
+void ALTraceRecorder::latchEnabledFlag()
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  requestedFileName = readTraceFileName();
+  enabled = !requestedFileName.empty();
+  payloads = readPayloadsFlag();
+}
+
+void ALTraceRecorder::record(altrace::Op op, uint64_t start, uint64_t duration, int status, const std::string &body)
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  if (requestedFileName.empty())
+    return;
+  if (file == NULL || requestedFileName != fileName)
+    {
+      // a new trace file was requested by the environment when opening a data entry
+      if (file != NULL)
+	fclose(file);
+      fileName = requestedFileName;
+      file = fopen(fileName.c_str(), "wb");
+      if (file == NULL)
+	{
+	  std::cerr << "Warning: cannot write access layer trace to " << fileName << std::endl;
+	  requestedFileName.clear();
+	  enabled = false;
+	  return;
+	}
+      origin = start;
+      fwrite(altrace::MAGIC, 1, sizeof(altrace::MAGIC), file);
+      fwrite(&altrace::VERSION, sizeof(uint32_t), 1, file);
+      fwrite(&altrace::ENDIAN_MARKER, sizeof(uint32_t), 1, file);
+    }
+
+  uint8_t code = op;
+  uint32_t size = body.size();
+  uint64_t relStart = (start > origin) ? start - origin : 0;
+  int32_t st = status;
+  fwrite(&code, sizeof(code), 1, file);
+  fwrite(&size, sizeof(size), 1, file);
+  fwrite(&relStart, sizeof(relStart), 1, file);
+  fwrite(&duration, sizeof(duration), 1, file);
+  fwrite(&st, sizeof(st), 1, file);
+  fwrite(body.data(), 1, body.size(), file);
+  if (op == altrace::TR_CLOSE_PULSE)
+    fflush(file);
+}
+
+void ALTraceRecorder::flush()
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  if (file != NULL)
+    fflush(file);
+}
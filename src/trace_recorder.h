@@ -0,0 +1,64 @@
+//-*-c++-*-
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H 1
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "al_trace.h"
+
+#if defined(_WIN32)
+#  define IMAS_CORE_LIBRARY_API __declspec(dllexport)
+#else
+#  define IMAS_CORE_LIBRARY_API
+#endif
+
+#ifdef __cplusplus
+
+/**
+   Recorder of lowlevel access traces (see al_trace.h for the format).
+   Recording is enabled by setting the environment variable IMAS_AL_TRACE to the name of the
+   trace file, which is overwritten by the first recorded call of the process. Data payloads
+   of writes are only recorded when IMAS_AL_TRACE_PAYLOAD=TRUE.
+*/
+class IMAS_CORE_LIBRARY_API ALTraceRecorder
+{
+public:
+  static std::atomic<bool> enabled;     /**< IMAS_AL_TRACE is set */
+  static std::atomic<bool> payloads;    /**< IMAS_AL_TRACE_PAYLOAD=TRUE */
+
+  /**
+     Reads IMAS_AL_TRACE and IMAS_AL_TRACE_PAYLOAD again.
+  */
+  static void latchEnabledFlag();
+
+  /**
+     Appends one record to the trace file.
+     @param[in] op traced call
+     @param[in] start start of the call (steady clock, in ns)
+     @param[in] duration duration of the call in ns
+     @param[in] status returned status code
+     @param[in] body encoded arguments and results of the call
+  */
+  static void record(altrace::Op op, uint64_t start, uint64_t duration, int status, const std::string &body);
+
+  /**
+     Flushes the trace file, called when data entries are closed.
+  */
+  static void flush();
+
+private:
+  static std::mutex mutex;
+  static FILE *file;
+  static std::string fileName;            /**< name of the open trace file */
+  static std::string requestedFileName;   /**< value of IMAS_AL_TRACE */
+  static uint64_t origin;                 /**< start of the first record */
+};
+
+#endif
+
+#endif
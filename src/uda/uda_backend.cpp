@@ -75,12 +75,12 @@ std::string array_path(Context* ctx, bool for_dim = false)
  * Unpack the data returned from UDA as a NodeReader object.
  *
  * The NodeReader object allows deserialisation of the Capn Proto serialised data using the uda_capnp_read_data
- * function. This is used to read the data into a newly malloced array buffer returned via the `data` argument.
+ * function. This is used to read the data into a new array buffer (see ALAllocator) returned via the `data` argument.
  *
  * @tparam T the type of the data being unpacked
  * @param node the `NodeReader` from which the data is being unpacked
  * @param shape the shape of the data being unpacked
- * @param data [OUT] a pointer to the buffer which is malloced and then populated with the unpacked data
+ * @param data [OUT] a pointer to the buffer which is allocated with ALAllocator and then populated with the unpacked data
  * @param dim [OUT] the rank of the data being returned
  * @param size [OUT] array of dimension sizes
  */
@@ -109,7 +109,7 @@ void unpack_data(NodeReader* node,
 
     const size_t num_slices = uda_capnp_read_num_slices(node);
     const size_t buffer_size = node_count * sizeof(T);
-    *data = malloc(buffer_size);
+    *data = ALAllocator::allocate(buffer_size);
     const auto buffer = static_cast<char*>(*data);
     size_t offset = 0;
 
@@ -141,7 +141,7 @@ void unpack_data(NodeReader* node,
  * @param path the data path to check against the name of the node
  * @param tree [IN] the `TreeReader` from which the capnp tree is being read
  * @param node [IN] the `NodeReader` from which the data is being unpacked
- * @param data [OUT] a pointer to the buffer which is malloced and then populated with the unpacked data
+ * @param data [OUT] a pointer to the buffer which is allocated with ALAllocator and then populated with the unpacked data
  * @param datatype [OUT] the type of the data being returned
  * @param dim [OUT] the rank of the data being returned
  * @param size [OUT] array of dimension sizes
@@ -509,6 +509,8 @@ void UDABackend::openPulse(DataEntryContext* ctx,
     std::string backend = get_backend(query);
     query.remove("backend");
     query.remove("cache_mode");
+    query.remove("cache");
+    query.remove("cache_size");
     query.remove("verbose");
     std::string dd_version = query.get("dd_version").value_or(dd_version_);
     query.set("dd_version", dd_version);
@@ -554,6 +556,8 @@ void UDABackend::closePulse(DataEntryContext* ctx,
     std::string backend = get_backend(query);
     query.remove("backend");
     query.remove("cache_mode");
+    query.remove("cache");
+    query.remove("cache_size");
     query.remove("verbose");
     std::string dd_version = query.get("dd_version").value_or(dd_version_);
     query.set("dd_version", dd_version);
@@ -584,19 +588,19 @@ T* read_data_from_cache(imas::uda::CacheData& cache_data, int rank)
     size_t count = std::accumulate(cache_data.shape.begin(), cache_data.shape.end(), 1, std::multiplies<size_t>());
     auto& vec = boost::get<std::vector<T>>(cache_data.values);
     if (rank == 0) {
-        auto d = (T*)malloc(sizeof(T));
+        auto d = (T*)ALAllocator::allocate(sizeof(T));
         *d = vec[0];
         return d;
     } else {
-        auto d = (T*)malloc(sizeof(T) * count);
+        auto d = (T*)ALAllocator::allocate(sizeof(T) * count);
         memcpy(d, vec.data(), sizeof(T) * count);
         return d;
     }
 }
 
 int UDABackend::readData(Context* ctx,
-                         std::string fieldname,
-                         std::string timebasename,
+                         ALPath fieldname,
+                         ALPath timebasename,
                          void** data,
                          int* datatype,
                          int* dim,
@@ -606,7 +610,7 @@ int UDABackend::readData(Context* ctx,
         return local_backend_->readData(ctx, fieldname, timebasename, data, datatype, dim, size);
     }
 
-    auto path = array_path(ctx) + "/" + fieldname;
+    auto path = array_path(ctx) + "/" + fieldname.str();
 
     if (verbose_) {
         std::cout << "UDABackend readData:" << path << "\n";
@@ -951,6 +955,8 @@ void UDABackend::beginArraystructAction(ArraystructContext* ctx, int* size)
         std::string backend = get_backend(query);
         query.remove("backend");
         query.remove("cache_mode");
+        query.remove("cache");
+        query.remove("cache_size");
         query.remove("verbose");
         std::string dd_version = query.get("dd_version").value_or(dd_version_);
         query.set("dd_version", dd_version);
@@ -1019,12 +1025,17 @@ void UDABackend::beginAction(OperationContext* op_ctx)
             cache_.clear();
 
             if (path.empty()) {
-                path = ids;
+                populate_cache(ids, ids, entry_ctx, op_ctx);
             } else {
-                path = ids + "/" + path;
+                // only the subtrees of the datapath are requested (indices are kept, see generate_ids_paths)
+                std::vector<std::string> prefixes;
+                boost::split(prefixes, path, boost::is_any_of(";"), boost::token_compress_on);
+                for (const auto& prefix : prefixes) {
+                    if (!prefix.empty()) {
+                        populate_cache(ids, ids + "/" + prefix, entry_ctx, op_ctx);
+                    }
+                }
             }
-
-            populate_cache(ids, path, entry_ctx, op_ctx);
         }
     }
     // else {
@@ -1097,7 +1108,7 @@ void UDABackend::endAction(Context* ctx)
 }
 
 void
-UDABackend::writeData(Context* ctx, std::string fieldname, std::string timebasename, void* data, int datatype, int dim,
+UDABackend::writeData(Context* ctx, ALPath fieldname, ALPath timebasename, void* data, int datatype, int dim,
                       int* size)
 {
     if (access_local_) {
@@ -1257,6 +1268,22 @@ std::vector<int> read_occurrences(NodeReader *node) {
 
 } // anon namespace
 
+void UDABackend::getMemoryUsage(DataEntryContext* ctx, ALMemoryUsage& usage)
+{
+    if (access_local_) {
+        return local_backend_->getMemoryUsage(ctx, usage);
+    }
+
+    // the cache holds the IDS being read, its entries are keyed by path within the IDS
+    size_t bytes = 0;
+    for (const auto& entry : cache_) {
+        bytes += entry.first.capacity() + entry.second.shape.capacity() * sizeof(int);
+        bytes += boost::apply_visitor([](const auto& values) { return values.capacity() * sizeof(values[0]); },
+                                      entry.second.values);
+    }
+    usage.add("uda_cache", "", bytes);
+}
+
 void UDABackend::get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) {
     if (access_local_) {
         return local_backend_->get_occurrences(ctx, ids_name, occurrences_list, size);
@@ -1270,6 +1297,8 @@ void UDABackend::get_occurrences(Context* ctx, const char* ids_name, int** occur
     std::string backend = get_backend(query);
     query.remove("backend");
     query.remove("cache_mode");
+    query.remove("cache");
+    query.remove("cache_size");
     query.remove("verbose");
     std::string dd_version = query.get("dd_version").value_or(dd_version_);
     query.set("dd_version", dd_version);
@@ -160,16 +160,16 @@ public:
     void endAction(Context *ctx) override;
 
     void writeData(Context *ctx,
-                   std::string fieldname,
-                   std::string timebasename,
+                   ALPath fieldname,
+                   ALPath timebasename,
                    void* data,
                    int datatype,
                    int dim,
                    int* size) override;
 
     int readData(Context *ctx,
-                  std::string fieldname,
-                  std::string timebasename,
+                  ALPath fieldname,
+                  ALPath timebasename,
                   void** data,
                   int* datatype,
                   int* dim,
@@ -184,6 +184,8 @@ public:
 
     void get_occurrences(Context* ctx, const char* ids_name, int** occurrences_list, int* size) override;
 
+    void getMemoryUsage(DataEntryContext* ctx, ALMemoryUsage& usage) override;
+
     bool supportsTimeDataInterpolation();
 
     // Do nothing, UDA plugin will need to initDataInterpolationComponent on data backend when it knows which backend
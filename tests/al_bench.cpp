@@ -0,0 +1,605 @@
+/*
+  Cross-backend benchmark suite.
+
+  Synthetic IDSs shaped like core_profiles (time dependent AoS of 1D profiles,
+  with nested ion/state AoS), equilibrium (time slices holding 1D profiles and
+  an AoS of 2D maps) and summary (many 1D time traces) are written and read
+  back through each requested backend with put, get, put_slice, get_slice and
+  get_sample (time range) operations.
+
+  All data are generated deterministically from the options, so that two runs
+  with the same options write the same bytes. The report is a JSON document
+  holding the options, one result per (backend, IDS, operation) with the
+  number of samples, transferred bytes, throughput and latency percentiles,
+  and the peak resident set size of the process. Operations that a backend
+  does not support are reported with their error message instead of
+  aborting the run.
+
+  usage: al-bench [--slices N] [--aos N] [--points N] [--depth N] [--repeat N]
+                  [--backends memory,hdf5,flexbuffers,ascii,no]
+                  [--ids core_profiles,equilibrium,summary]
+                  [--dir DIR] [--out FILE]
+*/
+
+#include <al_lowlevel.h>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Options
+{
+  int slices = 10;     // number of time slices
+  int aos = 4;         // size of the non time dependent AoS
+  int points = 100;    // size of the profiles (and of each dimension of the 2D maps)
+  int depth = 2;       // number of nested AoS levels below core_profiles/profiles_1d
+  int repeat = 5;      // number of samples per operation
+  std::vector<std::string> backends = {"memory", "hdf5", "flexbuffers", "ascii", "no"};
+  std::vector<std::string> ids = {"core_profiles", "equilibrium", "summary"};
+  std::string dir = ".";
+  std::string out;
+};
+
+struct Result
+{
+  std::string backend, ids, operation;
+  std::string error;
+  std::vector<double> latencies;   // seconds, one per sample
+  size_t bytes = 0;                // transferred bytes over all samples
+};
+
+class BenchError : public std::runtime_error
+{
+public:
+  BenchError(const std::string &msg) : std::runtime_error(msg) {}
+};
+
+static void check(al_status_t st, const char *what)
+{
+  if (st.code < 0)
+    throw BenchError(std::string(what) + ": " + st.message);
+}
+
+static double now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::vector<std::string> split(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+
+/**
+   Ends a context when going out of scope, so that a failing operation does not leave
+   dangling contexts behind.
+*/
+class Action
+{
+public:
+  int ctx = -1;
+
+  ~Action()
+  {
+    if (ctx >= 0)
+      al_end_action(ctx);
+  }
+
+  void end()
+  {
+    int c = ctx;
+    ctx = -1;
+    check(al_end_action(c), "al_end_action");
+  }
+};
+
+
+/**
+   Writes or reads back the nodes of a synthetic IDS, counting transferred bytes.
+   The same traversal is used in both directions: when reading, AoS sizes come from
+   the backend.
+*/
+class Visitor
+{
+public:
+  Visitor(bool write, bool slice = false) : writing(write), slicing(slice) {}
+
+  bool writing;
+  bool slicing;     // slice writes skip the non time dependent nodes
+  size_t bytes = 0;
+
+  void leaf(int ctx, const std::string &path, const char *timebase, const double *values, int dim, const int *shape)
+  {
+    int size[MAXDIM];
+    size_t n = 1;
+    for (int d = 0; d < dim; d++)
+      {
+	size[d] = shape[d];
+	n *= shape[d];
+      }
+    if (writing)
+      {
+	check(al_write_data(ctx, path.c_str(), timebase, const_cast<double *>(values), DOUBLE_DATA, dim, size),
+	      "al_write_data");
+	bytes += n * sizeof(double);
+	return;
+      }
+    double scalar;
+    void *data = (dim == 0) ? &scalar : NULL;
+    check(al_read_data(ctx, path.c_str(), timebase, &data, DOUBLE_DATA, dim, size), "al_read_data");
+    if (dim == 0)
+      bytes += sizeof(double);
+    else if (data != NULL)
+      {
+	n = 1;
+	for (int d = 0; d < dim; d++)
+	  n *= size[d];
+	bytes += n * sizeof(double);
+	free(data);
+      }
+  }
+
+  void leaf(int ctx, const std::string &path, int value)
+  {
+    void *data = &value;
+    int size[MAXDIM];
+    if (writing && slicing)
+      return;
+    if (writing)
+      check(al_write_data(ctx, path.c_str(), "", data, INTEGER_DATA, 0, size), "al_write_data");
+    else
+      check(al_read_data(ctx, path.c_str(), "", &data, INTEGER_DATA, 0, size), "al_read_data");
+    bytes += sizeof(int);
+  }
+
+  /**
+     Iterates over an AoS, calling element(actx, index) for each of its elements.
+  */
+  void aos(int ctx, const std::string &path, const char *timebase, int size,
+	   const std::function<void(int, int)> &element)
+  {
+    Action action;
+    check(al_begin_arraystruct_action(ctx, path.c_str(), timebase, &size, &action.ctx),
+	  "al_begin_arraystruct_action");
+    for (int i = 0; i < size; i++)
+      {
+	element(action.ctx, i);
+	check(al_iterate_over_arraystruct(action.ctx, 1), "al_iterate_over_arraystruct");
+      }
+    action.end();
+  }
+};
+
+
+/**
+   Deterministic content of a synthetic IDS, for nt time slices starting at slice t0.
+*/
+class SyntheticIDS
+{
+public:
+  SyntheticIDS(const Options &o) : opt(o)
+  {
+    profile.resize(opt.points);
+    for (int i = 0; i < opt.points; i++)
+      profile[i] = (double)i / opt.points;
+    map.resize((size_t)opt.points * opt.points);
+    for (size_t i = 0; i < map.size(); i++)
+      map[i] = (double)(i % 977) * 1e-3;
+  }
+
+  static double timeOf(int slice) { return 0.1 * slice; }
+
+  void visit(Visitor &v, int octx, const std::string &ids, int t0, int nt)
+  {
+    std::vector<double> time(nt), trace(nt);
+    for (int t = 0; t < nt; t++)
+      {
+	time[t] = timeOf(t0 + t);
+	trace[t] = 1.0 + 1e-3 * (t0 + t);
+      }
+
+    v.leaf(octx, "ids_properties/homogeneous_time", 1);
+    v.leaf(octx, "time", "time", time.data(), 1, &nt);
+
+    if (ids == "core_profiles")
+      {
+	v.leaf(octx, "global_quantities/ip", "time", trace.data(), 1, &nt);
+	v.aos(octx, "profiles_1d", "profiles_1d/time", nt, [&](int actx, int t) {
+	  v.leaf(actx, "time", "", &time[t], 0, NULL);
+	  v.leaf(actx, "grid/rho_tor_norm", "", profile.data(), 1, &opt.points);
+	  v.leaf(actx, "electrons/temperature", "", profile.data(), 1, &opt.points);
+	  v.leaf(actx, "electrons/density", "", profile.data(), 1, &opt.points);
+	  v.aos(actx, "ion", "", opt.aos, [&](int ictx, int) { nested(v, ictx, opt.depth); });
+	});
+      }
+    else if (ids == "equilibrium")
+      {
+	v.aos(octx, "time_slice", "time_slice/time", nt, [&](int actx, int t) {
+	  v.leaf(actx, "time", "", &time[t], 0, NULL);
+	  v.leaf(actx, "global_quantities/ip", "", &trace[t], 0, NULL);
+	  v.leaf(actx, "profiles_1d/psi", "", profile.data(), 1, &opt.points);
+	  v.leaf(actx, "profiles_1d/q", "", profile.data(), 1, &opt.points);
+	  int shape[2] = {opt.points, opt.points};
+	  v.aos(actx, "profiles_2d", "", opt.aos, [&](int pctx, int) {
+	    v.leaf(pctx, "grid/dim1", "", profile.data(), 1, &opt.points);
+	    v.leaf(pctx, "grid/dim2", "", profile.data(), 1, &opt.points);
+	    v.leaf(pctx, "psi", "", map.data(), 2, shape);
+	  });
+	});
+      }
+    else if (ids == "summary")
+      {
+	static const char *quantities[] = {"ip", "v_loop", "li", "beta_pol", "beta_tor", "energy_total",
+					   "h_98", "tau_energy"};
+	for (int i = 0; i < opt.aos; i++)
+	  for (const char *q : quantities)
+	    v.leaf(octx, "global_quantities/" + std::string(q) + "_" + std::to_string(i) + "/value", "time",
+		   trace.data(), 1, &nt);
+      }
+    else
+      throw BenchError("unknown synthetic IDS " + ids);
+  }
+
+private:
+  // ion/state/state/... chain of AoS, each element holding two profiles
+  void nested(Visitor &v, int ctx, int level)
+  {
+    v.leaf(ctx, "temperature", "", profile.data(), 1, &opt.points);
+    v.leaf(ctx, "density", "", profile.data(), 1, &opt.points);
+    if (level > 1)
+      v.aos(ctx, "state", "", opt.aos, [&](int sctx, int) { nested(v, sctx, level - 1); });
+  }
+
+  const Options &opt;
+  std::vector<double> profile, map;
+};
+
+
+/**
+   Runs the benchmarked operations for one backend and one IDS.
+*/
+class Bench
+{
+public:
+  Bench(const Options &o, const std::string &b, const std::string &i)
+    : opt(o), backend(b), ids(i), data(o)
+  {
+    uri = "imas:" + backend + "?path=" + opt.dir + "/al_bench_" + backend;
+    flexbuffers = (backend == "flexbuffers");
+  }
+
+  void run(std::vector<Result> &results)
+  {
+    // memory backend entries only live while one of their handles is open
+    Action keeper;
+    if (backend == "memory")
+      {
+	try
+	  {
+	    open(keeper, true);
+	  }
+	catch (const BenchError &e)
+	  {
+	    fprintf(stderr, "%s: %s\n", backend.c_str(), e.what());
+	  }
+      }
+    measure(results, "put", [&](Result &r) { r.latencies.push_back(put(r)); });
+    measure(results, "get", [&](Result &r) { r.latencies.push_back(get(r)); });
+    measure(results, "put_slice", [&](Result &r) { putSlices(r); });
+    measure(results, "get_slice", [&](Result &r) { getSlices(r); });
+    measure(results, "get_sample", [&](Result &r) { r.latencies.push_back(getSample(r)); });
+    if (keeper.ctx >= 0)
+      al_close_pulse(keeper.ctx, CLOSE_PULSE);
+  }
+
+private:
+  void measure(std::vector<Result> &results, const char *operation, const std::function<void(Result &)> &sample)
+  {
+    Result r;
+    r.backend = backend;
+    r.ids = ids;
+    r.operation = operation;
+    try
+      {
+	for (int i = 0; i < opt.repeat; i++)
+	  sample(r);
+      }
+    catch (const BenchError &e)
+      {
+	r.error = e.what();
+      }
+    fprintf(stderr, "%-12s %-14s %-10s %s\n", backend.c_str(), ids.c_str(), operation,
+	    r.error.empty() ? "ok" : r.error.c_str());
+    results.push_back(r);
+  }
+
+  // Opens the data entry, restoring the serialized buffer for reads on the flexbuffers backend
+  void open(Action &entry, bool create)
+  {
+    int ctx;
+    check(al_begin_dataentry_action(uri.c_str(), create ? FORCE_CREATE_PULSE : OPEN_PULSE, &ctx),
+	  "al_begin_dataentry_action");
+    entry.ctx = ctx;
+    if (flexbuffers && !create)
+      {
+	if (buffer.empty())
+	  throw BenchError("no serialized buffer available");
+	int size = buffer.size();
+	check(al_write_data(entry.ctx, "<buffer>", "", buffer.data(), CHAR_DATA, 1, &size), "al_write_data");
+      }
+  }
+
+  void close(Action &entry, bool create)
+  {
+    if (flexbuffers && create)
+      {
+	// the serialized IDS stands for the stored data entry
+	void *serialized = NULL;
+	int size;
+	check(al_read_data(entry.ctx, "<buffer>", "", &serialized, CHAR_DATA, 1, &size), "al_read_data");
+	buffer.assign((char *)serialized, (char *)serialized + size);
+	free(serialized);
+      }
+    check(al_close_pulse(entry.ctx, CLOSE_PULSE), "al_close_pulse");
+    entry.end();
+  }
+
+  double put(Result &r)
+  {
+    Action entry;
+    open(entry, true);
+    double elapsed = putGlobal(r, entry.ctx, opt.slices);
+    close(entry, true);
+    return elapsed;
+  }
+
+  double putGlobal(Result &r, int pctx, int nt)
+  {
+    Visitor v(true);
+    double start = now();
+    {
+      Action op;
+      check(al_begin_global_action(pctx, ids.c_str(), "", WRITE_OP, &op.ctx), "al_begin_global_action");
+      data.visit(v, op.ctx, ids, 0, nt);
+      op.end();
+    }
+    r.bytes += v.bytes;
+    return now() - start;
+  }
+
+  double get(Result &r)
+  {
+    Action entry;
+    open(entry, false);
+    Visitor v(false);
+    double start = now();
+    {
+      Action op;
+      check(al_begin_global_action(entry.ctx, ids.c_str(), "", READ_OP, &op.ctx), "al_begin_global_action");
+      data.visit(v, op.ctx, ids, 0, opt.slices);
+      op.end();
+    }
+    double elapsed = now() - start;
+    close(entry, false);
+    r.bytes += v.bytes;
+    return elapsed;
+  }
+
+  // puts the first slice, then appends the other ones one by one, one latency sample per
+  // appended slice
+  void putSlices(Result &r)
+  {
+    if (opt.slices < 2)
+      throw BenchError("put_slice needs at least 2 slices");
+    Action entry;
+    open(entry, true);
+    Result first;
+    putGlobal(first, entry.ctx, 1);
+    for (int t = 1; t < opt.slices; t++)
+      {
+	Visitor v(true, true);
+	double start = now();
+	{
+	  Action op;
+	  check(al_begin_slice_action(entry.ctx, ids.c_str(), WRITE_OP, SyntheticIDS::timeOf(t), CLOSEST_INTERP,
+				      &op.ctx), "al_begin_slice_action");
+	  data.visit(v, op.ctx, ids, t, 1);
+	  op.end();
+	}
+	r.latencies.push_back(now() - start);
+	r.bytes += v.bytes;
+      }
+    close(entry, true);
+  }
+
+  // reads every slice of the entry written by putSlices, one latency sample per slice
+  void getSlices(Result &r)
+  {
+    Action entry;
+    open(entry, false);
+    for (int t = 0; t < opt.slices; t++)
+      {
+	Visitor v(false);
+	double start = now();
+	{
+	  Action op;
+	  check(al_begin_slice_action(entry.ctx, ids.c_str(), READ_OP, SyntheticIDS::timeOf(t), CLOSEST_INTERP,
+				      &op.ctx), "al_begin_slice_action");
+	  data.visit(v, op.ctx, ids, t, 1);
+	  op.end();
+	}
+	r.latencies.push_back(now() - start);
+	r.bytes += v.bytes;
+      }
+    close(entry, false);
+  }
+
+  // reads the middle half of the time range
+  double getSample(Result &r)
+  {
+    int first = opt.slices / 4;
+    int nt = std::max(1, opt.slices / 2);
+    int noResampling = 0;
+    Action entry;
+    open(entry, false);
+    Visitor v(false);
+    double start = now();
+    {
+      Action op;
+      check(al_begin_timerange_action(entry.ctx, ids.c_str(), READ_OP, SyntheticIDS::timeOf(first),
+				      SyntheticIDS::timeOf(first + nt - 1), NULL, &noResampling, CLOSEST_INTERP,
+				      &op.ctx),
+	    "al_begin_timerange_action");
+      data.visit(v, op.ctx, ids, first, nt);
+      op.end();
+    }
+    double elapsed = now() - start;
+    close(entry, false);
+    r.bytes += v.bytes;
+    return elapsed;
+  }
+
+  const Options &opt;
+  std::string backend, ids, uri;
+  bool flexbuffers;
+  SyntheticIDS data;
+  std::vector<char> buffer;   // serialized IDS, flexbuffers backend only
+};
+
+
+static std::string jsonString(const std::string &s)
+{
+  std::string out = "\"";
+  for (char c : s)
+    {
+      if (c == '"' || c == '\\')
+	out += '\\';
+      out += ((unsigned char)c < 0x20) ? ' ' : c;
+    }
+  return out + "\"";
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+  size_t i = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static std::string report(const Options &opt, const std::vector<Result> &results)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  std::ostringstream json;
+  json.precision(6);
+  json << "{\n  \"options\": {\"slices\": " << opt.slices << ", \"aos\": " << opt.aos
+       << ", \"points\": " << opt.points << ", \"depth\": " << opt.depth << ", \"repeat\": " << opt.repeat
+       << "},\n  \"results\": [";
+  for (size_t i = 0; i < results.size(); i++)
+    {
+      const Result &r = results[i];
+      json << (i ? "," : "") << "\n    {\"backend\": " << jsonString(r.backend)
+	   << ", \"ids\": " << jsonString(r.ids) << ", \"operation\": " << jsonString(r.operation);
+      if (!r.error.empty())
+	{
+	  json << ", \"status\": \"error\", \"message\": " << jsonString(r.error) << "}";
+	  continue;
+	}
+      std::vector<double> sorted = r.latencies;
+      std::sort(sorted.begin(), sorted.end());
+      double total = 0;
+      for (double l : sorted)
+	total += l;
+      json << ", \"status\": \"ok\", \"samples\": " << sorted.size() << ", \"bytes\": " << r.bytes
+	   << ", \"throughput_mb_s\": " << (total > 0 ? r.bytes / total / 1e6 : 0.0)
+	   << ", \"latency_ms\": {\"min\": " << sorted.front() * 1e3
+	   << ", \"p50\": " << percentile(sorted, 50) * 1e3
+	   << ", \"p90\": " << percentile(sorted, 90) * 1e3
+	   << ", \"p99\": " << percentile(sorted, 99) * 1e3
+	   << ", \"max\": " << sorted.back() * 1e3
+	   << ", \"mean\": " << total / sorted.size() * 1e3 << "}}";
+    }
+  json << "\n  ],\n  \"peak_rss_kb\": " << usage.ru_maxrss << "\n}\n";
+  return json.str();
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [--slices N] [--aos N] [--points N] [--depth N] [--repeat N]\n"
+	  "          [--backends memory,hdf5,flexbuffers,ascii,no]\n"
+	  "          [--ids core_profiles,equilibrium,summary] [--dir DIR] [--out FILE]\n", prog);
+  exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+  Options opt;
+  for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if (i + 1 >= argc)
+	usage(argv[0]);
+      const char *value = argv[++i];
+      if (arg == "--slices")
+	opt.slices = atoi(value);
+      else if (arg == "--aos")
+	opt.aos = atoi(value);
+      else if (arg == "--points")
+	opt.points = atoi(value);
+      else if (arg == "--depth")
+	opt.depth = atoi(value);
+      else if (arg == "--repeat")
+	opt.repeat = atoi(value);
+      else if (arg == "--backends")
+	opt.backends = split(value);
+      else if (arg == "--ids")
+	opt.ids = split(value);
+      else if (arg == "--dir")
+	opt.dir = value;
+      else if (arg == "--out")
+	opt.out = value;
+      else
+	usage(argv[0]);
+    }
+  if (opt.slices < 1 || opt.aos < 1 || opt.points < 1 || opt.depth < 1 || opt.repeat < 1)
+    usage(argv[0]);
+  mkdir(opt.dir.c_str(), 0755);
+
+  std::vector<Result> results;
+  for (const auto &backend : opt.backends)
+    for (const auto &ids : opt.ids)
+      Bench(opt, backend, ids).run(results);
+
+  std::string json = report(opt, results);
+  if (opt.out.empty())
+    fputs(json.c_str(), stdout);
+  else
+    {
+      FILE *f = fopen(opt.out.c_str(), "w");
+      if (f == NULL)
+	{
+	  perror(opt.out.c_str());
+	  return 1;
+	}
+      fputs(json.c_str(), f);
+      fclose(f);
+    }
+  return 0;
+}
@@ -0,0 +1,189 @@
+/*
+  Copies the IDSs of a data entry to another data entry, possibly of another
+  backend (e.g. MDSplus to HDF5), with al_copy_ids.
+
+  Every occurrence of the selected IDSs (all the IDSs of the Data Dictionary
+  by default) found in the source is copied. IDSs are copied in parallel by
+  several workers, each with its own source and destination data entries.
+  Destinations held in memory (memory, flexbuffers backends) are copied by a
+  single worker.
+
+  usage: al-copy [-j workers] [--ids name,name,...] [--create] SRC_URI DST_URI
+  -j        number of IDSs copied in parallel (default: 4)
+  --ids     IDSs to copy (default: all the IDSs of the Data Dictionary)
+  --create  creates the destination (erasing it if it exists), otherwise the
+            destination is opened or created if it does not exist
+*/
+
+#include <al_lowlevel.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void check(al_status_t st, const char *what)
+{
+  if (st.code < 0)
+    throw std::runtime_error(std::string(what) + ": " + st.message);
+}
+
+static std::vector<std::string> split(const std::string &list, char separator)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  for (std::string item; std::getline(ss, item, separator);)
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+struct Job
+{
+  std::string ids;
+  int occurrence;
+};
+
+static void usage()
+{
+  fprintf(stderr, "usage: al-copy [-j workers] [--ids name,name,...] [--create] SRC_URI DST_URI\n");
+}
+
+int main(int argc, char *argv[])
+{
+  int workers = 4;
+  bool create = false;
+  std::string idsList;
+  std::vector<std::string> uris;
+  for (int i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+	workers = atoi(argv[++i]);
+      else if (strcmp(argv[i], "--ids") == 0 && i + 1 < argc)
+	idsList = argv[++i];
+      else if (strcmp(argv[i], "--create") == 0)
+	create = true;
+      else if (argv[i][0] == '-')
+	{
+	  usage();
+	  return 2;
+	}
+      else
+	uris.push_back(argv[i]);
+    }
+  if (uris.size() != 2)
+    {
+      usage();
+      return 2;
+    }
+  if (workers < 1)
+    workers = 1;
+
+  try {
+    std::vector<std::string> names;
+    if (idsList.empty())
+      {
+	char *list = NULL;
+	check(al_list_ids(&list), "al_list_ids");
+	names = split(list, ' ');
+	free(list);
+      }
+    else
+      names = split(idsList, ',');
+
+    // the destination is created once, workers then open it
+    int src, dst;
+    check(al_begin_dataentry_action(uris[0].c_str(), OPEN_PULSE, &src), "al_begin_dataentry_action");
+    check(al_begin_dataentry_action(uris[1].c_str(), create ? FORCE_CREATE_PULSE : FORCE_OPEN_PULSE, &dst),
+	  "al_begin_dataentry_action");
+    int backend;
+    check(al_get_backendID(dst, &backend), "al_get_backendID");
+    if (backend == MEMORY_BACKEND || backend == FLEXBUFFERS_BACKEND)
+      workers = 1;
+
+    std::vector<Job> jobs;
+    for (const auto &name : names)
+      {
+	int *occurrences = NULL;
+	int n = 0;
+	al_status_t st = al_get_occurrences(src, name.c_str(), &occurrences, &n);
+	if (st.code < 0)
+	  {
+	    // backend without occurrence listing: empty IDSs are skipped by al_copy_ids
+	    jobs.push_back(Job{name, 0});
+	    continue;
+	  }
+	for (int k = 0; k < n; k++)
+	  jobs.push_back(Job{name, occurrences[k]});
+	free(occurrences);
+      }
+
+    std::atomic<size_t> next(0);
+    std::atomic<int> errors(0), copied(0);
+    std::mutex outputMutex;
+    auto start = std::chrono::steady_clock::now();
+    auto work = [&](int srcCtx, int dstCtx) {
+      for (size_t j = next++; j < jobs.size(); j = next++)
+	{
+	  auto t0 = std::chrono::steady_clock::now();
+	  al_status_t st = al_copy_ids(srcCtx, dstCtx, jobs[j].ids.c_str(), jobs[j].occurrence, COPY_DEFAULT);
+	  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	  std::lock_guard<std::mutex> guard(outputMutex);
+	  if (st.code < 0)
+	    {
+	      errors++;
+	      fprintf(stderr, "%s/%d: %s\n", jobs[j].ids.c_str(), jobs[j].occurrence, st.message);
+	    }
+	  else
+	    {
+	      copied++;
+	      printf("%-32s %4d %10.3f s\n", jobs[j].ids.c_str(), jobs[j].occurrence, elapsed);
+	    }
+	}
+    };
+
+    std::vector<std::thread> threads;
+    for (int w = 1; w < workers && (size_t)w < jobs.size(); w++)
+      threads.emplace_back([&]() {
+	  int s, d;
+	  try {
+	    check(al_begin_dataentry_action(uris[0].c_str(), OPEN_PULSE, &s), "al_begin_dataentry_action");
+	    check(al_begin_dataentry_action(uris[1].c_str(), OPEN_PULSE, &d), "al_begin_dataentry_action");
+	  }
+	  catch (const std::exception &e) {
+	    std::lock_guard<std::mutex> guard(outputMutex);
+	    errors++;
+	    fprintf(stderr, "%s\n", e.what());
+	    return;
+	  }
+	  work(s, d);
+	  al_close_pulse(d, CLOSE_PULSE);
+	  al_end_action(d);
+	  al_close_pulse(s, CLOSE_PULSE);
+	  al_end_action(s);
+	});
+    work(src, dst);
+    for (auto &t : threads)
+      t.join();
+
+    check(al_close_pulse(dst, CLOSE_PULSE), "al_close_pulse");
+    check(al_end_action(dst), "al_end_action");
+    check(al_close_pulse(src, CLOSE_PULSE), "al_close_pulse");
+    check(al_end_action(src), "al_end_action");
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%d IDS occurrences copied in %.3f s with %d workers, %d errors\n", copied.load(), elapsed,
+	   workers, errors.load());
+    return (errors == 0) ? 0 : 1;
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+}
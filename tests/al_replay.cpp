@@ -0,0 +1,645 @@
+/*
+  Replays an access trace recorded with IMAS_AL_TRACE=<file> (see al_trace.h).
+
+  Every recorded lowlevel call is issued again, in the same order, against the
+  given data entry URI. Recorded context ids are mapped to the ones of the
+  replay. Written data use the recorded payloads when the trace holds them
+  (IMAS_AL_TRACE_PAYLOAD=TRUE), synthetic data of the recorded shapes
+  otherwise: integers are 1 and floating point values increase along the
+  replay. Synthetic time fields ("time" and ".../time") span the times of the
+  recorded slice and time range operations instead: a time vector is spread
+  evenly over them, the time of an AoS element follows its index, and a slice
+  write uses the time of its slice, so that slice and time range reads select
+  data as when recorded. Calls that failed when recorded are skipped.
+
+  The recorded and replayed durations are reported per call.
+
+  usage: al-replay [--pace] --uri URI trace
+         al-replay --dump trace
+  --uri    target data entry; "%d" is replaced by the index of each distinct
+           data entry URI of the trace (0, 1, ...)
+  --pace   waits so that calls start at their recorded offsets
+  --dump   prints the records instead of replaying them
+*/
+
+#include <al_lowlevel.h>
+#include <al_trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Record
+{
+  int op;
+  uint64_t start;
+  uint64_t duration;
+  int status;
+  const char *body;
+  uint32_t size;
+};
+
+struct OpStats
+{
+  uint64_t count = 0;
+  uint64_t recordedNs = 0;
+  uint64_t replayedNs = 0;
+  uint64_t errors = 0;
+  uint64_t skipped = 0;
+};
+
+static uint64_t now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	   std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool load(const char *name, std::vector<char> &content, std::vector<Record> &records)
+{
+  std::ifstream in(name, std::ios::binary);
+  if (!in)
+    {
+      perror(name);
+      return false;
+    }
+  content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  uint32_t version, endian;
+  if (content.size() < altrace::HEADER_SIZE || memcmp(content.data(), altrace::MAGIC, sizeof(altrace::MAGIC)) != 0)
+    {
+      fprintf(stderr, "%s: not an access layer trace\n", name);
+      return false;
+    }
+  memcpy(&version, content.data() + 8, sizeof(version));
+  memcpy(&endian, content.data() + 12, sizeof(endian));
+  if (endian != altrace::ENDIAN_MARKER || version != altrace::VERSION)
+    {
+      fprintf(stderr, "%s: unsupported trace version %u or byte order\n", name, version);
+      return false;
+    }
+
+  size_t pos = altrace::HEADER_SIZE;
+  while (pos + altrace::RECORD_HEADER_SIZE <= content.size())
+    {
+      const char *p = content.data() + pos;
+      Record r;
+      uint8_t op;
+      int32_t status;
+      memcpy(&op, p, 1);
+      memcpy(&r.size, p + 1, 4);
+      memcpy(&r.start, p + 5, 8);
+      memcpy(&r.duration, p + 13, 8);
+      memcpy(&status, p + 21, 4);
+      r.op = op;
+      r.status = status;
+      r.body = p + altrace::RECORD_HEADER_SIZE;
+      pos += altrace::RECORD_HEADER_SIZE + r.size;
+      if (pos > content.size())
+	{
+	  fprintf(stderr, "%s: truncated last record ignored\n", name);
+	  break;
+	}
+      records.push_back(r);
+    }
+  return true;
+}
+
+static std::vector<int> readShape(altrace::Cursor &c)
+{
+  int dim = c.i32();
+  std::vector<int> shape;
+  for (int i = 0; i < dim && i < MAXDIM; i++)
+    shape.push_back(c.i32());
+  return shape;
+}
+
+
+/**
+   Replays the records one by one, keeping the mapping between recorded and replayed contexts.
+*/
+class Replayer
+{
+public:
+  Replayer(const std::string &u, bool p) : uri(u), pace(p) {}
+
+  std::map<int, OpStats> stats;
+
+  void run(const std::vector<Record> &records)
+  {
+    findTimes(records);
+    uint64_t origin = now();
+    for (const Record &r : records)
+      {
+	if (pace)
+	  {
+	    uint64_t elapsed = now() - origin;
+	    if (r.start > elapsed)
+	      std::this_thread::sleep_for(std::chrono::nanoseconds(r.start - elapsed));
+	  }
+	OpStats &s = stats[r.op];
+	s.count++;
+	s.recordedNs += r.duration;
+	if (r.status < 0)
+	  {
+	    s.skipped++;
+	    continue;
+	  }
+	altrace::Cursor c(r.body, r.size);
+	uint64_t start = now();
+	al_status_t status = replay(r.op, c);
+	s.replayedNs += now() - start;
+	if (status.code < 0)
+	  {
+	    if (s.errors++ == 0)
+	      fprintf(stderr, "%s: %s\n", altrace::opName(r.op), status.message);
+	  }
+      }
+  }
+
+private:
+  // position of a recorded context, for the synthetic time fields
+  struct Position
+  {
+    double sliceTime = NAN;  // time of the slice operation, NAN for other operations
+    int aosSize = 0;         // number of elements of an AoS context, 0 for operations
+    int index = 0;           // current element of an AoS context
+  };
+
+  // range of the times of the recorded slice and time range operations
+  void findTimes(const std::vector<Record> &records)
+  {
+    for (const Record &r : records)
+      {
+	if (r.status < 0 || (r.op != altrace::TR_BEGIN_SLICE && r.op != altrace::TR_BEGIN_TIMERANGE))
+	  continue;
+	altrace::Cursor c(r.body, r.size);
+	c.i32();
+	c.str();
+	c.i32();
+	std::vector<double> times = { c.f64() };
+	if (r.op == altrace::TR_BEGIN_TIMERANGE)
+	  {
+	    times.push_back(c.f64());
+	    int n = c.i32();
+	    for (int i = 0; i < n; i++)
+	      times.push_back(c.f64());
+	  }
+	for (double t : times)
+	  {
+	    tmin = std::min(tmin, t);
+	    tmax = std::max(tmax, t);
+	  }
+      }
+  }
+
+  static bool isTime(const std::string &field)
+  {
+    return field == "time" || (field.size() > 5 && field.compare(field.size() - 5, 5, "/time") == 0);
+  }
+
+  // i-th of n times spread over the recorded ones
+  double timeAt(int i, int n)
+  {
+    return (n > 1) ? tmin + i * (tmax - tmin) / (n - 1) : tmin;
+  }
+
+  // synthetic time field written in the recorded context, false when no slice or time range was recorded
+  bool times(int recorded, const std::vector<int> &shape, size_t n)
+  {
+    if (tmin > tmax)
+      return false;
+    buffer.resize(n * sizeof(double));
+    double *times = reinterpret_cast<double *>(buffer.data());
+    auto got = positions.find(recorded);
+    Position p = (got != positions.end()) ? got->second : Position();
+    for (size_t i = 0; i < n; i++)
+      {
+	if (!std::isnan(p.sliceTime))
+	  times[i] = p.sliceTime;
+	else if (shape.empty() && p.aosSize > 0)
+	  times[i] = timeAt(p.index, p.aosSize);
+	else
+	  times[i] = timeAt(i, n);
+      }
+    return true;
+  }
+
+  // maps a recorded context id, -1 when the recorded context was not replayed
+  int ctx(int recorded)
+  {
+    auto got = contexts.find(recorded);
+    return (got != contexts.end()) ? got->second : -1;
+  }
+
+  void bind(int recorded, int replayed, const al_status_t &status)
+  {
+    if (status.code >= 0 && recorded != 0)
+      contexts[recorded] = replayed;
+  }
+
+  std::string targetURI(const std::string &recorded)
+  {
+    auto got = uris.find(recorded);
+    if (got == uris.end())
+      got = uris.emplace(recorded, uris.size()).first;
+    int index = got->second;
+    std::string target = uri;
+    size_t pos = target.find("%d");
+    if (pos != std::string::npos)
+      target.replace(pos, 2, std::to_string(index));
+    return target;
+  }
+
+  // recorded payload if any, synthetic data otherwise
+  void *payload(altrace::Cursor &c, int recordedCtx, const std::string &field, int datatype,
+		const std::vector<int> &shape)
+  {
+    size_t n = 1;
+    for (int s : shape)
+      n *= s;
+    bool recorded = (c.i32() == 1);
+    size_t bytes = recorded ? c.i64() : 0;
+    const char *data = recorded ? c.bytes(bytes) : NULL;
+    if (data != NULL)
+      {
+	buffer.assign(data, data + bytes);
+	return buffer.data();
+      }
+    if (datatype == DOUBLE_DATA && isTime(field) && times(recordedCtx, shape, n))
+      return buffer.data();
+
+    switch (datatype)
+      {
+      case CHAR_DATA:
+	buffer.assign(n, 'a');
+	break;
+      case INTEGER_DATA:
+	buffer.resize(n * sizeof(int));
+	for (size_t i = 0; i < n; i++)
+	  reinterpret_cast<int *>(buffer.data())[i] = 1;
+	break;
+      case DOUBLE_DATA:
+	buffer.resize(n * sizeof(double));
+	for (size_t i = 0; i < n; i++)
+	  reinterpret_cast<double *>(buffer.data())[i] = counter++;
+	break;
+      case COMPLEX_DATA:
+	buffer.resize(n * sizeof(std::complex<double>));
+	for (size_t i = 0; i < n; i++)
+	  reinterpret_cast<std::complex<double> *>(buffer.data())[i] = counter++;
+	break;
+      }
+    return buffer.data();
+  }
+
+  al_status_t replay(int op, altrace::Cursor &c)
+  {
+    al_status_t status = {};
+    switch (op)
+      {
+      case altrace::TR_BEGIN_DATAENTRY:
+	{
+	  std::string recorded = c.str();
+	  int mode = c.i32();
+	  int out;
+	  status = al_begin_dataentry_action(targetURI(recorded).c_str(), mode, &out);
+	  bind(c.i32(), out, status);
+	  break;
+	}
+      case altrace::TR_CLOSE_PULSE:
+	{
+	  int pctx = ctx(c.i32());
+	  status = al_close_pulse(pctx, c.i32());
+	  break;
+	}
+      case altrace::TR_BEGIN_GLOBAL:
+	{
+	  int pctx = ctx(c.i32());
+	  std::string ids = c.str(), datapath = c.str();
+	  int rwmode = c.i32(), out;
+	  status = al_begin_global_action(pctx, ids.c_str(), datapath.c_str(), rwmode, &out);
+	  bind(c.i32(), out, status);
+	  break;
+	}
+      case altrace::TR_BEGIN_SLICE:
+	{
+	  int pctx = ctx(c.i32());
+	  std::string ids = c.str();
+	  int rwmode = c.i32();
+	  double time = c.f64();
+	  int interp = c.i32(), out;
+	  status = al_begin_slice_action(pctx, ids.c_str(), rwmode, time, interp, &out);
+	  int recorded = c.i32();
+	  bind(recorded, out, status);
+	  positions[recorded].sliceTime = time;
+	  break;
+	}
+      case altrace::TR_BEGIN_TIMERANGE:
+	{
+	  int pctx = ctx(c.i32());
+	  std::string ids = c.str();
+	  int rwmode = c.i32();
+	  double tmin = c.f64(), tmax = c.f64();
+	  int n = c.i32();
+	  std::vector<double> dtime;
+	  for (int i = 0; i < n; i++)
+	    dtime.push_back(c.f64());
+	  int interp = c.i32(), out;
+	  status = al_begin_timerange_action(pctx, ids.c_str(), rwmode, tmin, tmax, dtime.data(), &n, interp, &out);
+	  bind(c.i32(), out, status);
+	  break;
+	}
+      case altrace::TR_BEGIN_ARRAYSTRUCT:
+	{
+	  int recordedParent = c.i32();
+	  int parent = ctx(recordedParent);
+	  std::string path = c.str(), timebase = c.str();
+	  int size = c.i32(), out = 0;
+	  Position p;
+	  p.sliceTime = positions[recordedParent].sliceTime;
+	  p.aosSize = size;
+	  status = al_begin_arraystruct_action(parent, path.c_str(), timebase.c_str(), &size, &out);
+	  c.i32();
+	  int recorded = c.i32();
+	  bind(recorded, out, status);
+	  positions[recorded] = p;
+	  break;
+	}
+      case altrace::TR_ITERATE:
+	{
+	  int recorded = c.i32();
+	  int step = c.i32();
+	  status = al_iterate_over_arraystruct(ctx(recorded), step);
+	  positions[recorded].index += step;
+	  break;
+	}
+      case altrace::TR_END_ACTION:
+	{
+	  int recorded = c.i32();
+	  status = al_end_action(ctx(recorded));
+	  contexts.erase(recorded);
+	  positions.erase(recorded);
+	  break;
+	}
+      case altrace::TR_DELETE_DATA:
+	{
+	  int octx = ctx(c.i32());
+	  status = al_delete_data(octx, c.str().c_str());
+	  break;
+	}
+      case altrace::TR_WRITE_DATA:
+	{
+	  int recorded = c.i32();
+	  int target = ctx(recorded);
+	  std::string field = c.str(), timebase = c.str();
+	  int datatype = c.i32();
+	  std::vector<int> shape = readShape(c);
+	  void *data = payload(c, recorded, field, datatype, shape);
+	  status = al_write_data(target, field.c_str(), timebase.c_str(), data, datatype, shape.size(), shape.data());
+	  break;
+	}
+      case altrace::TR_READ_DATA:
+      case altrace::TR_READ_DATA_SHAPE:
+      case altrace::TR_READ_DATA_INTO:
+	{
+	  int target = ctx(c.i32());
+	  std::string field = c.str(), timebase = c.str();
+	  int datatype = c.i32(), dim = c.i32();
+	  int size[MAXDIM];
+	  if (op == altrace::TR_READ_DATA_SHAPE)
+	    status = al_read_data_shape(target, field.c_str(), timebase.c_str(), datatype, dim, size);
+	  else if (op == altrace::TR_READ_DATA_INTO)
+	    {
+	      std::vector<char> dst(c.i64());
+	      status = al_read_data_into(target, field.c_str(), timebase.c_str(), dst.data(), dst.size(), datatype, dim, size);
+	    }
+	  else
+	    {
+	      std::complex<double> scalar;
+	      void *data = (dim == 0) ? &scalar : NULL;
+	      status = al_read_data(target, field.c_str(), timebase.c_str(), &data, datatype, dim, size);
+	      if (dim > 0)
+		free(data);
+	    }
+	  break;
+	}
+      case altrace::TR_WRITE_DATA_BATCH:
+	{
+	  int recorded = c.i32();
+	  int target = ctx(recorded);
+	  int n = c.i32();
+	  std::vector<std::string> fields(n), timebases(n);
+	  std::vector<int> datatypes(n), dims(n);
+	  std::vector<std::vector<int>> shapes(n);
+	  std::vector<std::vector<char>> payloads(n);
+	  for (int i = 0; i < n; i++)
+	    {
+	      fields[i] = c.str();
+	      timebases[i] = c.str();
+	      datatypes[i] = c.i32();
+	      shapes[i] = readShape(c);
+	      dims[i] = shapes[i].size();
+	      payload(c, recorded, fields[i], datatypes[i], shapes[i]);
+	      payloads[i].swap(buffer);
+	    }
+	  std::vector<const char *> fieldPtrs(n), timebasePtrs(n);
+	  std::vector<void *> dataPtrs(n);
+	  std::vector<int *> sizePtrs(n);
+	  for (int i = 0; i < n; i++)
+	    {
+	      fieldPtrs[i] = fields[i].c_str();
+	      timebasePtrs[i] = timebases[i].c_str();
+	      dataPtrs[i] = payloads[i].data();
+	      sizePtrs[i] = shapes[i].data();
+	    }
+	  status = al_write_data_batch(target, n, fieldPtrs.data(), timebasePtrs.data(), datatypes.data(),
+				       dims.data(), dataPtrs.data(), sizePtrs.data());
+	  break;
+	}
+      case altrace::TR_READ_DATA_BATCH:
+	{
+	  int target = ctx(c.i32());
+	  int n = c.i32();
+	  std::vector<std::string> fields(n), timebases(n);
+	  std::vector<int> datatypes(n), dims(n);
+	  for (int i = 0; i < n; i++)
+	    {
+	      fields[i] = c.str();
+	      timebases[i] = c.str();
+	      datatypes[i] = c.i32();
+	      dims[i] = c.i32();
+	    }
+	  std::vector<const char *> fieldPtrs(n), timebasePtrs(n);
+	  std::vector<std::complex<double>> scalars(n);
+	  std::vector<void *> dataPtrs(n);
+	  std::vector<std::vector<int>> sizes(n, std::vector<int>(MAXDIM));
+	  std::vector<int *> sizePtrs(n);
+	  for (int i = 0; i < n; i++)
+	    {
+	      fieldPtrs[i] = fields[i].c_str();
+	      timebasePtrs[i] = timebases[i].c_str();
+	      dataPtrs[i] = (dims[i] == 0) ? &scalars[i] : NULL;
+	      sizePtrs[i] = sizes[i].data();
+	    }
+	  status = al_read_data_batch(target, n, fieldPtrs.data(), timebasePtrs.data(), datatypes.data(),
+				      dims.data(), dataPtrs.data(), sizePtrs.data());
+	  for (int i = 0; i < n; i++)
+	    if (dims[i] > 0)
+	      free(dataPtrs[i]);
+	  break;
+	}
+      default:
+	status.code = -1;
+	snprintf(status.message, sizeof(status.message), "unknown record type %d", op);
+      }
+    return status;
+  }
+
+  std::string uri;
+  bool pace;
+  std::map<int, int> contexts;
+  std::map<std::string, int> uris;    // recorded data entry URI -> index
+  std::map<int, Position> positions;  // recorded context id -> position
+  std::vector<char> buffer;
+  double counter = 0;
+  double tmin = INFINITY, tmax = -INFINITY;  // times of the recorded slice and time range operations
+};
+
+
+static void dump(const std::vector<Record> &records)
+{
+  for (const Record &r : records)
+    {
+      altrace::Cursor c(r.body, r.size);
+      printf("%12.3f ms %10.3f us %4d %s(", r.start * 1e-6, r.duration * 1e-3, r.status, altrace::opName(r.op));
+      switch (r.op)
+	{
+	case altrace::TR_BEGIN_DATAENTRY:
+	  {
+	    std::string uri = c.str();
+	    int mode = c.i32();
+	    printf("\"%s\", %d) -> %d", uri.c_str(), mode, c.i32());
+	    break;
+	  }
+	case altrace::TR_BEGIN_GLOBAL:
+	  {
+	    int pctx = c.i32();
+	    std::string ids = c.str(), path = c.str();
+	    int rwmode = c.i32();
+	    printf("%d, \"%s\", \"%s\", %d) -> %d", pctx, ids.c_str(), path.c_str(), rwmode, c.i32());
+	    break;
+	  }
+	case altrace::TR_BEGIN_ARRAYSTRUCT:
+	  {
+	    int parent = c.i32();
+	    std::string path = c.str(), timebase = c.str();
+	    int size = c.i32(), out = c.i32();
+	    printf("%d, \"%s\", \"%s\", %d) -> size %d, %d", parent, path.c_str(), timebase.c_str(), size, out,
+		   c.i32());
+	    break;
+	  }
+	case altrace::TR_WRITE_DATA:
+	case altrace::TR_READ_DATA:
+	case altrace::TR_READ_DATA_INTO:
+	case altrace::TR_READ_DATA_SHAPE:
+	  {
+	    int target = c.i32();
+	    std::string field = c.str(), timebase = c.str();
+	    int datatype = c.i32();
+	    printf("%d, \"%s\", \"%s\", %s", target, field.c_str(), timebase.c_str(), const2str(datatype));
+	    std::vector<int> shape;
+	    if (r.op == altrace::TR_WRITE_DATA)
+	      shape = readShape(c);
+	    else
+	      {
+		c.i32();
+		if (r.op == altrace::TR_READ_DATA_INTO)
+		  c.i64();
+		shape = readShape(c);
+	      }
+	    printf(", [");
+	    for (size_t i = 0; i < shape.size(); i++)
+	      printf("%s%d", i ? "," : "", shape[i]);
+	    printf("])");
+	    break;
+	  }
+	default:
+	  {
+	    // other calls start with a context id
+	    printf("%d, ...)", c.i32());
+	  }
+	}
+      printf("\n");
+    }
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [--pace] --uri URI trace\n"
+	  "       %s --dump trace\n", prog, prog);
+  exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+  std::string uri;
+  const char *traceName = NULL;
+  bool pace = false, dumpOnly = false;
+  for (int i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "--pace") == 0)
+	pace = true;
+      else if (strcmp(argv[i], "--dump") == 0)
+	dumpOnly = true;
+      else if (strcmp(argv[i], "--uri") == 0 && i + 1 < argc)
+	uri = argv[++i];
+      else if (traceName == NULL && argv[i][0] != '-')
+	traceName = argv[i];
+      else
+	usage(argv[0]);
+    }
+  if (traceName == NULL || (uri.empty() && !dumpOnly))
+    usage(argv[0]);
+
+  std::vector<char> content;
+  std::vector<Record> records;
+  if (!load(traceName, content, records))
+    return 1;
+  if (dumpOnly)
+    {
+      dump(records);
+      return 0;
+    }
+
+  Replayer replayer(uri, pace);
+  replayer.run(records);
+
+  printf("%-28s %9s %14s %14s %9s %8s %8s\n", "call", "count", "recorded (ms)", "replayed (ms)", "ratio",
+	 "errors", "skipped");
+  OpStats total;
+  for (const auto &kv : replayer.stats)
+    {
+      const OpStats &s = kv.second;
+      printf("%-28s %9lu %14.3f %14.3f %9.2f %8lu %8lu\n", altrace::opName(kv.first), (unsigned long)s.count,
+	     s.recordedNs * 1e-6, s.replayedNs * 1e-6, s.recordedNs ? (double)s.replayedNs / s.recordedNs : 0.0,
+	     (unsigned long)s.errors, (unsigned long)s.skipped);
+      total.count += s.count;
+      total.recordedNs += s.recordedNs;
+      total.replayedNs += s.replayedNs;
+      total.errors += s.errors;
+      total.skipped += s.skipped;
+    }
+  printf("%-28s %9lu %14.3f %14.3f %9.2f %8lu %8lu\n", "total", (unsigned long)total.count,
+	 total.recordedNs * 1e-6, total.replayedNs * 1e-6,
+	 total.recordedNs ? (double)total.replayedNs / total.recordedNs : 0.0,
+	 (unsigned long)total.errors, (unsigned long)total.skipped);
+  return total.errors ? 1 : 0;
+}
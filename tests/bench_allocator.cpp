@@ -0,0 +1,225 @@
+/*
+  Benchmark of the allocator of the data returned by al_read_data
+  (al_set_allocator).
+
+  An equilibrium IDS is written with nslices time slices, each holding a 2D
+  map of points x points values and an integer 1D array. The maps are then
+  read repeats times:
+  - malloc: default allocator (depending on the malloc implementation and its
+    mmap threshold, large arrays may be mapped again at each read; glibc raises
+    its threshold once such blocks are freed, and then reuses its pages too);
+  - pool: allocator keeping released buffers in free lists, the same pages are
+    reused from one read to the next.
+  Each loop starts with a get that is not measured, so that the pool and the
+  malloc arenas are warmed up. The time and the minor page faults (getrusage
+  delta) of the following gets, and the number of pool buffers reused, are
+  reported.
+  Pool buffers are not malloc'd blocks (they start after a header), so a
+  buffer released with free() instead of the pool would abort. The integer
+  arrays are read as doubles, so that the conversion grows them through the
+  allocator too. The data read is checked, all pool buffers must be released
+  at the end, for the HDF5 and memory backends. The exit status is 1 if any
+  check failed.
+
+  usage: bench_allocator [nslices] [points] [repeats] [dir]
+  (defaults: 10 slices, 512 points, 5 repeats, current directory)
+*/
+
+#include "bench_common.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const int NB_INT = 1000;
+
+static double value(int slice, int i)
+{
+  return slice * 1.0e6 + i * 1.0e-3;
+}
+
+// buffers are preceded by a header holding their size class
+struct Pool
+{
+  static const size_t HEADER = 64;
+  std::mutex mutex;
+  std::map<size_t, std::vector<void *>> free;     // key = size class
+  long allocations = 0;
+  long reuses = 0;
+  long outstanding = 0;
+
+  static void* allocate(size_t size, void *user)
+  {
+    Pool *pool = (Pool *)user;
+    size_t sizeClass = 64;
+    while (sizeClass < size)
+      sizeClass <<= 1;
+    std::lock_guard<std::mutex> guard(pool->mutex);
+    pool->allocations++;
+    pool->outstanding++;
+    std::vector<void *> &list = pool->free[sizeClass];
+    char *block;
+    if (!list.empty())
+      {
+	block = (char *)list.back();
+	list.pop_back();
+	pool->reuses++;
+      }
+    else
+      {
+	block = (char *)malloc(HEADER + sizeClass);
+	*(size_t *)block = sizeClass;
+      }
+    return block + HEADER;
+  }
+
+  static void release(void *ptr, void *user)
+  {
+    Pool *pool = (Pool *)user;
+    char *block = (char *)ptr - HEADER;
+    std::lock_guard<std::mutex> guard(pool->mutex);
+    pool->outstanding--;
+    pool->free[*(size_t *)block].push_back(block);
+  }
+
+  ~Pool()
+  {
+    for (auto &kv : free)
+      for (void *block : kv.second)
+	::free(block);
+  }
+};
+
+static void put(int pctx, int nslices, int points)
+{
+  int octx, tctx;
+  int nt = nslices, nint = NB_INT, homogeneous = 1;
+  int size2d[2] = {points, points};
+  std::vector<double> time;
+  for (int t = 0; t < nslices; t++)
+    time.push_back(0.1 * t);
+
+  check(al_begin_global_action(pctx, "equilibrium", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_write_data(octx, "time", "time", time.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "time_slice", "time", &nt, &tctx), "al_begin_arraystruct_action");
+  for (int t = 0; t < nslices; t++)
+    {
+      std::vector<double> map((size_t)points * points);
+      for (size_t i = 0; i < map.size(); i++)
+	map[i] = value(t, (int)(i % 1000));
+      std::vector<int> indices(NB_INT);
+      for (int i = 0; i < NB_INT; i++)
+	indices[i] = t + i;
+      check(al_write_data(tctx, "profiles_2d/psi", "", map.data(), DOUBLE_DATA, 2, size2d), "al_write_data");
+      check(al_write_data(tctx, "boundary/x_point_index", "", indices.data(), INTEGER_DATA, 1, &nint),
+	    "al_write_data");
+      check(al_iterate_over_arraystruct(tctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(tctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void get(int pctx, int nslices, int points)
+{
+  int octx, tctx;
+  check(al_begin_global_action(pctx, "equilibrium", "", READ_OP, &octx), "al_begin_global_action");
+  int nt = 0;
+  check(al_begin_arraystruct_action(octx, "time_slice", "time", &nt, &tctx), "al_begin_arraystruct_action");
+  expect(nt == nslices, "time_slice size");
+  for (int t = 0; t < nt; t++)
+    {
+      void *data = NULL;
+      int size[MAXDIM] = {0};
+      check(al_read_data(tctx, "profiles_2d/psi", "", &data, DOUBLE_DATA, 2, size), "al_read_data");
+      expect(data != NULL && size[0] == points && size[1] == points, "profiles_2d/psi size");
+      double *map = (double *)data;
+      size_t last = (size_t)points * points - 1;
+      expect(map[0] == value(t, 0) && map[last] == value(t, (int)(last % 1000)), "profiles_2d/psi");
+      al_free_data(data);
+
+      // integers converted to doubles
+      data = NULL;
+      check(al_read_data(tctx, "boundary/x_point_index", "", &data, DOUBLE_DATA, 1, size), "al_read_data");
+      expect(data != NULL && size[0] == NB_INT && ((double *)data)[NB_INT - 1] == t + NB_INT - 1,
+	     "boundary/x_point_index");
+      al_free_data(data);
+      check(al_iterate_over_arraystruct(tctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(tctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static long minorFaults()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt;
+}
+
+static void run(const std::string &uri, int nslices, int points, int repeats)
+{
+  int pctx = openEntry(uri, FORCE_CREATE_PULSE);
+  put(pctx, nslices, points);
+
+  double times[2];
+  long faults[2], reuses = 0;
+  Pool pool;
+  for (int loop = 0; loop < 2; loop++)
+    {
+      if (loop == 1)
+	check(al_set_allocator(Pool::allocate, Pool::release, &pool), "al_set_allocator");
+      get(pctx, nslices, points);
+      long r0 = pool.reuses;
+      long f0 = minorFaults();
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < repeats; r++)
+	get(pctx, nslices, points);
+      times[loop] = elapsed(start);
+      faults[loop] = minorFaults() - f0;
+      reuses = pool.reuses - r0;
+    }
+  check(al_set_allocator(NULL, NULL, NULL), "al_set_allocator");
+  closeEntry(pctx);
+
+  expect(pool.allocations > 0 && pool.outstanding == 0,
+	 "pool buffers still in use: " + std::to_string(pool.outstanding));
+  printf("%-8s %-8s %10.3f %12ld %10s\n", uri.substr(5, uri.find('?') - 5).c_str(), "malloc", times[0],
+	 faults[0], "-");
+  printf("%-8s %-8s %10.3f %12ld %10ld\n", "", "pool", times[1], faults[1], reuses);
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nslices = args.get(1, 10);
+  int points = args.get(2, 512);
+  int repeats = args.get(3, 5);
+  std::string dir = args.get(4, ".");
+  std::string path = dir + "/allocator_bench";
+  std::filesystem::create_directories(path);
+
+  try {
+    printf("equilibrium of %.1f MB (%d slices of %dx%d maps), %d gets\n",
+	   nslices * (double)points * points * 8.0 / 1.0e6, nslices, points, points, repeats);
+    printf("%-8s %-8s %10s %12s %10s\n", "backend", "loop", "time (s)", "page faults", "reuses");
+    run("imas:hdf5?path=" + path, nslices, points, repeats);
+    run("imas:memory?path=" + path, nslices, points, repeats);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
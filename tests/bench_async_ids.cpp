@@ -0,0 +1,207 @@
+/*
+  Benchmark of the asynchronous whole-IDS get and put of the HDF5 backend.
+
+  A loop processes nids occurrences of a core_profiles IDS (time traces and a
+  time dependent AoS of 1D profiles, with a nested AoS of ions), and spends
+  work_ms milliseconds of simulated computation between two IDSs. The loop is
+  run four times:
+  - put: al_begin_global_action + writes + al_end_action, then work;
+  - async put: same with al_begin_global_action_async, the IDS is written on
+    the background I/O thread while the next one is computed (al_wait at the end);
+  - get: al_begin_global_action + reads + al_end_action, then work;
+  - prefetched get: the next occurrence is requested with al_prefetch_ids
+    before the current one is read, so that reading it overlaps with the work.
+  The async loops use a data entry opened with async=yes; the first gets of
+  the prefetched loop teach the fields read to the prefetch.
+  Every IDS read back is checked, the exit status is 1 if any check failed.
+
+  usage: bench_async_ids [nids] [points] [work_ms] [dir]
+  (defaults: 20 IDSs, 20000 points per profile, 20 ms, current directory)
+*/
+
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int NB_SLICES = 5;
+static const int NB_IONS = 3;
+
+static std::string idsName(int occurrence)
+{
+  return "core_profiles/" + std::to_string(occurrence);
+}
+
+static std::vector<double> profile(int occurrence, int slice, int ion, int points)
+{
+  std::vector<double> values(points);
+  for (int i = 0; i < points; i++)
+    values[i] = occurrence * 1.0e6 + slice * 1.0e4 + ion * 100.0 + i * 1.0e-3;
+  return values;
+}
+
+static void put(int pctx, int occurrence, int points, bool async)
+{
+  int octx, actx, ictx;
+  int nt = NB_SLICES, ni = NB_IONS, np = points, homogeneous = 1;
+  std::vector<double> time;
+  for (int t = 0; t < NB_SLICES; t++)
+    time.push_back(occurrence + 0.1 * t);
+
+  std::string name = idsName(occurrence);
+  if (async)
+    check(al_begin_global_action_async(pctx, name.c_str(), "", WRITE_OP, &octx), "al_begin_global_action_async");
+  else
+    check(al_begin_global_action(pctx, name.c_str(), "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_write_data(octx, "time", "time", time.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &nt, &actx),
+	"al_begin_arraystruct_action");
+  for (int t = 0; t < NB_SLICES; t++)
+    {
+      std::vector<double> te = profile(occurrence, t, 0, points);
+      check(al_write_data(actx, "time", "", &time[t], DOUBLE_DATA, 0, NULL), "al_write_data");
+      check(al_write_data(actx, "electrons/temperature", "", te.data(), DOUBLE_DATA, 1, &np), "al_write_data");
+      check(al_begin_arraystruct_action(actx, "ion", "", &ni, &ictx), "al_begin_arraystruct_action");
+      for (int i = 0; i < NB_IONS; i++)
+	{
+	  std::vector<double> density = profile(occurrence, t, i + 1, points);
+	  check(al_write_data(ictx, "density", "", density.data(), DOUBLE_DATA, 1, &np), "al_write_data");
+	  check(al_iterate_over_arraystruct(ictx, 1), "al_iterate_over_arraystruct");
+	}
+      check(al_end_action(ictx), "al_end_action");
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static std::vector<double> read1D(int ctx, const char *field, const char *timebase)
+{
+  void *data = NULL;
+  int size[MAXDIM] = {0};
+  check(al_read_data(ctx, field, timebase, &data, DOUBLE_DATA, 1, size), "al_read_data");
+  std::vector<double> values;
+  if (data != NULL)
+    values.assign((double *)data, (double *)data + size[0]);
+  free(data);
+  return values;
+}
+
+static void get(int pctx, int occurrence, int points)
+{
+  int octx, actx, ictx;
+  int size[MAXDIM];
+  int homogeneous = 0;
+  void *data = &homogeneous;
+  std::string name = idsName(occurrence);
+  check(al_begin_global_action(pctx, name.c_str(), "", READ_OP, &octx), "al_begin_global_action");
+  check(al_read_data(octx, "ids_properties/homogeneous_time", "", &data, INTEGER_DATA, 0, size), "al_read_data");
+  expect(homogeneous == 1, name + "/ids_properties/homogeneous_time");
+  std::vector<double> time = read1D(octx, "time", "time");
+  expect(time.size() == NB_SLICES && time[1] == occurrence + 0.1, name + "/time");
+  int nt = 0;
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &nt, &actx),
+	"al_begin_arraystruct_action");
+  expect(nt == NB_SLICES, name + "/profiles_1d size");
+  for (int t = 0; t < nt; t++)
+    {
+      expect(read1D(actx, "electrons/temperature", "") == profile(occurrence, t, 0, points),
+	     name + "/profiles_1d/electrons/temperature");
+      int ni = 0;
+      check(al_begin_arraystruct_action(actx, "ion", "", &ni, &ictx), "al_begin_arraystruct_action");
+      expect(ni == NB_IONS, name + "/profiles_1d/ion size");
+      for (int i = 0; i < ni; i++)
+	{
+	  expect(read1D(ictx, "density", "") == profile(occurrence, t, i + 1, points),
+		 name + "/profiles_1d/ion/density");
+	  check(al_iterate_over_arraystruct(ictx, 1), "al_iterate_over_arraystruct");
+	}
+      check(al_end_action(ictx), "al_end_action");
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nids = args.get(1, 20);
+  int points = args.get(2, 20000);
+  int workMs = args.get(3, 20);
+  std::string dir = args.get(4, ".");
+  std::string syncPath = dir + "/async_bench_sync", asyncPath = dir + "/async_bench_async";
+  std::filesystem::create_directories(syncPath);
+  std::filesystem::create_directories(asyncPath);
+
+  auto work = [workMs]() { std::this_thread::sleep_for(std::chrono::milliseconds(workMs)); };
+
+  try {
+    printf("%d IDSs of %.1f MB, %d ms of work per IDS\n", nids,
+	   NB_SLICES * (NB_IONS + 1) * points * 8.0 / 1.0e6, workMs);
+    printf("%-16s %10s %10s %10s\n", "loop", "time (s)", "IDS/s", "speedup");
+
+    auto start = std::chrono::steady_clock::now();
+    int pctx = openEntry("imas:hdf5?path=" + syncPath, FORCE_CREATE_PULSE);
+    for (int k = 0; k < nids; k++)
+      {
+	put(pctx, k, points, false);
+	work();
+      }
+    closeEntry(pctx);
+    double putTime = elapsed(start);
+    printf("%-16s %10.3f %10.1f %10.2f\n", "put", putTime, nids / putTime, 1.0);
+
+    start = std::chrono::steady_clock::now();
+    pctx = openEntry("imas:hdf5?path=" + asyncPath + "&async=yes", FORCE_CREATE_PULSE);
+    for (int k = 0; k < nids; k++)
+      {
+	put(pctx, k, points, true);
+	work();
+      }
+    check(al_wait(pctx), "al_wait");
+    closeEntry(pctx);
+    double asyncPutTime = elapsed(start);
+    printf("%-16s %10.3f %10.1f %10.2f\n", "async put", asyncPutTime, nids / asyncPutTime, putTime / asyncPutTime);
+
+    start = std::chrono::steady_clock::now();
+    pctx = openEntry("imas:hdf5?path=" + syncPath, OPEN_PULSE);
+    for (int k = 0; k < nids; k++)
+      {
+	get(pctx, k, points);
+	work();
+      }
+    closeEntry(pctx);
+    double getTime = elapsed(start);
+    printf("%-16s %10.3f %10.1f %10.2f\n", "get", getTime, nids / getTime, 1.0);
+
+    start = std::chrono::steady_clock::now();
+    pctx = openEntry("imas:hdf5?path=" + asyncPath + "&async=yes", OPEN_PULSE);
+    check(al_prefetch_ids(pctx, "core_profiles", 0), "al_prefetch_ids");
+    for (int k = 0; k < nids; k++)
+      {
+	if (k + 1 < nids)
+	  check(al_prefetch_ids(pctx, "core_profiles", k + 1), "al_prefetch_ids");
+	get(pctx, k, points);
+	work();
+      }
+    closeEntry(pctx);
+    double prefetchTime = elapsed(start);
+    printf("%-16s %10.3f %10.1f %10.2f\n", "prefetched get", prefetchTime, nids / prefetchTime,
+	   getTime / prefetchTime);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
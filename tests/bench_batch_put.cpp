@@ -0,0 +1,111 @@
+/*
+  Benchmark of per-field versus batched puts.
+
+  A synthetic IDS with 5000 leaves (an array of 50 structures holding 100 1D
+  fields each) is written with one al_write_data call per leaf, then with one
+  al_write_data_batch call per structure level.
+
+  usage: bench_batch_put [repeat] [uri...]
+  (default URIs: memory backend, and HDF5 backend in the current directory)
+*/
+
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static const int AOS_SIZE = 50;
+static const int LEAVES_PER_ELEMENT = 100;
+static const int LEAF_SIZE = 32;
+
+#define CHECK(call)							\
+  do {									\
+    al_status_t st = (call);						\
+    if (st.code < 0) {							\
+      fprintf(stderr, "%s failed: %s\n", #call, st.message);		\
+      exit(1);								\
+    }									\
+  } while (0)
+
+static double put(const std::string &uri, bool batched)
+{
+  std::vector<std::string> names;
+  for (int i = 0; i < LEAVES_PER_ELEMENT; i++)
+    names.push_back("group_" + std::to_string(i / 10) + "/leaf_" + std::to_string(i));
+  std::vector<double> values(LEAF_SIZE, 1.0);
+
+  std::vector<const char*> fields, timebases;
+  std::vector<int> datatypes, dims;
+  std::vector<void*> data;
+  std::vector<int*> sizes;
+  int leafSize = LEAF_SIZE;
+  for (const auto &name : names)
+    {
+      fields.push_back(name.c_str());
+      timebases.push_back("");
+      datatypes.push_back(DOUBLE_DATA);
+      dims.push_back(1);
+      data.push_back(values.data());
+      sizes.push_back(&leafSize);
+    }
+
+  int pctx, octx, actx;
+  CHECK(al_begin_dataentry_action(uri.c_str(), FORCE_CREATE_PULSE, &pctx));
+
+  auto start = std::chrono::steady_clock::now();
+  CHECK(al_begin_global_action(pctx, "core_profiles", "", WRITE_OP, &octx));
+  int homogeneous = 1;
+  CHECK(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL));
+  int aosSize = AOS_SIZE;
+  CHECK(al_begin_arraystruct_action(octx, "profiles_1d", "", &aosSize, &actx));
+  for (int e = 0; e < AOS_SIZE; e++)
+    {
+      if (batched)
+	CHECK(al_write_data_batch(actx, LEAVES_PER_ELEMENT, fields.data(), timebases.data(),
+				  datatypes.data(), dims.data(), data.data(), sizes.data()));
+      else
+	for (int i = 0; i < LEAVES_PER_ELEMENT; i++)
+	  CHECK(al_write_data(actx, fields[i], timebases[i], data[i], datatypes[i], dims[i], sizes[i]));
+      CHECK(al_iterate_over_arraystruct(actx, 1));
+    }
+  CHECK(al_end_action(actx));
+  CHECK(al_end_action(octx));
+  double seconds = elapsed(start);
+
+  CHECK(al_close_pulse(pctx, CLOSE_PULSE));
+  CHECK(al_end_action(pctx));
+  return seconds;
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int repeat = args.get(1, 5);
+  std::vector<std::string> uris;
+  for (int i = 2; i < argc; i++)
+    uris.push_back(argv[i]);
+  if (uris.empty())
+    {
+      uris.push_back("imas:memory?path=bench_batch_put");
+      uris.push_back("imas:hdf5?path=bench_batch_put");
+    }
+
+  printf("%d leaves per put, best of %d\n", AOS_SIZE * LEAVES_PER_ELEMENT, repeat);
+  printf("%-40s %14s %14s %9s\n", "uri", "per-field (ms)", "batched (ms)", "speedup");
+  for (const auto &uri : uris)
+    {
+      double best[2] = {1e30, 1e30};
+      for (int r = 0; r < repeat; r++)
+	for (int batched = 0; batched < 2; batched++)
+	  {
+	    double t = put(uri, batched);
+	    if (t < best[batched])
+	      best[batched] = t;
+	  }
+      printf("%-40s %14.2f %14.2f %9.2f\n", uri.c_str(), best[0] * 1e3, best[1] * 1e3, best[0] / best[1]);
+    }
+  return 0;
+}
@@ -0,0 +1,182 @@
+/*
+  Benchmark of the read-through cache of static data (URI option cache=memory)
+  in front of the HDF5 backend.
+
+  A wall IDS is written with one 2D description made of nunits limiter units,
+  each holding an outline of points (r, z) values. Its static data is then got
+  repeats times from the same data entry, the way a code reading the machine
+  description at each of its cycles does:
+  - get: data entry opened without cache;
+  - cached get: data entry opened with cache=memory, the first get fills the
+    cache, the following ones are served from memory.
+  Every get checks the data read. The hits and misses reported by
+  al_get_statistics are checked, then a put in the cached data entry, and a
+  put through another data entry opened on the same file, must invalidate the
+  cache so that the next get reads the new data. The exit status is 1 if any
+  check failed.
+
+  usage: bench_cache [nunits] [points] [repeats] [dir]
+  (defaults: 200 units, 1000 points, 20 repeats, current directory)
+*/
+
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static double value(int version, int unit, int coordinate, int i)
+{
+  return version * 1.0e6 + unit * 1.0e2 + coordinate * 10.0 + i * 1.0e-3;
+}
+
+static void put(int pctx, int version, int nunits, int points)
+{
+  int octx, dctx, uctx;
+  int one = 1, nu = nunits, np = points, homogeneous = 1;
+  // a put first deletes the IDS
+  check(al_begin_global_action(pctx, "wall", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_delete_data(octx, ""), "al_delete_data");
+  check(al_end_action(octx), "al_end_action");
+  check(al_begin_global_action(pctx, "wall", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_begin_arraystruct_action(octx, "description_2d", "", &one, &dctx), "al_begin_arraystruct_action");
+  check(al_begin_arraystruct_action(dctx, "limiter/unit", "", &nu, &uctx), "al_begin_arraystruct_action");
+  for (int u = 0; u < nunits; u++)
+    {
+      std::vector<double> r(points), z(points);
+      for (int i = 0; i < points; i++)
+	{
+	  r[i] = value(version, u, 0, i);
+	  z[i] = value(version, u, 1, i);
+	}
+      check(al_write_data(uctx, "outline/r", "", r.data(), DOUBLE_DATA, 1, &np), "al_write_data");
+      check(al_write_data(uctx, "outline/z", "", z.data(), DOUBLE_DATA, 1, &np), "al_write_data");
+      check(al_iterate_over_arraystruct(uctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(uctx), "al_end_action");
+  check(al_iterate_over_arraystruct(dctx, 1), "al_iterate_over_arraystruct");
+  check(al_end_action(dctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void readOutline(int ctx, const char *field, int version, int unit, int coordinate, int points)
+{
+  void *data = NULL;
+  int size[MAXDIM] = {0};
+  check(al_read_data(ctx, field, "", &data, DOUBLE_DATA, 1, size), "al_read_data");
+  expect(data != NULL && size[0] == points, field);
+  double *values = (double *)data;
+  expect(values[0] == value(version, unit, coordinate, 0) &&
+	 values[points - 1] == value(version, unit, coordinate, points - 1), field);
+  free(data);
+}
+
+// get of the static data of the wall IDS, as done by a high level interface
+static void get(int pctx, int version, int nunits, int points)
+{
+  int octx, dctx, uctx;
+  check(al_begin_global_action(pctx, "wall", "", READ_OP, &octx), "al_begin_global_action");
+  int homogeneous = -1;
+  void *data = &homogeneous;
+  int size[MAXDIM];
+  check(al_read_data(octx, "ids_properties/homogeneous_time", "", &data, INTEGER_DATA, 0, size), "al_read_data");
+  expect(homogeneous == 1, "ids_properties/homogeneous_time");
+  int nd = 0;
+  check(al_begin_arraystruct_action(octx, "description_2d", "", &nd, &dctx), "al_begin_arraystruct_action");
+  expect(nd == 1, "description_2d size");
+  int nu = 0;
+  check(al_begin_arraystruct_action(dctx, "limiter/unit", "", &nu, &uctx), "al_begin_arraystruct_action");
+  expect(nu == nunits, "limiter/unit size");
+  for (int u = 0; u < nu; u++)
+    {
+      readOutline(uctx, "outline/r", version, u, 0, points);
+      readOutline(uctx, "outline/z", version, u, 1, points);
+      check(al_iterate_over_arraystruct(uctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(uctx), "al_end_action");
+  check(al_end_action(dctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+// reads a counter of the "cache" object of al_get_statistics
+static long long cacheCounter(int pctx, const std::string &name)
+{
+  char *json = NULL;
+  check(al_get_statistics(pctx, &json), "al_get_statistics");
+  std::string s(json);
+  free(json);
+  size_t cache = s.find("\"cache\"");
+  size_t found = (cache == std::string::npos) ? cache : s.find("\"" + name + "\": ", cache);
+  if (found == std::string::npos)
+    throw std::runtime_error("no cache " + name + " in the statistics: " + s);
+  return atoll(s.c_str() + found + name.size() + 4);
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nunits = args.get(1, 200);
+  int points = args.get(2, 1000);
+  int repeats = args.get(3, 20);
+  std::string dir = args.get(4, ".");
+  std::string path = dir + "/cache_bench";
+  std::filesystem::create_directories(path);
+  if (repeats < 2)
+    repeats = 2;
+
+
+  try {
+    std::string uri = "imas:hdf5?path=" + path;
+    printf("wall of %.1f MB (%d units of %d points), %d gets\n", nunits * 2.0 * points * 8.0 / 1.0e6, nunits,
+	   points, repeats);
+    int pctx = openEntry(uri, FORCE_CREATE_PULSE);
+    put(pctx, 1, nunits, points);
+    closeEntry(pctx);
+
+    printf("%-16s %10s %10s\n", "loop", "time (s)", "speedup");
+    pctx = openEntry(uri, OPEN_PULSE);
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+      get(pctx, 1, nunits, points);
+    double getTime = elapsed(start);
+    printf("%-16s %10.3f %10.2f\n", "get", getTime, 1.0);
+    closeEntry(pctx);
+
+    pctx = openEntry(uri + "&cache=memory", OPEN_PULSE);
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+      get(pctx, 1, nunits, points);
+    double cachedTime = elapsed(start);
+    printf("%-16s %10.3f %10.2f\n", "cached get", cachedTime, getTime / cachedTime);
+
+    long long fields = 1 + 2LL * nunits;
+    expect(cacheCounter(pctx, "misses") == fields, "cache misses");
+    expect(cacheCounter(pctx, "hits") == fields * (repeats - 1), "cache hits");
+
+    // the put empties the cache, the new data is read back
+    put(pctx, 2, nunits, points);
+    expect(cacheCounter(pctx, "invalidations") == 1, "cache invalidations");
+    get(pctx, 2, nunits, points);
+    expect(cacheCounter(pctx, "misses") == 2 * fields, "cache misses after put");
+
+    // so does a put through another data entry on the same file
+    int wctx = openEntry("imas:hdf5?path=" + dir + "/./cache_bench", OPEN_PULSE);
+    put(wctx, 3, nunits, points);
+    closeEntry(wctx);
+    get(pctx, 3, nunits, points);
+    expect(cacheCounter(pctx, "invalidations") == 2, "cache invalidations after a put of another data entry");
+    closeEntry(pctx);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,71 @@
+/*
+  Scaffolding shared by the bench_* programs: checks of the calls of the
+  low-level API and of the data read back, timing, data entries and
+  positional arguments. A failed check throws std::runtime_error, which main
+  reports before exiting with status 1.
+
+  A program whose checks are not about the data read back defines
+  BENCH_WRONG (e.g. "wrong tree") before including this file.
+*/
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H 1
+
+#include <al_lowlevel.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#ifndef BENCH_WRONG
+#define BENCH_WRONG "wrong data read back"
+#endif
+
+inline void check(al_status_t st, const char *what)
+{
+  if (st.code < 0)
+    throw std::runtime_error(std::string(what) + ": " + st.message);
+}
+
+inline void expect(bool condition, const std::string &what)
+{
+  if (!condition)
+    throw std::runtime_error(BENCH_WRONG ": " + what);
+}
+
+// seconds since start
+inline double elapsed(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline int openEntry(const std::string &uri, int mode)
+{
+  int pctx;
+  check(al_begin_dataentry_action(uri.c_str(), mode, &pctx), "al_begin_dataentry_action");
+  return pctx;
+}
+
+inline void closeEntry(int pctx)
+{
+  check(al_close_pulse(pctx, CLOSE_PULSE), "al_close_pulse");
+  check(al_end_action(pctx), "al_end_action");
+}
+
+// positional arguments of the command line (argv[1] is argument 1), their default when missing
+class Args
+{
+public:
+  Args(int argc, char *argv[]) : argc(argc), argv(argv) {}
+
+  int get(int i, int defaultValue) const { return (argc > i) ? atoi(argv[i]) : defaultValue; }
+  long get(int i, long defaultValue) const { return (argc > i) ? atol(argv[i]) : defaultValue; }
+  std::string get(int i, const char *defaultValue) const { return (argc > i) ? argv[i] : defaultValue; }
+
+private:
+  int argc;
+  char **argv;
+};
+
+#endif
@@ -0,0 +1,230 @@
+/*
+  Stress test and scaling benchmark of independent data entries used from
+  concurrent threads.
+
+  Each worker thread owns its data entry and repeatedly puts a core_profiles
+  IDS (scalars, time traces and a time dependent AoS of 1D profiles) filled
+  with values derived from the thread and iteration numbers, then gets it back
+  and checks every value, so that data leaking between entries or corrupted
+  by a race is detected. The memory backend is read back through the same
+  data entry, the flexbuffers backend through a new entry restored from the
+  serialized buffer and the HDF5 backend through a new entry opened on the
+  written files.
+
+  The run is repeated with 1, 2, 4, ... threads up to max_threads, and the
+  throughput (put+get cycles per second) and speedup over one thread are
+  reported for each backend. The exit status is 1 if any check failed.
+
+  usage: bench_concurrent_entries [iterations] [max_threads] [backends] [dir]
+  (defaults: 20 iterations per thread, 4 threads, memory,flexbuffers,hdf5, current directory)
+*/
+
+#include "bench_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int NB_SLICES = 5;
+static const int NB_POINTS = 200;
+
+/**
+   Content of the IDS written by one iteration of one thread.
+*/
+struct Content
+{
+  std::vector<double> time, ip, temperature[NB_SLICES];
+
+  Content(long seed)
+  {
+    for (int t = 0; t < NB_SLICES; t++)
+      {
+	time.push_back(seed + 0.1 * t);
+	ip.push_back(2.0 * seed + t);
+	for (int i = 0; i < NB_POINTS; i++)
+	  temperature[t].push_back(seed + 1000.0 * t + i);
+      }
+  }
+};
+
+class Worker
+{
+public:
+  Worker(const std::string &b, const std::string &dir, int t) : backend(b)
+  {
+    std::string path = dir + "/" + backend + "_" + std::to_string(t);
+    std::filesystem::create_directories(path);
+    uri = "imas:" + backend + "?path=" + path;
+  }
+
+  // one put and get cycle
+  void cycle(long seed)
+  {
+    Content content(seed);
+    int pctx = openEntry(uri, FORCE_CREATE_PULSE);
+    put(pctx, content);
+    if (backend == "memory")
+      {
+	// memory entries vanish when their last handle is closed
+	get(pctx, content);
+	closeEntry(pctx);
+	return;
+      }
+
+    std::vector<char> buffer;
+    if (backend == "flexbuffers")
+      {
+	void *serialized = NULL;
+	int size;
+	check(al_read_data(pctx, "<buffer>", "", &serialized, CHAR_DATA, 1, &size), "al_read_data");
+	buffer.assign((char *)serialized, (char *)serialized + size);
+	free(serialized);
+      }
+    closeEntry(pctx);
+
+    pctx = openEntry(uri, OPEN_PULSE);
+    if (backend == "flexbuffers")
+      {
+	int size = buffer.size();
+	check(al_write_data(pctx, "<buffer>", "", buffer.data(), CHAR_DATA, 1, &size), "al_write_data");
+      }
+    get(pctx, content);
+    closeEntry(pctx);
+  }
+
+private:
+  void put(int pctx, Content &c)
+  {
+    int octx, actx;
+    int nt = NB_SLICES, np = NB_POINTS, homogeneous = 1;
+    check(al_begin_global_action(pctx, "core_profiles", "", WRITE_OP, &octx), "al_begin_global_action");
+    check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	  "al_write_data");
+    check(al_write_data(octx, "time", "time", c.time.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+    check(al_write_data(octx, "global_quantities/ip", "time", c.ip.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+    check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &nt, &actx),
+	  "al_begin_arraystruct_action");
+    for (int t = 0; t < NB_SLICES; t++)
+      {
+	check(al_write_data(actx, "time", "", &c.time[t], DOUBLE_DATA, 0, NULL), "al_write_data");
+	check(al_write_data(actx, "electrons/temperature", "", c.temperature[t].data(), DOUBLE_DATA, 1, &np),
+	      "al_write_data");
+	check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+      }
+    check(al_end_action(actx), "al_end_action");
+    check(al_end_action(octx), "al_end_action");
+  }
+
+  std::vector<double> read1D(int ctx, const char *field, const char *timebase)
+  {
+    void *data = NULL;
+    int size[MAXDIM] = {0};
+    check(al_read_data(ctx, field, timebase, &data, DOUBLE_DATA, 1, size), "al_read_data");
+    std::vector<double> values;
+    if (data != NULL)
+      values.assign((double *)data, (double *)data + size[0]);
+    free(data);
+    return values;
+  }
+
+  void get(int pctx, Content &c)
+  {
+    int octx, actx;
+    int size[MAXDIM];
+    int homogeneous = 0;
+    void *data = &homogeneous;
+    check(al_begin_global_action(pctx, "core_profiles", "", READ_OP, &octx), "al_begin_global_action");
+    check(al_read_data(octx, "ids_properties/homogeneous_time", "", &data, INTEGER_DATA, 0, size), "al_read_data");
+    expect(homogeneous == 1, "ids_properties/homogeneous_time");
+    expect(read1D(octx, "time", "time") == c.time, "time");
+    expect(read1D(octx, "global_quantities/ip", "time") == c.ip, "global_quantities/ip");
+    int nt = 0;
+    check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &nt, &actx),
+	  "al_begin_arraystruct_action");
+    expect(nt == NB_SLICES, "size of profiles_1d");
+    for (int t = 0; t < nt; t++)
+      {
+	double time = 0;
+	data = &time;
+	check(al_read_data(actx, "time", "", &data, DOUBLE_DATA, 0, size), "al_read_data");
+	expect(time == c.time[t], "profiles_1d/time");
+	expect(read1D(actx, "electrons/temperature", "") == c.temperature[t], "profiles_1d/electrons/temperature");
+	check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+      }
+    check(al_end_action(actx), "al_end_action");
+    check(al_end_action(octx), "al_end_action");
+  }
+
+  std::string backend;
+  std::string uri;
+};
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int iterations = args.get(1, 20);
+  int maxThreads = args.get(2, 4);
+  std::string backendList = args.get(3, "memory,flexbuffers,hdf5");
+  std::string dir = args.get(4, ".");
+  if (maxThreads < 1)
+    maxThreads = 1;
+
+  std::vector<std::string> backends;
+  std::stringstream ss(backendList);
+  for (std::string b; std::getline(ss, b, ',');)
+    if (!b.empty())
+      backends.push_back(b);
+
+  int failures = 0;
+  printf("%-12s %8s %14s %10s %10s\n", "backend", "threads", "cycles/s", "speedup", "errors");
+  for (const auto &backend : backends)
+    {
+      double reference = 0;
+      for (int nthreads = 1; nthreads <= maxThreads; nthreads *= 2)
+	{
+	  std::atomic<int> errors(0);
+	  std::mutex messageMutex;
+	  std::string message;
+	  auto start = std::chrono::steady_clock::now();
+	  std::vector<std::thread> workers;
+	  for (int t = 0; t < nthreads; t++)
+	    workers.emplace_back([&, t]() {
+		try {
+		  Worker worker(backend, dir, t);
+		  for (int k = 0; k < iterations; k++)
+		    worker.cycle(1000003L * (t + 1) + k);
+		}
+		catch (const std::exception &e) {
+		  errors++;
+		  std::lock_guard<std::mutex> guard(messageMutex);
+		  if (message.empty())
+		    message = e.what();
+		}
+	      });
+	  for (auto &w : workers)
+	    w.join();
+	  double seconds = elapsed(start);
+
+	  double rate = (double)iterations * nthreads / seconds;
+	  if (nthreads == 1)
+	    reference = rate;
+	  printf("%-12s %8d %14.1f %10.2f %10d\n", backend.c_str(), nthreads, rate,
+		 reference > 0 ? rate / reference : 0.0, errors.load());
+	  if (errors > 0)
+	    {
+	      fprintf(stderr, "%s, %d threads: %s\n", backend.c_str(), nthreads, message.c_str());
+	      failures++;
+	    }
+	}
+    }
+
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/*
+  Microbenchmark of the type conversion of the data returned by the backends.
+
+  Lowlevel::setConvertedValue converts the malloc'd buffer returned by a
+  backend when its type differs from the requested one. Each conversion of
+  an array of n elements is compared with the previous implementation
+  (allocation of a second buffer filled with std::copy_n, then release of the
+  source buffer):
+  - integer -> double (the buffer is grown with realloc, SIMD kernel);
+  - double -> integer (in place, SIMD kernel);
+  - complex -> double (in place, real part, previously not converted);
+  - n scalar integer -> double conversions (straight into the variable).
+  Every converted array is checked, the exit status is 1 if any check failed.
+
+  usage: bench_convert [n] [repeats]
+  (defaults: 10000000 elements, 5 repeats)
+*/
+
+#define BENCH_WRONG "wrong conversion"
+#include "bench_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// buffer as returned by a backend
+template <typename T>
+static T* source(size_t n)
+{
+  T *data = (T *)malloc(n * sizeof(T));
+  for (size_t i = 0; i < n; i++)
+    data[i] = T((int)(i % 1000003) - 500000);
+  return data;
+}
+
+// called through a volatile pointer, so that the compiler does not elide the allocations
+static void *(*volatile allocate)(size_t) = malloc;
+
+// previous implementation of Lowlevel::setConvertedValue for arrays
+template <typename From, typename To>
+static To* reference(From *data, size_t n)
+{
+  To *convdata = (To *)allocate(n * sizeof(To));
+  std::copy_n(data, n, convdata);
+  free(data);
+  return convdata;
+}
+
+template <typename From, typename To>
+static void run(const char *name, int srctype, int desttype, size_t n, int repeats)
+{
+  // the previous implementation could not convert complex data
+  constexpr bool hasReference = std::is_convertible<From, To>::value;
+  double refTime = 0.0, newTime = 0.0;
+  int size[1] = {(int)n};
+  for (int r = 0; r < repeats; r++)
+    {
+      if constexpr (hasReference)
+	{
+	  From *data = source<From>(n);
+	  auto start = std::chrono::steady_clock::now();
+	  To *converted = reference<From, To>(data, n);
+	  refTime += elapsed(start);
+	  free(converted);
+	}
+
+      From *data = source<From>(n);
+      void *var = NULL;
+      auto start = std::chrono::steady_clock::now();
+      Lowlevel::setConvertedValue(data, srctype, 1, size, desttype, &var);
+      newTime += elapsed(start);
+      To *converted = (To *)var;
+      for (size_t i = 0; i < n; i += 997)
+	expect(converted[i] == To((int)(i % 1000003) - 500000), std::string(name) + " element " + std::to_string(i));
+      expect(converted[n - 1] == To((int)((n - 1) % 1000003) - 500000), std::string(name) + " last element");
+      free(converted);
+    }
+  if (hasReference)
+    printf("%-20s %12.3f %12.3f %10.2f\n", name, refTime * 1000.0 / repeats, newTime * 1000.0 / repeats,
+	   refTime / newTime);
+  else
+    printf("%-20s %12s %12.3f %10s\n", name, "-", newTime * 1000.0 / repeats, "-");
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  size_t n = args.get(1, 10000000L);
+  int repeats = args.get(2, 5);
+  if (n < 1)
+    n = 1;
+
+  try {
+    printf("%zu elements, %d repeats\n", n, repeats);
+    printf("%-20s %12s %12s %10s\n", "conversion", "copy (ms)", "new (ms)", "speedup");
+    run<int, double>("int -> double", INTEGER_DATA, DOUBLE_DATA, n, repeats);
+    run<double, int>("double -> int", DOUBLE_DATA, INTEGER_DATA, n, repeats);
+    run<std::complex<double>, double>("complex -> double", COMPLEX_DATA, DOUBLE_DATA, n, repeats);
+
+    // scalars: previously converted into a malloc'd copy, then copied into the variable
+    double refTime = 0.0, newTime = 0.0;
+    for (int r = 0; r < repeats; r++)
+      {
+	auto start = std::chrono::steady_clock::now();
+	double sum = 0.0;
+	for (size_t i = 0; i < n / 10; i++)
+	  {
+	    int *data = (int *)allocate(sizeof(int));
+	    *data = (int)i;
+	    double *converted = reference<int, double>(data, 1);
+	    sum += *converted;
+	    free(converted);
+	  }
+	refTime += elapsed(start);
+	start = std::chrono::steady_clock::now();
+	double sum2 = 0.0;
+	for (size_t i = 0; i < n / 10; i++)
+	  {
+	    int *data = (int *)allocate(sizeof(int));
+	    *data = (int)i;
+	    double value;
+	    void *var = &value;
+	    Lowlevel::setConvertedValue(data, INTEGER_DATA, 0, NULL, DOUBLE_DATA, &var);
+	    sum2 += value;
+	  }
+	newTime += elapsed(start);
+	expect(sum == sum2, "scalar int -> double");
+      }
+    printf("%-20s %12.3f %12.3f %10.2f\n", "scalars", refTime * 1000.0 / repeats, newTime * 1000.0 / repeats,
+	   refTime / newTime);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,213 @@
+/*
+  Benchmark of the deduplication of the arrays written (URI option dedup=yes).
+
+  A core_profiles IDS holding ntimes elements of profiles_1d is put, every
+  element with the same radial grid and an ion temperature equal to its
+  electron temperature, as written by codes assuming Ti = Te. nslices more
+  elements (with Ti != Te) are then appended by put_slice. The time of the put
+  and of a slice, the dedup ratio reported by al_get_statistics and, for HDF5,
+  the size of the IDS file are reported without and with dedup=yes, for the
+  memory and HDF5 backends.
+  The IDS read back must match what was written, also after reopening the HDF5
+  entry, and the arrays expected to be shared must be reported as such. The
+  exit status is 1 if any check failed.
+
+  usage: bench_dedup [ntimes] [npoints] [nslices] [dir]
+  (defaults: 200 elements, 500 points, 20 slices, current directory)
+*/
+
+#define BENCH_WRONG "wrong dedup"
+#include "bench_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *FIELDS[] = {"grid/rho_tor_norm", "electrons/density", "electrons/temperature", "t_i_average"};
+static const int NB_FIELDS = 4;
+
+struct Profile
+{
+  double time;
+  std::vector<double> fields[NB_FIELDS];
+};
+
+static Profile profile(int e, int npoints, bool sameTemperatures)
+{
+  Profile p;
+  p.time = e * 0.1;
+  for (int i = 0; i < npoints; i++)
+    {
+      double x = i / (double)npoints;
+      p.fields[0].push_back(x);
+      p.fields[1].push_back(1.0e19 * (1.0 + e * 1.0e-3) * (1.0 - x * x));
+      p.fields[2].push_back(5.0e3 * (1.0 + e * 1.0e-3) * (1.0 - x));
+    }
+  p.fields[3] = p.fields[2];
+  if (!sameTemperatures)
+    for (double &v : p.fields[3])
+      v *= 0.9;
+  return p;
+}
+
+static void writeProfiles(int octx, const std::vector<Profile> &profiles, size_t first)
+{
+  int actx, n = (int)(profiles.size() - first);
+  std::vector<double> time;
+  for (size_t e = first; e < profiles.size(); e++)
+    time.push_back(profiles[e].time);
+  check(al_write_data(octx, "time", "time", time.data(), DOUBLE_DATA, 1, &n), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &n, &actx), "al_begin_arraystruct_action");
+  for (size_t e = first; e < profiles.size(); e++)
+    {
+      check(al_write_data(actx, "time", "", (void *)&profiles[e].time, DOUBLE_DATA, 0, NULL), "al_write_data");
+      for (int f = 0; f < NB_FIELDS; f++)
+	{
+	  int size = (int)profiles[e].fields[f].size();
+	  check(al_write_data(actx, FIELDS[f], "", (void *)profiles[e].fields[f].data(), DOUBLE_DATA, 1, &size),
+		"al_write_data");
+	}
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+}
+
+static void put(int pctx, const std::vector<Profile> &profiles)
+{
+  int octx, homogeneous = 1;
+  check(al_begin_global_action(pctx, "core_profiles", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_delete_data(octx, ""), "al_delete_data");
+  check(al_end_action(octx), "al_end_action");
+  check(al_begin_global_action(pctx, "core_profiles", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  writeProfiles(octx, profiles, 0);
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void putSlice(int pctx, const std::vector<Profile> &profiles)
+{
+  int octx;
+  check(al_begin_slice_action(pctx, "core_profiles", WRITE_OP, profiles.back().time, CLOSEST_INTERP, &octx),
+	"al_begin_slice_action");
+  writeProfiles(octx, profiles, profiles.size() - 1);
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void verify(int pctx, const std::vector<Profile> &profiles)
+{
+  int octx, actx, n = 0;
+  check(al_begin_global_action(pctx, "core_profiles", "", READ_OP, &octx), "al_begin_global_action");
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &n, &actx), "al_begin_arraystruct_action");
+  expect(n == (int)profiles.size(), "profiles_1d size " + std::to_string(n));
+  for (int e = 0; e < n; e++)
+    {
+      for (int f = 0; f < NB_FIELDS; f++)
+	{
+	  void *data = NULL;
+	  int size[MAXDIM] = {0};
+	  check(al_read_data(actx, FIELDS[f], "", &data, DOUBLE_DATA, 1, size), "al_read_data");
+	  std::string what = "profiles_1d[" + std::to_string(e) + "]/" + FIELDS[f];
+	  const std::vector<double> &expected = profiles[e].fields[f];
+	  expect(data != NULL && size[0] == (int)expected.size(), what + " size");
+	  expect(std::equal(expected.begin(), expected.end(), (double *)data), what + " values");
+	  // the arrays returned are independent copies, even when stored once
+	  ((double *)data)[0] = -1.0;
+	  al_free_data(data);
+	}
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+// value following the given key in the "dedup" object of the statistics, -1 if missing
+static double counter(int pctx, const std::string &key)
+{
+  char *json = NULL;
+  check(al_get_statistics(pctx, &json), "al_get_statistics");
+  std::string s(json);
+  free(json);
+  size_t pos = s.find("\"dedup\": ");
+  if (pos == std::string::npos || (pos = s.find("\"" + key + "\": ", pos)) == std::string::npos)
+    return -1;
+  return atof(s.c_str() + pos + key.size() + 4);
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int ntimes = args.get(1, 200);
+  int npoints = args.get(2, 500);
+  int nslices = args.get(3, 20);
+  std::string dir = args.get(4, ".");
+  std::string path = dir + "/dedup_bench";
+
+  try {
+    printf("core_profiles of %.1f MB (%d profiles of %d points), %d slices\n",
+	   ntimes * (double)npoints * NB_FIELDS * 8 / 1.0e6, ntimes, npoints, nslices);
+    printf("%-40s %10s %12s %8s %12s\n", "uri", "put (ms)", "slice (ms)", "ratio", "file (MB)");
+    for (const char *backend : {"memory", "hdf5"})
+      for (bool dedup : {false, true})
+	{
+	  std::string uri = std::string("imas:") + backend + "?path=" + path;
+	  if (dedup)
+	    uri += "&dedup=yes";
+	  bool hdf5 = std::string(backend) == "hdf5";
+	  std::filesystem::remove_all(path);
+	  std::filesystem::create_directories(path);
+
+	  std::vector<Profile> profiles;
+	  for (int e = 0; e < ntimes; e++)
+	    profiles.push_back(profile(e, npoints, true));
+	  int pctx = openEntry(uri, FORCE_CREATE_PULSE);
+	  auto start = std::chrono::steady_clock::now();
+	  put(pctx, profiles);
+	  double putTime = elapsed(start);
+	  verify(pctx, profiles);
+
+	  // the grid is shared by all the elements, Ti with Te: memory shares each array, HDF5 the whole
+	  // dataset of Ti (all the elements of a field are stored in one dataset)
+	  double field = (double)npoints * 8;
+	  double shared = dedup ? counter(pctx, "shared_bytes") : 0;
+	  if (dedup)
+	    expect(shared >= (hdf5 ? ntimes * field : (2.0 * ntimes - 1) * field), "shared bytes of the put");
+	  double ratio = dedup ? counter(pctx, "ratio") : 1.0;
+	  double fileSize = hdf5 ? std::filesystem::file_size(path + "/core_profiles.h5") / 1.0e6 : 0.0;
+
+	  start = std::chrono::steady_clock::now();
+	  for (int s = 0; s < nslices; s++)
+	    {
+	      profiles.push_back(profile(ntimes + s, npoints, false));
+	      putSlice(pctx, profiles);
+	    }
+	  double sliceTime = elapsed(start);
+	  verify(pctx, profiles);
+	  if (dedup && !hdf5)
+	    expect(counter(pctx, "shared_bytes") >= shared + nslices * field, "shared bytes of the slices");
+	  closeEntry(pctx);
+
+	  printf("%-40s %10.2f %12.2f %8.2f %12.2f\n", uri.c_str(), putTime * 1e3,
+		 nslices > 0 ? sliceTime / nslices * 1e3 : 0.0, ratio, fileSize);
+
+	  // the IDS is read back from the file when opened again
+	  if (hdf5)
+	    {
+	      pctx = openEntry(uri, OPEN_PULSE);
+	      verify(pctx, profiles);
+	      closeEntry(pctx);
+	    }
+	}
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
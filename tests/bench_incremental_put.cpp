@@ -0,0 +1,201 @@
+/*
+  Benchmark of the incremental put (URI option incremental_put=yes).
+
+  A core_profiles IDS holding nprofiles elements of profiles_1d, each with four
+  1D fields of npoints values, is put niter times in a row the way an
+  iterative solver does: every put writes the whole IDS, only the ion and
+  electron temperatures of one element changed since the previous put. The
+  mean time per put is reported without and with incremental_put=yes, for the
+  memory and HDF5 backends, with the bytes written and saved reported by
+  al_get_statistics.
+  The IDS read back must match the last put. Three more puts follow a put
+  through another data entry, change the shape of a field (HDF5 rewrites the
+  whole IDS for both) and remove the last element. The exit status is 1 if
+  any check failed.
+
+  usage: bench_incremental_put [nprofiles] [npoints] [niter] [dir]
+  (defaults: 100 profiles, 1000 points, 20 puts, current directory)
+*/
+
+#define BENCH_WRONG "wrong incremental put"
+#include "bench_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *FIELDS[] = {"grid/rho_tor_norm", "electrons/density", "electrons/temperature", "t_i_average"};
+static const int NB_FIELDS = 4;
+
+// profiles[element][field] as last put
+typedef std::vector<std::vector<std::vector<double>>> Profiles;
+
+static void put(int pctx, const Profiles &profiles)
+{
+  int octx, actx;
+  // as done by the high level: the IDS is deleted, then written
+  check(al_begin_global_action(pctx, "core_profiles", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_delete_data(octx, ""), "al_delete_data");
+  check(al_end_action(octx), "al_end_action");
+
+  int homogeneous = 1, n = (int)profiles.size();
+  std::vector<double> time(n);
+  for (int e = 0; e < n; e++)
+    time[e] = e * 0.1;
+  check(al_begin_global_action(pctx, "core_profiles", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_write_data(octx, "time", "", time.data(), DOUBLE_DATA, 1, &n), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "time", &n, &actx), "al_begin_arraystruct_action");
+  for (int e = 0; e < n; e++)
+    {
+      for (int f = 0; f < NB_FIELDS; f++)
+	{
+	  int size = (int)profiles[e][f].size();
+	  check(al_write_data(actx, FIELDS[f], "", (void *)profiles[e][f].data(), DOUBLE_DATA, 1, &size),
+		"al_write_data");
+	}
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void verify(int pctx, const Profiles &profiles)
+{
+  int octx, actx, n = 0;
+  check(al_begin_global_action(pctx, "core_profiles", "", READ_OP, &octx), "al_begin_global_action");
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "time", &n, &actx), "al_begin_arraystruct_action");
+  expect(n == (int)profiles.size(), "profiles_1d size " + std::to_string(n));
+  for (int e = 0; e < n; e++)
+    {
+      for (int f = 0; f < NB_FIELDS; f++)
+	{
+	  void *data = NULL;
+	  int size[MAXDIM] = {0};
+	  check(al_read_data(actx, FIELDS[f], "", &data, DOUBLE_DATA, 1, size), "al_read_data");
+	  std::string what = "profiles_1d[" + std::to_string(e) + "]/" + FIELDS[f];
+	  expect(data != NULL && size[0] == (int)profiles[e][f].size(), what + " size");
+	  expect(std::equal(profiles[e][f].begin(), profiles[e][f].end(), (double *)data), what + " values");
+	  al_free_data(data);
+	}
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+// value following the given key in the "incremental_put" object of the statistics, -1 if missing
+static long long counter(int pctx, const std::string &key)
+{
+  char *json = NULL;
+  check(al_get_statistics(pctx, &json), "al_get_statistics");
+  std::string s(json);
+  free(json);
+  size_t pos = s.find("\"incremental_put\": ");
+  if (pos == std::string::npos || (pos = s.find("\"" + key + "\": ", pos)) == std::string::npos)
+    return -1;
+  return atoll(s.c_str() + pos + key.size() + 4);
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nprofiles = args.get(1, 100);
+  int npoints = args.get(2, 1000);
+  int niter = args.get(3, 20);
+  std::string dir = args.get(4, ".");
+  std::string path = dir + "/incremental_put_bench";
+  std::filesystem::create_directories(path);
+
+  try {
+    printf("core_profiles of %.1f MB (%d profiles of %d points), %d puts\n",
+	   nprofiles * (double)npoints * NB_FIELDS * 8 / 1.0e6, nprofiles, npoints, niter);
+    printf("%-40s %12s %14s %14s\n", "uri", "put (ms)", "written (MB)", "saved (MB)");
+    for (const char *backend : {"memory", "hdf5"})
+      for (bool incremental : {false, true})
+	{
+	  std::string uri = std::string("imas:") + backend + "?path=" + path;
+	  if (incremental)
+	    uri += "&incremental_put=yes";
+
+	  Profiles profiles(nprofiles, std::vector<std::vector<double>>(NB_FIELDS));
+	  for (int e = 0; e < nprofiles; e++)
+	    for (int f = 0; f < NB_FIELDS; f++)
+	      for (int i = 0; i < npoints; i++)
+		profiles[e][f].push_back(e + f * 1.0e3 + i * 1.0e-3);
+
+	  int pctx = openEntry(uri, FORCE_CREATE_PULSE);
+	  put(pctx, profiles);
+	  auto start = std::chrono::steady_clock::now();
+	  for (int it = 1; it <= niter; it++)
+	    {
+	      // a solver iteration: the temperatures of one element change
+	      for (int f : {2, 3})
+		for (double &v : profiles[it % nprofiles][f])
+		  v += 1.0;
+	      put(pctx, profiles);
+	    }
+	  double seconds = elapsed(start);
+	  verify(pctx, profiles);
+
+	  long long written = incremental ? counter(pctx, "bytes_written") : 0;
+	  long long saved = incremental ? counter(pctx, "bytes_saved") : 0;
+	  printf("%-40s %12.2f %14.2f %14.2f\n", uri.c_str(), seconds / niter * 1e3, written / 1.0e6, saved / 1.0e6);
+	  if (incremental)
+	    {
+	      // the memory backend skips the unchanged elements, HDF5 the unchanged datasets (all the
+	      // elements of a field of profiles_1d are stored in one dataset)
+	      long long field = (long long)nprofiles * npoints * 8;
+	      long long unchanged = (std::string(backend) == "memory") ? NB_FIELDS * field - 2LL * npoints * 8 : 2 * field;
+	      expect(counter(pctx, "puts") == niter + 1, "number of puts");
+	      expect(saved >= unchanged * niter, "bytes saved");
+	      expect(counter(pctx, "full_rewrites") >= 1, "first put not counted as a full rewrite");
+	    }
+
+	  // a put through another data entry, which the next incremental put must not take for its previous put
+	  long long rewrites = incremental ? counter(pctx, "full_rewrites") : 0;
+	  Profiles other = profiles;
+	  for (double &v : other[0][1])
+	    v *= 2.0;
+	  int octx = openEntry(std::string("imas:") + backend + "?path=" + path, OPEN_PULSE);
+	  put(octx, other);
+	  closeEntry(octx);
+	  put(pctx, profiles);
+	  verify(pctx, profiles);
+	  if (incremental && std::string(backend) == "hdf5")
+	    expect(counter(pctx, "full_rewrites") == rewrites + 1, "put of another data entry not rewritten entirely");
+
+	  // a field changing shape, then an element removed
+	  rewrites = incremental ? counter(pctx, "full_rewrites") : 0;
+	  profiles[0][0].push_back(1.0);
+	  put(pctx, profiles);
+	  verify(pctx, profiles);
+	  if (incremental && std::string(backend) == "hdf5")
+	    expect(counter(pctx, "full_rewrites") == rewrites + 1, "shape change not rewritten entirely");
+	  profiles.pop_back();
+	  put(pctx, profiles);
+	  verify(pctx, profiles);
+	  closeEntry(pctx);
+
+	  // the IDS is read back from the file when opened again
+	  if (std::string(backend) == "hdf5")
+	    {
+	      pctx = openEntry(uri, OPEN_PULSE);
+	      verify(pctx, profiles);
+	      closeEntry(pctx);
+	    }
+	}
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
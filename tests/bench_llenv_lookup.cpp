@@ -0,0 +1,94 @@
+/*
+  Microbenchmark of the lowlevel context store.
+
+  Several threads resolve context identifiers through Lowlevel::getLLenv while
+  another thread keeps inserting and removing entries, which is the access
+  pattern of concurrent get/put calls on independent data entries. It also
+  checks that stale handles are detected and that the plugin wildcard
+  binding all occurrences of an IDS keeps the whole IDS name.
+
+  usage: bench_llenv_lookup [lookups_per_thread] [max_threads]
+*/
+
+#include "bench_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static const int NB_CONTEXTS = 64;
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  long lookups = args.get(1, 10000000L);
+  int maxThreads = args.get(2, (int)std::thread::hardware_concurrency());
+  if (maxThreads < 1)
+    maxThreads = 1;
+
+  std::vector<int> handles;
+  for (int i = 0; i < NB_CONTEXTS; i++)
+    handles.push_back(Lowlevel::addLLenv(NULL, new DataEntryContext("imas:memory?path=bench")));
+
+  // a removed handle must be reported as stale, even once its slot is recycled
+  int stale = Lowlevel::addLLenv(NULL, NULL);
+  Lowlevel::delLLenv(stale);
+  int recycled = Lowlevel::addLLenv(NULL, NULL);
+  bool detected = false;
+  try {
+    Lowlevel::getLLenv(stale);
+  }
+  catch (const ALLowlevelException &e) {
+    detected = true;
+  }
+  Lowlevel::delLLenv(recycled);
+  printf("stale handle detection: %s\n", detected ? "ok" : "FAILED");
+
+  // the wildcard binding all occurrences of an IDS keeps the whole IDS name
+  bool wildcard = LLplugin::idsWildcardPath("equilibrium:0") == "equilibrium:*/*"
+    && LLplugin::idsWildcardPath("equilibrium:12") == "equilibrium:*/*"
+    && LLplugin::idsWildcardPath("b:1") == "b:*/*";
+  printf("IDS wildcard path: %s\n", wildcard ? "ok" : "FAILED");
+
+  printf("%8s %16s %14s\n", "threads", "lookups/s", "ns/lookup");
+  for (int nthreads = 1; nthreads <= maxThreads; nthreads *= 2)
+    {
+      std::atomic<bool> stop(false);
+      std::thread churn([&stop]() {
+	  while (!stop.load(std::memory_order_relaxed))
+	    Lowlevel::delLLenv(Lowlevel::addLLenv(NULL, NULL));
+	});
+
+      std::atomic<long> checksum(0);
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> workers;
+      for (int t = 0; t < nthreads; t++)
+	workers.emplace_back([&handles, &checksum, lookups, t]() {
+	    long sum = 0;
+	    for (long i = 0; i < lookups; i++)
+	      sum += Lowlevel::getLLenv(handles[(i + t) % NB_CONTEXTS]).context->getType();
+	    checksum += sum;
+	  });
+      for (auto &w : workers)
+	w.join();
+      double seconds = elapsed(start);
+      stop = true;
+      churn.join();
+
+      double total = (double)lookups * nthreads;
+      printf("%8d %16.0f %14.2f\n", nthreads, total / seconds, seconds * 1e9 * nthreads / total);
+      if (checksum.load() != (long)CTX_PULSE_TYPE * lookups * nthreads)
+	{
+	  fprintf(stderr, "inconsistent lookups\n");
+	  return 1;
+	}
+    }
+
+  for (int h : handles)
+    delete Lowlevel::delLLenv(h).context;
+
+  return (detected && wildcard) ? 0 : 1;
+}
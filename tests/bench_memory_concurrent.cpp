@@ -0,0 +1,191 @@
+/*
+  Benchmark of concurrent readers and writer of the same memory data entry.
+
+  An equilibrium IDS (a time dependent AoS of 1D profiles) is put in a memory
+  entry. Reader threads, each with its own data entry opened on the same
+  path, as done by coupled components, then get equilibrium repeatedly and
+  check every value while a writer thread keeps putting core_profiles in the
+  same entry. The run is repeated with 1, 2, 4, ... readers up to
+  max_readers, and the throughput of the readers (gets per second, over all
+  of them) and its speedup over one reader are reported with the number of
+  puts done meanwhile: readers of an IDS proceed in parallel, and are not
+  held by the writer of another IDS. The speedup needs at least as many
+  cores as readers plus the writer.
+  The last core_profiles put must be read back. The exit status is 1 if any
+  check failed.
+
+  usage: bench_memory_concurrent [gets] [max_readers] [dir]
+  (defaults: 1000 gets per reader, 4 readers, current directory)
+*/
+
+#include "bench_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int NB_SLICES = 10;
+static const int NB_POINTS = 1000;
+
+static double value(long seed, int slice, int point)
+{
+  return seed + 1000.0 * slice + point;
+}
+
+// equilibrium (seed 0) or core_profiles (seed of the put) with NB_SLICES elements of 1D profiles
+static void put(int pctx, const char *ids, const char *aosPath, const char *profile, long seed)
+{
+  int octx, actx, homogeneous = 1, nt = NB_SLICES, np = NB_POINTS;
+  std::vector<double> time, values(NB_POINTS);
+  for (int t = 0; t < NB_SLICES; t++)
+    time.push_back(0.1 * t);
+  std::string timebase = std::string(aosPath) + "/time";
+  check(al_begin_global_action(pctx, ids, "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_write_data(octx, "time", "time", time.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+  check(al_begin_arraystruct_action(octx, aosPath, timebase.c_str(), &nt, &actx), "al_begin_arraystruct_action");
+  for (int t = 0; t < NB_SLICES; t++)
+    {
+      for (int i = 0; i < NB_POINTS; i++)
+	values[i] = value(seed, t, i);
+      check(al_write_data(actx, "time", "", &time[t], DOUBLE_DATA, 0, NULL), "al_write_data");
+      check(al_write_data(actx, profile, "", values.data(), DOUBLE_DATA, 1, &np), "al_write_data");
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void get(int pctx, const char *ids, const char *aosPath, const char *profile, long seed)
+{
+  int octx, actx, nt = 0;
+  std::string timebase = std::string(aosPath) + "/time";
+  check(al_begin_global_action(pctx, ids, "", READ_OP, &octx), "al_begin_global_action");
+  check(al_begin_arraystruct_action(octx, aosPath, timebase.c_str(), &nt, &actx), "al_begin_arraystruct_action");
+  expect(nt == NB_SLICES, std::string("size of ") + aosPath);
+  for (int t = 0; t < nt; t++)
+    {
+      double time = 0;
+      void *data = &time;
+      check(al_read_data(actx, "time", "", &data, DOUBLE_DATA, 0, NULL), "al_read_data");
+      expect(time == 0.1 * t, timebase);
+      data = NULL;
+      int size[MAXDIM] = {0};
+      check(al_read_data(actx, profile, "", &data, DOUBLE_DATA, 1, size), "al_read_data");
+      expect(data != NULL && size[0] == NB_POINTS, std::string(profile) + " size");
+      int i = 0;
+      while (i < NB_POINTS && ((double *)data)[i] == value(seed, t, i))
+	i++;
+      al_free_data(data);
+      expect(i == NB_POINTS, std::string(aosPath) + "[" + std::to_string(t) + "]/" + profile);
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int gets = args.get(1, 1000);
+  int maxReaders = args.get(2, 4);
+  std::string dir = args.get(3, ".");
+  std::string uri = "imas:memory?path=" + dir + "/memory_concurrent_bench";
+  if (maxReaders < 1)
+    maxReaders = 1;
+
+  int failures = 0;
+  try {
+    // the entry is kept open by the main thread: memory entries vanish when their last handle is closed
+    int pctx = openEntry(uri, FORCE_CREATE_PULSE);
+    put(pctx, "equilibrium", "time_slice", "profiles_1d/psi", 0);
+
+    printf("%8s %14s %10s %10s %10s\n", "readers", "gets/s", "speedup", "puts", "errors");
+    double reference = 0;
+    for (int nreaders = 1; nreaders <= maxReaders; nreaders *= 2)
+      {
+	std::atomic<int> errors(0), running(nreaders);
+	std::atomic<long> lastPut(0);
+	std::mutex messageMutex;
+	std::string message;
+	auto fail = [&](const std::exception &e) {
+	  errors++;
+	  std::lock_guard<std::mutex> guard(messageMutex);
+	  if (message.empty())
+	    message = e.what();
+	};
+
+	// the writer puts core_profiles until the readers are done
+	std::thread writer([&]() {
+	    try {
+	      int wctx = openEntry(uri, OPEN_PULSE);
+	      for (long seed = 1; running > 0; seed++)
+		{
+		  put(wctx, "core_profiles", "profiles_1d", "electrons/temperature", seed);
+		  lastPut = seed;
+		}
+	      closeEntry(wctx);
+	    }
+	    catch (const std::exception &e) {
+	      fail(e);
+	    }
+	  });
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> readers;
+	for (int r = 0; r < nreaders; r++)
+	  readers.emplace_back([&]() {
+	      try {
+		int rctx = openEntry(uri, OPEN_PULSE);
+		for (int k = 0; k < gets; k++)
+		  get(rctx, "equilibrium", "time_slice", "profiles_1d/psi", 0);
+		closeEntry(rctx);
+	      }
+	      catch (const std::exception &e) {
+		fail(e);
+	      }
+	      running--;
+	    });
+	for (auto &r : readers)
+	  r.join();
+	double seconds = elapsed(start);
+	writer.join();
+
+	// the entry holds the last put of the writer
+	if (lastPut > 0)
+	  {
+	    try {
+	      get(pctx, "core_profiles", "profiles_1d", "electrons/temperature", lastPut);
+	    }
+	    catch (const std::exception &e) {
+	      fail(e);
+	    }
+	  }
+
+	double rate = (double)gets * nreaders / seconds;
+	if (nreaders == 1)
+	  reference = rate;
+	printf("%8d %14.1f %10.2f %10ld %10d\n", nreaders, rate, reference > 0 ? rate / reference : 0.0,
+	       lastPut.load(), errors.load());
+	if (errors > 0)
+	  {
+	    fprintf(stderr, "%d readers: %s\n", nreaders, message.c_str());
+	    failures++;
+	  }
+      }
+    closeEntry(pctx);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return (failures == 0) ? 0 : 1;
+}
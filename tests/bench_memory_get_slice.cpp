@@ -0,0 +1,168 @@
+/*
+  Benchmark of get_slice on long time series in the memory backend.
+
+  For series of nslices / 100, nslices / 10 and nslices time slices, a
+  core_profiles IDS is put with the time, a scalar signal of
+  global_quantities and a timed profiles_1d array of structures with one
+  element per slice. The mean time of a get_slice of the signal (timebase
+  /time) and of an element of profiles_1d (timebase profiles_1d/time) is
+  reported for each length: it should grow slowly with the number of slices.
+  A slice is then appended with put_slice, and the get_slice of the new last
+  slice must return it (cached time vectors are renewed).
+  The values read must match the values written, also between slices with
+  CLOSEST_INTERP. The exit status is 1 if any check failed.
+
+  usage: bench_memory_get_slice [nslices] [reads] [dir]
+  (defaults: 20000 slices, 1000 reads, current directory)
+*/
+
+#define BENCH_WRONG "wrong slice"
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static double timeOf(int slice)
+{
+  return slice * 1.0e-3;
+}
+
+static double value(int slice)
+{
+  return 1.0e6 + slice;
+}
+
+static void put(int pctx, int nslices)
+{
+  int octx, actx, homogeneous = 1;
+  std::vector<double> time, ip;
+  for (int t = 0; t < nslices; t++)
+    {
+      time.push_back(timeOf(t));
+      ip.push_back(value(t));
+    }
+  check(al_begin_global_action(pctx, "core_profiles", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_write_data(octx, "time", "time", time.data(), DOUBLE_DATA, 1, &nslices), "al_write_data");
+  check(al_write_data(octx, "global_quantities/ip", "time", ip.data(), DOUBLE_DATA, 1, &nslices), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &nslices, &actx),
+	"al_begin_arraystruct_action");
+  for (int t = 0; t < nslices; t++)
+    {
+      check(al_write_data(actx, "time", "", &time[t], DOUBLE_DATA, 0, NULL), "al_write_data");
+      check(al_write_data(actx, "t_i_average", "", &ip[t], DOUBLE_DATA, 0, NULL), "al_write_data");
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void putSlice(int pctx, int slice)
+{
+  int octx, actx, one = 1;
+  double time = timeOf(slice), ip = value(slice);
+  check(al_begin_slice_action(pctx, "core_profiles", WRITE_OP, time, CLOSEST_INTERP, &octx),
+	"al_begin_slice_action");
+  check(al_write_data(octx, "time", "time", &time, DOUBLE_DATA, 1, &one), "al_write_data");
+  check(al_write_data(octx, "global_quantities/ip", "time", &ip, DOUBLE_DATA, 1, &one), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &one, &actx),
+	"al_begin_arraystruct_action");
+  check(al_write_data(actx, "time", "", &time, DOUBLE_DATA, 0, NULL), "al_write_data");
+  check(al_write_data(actx, "t_i_average", "", &ip, DOUBLE_DATA, 0, NULL), "al_write_data");
+  check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+// signal read by a get_slice at the given time
+static double signalAt(int pctx, double time)
+{
+  int octx;
+  void *data = NULL;
+  int size[MAXDIM] = {0};
+  check(al_begin_slice_action(pctx, "core_profiles", READ_OP, time, CLOSEST_INTERP, &octx), "al_begin_slice_action");
+  check(al_read_data(octx, "global_quantities/ip", "time", &data, DOUBLE_DATA, 1, size), "al_read_data");
+  expect(data != NULL && size[0] == 1, "size of global_quantities/ip");
+  double v = ((double *)data)[0];
+  al_free_data(data);
+  check(al_end_action(octx), "al_end_action");
+  return v;
+}
+
+// element of profiles_1d read by a get_slice at the given time
+static double profileAt(int pctx, double time)
+{
+  int octx, actx, n = 0;
+  double v = 0;
+  void *data = &v;  // scalars are read into the variable pointed to
+  check(al_begin_slice_action(pctx, "core_profiles", READ_OP, time, CLOSEST_INTERP, &octx), "al_begin_slice_action");
+  check(al_begin_arraystruct_action(octx, "profiles_1d", "profiles_1d/time", &n, &actx), "al_begin_arraystruct_action");
+  expect(n == 1, "size of profiles_1d " + std::to_string(n));
+  check(al_read_data(actx, "t_i_average", "", &data, DOUBLE_DATA, 0, NULL), "al_read_data");
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+  return v;
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nslices = args.get(1, 20000);
+  int reads = args.get(2, 1000);
+  std::string dir = args.get(3, ".");
+  std::string uri = "imas:memory?path=" + dir + "/memory_get_slice_bench";
+
+  try {
+    if (nslices < 1000)
+      throw std::runtime_error("at least 1000 slices are needed");
+    printf("%10s %20s %20s\n", "slices", "signal slice (us)", "AoS slice (us)");
+    for (int n : {nslices / 100, nslices / 10, nslices})
+      {
+	int pctx = openEntry(uri, FORCE_CREATE_PULSE);
+	put(pctx, n);
+
+	// times spread over the series, half way between two slices
+	double signalTime = 0, profileTime = 0;
+	for (int pass = 0; pass < 2; pass++)
+	  {
+	    auto start = std::chrono::steady_clock::now();
+	    for (int r = 0; r < reads; r++)
+	      {
+		int t = (int)((long long)r * (n - 2) / (reads > 1 ? reads - 1 : 1));
+		double time = (pass == 0) ? timeOf(t) + 0.4e-3 : timeOf(t) + 0.6e-3;
+		int expected = (pass == 0) ? t : t + 1;
+		expect(signalAt(pctx, time) == value(expected), "signal at slice " + std::to_string(expected));
+	      }
+	    signalTime += elapsed(start);
+	    start = std::chrono::steady_clock::now();
+	    for (int r = 0; r < reads; r++)
+	      {
+		int t = (int)((long long)r * (n - 2) / (reads > 1 ? reads - 1 : 1));
+		double time = (pass == 0) ? timeOf(t) + 0.4e-3 : timeOf(t) + 0.6e-3;
+		int expected = (pass == 0) ? t : t + 1;
+		expect(profileAt(pctx, time) == value(expected), "profiles_1d at slice " + std::to_string(expected));
+	      }
+	    profileTime += elapsed(start);
+	  }
+	printf("%10d %20.2f %20.2f\n", n, signalTime / (2 * reads) * 1e6, profileTime / (2 * reads) * 1e6);
+
+	// the times read before must not hide the appended slice
+	putSlice(pctx, n);
+	expect(signalAt(pctx, timeOf(n)) == value(n), "signal of the appended slice");
+	expect(profileAt(pctx, timeOf(n)) == value(n), "profiles_1d of the appended slice");
+
+	closeEntry(pctx);
+      }
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
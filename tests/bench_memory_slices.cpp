@@ -0,0 +1,139 @@
+/*
+  Benchmark of long time series in the memory backend.
+
+  A core_profiles IDS is put with one time slice, then nslices - 1 slices
+  are appended one by one with put_slice, each slice holding the time and
+  NB_SIGNALS scalar signals of global_quantities, as done when codes are
+  coupled in memory. The mean time of an append is reported for the first
+  and the last tenth of the slices (they should be close: appends take
+  amortized constant time), then the mean time to get a whole signal and to
+  get a single slice.
+  The signals read back must match what was appended. The exit status is 1
+  if any check failed.
+
+  usage: bench_memory_slices [nslices] [reads] [dir]
+  (defaults: 100000 slices, 100 reads, current directory)
+*/
+
+#define BENCH_WRONG "wrong time series"
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *SIGNALS[] = {"global_quantities/ip", "global_quantities/v_loop", "global_quantities/li_3",
+				"global_quantities/beta_pol"};
+static const int NB_SIGNALS = 4;
+
+static double timeOf(int slice)
+{
+  return slice * 1.0e-3;
+}
+
+static double value(int signal, int slice)
+{
+  return signal * 1.0e6 + slice;
+}
+
+static void writeSlice(int octx, int slice)
+{
+  int one = 1;
+  double time = timeOf(slice);
+  check(al_write_data(octx, "time", "time", &time, DOUBLE_DATA, 1, &one), "al_write_data");
+  for (int s = 0; s < NB_SIGNALS; s++)
+    {
+      double v = value(s, slice);
+      check(al_write_data(octx, SIGNALS[s], "time", &v, DOUBLE_DATA, 1, &one), "al_write_data");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nslices = args.get(1, 100000);
+  int reads = args.get(2, 100);
+  std::string dir = args.get(3, ".");
+  std::string uri = "imas:memory?path=" + dir + "/memory_slices_bench";
+
+  try {
+    if (nslices < 10)
+      throw std::runtime_error("at least 10 slices are needed");
+    int pctx, octx, homogeneous = 1;
+    pctx = openEntry(uri, FORCE_CREATE_PULSE);
+    check(al_begin_global_action(pctx, "core_profiles", "", WRITE_OP, &octx), "al_begin_global_action");
+    check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	  "al_write_data");
+    writeSlice(octx, 0);
+    check(al_end_action(octx), "al_end_action");
+
+    // appends, timed over the first and the last tenth of the slices
+    int tenth = nslices / 10;
+    double first = 0, last = 0;
+    for (int t = 1; t < nslices; t++)
+      {
+	auto start = std::chrono::steady_clock::now();
+	check(al_begin_slice_action(pctx, "core_profiles", WRITE_OP, timeOf(t), CLOSEST_INTERP, &octx),
+	      "al_begin_slice_action");
+	writeSlice(octx, t);
+	check(al_end_action(octx), "al_end_action");
+	if (t <= tenth)
+	  first += elapsed(start);
+	else if (t > nslices - 1 - tenth)
+	  last += elapsed(start);
+      }
+
+    // whole signals
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reads; r++)
+      {
+	check(al_begin_global_action(pctx, "core_profiles", "", READ_OP, &octx), "al_begin_global_action");
+	int s = r % NB_SIGNALS;
+	void *data = NULL;
+	int size[MAXDIM] = {0};
+	check(al_read_data(octx, SIGNALS[s], "time", &data, DOUBLE_DATA, 1, size), "al_read_data");
+	expect(data != NULL && size[0] == nslices, std::string(SIGNALS[s]) + " size");
+	int t = 0;
+	while (t < nslices && ((double *)data)[t] == value(s, t))
+	  t++;
+	expect(t == nslices, std::string(SIGNALS[s]) + " value at slice " + std::to_string(t));
+	al_free_data(data);
+	check(al_end_action(octx), "al_end_action");
+      }
+    double whole = elapsed(start);
+
+    // single slices, spread over the series
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reads; r++)
+      {
+	int t = (int)((long long)r * (nslices - 1) / (reads > 1 ? reads - 1 : 1));
+	check(al_begin_slice_action(pctx, "core_profiles", READ_OP, timeOf(t), CLOSEST_INTERP, &octx),
+	      "al_begin_slice_action");
+	int s = r % NB_SIGNALS;
+	void *data = NULL;
+	int size[MAXDIM] = {0};
+	check(al_read_data(octx, SIGNALS[s], "time", &data, DOUBLE_DATA, 1, size), "al_read_data");
+	expect(data != NULL && size[0] == 1 && ((double *)data)[0] == value(s, t),
+	       std::string(SIGNALS[s]) + " slice " + std::to_string(t));
+	al_free_data(data);
+	check(al_end_action(octx), "al_end_action");
+      }
+    double single = elapsed(start);
+
+    closeEntry(pctx);
+
+    printf("%d slices of %d signals\n", nslices, NB_SIGNALS);
+    printf("append (us): first tenth %.2f, last tenth %.2f\n", first / tenth * 1e6, last / tenth * 1e6);
+    printf("get of a whole signal (ms): %.3f (with the check of its values)\n", whole / reads * 1e3);
+    printf("get of a slice (ms): %.3f\n", single / reads * 1e3);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
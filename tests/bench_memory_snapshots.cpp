@@ -0,0 +1,235 @@
+/*
+  Benchmark of get_slice and put_slice of large AoS elements in the memory
+  backend.
+
+  An equilibrium IDS is put with nslices elements of time_slice, each holding
+  NB_FIELDS_1D profiles of npoints values and NB_PROFILES_2D elements of
+  profiles_2d with NB_FIELDS_2D maps of npoints x npoints values. The mean time
+  of a get_slice of one element (reading one of its profiles) and of a
+  put_slice appending an element are reported: the element is shared with the
+  IDS instead of being copied.
+  An element read by a get_slice must not change while it is read, when
+  another data entry of the same path puts the IDS again, with and without
+  incremental_put=yes, and the next get_slice must return the new IDS. The
+  values read must match the values written. The exit status is 1 if any
+  check failed.
+
+  usage: bench_memory_snapshots [nslices] [npoints] [reads] [dir]
+  (defaults: 100 slices, 64 points, 1000 reads, current directory)
+*/
+
+#define BENCH_WRONG "wrong slice"
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const int NB_FIELDS_1D = 20;
+static const int NB_PROFILES_2D = 3;
+static const char *FIELDS_2D[] = {"psi", "j_tor", "b_field_r", "b_field_z"};
+static const int NB_FIELDS_2D = 4;
+
+static double timeOf(int slice)
+{
+  return slice * 1.0e-3;
+}
+
+static double value(int seed, int slice, int field, int point)
+{
+  return seed * 1.0e9 + slice * 1.0e5 + field * 1.0e3 + point;
+}
+
+// profiles_1d fields, 1D arrays of npoints values
+static std::string field1D(int f)
+{
+  return "profiles_1d/field_" + std::to_string(f);
+}
+
+static std::vector<double> values(int seed, int slice, int field, int npoints)
+{
+  std::vector<double> v(npoints);
+  for (int i = 0; i < npoints; i++)
+    v[i] = value(seed, slice, field, i);
+  return v;
+}
+
+static void writeElement(int actx, int slice, int seed, int npoints)
+{
+  int pctx, np = npoints, n2d = NB_PROFILES_2D;
+  int shape[2] = {npoints, npoints};
+  double time = timeOf(slice);
+  check(al_write_data(actx, "time", "", &time, DOUBLE_DATA, 0, NULL), "al_write_data");
+  for (int f = 0; f < NB_FIELDS_1D; f++)
+    check(al_write_data(actx, field1D(f).c_str(), "", values(seed, slice, f, npoints).data(), DOUBLE_DATA, 1, &np),
+	  "al_write_data");
+  check(al_begin_arraystruct_action(actx, "profiles_2d", "", &n2d, &pctx), "al_begin_arraystruct_action");
+  for (int p = 0; p < NB_PROFILES_2D; p++)
+    {
+      for (int f = 0; f < NB_FIELDS_2D; f++)
+	check(al_write_data(pctx, FIELDS_2D[f], "", values(seed, slice, 100 * (p + 1) + f, npoints * npoints).data(),
+			    DOUBLE_DATA, 2, shape), "al_write_data");
+      check(al_iterate_over_arraystruct(pctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(pctx), "al_end_action");
+}
+
+static void put(int pctx, int nslices, int seed, int npoints)
+{
+  int octx, actx, homogeneous = 1, nt = nslices;
+  std::vector<double> time;
+  for (int t = 0; t < nslices; t++)
+    time.push_back(timeOf(t));
+  // as done by the high level: the IDS is deleted, then written
+  check(al_begin_global_action(pctx, "equilibrium", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_delete_data(octx, ""), "al_delete_data");
+  check(al_end_action(octx), "al_end_action");
+  check(al_begin_global_action(pctx, "equilibrium", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_write_data(octx, "time", "time", time.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "time_slice", "time_slice/time", &nt, &actx), "al_begin_arraystruct_action");
+  for (int t = 0; t < nslices; t++)
+    {
+      writeElement(actx, t, seed, npoints);
+      check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void putSlice(int pctx, int slice, int seed, int npoints)
+{
+  int octx, actx, one = 1;
+  double time = timeOf(slice);
+  check(al_begin_slice_action(pctx, "equilibrium", WRITE_OP, time, PREVIOUS_INTERP, &octx), "al_begin_slice_action");
+  check(al_write_data(octx, "time", "time", &time, DOUBLE_DATA, 1, &one), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "time_slice", "time_slice/time", &one, &actx), "al_begin_arraystruct_action");
+  writeElement(actx, slice, seed, npoints);
+  check(al_iterate_over_arraystruct(actx, 1), "al_iterate_over_arraystruct");
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void expectValues(int ctx, const std::string &field, int seed, int slice, int f, int dim, int size)
+{
+  void *data = NULL;
+  int dims[MAXDIM] = {0};
+  check(al_read_data(ctx, field.c_str(), "", &data, DOUBLE_DATA, dim, dims), "al_read_data");
+  expect(data != NULL, field + " missing");
+  int i = 0;
+  while (i < size && ((double *)data)[i] == value(seed, slice, f, i))
+    i++;
+  al_free_data(data);
+  expect(i == size, field + " of slice " + std::to_string(slice) + " at " + std::to_string(i));
+}
+
+// get_slice of an element: the operation and AoS contexts are left open for the caller to read more
+static void beginSlice(int pctx, int slice, int *octx, int *actx)
+{
+  int n = 0;
+  check(al_begin_slice_action(pctx, "equilibrium", READ_OP, timeOf(slice), PREVIOUS_INTERP, octx),
+	"al_begin_slice_action");
+  check(al_begin_arraystruct_action(*octx, "time_slice", "time_slice/time", &n, actx), "al_begin_arraystruct_action");
+  expect(n == 1, "size of time_slice " + std::to_string(n));
+}
+
+static void endSlice(int octx, int actx)
+{
+  check(al_end_action(actx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+// reads the fields of a whole element, except field 0 of profiles_1d
+static void expectElement(int actx, int slice, int seed, int npoints)
+{
+  int n2d = 0, pctx;
+  for (int f = 1; f < NB_FIELDS_1D; f++)
+    expectValues(actx, field1D(f), seed, slice, f, 1, npoints);
+  check(al_begin_arraystruct_action(actx, "profiles_2d", "", &n2d, &pctx), "al_begin_arraystruct_action");
+  expect(n2d == NB_PROFILES_2D, "size of profiles_2d " + std::to_string(n2d));
+  for (int p = 0; p < NB_PROFILES_2D; p++)
+    {
+      for (int f = 0; f < NB_FIELDS_2D; f++)
+	expectValues(pctx, FIELDS_2D[f], seed, slice, 100 * (p + 1) + f, 2, npoints * npoints);
+      check(al_iterate_over_arraystruct(pctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(pctx), "al_end_action");
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nslices = args.get(1, 100);
+  int npoints = args.get(2, 64);
+  int reads = args.get(3, 1000);
+  std::string dir = args.get(4, ".");
+  std::string uri = "imas:memory?path=" + dir + "/memory_snapshots_bench";
+
+  try {
+    if (nslices < 2)
+      throw std::runtime_error("at least 2 slices are needed");
+    double mb = (NB_FIELDS_1D * (double)npoints + NB_PROFILES_2D * NB_FIELDS_2D * (double)npoints * npoints) * 8 / 1.0e6;
+    printf("equilibrium of %.1f MB (%d slices of %.2f MB)\n", mb * nslices, nslices, mb);
+
+    int pctx, octx, actx;
+    pctx = openEntry(uri, FORCE_CREATE_PULSE);
+    put(pctx, nslices, 0, npoints);
+
+    // get_slice of elements spread over the series
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reads; r++)
+      {
+	int t = (int)((long long)r * (nslices - 1) / (reads > 1 ? reads - 1 : 1));
+	beginSlice(pctx, t, &octx, &actx);
+	expectValues(actx, field1D(0), 0, t, 0, 1, npoints);
+	endSlice(octx, actx);
+      }
+    double getTime = elapsed(start);
+
+    // put_slice of new elements
+    int appends = nslices / 2;
+    start = std::chrono::steady_clock::now();
+    for (int t = nslices; t < nslices + appends; t++)
+      putSlice(pctx, t, 0, npoints);
+    double putTime = elapsed(start);
+    for (int t : {0, nslices - 1, nslices, nslices + appends - 1})
+      {
+	beginSlice(pctx, t, &octx, &actx);
+	expectValues(actx, field1D(0), 0, t, 0, 1, npoints);
+	expectElement(actx, t, 0, npoints);
+	endSlice(octx, actx);
+      }
+    printf("get_slice of an element (us): %.2f\n", getTime / reads * 1e6);
+    printf("put_slice of an element (us): %.2f\n", putTime / appends * 1e6);
+
+    // the IDS put again by another entry while an element is read
+    int seed = 0, slice = nslices / 2;
+    for (const char *option : {"", "&incremental_put=yes"})
+      {
+	int wctx = openEntry(uri + option, OPEN_PULSE);
+	beginSlice(pctx, slice, &octx, &actx);
+	expectValues(actx, field1D(0), seed, slice, 0, 1, npoints);
+	put(wctx, nslices, seed + 1, npoints);
+	expectElement(actx, slice, seed, npoints);
+	endSlice(octx, actx);
+	seed++;
+	beginSlice(pctx, slice, &octx, &actx);
+	expectValues(actx, field1D(0), seed, slice, 0, 1, npoints);
+	expectElement(actx, slice, seed, npoints);
+	endSlice(octx, actx);
+	closeEntry(wctx);
+      }
+
+    closeEntry(pctx);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+/*
+  Benchmark of building and freeing large trees of AoS in the memory backend.
+
+  An edge_profiles IDS shaped like its ggd is put: nslices elements of ggd,
+  each holding the electron density and temperature and NB_IONS ions with
+  their density and temperature, every quantity being an AoS of nsubsets
+  grid subsets (grid_index, grid_subset_index and values of NB_VALUES
+  points). Such IDSs have tens of thousands of AoS elements and fields. The
+  mean time of a first put (building the tree), of a put replacing the IDS
+  (freeing the previous tree, then building it again), of a get and of the
+  close of the data entry (freeing the tree) is reported over nputs rounds.
+  The IDS read back must match the last put. The exit status is 1 if any
+  check failed.
+
+  usage: bench_memory_tree [nslices] [nsubsets] [nputs] [dir]
+  (defaults: 100 slices, 20 subsets, 10 puts, current directory)
+*/
+
+#define BENCH_WRONG "wrong tree"
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const int NB_IONS = 5;
+static const int NB_VALUES = 10;
+static const char *QUANTITIES[] = {"density", "temperature"};
+static const int NB_QUANTITIES = 2;
+
+// species 0 is the electrons, 1 to NB_IONS the ions
+static double value(int seed, int slice, int species, int quantity, int subset, int point)
+{
+  return seed * 1.0e9 + slice * 1.0e6 + species * 1.0e5 + quantity * 1.0e4 + subset * 1.0e2 + point;
+}
+
+static void writeQuantity(int ctx, int slice, int species, int quantity, int nsubsets, int seed)
+{
+  int qctx, n = nsubsets, np = NB_VALUES;
+  std::vector<double> values(NB_VALUES);
+  check(al_begin_arraystruct_action(ctx, QUANTITIES[quantity], "", &n, &qctx), "al_begin_arraystruct_action");
+  for (int s = 0; s < nsubsets; s++)
+    {
+      int grid = 1;
+      for (int i = 0; i < NB_VALUES; i++)
+	values[i] = value(seed, slice, species, quantity, s, i);
+      check(al_write_data(qctx, "grid_index", "", &grid, INTEGER_DATA, 0, NULL), "al_write_data");
+      check(al_write_data(qctx, "grid_subset_index", "", &s, INTEGER_DATA, 0, NULL), "al_write_data");
+      check(al_write_data(qctx, "values", "", values.data(), DOUBLE_DATA, 1, &np), "al_write_data");
+      check(al_iterate_over_arraystruct(qctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(qctx), "al_end_action");
+}
+
+static void put(int pctx, int nslices, int nsubsets, int seed)
+{
+  int octx, gctx, ictx, homogeneous = 1, nt = nslices, nions = NB_IONS;
+  std::vector<double> time;
+  for (int t = 0; t < nslices; t++)
+    time.push_back(t * 1.0e-3);
+  check(al_begin_global_action(pctx, "edge_profiles", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_write_data(octx, "time", "time", time.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "ggd", "ggd/time", &nt, &gctx), "al_begin_arraystruct_action");
+  for (int t = 0; t < nslices; t++)
+    {
+      check(al_write_data(gctx, "time", "", &time[t], DOUBLE_DATA, 0, NULL), "al_write_data");
+      for (int q = 0; q < NB_QUANTITIES; q++)
+	writeQuantity(gctx, t, 0, q, nsubsets, seed);
+      check(al_begin_arraystruct_action(gctx, "ion", "", &nions, &ictx), "al_begin_arraystruct_action");
+      for (int i = 0; i < NB_IONS; i++)
+	{
+	  for (int q = 0; q < NB_QUANTITIES; q++)
+	    writeQuantity(ictx, t, i + 1, q, nsubsets, seed);
+	  check(al_iterate_over_arraystruct(ictx, 1), "al_iterate_over_arraystruct");
+	}
+      check(al_end_action(ictx), "al_end_action");
+      check(al_iterate_over_arraystruct(gctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(gctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void expectQuantity(int ctx, int slice, int species, int quantity, int nsubsets, int seed)
+{
+  int qctx, n = 0;
+  std::string what = "species " + std::to_string(species) + " " + QUANTITIES[quantity] + " of slice " +
+    std::to_string(slice);
+  check(al_begin_arraystruct_action(ctx, QUANTITIES[quantity], "", &n, &qctx), "al_begin_arraystruct_action");
+  expect(n == nsubsets, what + " size");
+  for (int s = 0; s < nsubsets; s++)
+    {
+      int subset = -1;
+      void *data = &subset;
+      check(al_read_data(qctx, "grid_subset_index", "", &data, INTEGER_DATA, 0, NULL), "al_read_data");
+      expect(subset == s, what + " grid_subset_index");
+      data = NULL;
+      int size[MAXDIM] = {0};
+      check(al_read_data(qctx, "values", "", &data, DOUBLE_DATA, 1, size), "al_read_data");
+      expect(data != NULL && size[0] == NB_VALUES, what + " values size");
+      int i = 0;
+      while (i < NB_VALUES && ((double *)data)[i] == value(seed, slice, species, quantity, s, i))
+	i++;
+      al_free_data(data);
+      expect(i == NB_VALUES, what + " values");
+      check(al_iterate_over_arraystruct(qctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(qctx), "al_end_action");
+}
+
+static void get(int pctx, int nslices, int nsubsets, int seed)
+{
+  int octx, gctx, ictx, nt = 0, nions = 0;
+  check(al_begin_global_action(pctx, "edge_profiles", "", READ_OP, &octx), "al_begin_global_action");
+  check(al_begin_arraystruct_action(octx, "ggd", "ggd/time", &nt, &gctx), "al_begin_arraystruct_action");
+  expect(nt == nslices, "size of ggd");
+  for (int t = 0; t < nslices; t++)
+    {
+      for (int q = 0; q < NB_QUANTITIES; q++)
+	expectQuantity(gctx, t, 0, q, nsubsets, seed);
+      check(al_begin_arraystruct_action(gctx, "ion", "", &nions, &ictx), "al_begin_arraystruct_action");
+      expect(nions == NB_IONS, "size of ion");
+      for (int i = 0; i < NB_IONS; i++)
+	{
+	  for (int q = 0; q < NB_QUANTITIES; q++)
+	    expectQuantity(ictx, t, i + 1, q, nsubsets, seed);
+	  check(al_iterate_over_arraystruct(ictx, 1), "al_iterate_over_arraystruct");
+	}
+      check(al_end_action(ictx), "al_end_action");
+      check(al_iterate_over_arraystruct(gctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(gctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nslices = args.get(1, 100);
+  int nsubsets = args.get(2, 20);
+  int nputs = args.get(3, 10);
+  std::string dir = args.get(4, ".");
+  std::string uri = "imas:memory?path=" + dir + "/memory_tree_bench";
+
+  try {
+    if (nslices < 1 || nsubsets < 1 || nputs < 1)
+      throw std::runtime_error("at least 1 slice, 1 subset and 1 put are needed");
+    long elements = (long)nslices * (1 + NB_IONS + (1 + NB_IONS) * NB_QUANTITIES * nsubsets);
+    printf("edge_profiles of %ld AoS elements and %ld fields\n", elements,
+	   (long)nslices * (1 + (1 + NB_IONS) * NB_QUANTITIES * nsubsets * 3));
+
+    double firstTime = 0, replaceTime = 0, getTime = 0, closeTime = 0;
+    for (int r = 0; r < nputs; r++)
+      {
+	int pctx = openEntry(uri, FORCE_CREATE_PULSE);
+	auto start = std::chrono::steady_clock::now();
+	put(pctx, nslices, nsubsets, 0);
+	firstTime += elapsed(start);
+	start = std::chrono::steady_clock::now();
+	put(pctx, nslices, nsubsets, 1);
+	replaceTime += elapsed(start);
+	start = std::chrono::steady_clock::now();
+	get(pctx, nslices, nsubsets, 1);
+	getTime += elapsed(start);
+	start = std::chrono::steady_clock::now();
+	closeEntry(pctx);
+	closeTime += elapsed(start);
+      }
+    printf("first put (ms): %.2f\n", firstTime / nputs * 1e3);
+    printf("put replacing the IDS (ms): %.2f\n", replaceTime / nputs * 1e3);
+    printf("get (ms): %.2f\n", getTime / nputs * 1e3);
+    printf("close freeing the IDS (ms): %.2f\n", closeTime / nputs * 1e3);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,166 @@
+/*
+  Check and benchmark of the memory accounting of the data entries
+  (al_memory_usage).
+
+  - memory backend: a wall IDS with one 2D description made of nunits limiter
+    units, each holding an outline of points (r, z) values, is put. The
+    memory reported for the data entry and for the wall must cover the data
+    written, the process-wide count of the memory backend as well. The tree
+    of the wall (its nodes and tables) must be reported apart, at least one
+    node per unit. The time taken by al_memory_usage to walk the IDS is
+    reported. Deleting the 2D description must release its data;
+  - HDF5 backend opened with cache=memory: after a get of the same IDS, the
+    cache of static data must report the data read, attributed to the wall.
+    The HDF5 buffers are released at the end of the get.
+  The exit status is 1 if any check failed.
+
+  usage: bench_memory_usage [nunits] [points] [dir]
+  (defaults: 200 units, 2000 points, current directory)
+*/
+
+#define BENCH_WRONG "wrong memory usage"
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::string memoryUsage(int pctx)
+{
+  char *json = NULL;
+  check(al_memory_usage(pctx, &json), "al_memory_usage");
+  std::string s(json);
+  free(json);
+  return s;
+}
+
+// value following the given keys, looked up in sequence in the JSON string, 0 if missing
+static long long value(const std::string &json, const std::vector<std::string> &keys)
+{
+  size_t pos = 0;
+  for (const std::string &key : keys)
+    {
+      pos = json.find("\"" + key + "\": ", pos);
+      if (pos == std::string::npos)
+	return 0;
+      pos += key.size() + 4;
+    }
+  return atoll(json.c_str() + pos);
+}
+
+static void put(int pctx, int nunits, int points)
+{
+  int octx, dctx, uctx;
+  int one = 1, nu = nunits, np = points, homogeneous = 2;
+  std::vector<double> outline(points, 1.0);
+
+  check(al_begin_global_action(pctx, "wall", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_begin_arraystruct_action(octx, "description_2d", "", &one, &dctx), "al_begin_arraystruct_action");
+  check(al_begin_arraystruct_action(dctx, "limiter/unit", "", &nu, &uctx), "al_begin_arraystruct_action");
+  for (int u = 0; u < nunits; u++)
+    {
+      check(al_write_data(uctx, "outline/r", "", outline.data(), DOUBLE_DATA, 1, &np), "al_write_data");
+      check(al_write_data(uctx, "outline/z", "", outline.data(), DOUBLE_DATA, 1, &np), "al_write_data");
+      check(al_iterate_over_arraystruct(uctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(uctx), "al_end_action");
+  check(al_end_action(dctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+static void get(int pctx, int nunits)
+{
+  int octx, dctx, uctx;
+  int nd = 0, nu = 0;
+  check(al_begin_global_action(pctx, "wall", "", READ_OP, &octx), "al_begin_global_action");
+  check(al_begin_arraystruct_action(octx, "description_2d", "", &nd, &dctx), "al_begin_arraystruct_action");
+  expect(nd == 1, "description_2d size");
+  check(al_begin_arraystruct_action(dctx, "limiter/unit", "", &nu, &uctx), "al_begin_arraystruct_action");
+  expect(nu == nunits, "limiter/unit size");
+  for (int u = 0; u < nu; u++)
+    {
+      for (const char *field : {"outline/r", "outline/z"})
+	{
+	  void *data = NULL;
+	  int size[MAXDIM] = {0};
+	  check(al_read_data(uctx, field, "", &data, DOUBLE_DATA, 1, size), "al_read_data");
+	  al_free_data(data);
+	}
+      check(al_iterate_over_arraystruct(uctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(uctx), "al_end_action");
+  check(al_end_action(dctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nunits = args.get(1, 200);
+  int points = args.get(2, 2000);
+  std::string dir = args.get(3, ".");
+  std::string path = dir + "/memory_usage_bench";
+  std::filesystem::create_directories(path);
+  long long dataBytes = nunits * (long long)points * 2 * 8;
+
+  try {
+    printf("wall of %.1f MB (%d units of %d points)\n", dataBytes / 1.0e6, nunits, points);
+
+    // memory backend
+    int pctx = openEntry("imas:memory?path=" + path, FORCE_CREATE_PULSE);
+    put(pctx, nunits, points);
+    auto start = std::chrono::steady_clock::now();
+    std::string json = memoryUsage(pctx);
+    double seconds = elapsed(start);
+    long long entry = value(json, {"data_entry", "memory", "total"});
+    long long ids = value(json, {"data_entry", "memory", "wall"});
+    long long process = value(json, {"process", "memory"});
+    long long tree = value(json, {"data_entry", "memory_tree", "wall"});
+    printf("%-24s %14lld bytes (al_memory_usage: %.3f ms)\n", "memory backend", entry, seconds * 1000.0);
+    printf("%-24s %14lld bytes\n", "  wall", ids);
+    printf("%-24s %14lld bytes\n", "  wall tree", tree);
+    printf("%-24s %14lld bytes\n", "  process", process);
+    printf("%-24s %14lld bytes\n", "  resident", value(json, {"process", "resident"}));
+    expect(ids >= dataBytes && entry >= ids, "memory backend data entry: " + json);
+    expect(process >= ids, "memory backend process count: " + json);
+    expect(tree >= nunits * 64LL && value(json, {"process", "memory_tree"}) >= tree, "memory backend tree: " + json);
+
+    int octx;
+    check(al_begin_global_action(pctx, "wall", "", WRITE_OP, &octx), "al_begin_global_action");
+    check(al_delete_data(octx, "description_2d"), "al_delete_data");
+    check(al_end_action(octx), "al_end_action");
+    json = memoryUsage(pctx);
+    expect(value(json, {"data_entry", "memory", "wall"}) <= ids - dataBytes, "memory backend after delete: " + json);
+    expect(value(json, {"process", "memory"}) <= process - dataBytes, "memory backend process count after delete: " + json);
+    closeEntry(pctx);
+
+    // HDF5 backend with the cache of static data
+    std::string uri = "imas:hdf5?path=" + path;
+    pctx = openEntry(uri, FORCE_CREATE_PULSE);
+    put(pctx, nunits, points);
+    closeEntry(pctx);
+    pctx = openEntry(uri + "&cache=memory", OPEN_PULSE);
+    get(pctx, nunits);
+    json = memoryUsage(pctx);
+    long long cached = value(json, {"data_entry", "cache", "wall"});
+    printf("%-24s %14lld bytes\n", "hdf5 + cache=memory", value(json, {"data_entry", "total"}));
+    printf("%-24s %14lld bytes\n", "  cache (wall)", cached);
+    printf("%-24s %14lld bytes\n", "  hdf5 buffers", value(json, {"data_entry", "hdf5_buffers", "total"}));
+    expect(cached >= dataBytes, "cache: " + json);
+    expect(value(json, {"data_entry", "hdf5_buffers", "total"}) == 0, "hdf5 buffers after the get: " + json);
+    expect(value(json, {"process", "cache"}) >= cached, "cache process count: " + json);
+    closeEntry(pctx);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
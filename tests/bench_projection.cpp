@@ -0,0 +1,178 @@
+/*
+  Benchmark of the projected get (partial get of a list of subtrees) of the
+  HDF5 backend.
+
+  An equilibrium IDS is written with nslices time slices, each holding a
+  global quantity, a 1D q profile and five 2D maps of points x points values
+  in profiles_2d. It is then read twice the way a high level interface does a
+  get, asking for every field of the IDS:
+  - get: al_begin_global_action without datapath;
+  - projected get: al_begin_global_action with the datapath
+    "time;time_slice/global_quantities/ip;time_slice/profiles_1d/q", so that
+    the backend skips the 2D maps (their datasets are not opened) and only
+    three quantities are read.
+  The quantities of the projection are checked in both gets, the 2D maps must
+  be empty in the projected get. A get with the single datapath
+  "time_slice/global_quantities/ip" (no ';') must still read the 2D maps. The exit status is 1 if any check failed.
+
+  usage: bench_projection [nslices] [points] [dir]
+  (defaults: 20 slices, 256 points, current directory)
+*/
+
+#include "bench_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *MAPS[] = {"psi", "j_tor", "b_field_r", "b_field_z", "b_field_tor"};
+static const int NB_MAPS = 5;
+static const int NB_Q = 100;
+
+static double value(int slice, int map, int i)
+{
+  return slice * 1.0e6 + map * 1.0e4 + i * 1.0e-3;
+}
+
+static void put(int pctx, int nslices, int points)
+{
+  int octx, tctx, pctx2d;
+  int nt = nslices, one = 1, nq = NB_Q, homogeneous = 1;
+  int size2d[2] = {points, points};
+  std::vector<double> time;
+  for (int t = 0; t < nslices; t++)
+    time.push_back(0.1 * t);
+
+  check(al_begin_global_action(pctx, "equilibrium", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  check(al_write_data(octx, "time", "time", time.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+  check(al_begin_arraystruct_action(octx, "time_slice", "time", &nt, &tctx), "al_begin_arraystruct_action");
+  for (int t = 0; t < nslices; t++)
+    {
+      double ip = value(t, 0, 0);
+      std::vector<double> q(NB_Q);
+      for (int i = 0; i < NB_Q; i++)
+	q[i] = value(t, 1, i);
+      check(al_write_data(tctx, "global_quantities/ip", "", &ip, DOUBLE_DATA, 0, NULL), "al_write_data");
+      check(al_write_data(tctx, "profiles_1d/q", "", q.data(), DOUBLE_DATA, 1, &nq), "al_write_data");
+      check(al_begin_arraystruct_action(tctx, "profiles_2d", "", &one, &pctx2d), "al_begin_arraystruct_action");
+      for (int m = 0; m < NB_MAPS; m++)
+	{
+	  std::vector<double> map((size_t)points * points);
+	  for (size_t i = 0; i < map.size(); i++)
+	    map[i] = value(t, m + 2, (int)(i % 1000));
+	  check(al_write_data(pctx2d, MAPS[m], "", map.data(), DOUBLE_DATA, 2, size2d), "al_write_data");
+	}
+      check(al_iterate_over_arraystruct(pctx2d, 1), "al_iterate_over_arraystruct");
+      check(al_end_action(pctx2d), "al_end_action");
+      check(al_iterate_over_arraystruct(tctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(tctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+// reads an array, returns its number of elements (0 if empty)
+static size_t read(int ctx, const char *field, const char *timebase, int dim, std::vector<double> *values = NULL)
+{
+  void *data = NULL;
+  int size[MAXDIM] = {0};
+  check(al_read_data(ctx, field, timebase, &data, DOUBLE_DATA, dim, size), "al_read_data");
+  size_t n = 0;
+  if (data != NULL)
+    {
+      n = 1;
+      for (int d = 0; d < dim; d++)
+	n *= size[d];
+    }
+  if (values != NULL && data != NULL)
+    values->assign((double *)data, (double *)data + n);
+  free(data);
+  return n;
+}
+
+// get of the whole IDS as done by a high level interface, the projected quantities are checked
+static void get(int pctx, const char *datapath, int nslices, int points)
+{
+  bool projected = strchr(datapath, ';') != NULL;
+  int octx, tctx, pctx2d;
+  check(al_begin_global_action(pctx, "equilibrium", datapath, READ_OP, &octx), "al_begin_global_action");
+  std::vector<double> time;
+  read(octx, "time", "time", 1, &time);
+  expect((int)time.size() == nslices, "time");
+  int nt = 0;
+  check(al_begin_arraystruct_action(octx, "time_slice", "time", &nt, &tctx), "al_begin_arraystruct_action");
+  expect(nt == nslices, "time_slice size");
+  for (int t = 0; t < nt; t++)
+    {
+      double ip = 0.0;
+      void *data = &ip;
+      int size[MAXDIM];
+      check(al_read_data(tctx, "global_quantities/ip", "", &data, DOUBLE_DATA, 0, size), "al_read_data");
+      expect(ip == value(t, 0, 0), "time_slice/global_quantities/ip");
+      std::vector<double> q;
+      read(tctx, "profiles_1d/q", "", 1, &q);
+      expect(q.size() == NB_Q && q[NB_Q - 1] == value(t, 1, NB_Q - 1), "time_slice/profiles_1d/q");
+      int n2d = 0;
+      check(al_begin_arraystruct_action(tctx, "profiles_2d", "", &n2d, &pctx2d), "al_begin_arraystruct_action");
+      expect(n2d == (projected ? 0 : 1), "time_slice/profiles_2d size");
+      for (int k = 0; k < n2d; k++)
+	{
+	  for (int m = 0; m < NB_MAPS; m++)
+	    expect(read(pctx2d, MAPS[m], "", 2) == (size_t)points * points, std::string("profiles_2d/") + MAPS[m]);
+	  check(al_iterate_over_arraystruct(pctx2d, 1), "al_iterate_over_arraystruct");
+	}
+      check(al_end_action(pctx2d), "al_end_action");
+      // fields of the IDS outside of the projection are read as empty
+      expect(read(tctx, "boundary/psi", "", 1) == 0, "time_slice/boundary/psi");
+      check(al_iterate_over_arraystruct(tctx, 1), "al_iterate_over_arraystruct");
+    }
+  check(al_end_action(tctx), "al_end_action");
+  check(al_end_action(octx), "al_end_action");
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int nslices = args.get(1, 20);
+  int points = args.get(2, 256);
+  std::string dir = args.get(3, ".");
+  std::string path = dir + "/projection_bench";
+  std::filesystem::create_directories(path);
+
+
+  try {
+    printf("equilibrium of %.1f MB (%d slices of %dx%d maps)\n",
+	   nslices * NB_MAPS * (double)points * points * 8.0 / 1.0e6, nslices, points, points);
+    int pctx = openEntry("imas:hdf5?path=" + path, FORCE_CREATE_PULSE);
+    put(pctx, nslices, points);
+    closeEntry(pctx);
+
+    printf("%-16s %10s %10s\n", "loop", "time (s)", "speedup");
+    pctx = openEntry("imas:hdf5?path=" + path, OPEN_PULSE);
+    auto start = std::chrono::steady_clock::now();
+    get(pctx, "", nslices, points);
+    double getTime = elapsed(start);
+    printf("%-16s %10.3f %10.2f\n", "get", getTime, 1.0);
+
+    start = std::chrono::steady_clock::now();
+    get(pctx, "time;time_slice/global_quantities/ip;time_slice/profiles_1d/q", nslices, points);
+    double projectedTime = elapsed(start);
+    printf("%-16s %10.3f %10.2f\n", "projected get", projectedTime, getTime / projectedTime);
+
+    // a single datapath is not a projection
+    get(pctx, "time_slice/global_quantities/ip", nslices, points);
+    closeEntry(pctx);
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
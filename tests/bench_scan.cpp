@@ -0,0 +1,181 @@
+/*
+  Benchmark of the multi-pulse scan (al_scan) with the HDF5 backend.
+
+  npulses data entries are written, each holding a summary IDS with ntimes
+  values of global_quantities/ip/value and of global_quantities/b0/value, the
+  way a database of pulses is. These two quantities and the time are then read
+  from all the pulses:
+  - loop: open, get of the three fields, close, one pulse after the other;
+  - scan: al_scan with 1 thread, then with nthreads threads, the callback
+    copying the data into columns allocated beforehand (one row per pulse).
+  The values are checked, the callback must receive the pulses in the order
+  of the URIs. A URI without data entry is appended to the scan: it must be
+  reported as failed without stopping the scan. The exit status is 1 if any
+  check failed.
+
+  usage: bench_scan [npulses] [ntimes] [nthreads] [dir]
+  (defaults: 200 pulses, 1000 times, 8 threads, current directory)
+*/
+
+#include "bench_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *FIELDS[] = {"time", "global_quantities/ip/value", "global_quantities/b0/value"};
+static const char *TIMEBASES[] = {"time", "time", "time"};
+static const int DATATYPES[] = {DOUBLE_DATA, DOUBLE_DATA, DOUBLE_DATA};
+static const int DIMS[] = {1, 1, 1};
+static const int NB_FIELDS = 3;
+
+static double value(int pulse, int field, int t)
+{
+  return pulse * 1.0e4 + field * 1.0e3 + t * 1.0e-3;
+}
+
+static void put(const std::string &uri, int pulse, int ntimes)
+{
+  int pctx, octx;
+  int nt = ntimes, homogeneous = 1;
+  pctx = openEntry(uri, FORCE_CREATE_PULSE);
+  check(al_begin_global_action(pctx, "summary", "", WRITE_OP, &octx), "al_begin_global_action");
+  check(al_write_data(octx, "ids_properties/homogeneous_time", "", &homogeneous, INTEGER_DATA, 0, NULL),
+	"al_write_data");
+  for (int f = 0; f < NB_FIELDS; f++)
+    {
+      std::vector<double> data(ntimes);
+      for (int t = 0; t < ntimes; t++)
+	data[t] = value(pulse, f, t);
+      check(al_write_data(octx, FIELDS[f], TIMEBASES[f], data.data(), DOUBLE_DATA, 1, &nt), "al_write_data");
+    }
+  check(al_end_action(octx), "al_end_action");
+  closeEntry(pctx);
+}
+
+// one row of ntimes values per pulse and field
+struct Columns
+{
+  int ntimes;
+  int expected = 0;                             // next index expected by the callback
+  int failed = -1;                              // index of the failed data entry
+  std::vector<std::vector<double>> fields;
+
+  std::string error;                            // first check failed in the callback
+
+  // runs on the threads of al_scan: errors are recorded, not thrown
+  static void callback(int index, al_status_t status, void **data, int **sizes, void *user)
+  {
+    Columns *c = (Columns *)user;
+    if (index != c->expected++ && c->error.empty())
+      c->error = "pulse " + std::to_string(index) + " received out of order";
+    if (status.code < 0)
+      {
+	c->failed = index;
+	return;
+      }
+    for (int f = 0; f < NB_FIELDS; f++)
+      {
+	if (data[f] == NULL || sizes[f][0] != c->ntimes)
+	  {
+	    if (c->error.empty())
+	      c->error = std::string(FIELDS[f]) + " size of pulse " + std::to_string(index);
+	    continue;
+	  }
+	std::copy_n((double *)data[f], c->ntimes, c->fields[f].begin() + (size_t)index * c->ntimes);
+      }
+  }
+};
+
+static void loop(const std::vector<std::string> &uris, Columns &c)
+{
+  for (size_t p = 0; p < uris.size(); p++)
+    {
+      int pctx, octx;
+      pctx = openEntry(uris[p], OPEN_PULSE);
+      check(al_begin_global_action(pctx, "summary", "", READ_OP, &octx), "al_begin_global_action");
+      for (int f = 0; f < NB_FIELDS; f++)
+	{
+	  void *data = NULL;
+	  int size[MAXDIM] = {0};
+	  check(al_read_data(octx, FIELDS[f], TIMEBASES[f], &data, DOUBLE_DATA, 1, size), "al_read_data");
+	  expect(data != NULL && size[0] == c.ntimes, std::string(FIELDS[f]) + " size");
+	  std::copy_n((double *)data, c.ntimes, c.fields[f].begin() + p * c.ntimes);
+	  al_free_data(data);
+	}
+      check(al_end_action(octx), "al_end_action");
+      closeEntry(pctx);
+    }
+}
+
+static void verify(const Columns &c, int npulses)
+{
+  for (int p = 0; p < npulses; p++)
+    for (int f = 0; f < NB_FIELDS; f++)
+      for (int t : {0, c.ntimes - 1})
+	expect(c.fields[f][(size_t)p * c.ntimes + t] == value(p, f, t),
+	       std::string(FIELDS[f]) + " of pulse " + std::to_string(p));
+}
+
+int main(int argc, char *argv[])
+{
+  Args args(argc, argv);
+  int npulses = args.get(1, 200);
+  int ntimes = args.get(2, 1000);
+  int nthreads = args.get(3, 8);
+  std::string dir = args.get(4, ".");
+
+  try {
+    std::vector<std::string> uris;
+    for (int p = 0; p < npulses; p++)
+      {
+	std::string path = dir + "/scan_bench/" + std::to_string(p);
+	std::filesystem::create_directories(path);
+	uris.push_back("imas:hdf5?path=" + path);
+	put(uris.back(), p, ntimes);
+      }
+    printf("%d pulses, summary with %d times\n", npulses, ntimes);
+    printf("%-12s %10s\n", "read", "time (s)");
+
+    Columns c;
+    c.ntimes = ntimes;
+    c.fields.assign(NB_FIELDS, std::vector<double>((size_t)npulses * ntimes, 0.0));
+    auto start = std::chrono::steady_clock::now();
+    loop(uris, c);
+    double seconds = elapsed(start);
+    verify(c, npulses);
+    printf("%-12s %10.3f\n", "loop", seconds);
+
+    // the last URI has no data entry
+    uris.push_back("imas:hdf5?path=" + dir + "/scan_bench/missing");
+    std::vector<const char *> curis;
+    for (const std::string &uri : uris)
+      curis.push_back(uri.c_str());
+    for (int threads : {1, nthreads})
+      {
+	Columns s;
+	s.ntimes = ntimes;
+	s.fields.assign(NB_FIELDS, std::vector<double>((size_t)(npulses + 1) * ntimes, 0.0));
+	start = std::chrono::steady_clock::now();
+	check(al_scan(curis.data(), (int)curis.size(), "summary", NB_FIELDS, FIELDS, TIMEBASES, DATATYPES, DIMS,
+		      Columns::callback, &s, threads), "al_scan");
+	seconds = elapsed(start);
+	expect(s.error.empty(), s.error);
+	expect(s.expected == npulses + 1, "number of pulses received");
+	expect(s.failed == npulses, "missing data entry not reported");
+	verify(s, npulses);
+	printf("%-12s %10.3f\n", ("scan (" + std::to_string(threads) + ")").c_str(), seconds);
+      }
+  }
+  catch (const std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}